@@ -0,0 +1,308 @@
+/*
+ * Jitsi, the OpenSource Java VoIP and Instant Messaging client.
+ *
+ * Distributable under LGPL license.
+ * See terms of license at gnu.org.
+ */
+
+#include "FramePool.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <libavutil/common.h>
+#include <libavutil/mem.h>
+
+/**
+ * The alignment in bytes of the planes and the lines of the pooled pictures
+ * which is sufficient for the SIMD of the decoders (and the consumers).
+ */
+#define FRAMEPOOL_ALIGN 32
+
+/** Represents a (reference counted) picture buffer of a <tt>FramePool</tt>. */
+typedef struct _FramePoolBuffer
+{
+    uint8_t *data;
+    struct _FramePoolBuffer *next;
+    struct _FramePool *pool;
+    volatile int refs;
+    size_t size;
+} FramePoolBuffer;
+
+struct _FramePool
+{
+    /** The indicator which determines whether the owner has freed the pool. */
+    int freed;
+    /** The buffers which are not referenced and may be handed out again. */
+    FramePoolBuffer *idle;
+    volatile int lock;
+    /** The reference of the owner plus one per referenced buffer. */
+    volatile int refs;
+};
+
+static int FramePool_getBuffer(AVCodecContext *avctx, AVFrame *frame);
+static void FramePool_lock(FramePool *pool);
+static void FramePool_releaseBuffer(AVCodecContext *avctx, AVFrame *frame);
+static void FramePool_unlock(FramePool *pool);
+static void FramePool_unrefBuffer(FramePoolBuffer *buffer);
+static void FramePool_unrefPool(FramePool *pool);
+
+FramePool *
+FramePool_alloc(void)
+{
+    FramePool *pool = calloc(1, sizeof(FramePool));
+
+    if (pool)
+        pool->refs = 1;
+    return pool;
+}
+
+void
+FramePool_free(FramePool *pool)
+{
+    FramePoolBuffer *idle;
+
+    FramePool_lock(pool);
+    pool->freed = 1;
+    idle = pool->idle;
+    pool->idle = NULL;
+    FramePool_unlock(pool);
+
+    while (idle)
+    {
+        FramePoolBuffer *next = idle->next;
+
+        av_free(idle->data);
+        free(idle);
+        idle = next;
+    }
+    FramePool_unrefPool(pool);
+}
+
+void
+FramePool_install(FramePool *pool, AVCodecContext *avctx)
+{
+    if (avctx->codec && !(avctx->codec->capabilities & CODEC_CAP_DR1))
+        return;
+
+    avctx->opaque = pool;
+    avctx->get_buffer = FramePool_getBuffer;
+    avctx->release_buffer = FramePool_releaseBuffer;
+    /*
+     * Have the decoder emulate the edges of the reference pictures rather than
+     * draw them around the pictures so that the buffers hold the pictures only.
+     */
+    avctx->flags |= CODEC_FLAG_EMU_EDGE;
+}
+
+int
+FramePool_ref(AVFrame *dst, const AVFrame *src)
+{
+    FramePoolBuffer *buffer;
+    int i;
+
+    if (dst == src)
+        return 0;
+    if (((FF_BUFFER_TYPE_USER != src->type)
+                && (FF_BUFFER_TYPE_COPY != src->type))
+            || !(src->opaque))
+        return -1;
+
+    buffer = (FramePoolBuffer *) (src->opaque);
+    /* The reference of src keeps buffer alive while it is referenced again. */
+    __sync_fetch_and_add(&(buffer->refs), 1);
+    FramePool_unref(dst);
+
+    for (i = 0; i < AV_NUM_DATA_POINTERS; i++)
+    {
+        dst->data[i] = src->data[i];
+        dst->linesize[i] = src->linesize[i];
+    }
+    dst->extended_data = dst->data;
+    dst->width = src->width;
+    dst->height = src->height;
+    dst->format = src->format;
+    dst->key_frame = src->key_frame;
+    dst->pict_type = src->pict_type;
+    dst->pts = src->pts;
+    dst->pkt_pts = src->pkt_pts;
+    /* The copy does not own the picture, its reference does. */
+    dst->type = FF_BUFFER_TYPE_COPY;
+    dst->opaque = buffer;
+    return 0;
+}
+
+void
+FramePool_unref(AVFrame *frame)
+{
+    if ((FF_BUFFER_TYPE_COPY == frame->type) && frame->opaque)
+    {
+        FramePoolBuffer *buffer = (FramePoolBuffer *) (frame->opaque);
+
+        avcodec_get_frame_defaults(frame);
+        FramePool_unrefBuffer(buffer);
+    }
+}
+
+static int
+FramePool_getBuffer(AVCodecContext *avctx, AVFrame *frame)
+{
+    FramePool *pool = (FramePool *) (avctx->opaque);
+    int width = avctx->width;
+    int height = avctx->height;
+    int linesizeAlign[AV_NUM_DATA_POINTERS];
+    int linesize[3];
+    size_t size;
+    FramePoolBuffer *buffer;
+    FramePoolBuffer *stale;
+    int i;
+
+    if ((PIX_FMT_YUV420P != avctx->pix_fmt) || (width < 1) || (height < 1))
+        return avcodec_default_get_buffer(avctx, frame);
+
+    avcodec_align_dimensions2(avctx, &width, &height, linesizeAlign);
+    linesize[0] = FFALIGN(width, FFMAX(FRAMEPOOL_ALIGN, linesizeAlign[0]));
+    linesize[1]
+        = FFALIGN((width + 1) / 2, FFMAX(FRAMEPOOL_ALIGN, linesizeAlign[1]));
+    linesize[2] = linesize[1];
+    height = FFALIGN(height, 2);
+    /*
+     * av_malloc does not necessarily align to FRAMEPOOL_ALIGN so leave room
+     * for the start of the picture to be rounded up to it.
+     */
+    size
+        = (size_t) linesize[0] * height
+            + 2 * (size_t) linesize[1] * (height / 2)
+            + FRAMEPOOL_ALIGN;
+
+    /*
+     * Take an idle buffer of the right size (if any). The ones of another size
+     * are left over from a change of the size of the pictures.
+     */
+    stale = NULL;
+    FramePool_lock(pool);
+    while ((buffer = pool->idle))
+    {
+        pool->idle = buffer->next;
+        if (buffer->size == size)
+            break;
+        buffer->next = stale;
+        stale = buffer;
+    }
+    FramePool_unlock(pool);
+    while (stale)
+    {
+        FramePoolBuffer *next = stale->next;
+
+        av_free(stale->data);
+        free(stale);
+        stale = next;
+    }
+
+    if (!buffer)
+    {
+        buffer = malloc(sizeof(FramePoolBuffer));
+        if (!buffer)
+            return -1;
+        buffer->data = av_malloc(size);
+        if (!(buffer->data))
+        {
+            free(buffer);
+            return -1;
+        }
+        buffer->pool = pool;
+        buffer->size = size;
+    }
+    buffer->next = NULL;
+    buffer->refs = 1;
+    __sync_fetch_and_add(&(pool->refs), 1);
+
+    for (i = 0; i < AV_NUM_DATA_POINTERS; i++)
+    {
+        frame->data[i] = NULL;
+        frame->linesize[i] = 0;
+    }
+    frame->data[0]
+        = (uint8_t *) FFALIGN((uintptr_t) (buffer->data), FRAMEPOOL_ALIGN);
+    frame->data[1] = frame->data[0] + (size_t) linesize[0] * height;
+    frame->data[2] = frame->data[1] + (size_t) linesize[1] * (height / 2);
+    for (i = 0; i < 3; i++)
+        frame->linesize[i] = linesize[i];
+    frame->extended_data = frame->data;
+    frame->type = FF_BUFFER_TYPE_USER;
+    frame->opaque = buffer;
+    frame->width = avctx->width;
+    frame->height = avctx->height;
+    frame->format = avctx->pix_fmt;
+    frame->pkt_pts = avctx->pkt ? avctx->pkt->pts : AV_NOPTS_VALUE;
+    frame->reordered_opaque = avctx->reordered_opaque;
+    return 0;
+}
+
+static void
+FramePool_lock(FramePool *pool)
+{
+    while (__sync_lock_test_and_set(&(pool->lock), 1))
+    {
+        while (pool->lock);
+    }
+}
+
+static void
+FramePool_releaseBuffer(AVCodecContext *avctx, AVFrame *frame)
+{
+    FramePoolBuffer *buffer;
+    int i;
+
+    if (FF_BUFFER_TYPE_USER != frame->type)
+    {
+        avcodec_default_release_buffer(avctx, frame);
+        return;
+    }
+
+    buffer = (FramePoolBuffer *) (frame->opaque);
+    frame->opaque = NULL;
+    for (i = 0; i < AV_NUM_DATA_POINTERS; i++)
+        frame->data[i] = NULL;
+    if (buffer)
+        FramePool_unrefBuffer(buffer);
+}
+
+static void
+FramePool_unlock(FramePool *pool)
+{
+    __sync_lock_release(&(pool->lock));
+}
+
+static void
+FramePool_unrefBuffer(FramePoolBuffer *buffer)
+{
+    if (__sync_sub_and_fetch(&(buffer->refs), 1) == 0)
+    {
+        FramePool *pool = buffer->pool;
+        int freed;
+
+        FramePool_lock(pool);
+        freed = pool->freed;
+        if (!freed)
+        {
+            buffer->next = pool->idle;
+            pool->idle = buffer;
+        }
+        FramePool_unlock(pool);
+        if (freed)
+        {
+            av_free(buffer->data);
+            free(buffer);
+        }
+        FramePool_unrefPool(pool);
+    }
+}
+
+static void
+FramePool_unrefPool(FramePool *pool)
+{
+    if (__sync_sub_and_fetch(&(pool->refs), 1) == 0)
+        free(pool);
+}
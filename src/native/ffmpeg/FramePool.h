@@ -0,0 +1,71 @@
+/*
+ * Jitsi, the OpenSource Java VoIP and Instant Messaging client.
+ *
+ * Distributable under LGPL license.
+ * See terms of license at gnu.org.
+ */
+
+#ifndef _ORG_JITSI_IMPL_NEOMEDIA_CODEC_FRAMEPOOL_H_
+#define _ORG_JITSI_IMPL_NEOMEDIA_CODEC_FRAMEPOOL_H_
+
+#include <libavcodec/avcodec.h>
+
+/**
+ * Represents a pool of aligned picture buffers which a video decoder decodes
+ * into through its <tt>get_buffer</tt> and <tt>release_buffer</tt> callbacks.
+ * A buffer is reference counted so that a decoded picture may outlive the next
+ * decode (e.g. while a renderer holds it) without being copied and is returned
+ * to the pool rather than freed once its last reference is dropped. The
+ * references may be dropped on any thread.
+ */
+typedef struct _FramePool FramePool;
+
+/**
+ * Allocates a new empty <tt>FramePool</tt>.
+ *
+ * @return a new <tt>FramePool</tt> or <tt>NULL</tt> on failure
+ */
+FramePool *FramePool_alloc(void);
+
+/**
+ * Releases the reference of the owner of a <tt>FramePool</tt> i.e. frees its
+ * idle buffers. The buffers which are still referenced are freed (and the pool
+ * itself with the last of them) when their last references are dropped. The
+ * codec the pool is installed into is to be closed first.
+ *
+ * @param pool the <tt>FramePool</tt> to free
+ */
+void FramePool_free(FramePool *pool);
+
+/**
+ * Installs a <tt>FramePool</tt> as the allocator of the pictures of a video
+ * decoder. It is to be invoked before <tt>avcodec_open2</tt>. Decoders which
+ * do not support direct rendering (and pixel formats other than
+ * <tt>PIX_FMT_YUV420P</tt>) keep the default allocator.
+ *
+ * @param pool the <tt>FramePool</tt> to install
+ * @param avctx the <tt>AVCodecContext</tt> to install <tt>pool</tt> into
+ */
+void FramePool_install(FramePool *pool, AVCodecContext *avctx);
+
+/**
+ * Makes a frame reference the pooled picture of another frame. The frame drops
+ * whatever it referenced before.
+ *
+ * @param dst the frame to reference the picture of <tt>src</tt>
+ * @param src a frame decoded into a <tt>FramePool</tt> or another frame which
+ * references a pooled picture
+ * @return <tt>0</tt> if <tt>dst</tt> references the picture of <tt>src</tt>;
+ * <tt>-1</tt> if the picture of <tt>src</tt> is not pooled
+ */
+int FramePool_ref(AVFrame *dst, const AVFrame *src);
+
+/**
+ * Drops the reference of a frame made by <tt>FramePool_ref</tt> (if any) and
+ * resets the frame to its defaults.
+ *
+ * @param frame the frame to drop the reference of
+ */
+void FramePool_unref(AVFrame *frame);
+
+#endif /* #ifndef _ORG_JITSI_IMPL_NEOMEDIA_CODEC_FRAMEPOOL_H_ */
@@ -0,0 +1,342 @@
+/*
+ * Jitsi, the OpenSource Java VoIP and Instant Messaging client.
+ *
+ * Distributable under LGPL license.
+ * See terms of license at gnu.org.
+ */
+
+#include "H264Packetizer.h"
+
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64) \
+        || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define H264PACKETIZER_SSE2
+#include <emmintrin.h>
+#endif
+
+/** The maximum number of NAL units aggregated into a STAP-A payload. */
+#define H264PACKETIZER_MAX_AGGREGATED 32
+
+/** Represents the payloads written by <tt>H264Packetizer_packetize</tt>. */
+typedef struct _H264PacketizerOutput
+{
+    uint8_t *packets;
+    int packetsCapacity;
+    int packetsLength;
+    int *payloadLengths;
+    int payloadLengthsCapacity;
+    int payloadCount;
+} H264PacketizerOutput;
+
+static uint8_t *H264Packetizer_addPayload(H264PacketizerOutput *output, int length);
+static int H264Packetizer_aggregate(H264PacketizerOutput *output, const uint8_t *const nals[], const int nalLengths[], int count);
+static int H264Packetizer_packetizeNAL(H264PacketizerOutput *output, const uint8_t *nal, int nalLength, int maxPayloadSize);
+
+const uint8_t *
+H264Packetizer_findStartCode(const uint8_t *p, const uint8_t *end)
+{
+    const uint8_t *limit;
+
+    if (end - p < 4)
+        return end;
+    /* A start code has to be followed by (the octet of) a NAL unit. */
+    limit = end - 3;
+
+#ifdef H264PACKETIZER_SSE2
+    {
+        __m128i zero = _mm_setzero_si128();
+
+        /*
+         * Skip 16 bytes at a time while there are no two consecutive zero
+         * bytes. Thanks to the emulation prevention of H.264, two consecutive
+         * zero bytes are rare outside of the start codes.
+         */
+        while (p + 16 <= limit)
+        {
+            __m128i v = _mm_loadu_si128((const __m128i *) p);
+            int zeros = _mm_movemask_epi8(_mm_cmpeq_epi8(v, zero));
+
+            if (zeros)
+            {
+                /* The last byte pairs with the first byte of the next block. */
+                int candidates = zeros & ((zeros >> 1) | 0x8000);
+                int k;
+
+                for (k = 0; candidates; k++, candidates >>= 1)
+                {
+                    if ((candidates & 1) && !p[k + 1] && (1 == p[k + 2]))
+                        return p + k;
+                }
+            }
+            p += 16;
+        }
+    }
+#endif /* #ifdef H264PACKETIZER_SSE2 */
+
+    while (p < limit)
+    {
+        if (p[2] > 1)
+            p += 3;
+        else if (p[1])
+            p += 2;
+        else if (p[0] || (1 != p[2]))
+            p++;
+        else
+            return p;
+    }
+    return end;
+}
+
+int
+H264Packetizer_packetize
+    (const uint8_t *src, int srcLength,
+        int maxPayloadSize, int aggregate,
+        uint8_t *packets, int packetsCapacity,
+        int *payloadLengths, int payloadLengthsCapacity)
+{
+    H264PacketizerOutput output;
+    const uint8_t *end;
+    const uint8_t *begin;
+    const uint8_t *aggregated[H264PACKETIZER_MAX_AGGREGATED];
+    int aggregatedLengths[H264PACKETIZER_MAX_AGGREGATED];
+    int aggregatedCount;
+    int aggregatedSize;
+
+    /* A FU-A carries the FU indicator, the FU header and a byte at least. */
+    if (maxPayloadSize < 3)
+        return -1;
+
+    output.packets = packets;
+    output.packetsCapacity = packetsCapacity;
+    output.packetsLength = 0;
+    output.payloadLengths = payloadLengths;
+    output.payloadLengthsCapacity = payloadLengthsCapacity;
+    output.payloadCount = 0;
+
+    aggregatedCount = 0;
+    aggregatedSize = 1 /* STAP-A NAL HDR */;
+
+    /*
+     * Split the H.264 byte stream into NAL units. Each NAL unit begins with
+     * start_code_prefix_one_3bytes. Refer to "B.1 Byte stream NAL unit syntax
+     * and semantics" of "ITU-T Rec. H.264 Advanced video coding for generic
+     * audiovisual services" for further details.
+     */
+    end = src + srcLength;
+    begin = H264Packetizer_findStartCode(src, end);
+    if (begin < end)
+    {
+        begin += 3;
+        while (begin < end)
+        {
+            const uint8_t *next = H264Packetizer_findStartCode(begin, end);
+            int nalLength = (int) (next - begin);
+
+            /* Discard any trailing_zero_8bits. */
+            while ((nalLength > 0) && !begin[nalLength - 1])
+                nalLength--;
+
+            if (nalLength > 0)
+            {
+                if (aggregate
+                        && (2 /* NALU Size */ + nalLength
+                                <= maxPayloadSize - 1 /* STAP-A NAL HDR */))
+                {
+                    if ((aggregatedCount == H264PACKETIZER_MAX_AGGREGATED)
+                            || (aggregatedSize + 2 + nalLength
+                                    > maxPayloadSize))
+                    {
+                        if (H264Packetizer_aggregate(
+                                    &output,
+                                    aggregated, aggregatedLengths,
+                                    aggregatedCount))
+                            return -1;
+                        aggregatedCount = 0;
+                        aggregatedSize = 1;
+                    }
+                    aggregated[aggregatedCount] = begin;
+                    aggregatedLengths[aggregatedCount] = nalLength;
+                    aggregatedCount++;
+                    aggregatedSize += 2 + nalLength;
+                }
+                else
+                {
+                    if (H264Packetizer_aggregate(
+                                &output,
+                                aggregated, aggregatedLengths,
+                                aggregatedCount)
+                            || H264Packetizer_packetizeNAL(
+                                    &output,
+                                    begin, nalLength,
+                                    maxPayloadSize))
+                        return -1;
+                    aggregatedCount = 0;
+                    aggregatedSize = 1;
+                }
+            }
+            begin = next + 3;
+        }
+    }
+    if (H264Packetizer_aggregate(
+                &output,
+                aggregated, aggregatedLengths,
+                aggregatedCount))
+        return -1;
+    return output.payloadCount;
+}
+
+/**
+ * Appends a payload of a specific length to the output of
+ * <tt>H264Packetizer_packetize</tt>.
+ *
+ * @return the beginning of the payload to be written or <tt>NULL</tt> if the
+ * output is full
+ */
+static uint8_t *
+H264Packetizer_addPayload(H264PacketizerOutput *output, int length)
+{
+    uint8_t *payload;
+
+    if ((output->payloadCount == output->payloadLengthsCapacity)
+            || (length > output->packetsCapacity - output->packetsLength))
+        return NULL;
+
+    payload = output->packets + output->packetsLength;
+    output->packetsLength += length;
+    output->payloadLengths[output->payloadCount] = length;
+    output->payloadCount++;
+    return payload;
+}
+
+/**
+ * Writes a number of NAL units into a STAP-A payload or, if there is a single
+ * one, into a Single NAL Unit Packet.
+ *
+ * @return <tt>0</tt> on success or <tt>-1</tt> if the output is full
+ */
+static int
+H264Packetizer_aggregate
+    (H264PacketizerOutput *output,
+        const uint8_t *const nals[], const int nalLengths[], int count)
+{
+    uint8_t *payload;
+    int length;
+    uint8_t forbiddenZeroBit;
+    uint8_t nri;
+    int i;
+
+    if (count == 0)
+        return 0;
+    if (count == 1)
+    {
+        payload = H264Packetizer_addPayload(output, nalLengths[0]);
+        if (!payload)
+            return -1;
+        memcpy(payload, nals[0], nalLengths[0]);
+        return 0;
+    }
+
+    length = 1 /* STAP-A NAL HDR */;
+    forbiddenZeroBit = 0;
+    nri = 0;
+    for (i = 0; i < count; i++)
+    {
+        uint8_t octet = nals[i][0];
+
+        length += 2 /* NALU Size */ + nalLengths[i];
+        forbiddenZeroBit |= octet & 0x80;
+        if ((octet & 0x60) > nri)
+            nri = octet & 0x60;
+    }
+
+    payload = H264Packetizer_addPayload(output, length);
+    if (!payload)
+        return -1;
+    /*
+     * The F bit of a STAP-A is set if any aggregated NAL unit has its F bit
+     * set and its NRI is the maximum of the NRIs of the aggregated NAL units.
+     */
+    *payload++ = forbiddenZeroBit | nri | H264PACKETIZER_STAP_A;
+    for (i = 0; i < count; i++)
+    {
+        int nalLength = nalLengths[i];
+
+        *payload++ = (uint8_t) (nalLength >> 8);
+        *payload++ = (uint8_t) nalLength;
+        memcpy(payload, nals[i], nalLength);
+        payload += nalLength;
+    }
+    return 0;
+}
+
+/**
+ * Writes a NAL unit into a Single NAL Unit Packet or, if it does not fit,
+ * splits it into FU-A payloads.
+ *
+ * @return <tt>0</tt> on success or <tt>-1</tt> if the output is full
+ */
+static int
+H264Packetizer_packetizeNAL
+    (H264PacketizerOutput *output,
+        const uint8_t *nal, int nalLength,
+        int maxPayloadSize)
+{
+    uint8_t *payload;
+    uint8_t fuIndicator;
+    uint8_t fuHeader;
+    int maxFUPayloadLength;
+
+    if (nalLength <= maxPayloadSize)
+    {
+        payload = H264Packetizer_addPayload(output, nalLength);
+        if (!payload)
+            return -1;
+        memcpy(payload, nal, nalLength);
+        return 0;
+    }
+
+    /* forbidden_zero_bit, NRI and nal_unit_type FU-A */
+    fuIndicator = (nal[0] & 0xE0) | H264PACKETIZER_FU_A;
+    /* Start bit and nal_unit_type */
+    fuHeader = 0x80 | (nal[0] & 0x1F);
+    nal++;
+    nalLength--;
+
+    maxFUPayloadLength = maxPayloadSize - 2 /* FU indicator & FU header */;
+    while (nalLength > 0)
+    {
+        int fuPayloadLength;
+
+        if (nalLength > maxFUPayloadLength)
+            fuPayloadLength = maxFUPayloadLength;
+        else
+        {
+            fuPayloadLength = nalLength;
+            fuHeader |= 0x40; /* End bit */
+        }
+
+        /*
+         * Tests with Asterisk suggest that the fragments of a fragmented NAL
+         * unit must be with one and the same size so the last one is padded.
+         */
+        payload = H264Packetizer_addPayload(output, maxPayloadSize);
+        if (!payload)
+            return -1;
+        payload[0] = fuIndicator;
+        payload[1] = fuHeader;
+        memcpy(payload + 2, nal, fuPayloadLength);
+        if (fuPayloadLength < maxFUPayloadLength)
+        {
+            memset(
+                    payload + 2 + fuPayloadLength,
+                    0,
+                    maxFUPayloadLength - fuPayloadLength);
+        }
+        nal += fuPayloadLength;
+        nalLength -= fuPayloadLength;
+
+        fuHeader &= ~0x80; /* Start bit */
+    }
+    return 0;
+}
@@ -0,0 +1,61 @@
+/*
+ * Jitsi, the OpenSource Java VoIP and Instant Messaging client.
+ *
+ * Distributable under LGPL license.
+ * See terms of license at gnu.org.
+ */
+
+#ifndef _ORG_JITSI_IMPL_NEOMEDIA_CODEC_H264PACKETIZER_H_
+#define _ORG_JITSI_IMPL_NEOMEDIA_CODEC_H264PACKETIZER_H_
+
+#include <stdint.h>
+
+/** The <tt>nal_unit_type</tt> of a Single-Time Aggregation Packet. */
+#define H264PACKETIZER_STAP_A 24
+
+/** The <tt>nal_unit_type</tt> of a Fragmentation Unit. */
+#define H264PACKETIZER_FU_A 28
+
+/**
+ * Finds the start_code_prefix_one_3bytes of a NAL unit in a H.264 byte
+ * stream, using SSE2 where available. A start code at the very end of the
+ * byte stream (i.e. not followed by at least one byte of a NAL unit) is not
+ * found.
+ *
+ * @param p the beginning of the byte stream to search
+ * @param end the end of the byte stream to search
+ * @return the beginning of the first start_code_prefix_one_3bytes found or
+ * <tt>end</tt> if there is none
+ */
+const uint8_t *H264Packetizer_findStartCode
+    (const uint8_t *p, const uint8_t *end);
+
+/**
+ * Packetizes the NAL units of a H.264 byte stream (e.g. an access unit output
+ * by the encoder) into RTP payloads in accord with RFC 6184 "RTP Payload
+ * Format for H.264 Video". A NAL unit which does not fit into a payload is
+ * fragmented into FU-A payloads which are all of the same size. If
+ * <tt>aggregate</tt>, consecutive NAL units which fit into a payload together
+ * are aggregated into a STAP-A payload. The payloads are written one after the
+ * other into <tt>packets</tt>.
+ *
+ * @param src the H.264 byte stream to packetize
+ * @param srcLength the length in bytes of <tt>src</tt>
+ * @param maxPayloadSize the maximum size in bytes of a payload
+ * @param aggregate non-zero to aggregate NAL units into STAP-A payloads
+ * (which is only allowed in packetization-mode 1)
+ * @param packets the buffer to write the payloads into
+ * @param packetsCapacity the size in bytes of <tt>packets</tt>
+ * @param payloadLengths the array to write the lengths of the payloads into
+ * @param payloadLengthsCapacity the number of elements of
+ * <tt>payloadLengths</tt>
+ * @return the number of payloads written or <tt>-1</tt> if <tt>packets</tt>
+ * or <tt>payloadLengths</tt> is too small
+ */
+int H264Packetizer_packetize
+    (const uint8_t *src, int srcLength,
+        int maxPayloadSize, int aggregate,
+        uint8_t *packets, int packetsCapacity,
+        int *payloadLengths, int payloadLengthsCapacity);
+
+#endif /* #ifndef _ORG_JITSI_IMPL_NEOMEDIA_CODEC_H264PACKETIZER_H_ */
@@ -0,0 +1,1528 @@
+/*
+ * Jitsi, the OpenSource Java VoIP and Instant Messaging client.
+ *
+ * Distributable under LGPL license.
+ * See terms of license at gnu.org.
+ */
+
+#include "I420Converter.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64) \
+        || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define I420CONVERTER_SSE2
+#include <emmintrin.h>
+
+/*
+ * The AVX2 routines are compiled with the target attribute and selected at
+ * run time so that the library does not require an AVX2-capable CPU.
+ */
+#if defined(__GNUC__) \
+        && (defined(__clang__) \
+            || (__GNUC__ > 4) || ((__GNUC__ == 4) && (__GNUC_MINOR__ >= 9)))
+#define I420CONVERTER_AVX2
+#include <immintrin.h>
+#endif
+#endif
+
+#if (defined(__ARM_NEON) || defined(__ARM_NEON__)) \
+        && (!defined(__BYTE_ORDER__) \
+            || (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__))
+#define I420CONVERTER_NEON
+#include <arm_neon.h>
+#endif
+
+static void I420Converter_nv12
+    (const uint8_t *const src[], const int srcStride[],
+        uint8_t *const dst[], const int dstStride[], int width, int height);
+static void I420Converter_nv12Half
+    (const uint8_t *const src[], const int srcStride[],
+        uint8_t *const dst[], const int dstStride[], int width, int height);
+static int I420Converter_nv12HalfRows_C
+    (const uint8_t *s0, const uint8_t *s1, uint8_t *d, int x, int width);
+static int I420Converter_nv12HalfUVRows_C
+    (const uint8_t *s0, const uint8_t *s1, uint8_t *u, uint8_t *v, int x,
+        int width);
+static int I420Converter_nv12UVRow_C
+    (const uint8_t *s, uint8_t *u, uint8_t *v, int x, int width);
+static void I420Converter_packed422
+    (int yOffset, const uint8_t *const src[], const int srcStride[],
+        uint8_t *const dst[], const int dstStride[], int width, int height);
+static void I420Converter_packed422Half
+    (int yOffset, const uint8_t *const src[], const int srcStride[],
+        uint8_t *const dst[], const int dstStride[], int width, int height);
+static int I420Converter_packed422HalfRows_C
+    (const uint8_t *const s[4], int yOffset,
+        uint8_t *y0, uint8_t *y1, uint8_t *u, uint8_t *v, int x, int width);
+static int I420Converter_packed422Rows_C
+    (const uint8_t *s0, const uint8_t *s1, int yOffset,
+        uint8_t *y0, uint8_t *y1, uint8_t *u, uint8_t *v, int x, int width);
+static int I420Converter_rgb32
+    (const uint8_t *const src[], const int srcStride[],
+        uint8_t *const dst[], const int dstStride[], int width, int height);
+static int I420Converter_rgb32Half
+    (const uint8_t *const src[], const int srcStride[],
+        uint8_t *const dst[], const int dstStride[], int width, int height);
+static int I420Converter_rgb32HalfRow_C
+    (const uint32_t *s0, const uint32_t *s1, uint32_t *d, int x, int width);
+static void I420Converter_rgb32RowPair
+    (const uint32_t *s0, const uint32_t *s1,
+        uint8_t *y0, uint8_t *y1, uint8_t *u, uint8_t *v, int width);
+static int I420Converter_rgb32Rows_C
+    (const uint32_t *s0, const uint32_t *s1,
+        uint8_t *y0, uint8_t *y1, uint8_t *u, uint8_t *v, int x, int width);
+
+#ifdef I420CONVERTER_AVX2
+static int I420Converter_hasAVX2(void);
+static int I420Converter_nv12UVRow_AVX2
+    (const uint8_t *s, uint8_t *u, uint8_t *v, int x, int width);
+static int I420Converter_packed422Rows_AVX2
+    (const uint8_t *s0, const uint8_t *s1, int yOffset,
+        uint8_t *y0, uint8_t *y1, uint8_t *u, uint8_t *v, int x, int width);
+#endif /* #ifdef I420CONVERTER_AVX2 */
+
+#ifdef I420CONVERTER_NEON
+static uint8x16_t I420Converter_average4_NEON
+    (uint8x16_t a, uint8x16_t b, uint8x16_t c, uint8x16_t d);
+static uint8x8_t I420Converter_halve_NEON(uint8x16_t a, uint8x16_t b);
+static int I420Converter_nv12HalfRows_NEON
+    (const uint8_t *s0, const uint8_t *s1, uint8_t *d, int x, int width);
+static int I420Converter_nv12HalfUVRows_NEON
+    (const uint8_t *s0, const uint8_t *s1, uint8_t *u, uint8_t *v, int x,
+        int width);
+static int I420Converter_nv12UVRow_NEON
+    (const uint8_t *s, uint8_t *u, uint8_t *v, int x, int width);
+static int I420Converter_packed422HalfRows_NEON
+    (const uint8_t *const s[4], int yOffset,
+        uint8_t *y0, uint8_t *y1, uint8_t *u, uint8_t *v, int x, int width);
+static int I420Converter_packed422Rows_NEON
+    (const uint8_t *s0, const uint8_t *s1, int yOffset,
+        uint8_t *y0, uint8_t *y1, uint8_t *u, uint8_t *v, int x, int width);
+static int I420Converter_rgb32HalfRow_NEON
+    (const uint32_t *s0, const uint32_t *s1, uint32_t *d, int x, int width);
+static int I420Converter_rgb32Rows_NEON
+    (const uint32_t *s0, const uint32_t *s1,
+        uint8_t *y0, uint8_t *y1, uint8_t *u, uint8_t *v, int x, int width);
+#endif /* #ifdef I420CONVERTER_NEON */
+
+#ifdef I420CONVERTER_SSE2
+static __m128i I420Converter_halve_SSE2
+    (__m128i a0, __m128i a1, __m128i b0, __m128i b1);
+static __m128i I420Converter_halveUV_SSE2
+    (__m128i a0, __m128i a1, __m128i b0, __m128i b1);
+static int I420Converter_nv12HalfRows_SSE2
+    (const uint8_t *s0, const uint8_t *s1, uint8_t *d, int x, int width);
+static int I420Converter_nv12HalfUVRows_SSE2
+    (const uint8_t *s0, const uint8_t *s1, uint8_t *u, uint8_t *v, int x,
+        int width);
+static int I420Converter_nv12UVRow_SSE2
+    (const uint8_t *s, uint8_t *u, uint8_t *v, int x, int width);
+static int I420Converter_packed422HalfRows_SSE2
+    (const uint8_t *const s[4], int yOffset,
+        uint8_t *y0, uint8_t *y1, uint8_t *u, uint8_t *v, int x, int width);
+static int I420Converter_packed422Rows_SSE2
+    (const uint8_t *s0, const uint8_t *s1, int yOffset,
+        uint8_t *y0, uint8_t *y1, uint8_t *u, uint8_t *v, int x, int width);
+static __m128i I420Converter_rgb32Channel_SSE2
+    (__m128i a, __m128i b, int shift);
+static int I420Converter_rgb32HalfRow_SSE2
+    (const uint32_t *s0, const uint32_t *s1, uint32_t *d, int x, int width);
+static int I420Converter_rgb32Rows_SSE2
+    (const uint32_t *s0, const uint32_t *s1,
+        uint8_t *y0, uint8_t *y1, uint8_t *u, uint8_t *v, int x, int width);
+static __m128i I420Converter_round_SSE2(__m128i sums, int shift);
+static void I420Converter_storeUV_SSE2(__m128i uv, uint8_t *u, uint8_t *v);
+static __m128i I420Converter_sumPairs_SSE2(__m128i a, __m128i b);
+static __m128i I420Converter_sumRGB32_SSE2(__m128i a, __m128i b);
+static __m128i I420Converter_sumUV_SSE2(__m128i a, __m128i b);
+#endif /* #ifdef I420CONVERTER_SSE2 */
+
+int
+I420Converter_convert
+    (int format,
+        const uint8_t *const src[], const int srcStride[],
+        int srcWidth, int srcHeight,
+        uint8_t *const dst[], const int dstStride[],
+        int dstWidth, int dstHeight)
+{
+    int half;
+
+    if ((dstWidth == srcWidth) && (dstHeight == srcHeight))
+        half = 0;
+    else if ((dstWidth * 2 == srcWidth) && (dstHeight * 2 == srcHeight))
+        half = 1;
+    else
+        return -1;
+    /* The chroma of the destination is to be subsampled exactly. */
+    if ((dstWidth < 2) || (dstHeight < 2)
+            || (dstWidth & 1) || (dstHeight & 1))
+        return -1;
+
+    switch (format)
+    {
+    case I420CONVERTER_NV12:
+        if (half)
+        {
+            I420Converter_nv12Half(
+                    src, srcStride,
+                    dst, dstStride, dstWidth, dstHeight);
+        }
+        else
+        {
+            I420Converter_nv12(
+                    src, srcStride,
+                    dst, dstStride, dstWidth, dstHeight);
+        }
+        return 0;
+    case I420CONVERTER_RGB32:
+        return
+            half
+                ? I420Converter_rgb32Half(
+                        src, srcStride,
+                        dst, dstStride, dstWidth, dstHeight)
+                : I420Converter_rgb32(
+                        src, srcStride,
+                        dst, dstStride, dstWidth, dstHeight);
+    case I420CONVERTER_UYVY:
+    case I420CONVERTER_YUYV:
+    {
+        int yOffset = (I420CONVERTER_UYVY == format) ? 1 : 0;
+
+        if (half)
+        {
+            I420Converter_packed422Half(
+                    yOffset, src, srcStride,
+                    dst, dstStride, dstWidth, dstHeight);
+        }
+        else
+        {
+            I420Converter_packed422(
+                    yOffset, src, srcStride,
+                    dst, dstStride, dstWidth, dstHeight);
+        }
+        return 0;
+    }
+    default:
+        return -1;
+    }
+}
+
+#ifdef I420CONVERTER_SSE2
+/**
+ * Averages the 2x2 blocks of bytes of 32 consecutive bytes of two rows. The
+ * 2x2 sums are computed in 16-bit lanes so that the averages are rounded
+ * exactly like the C routines round them.
+ *
+ * @param a0 the first 16 bytes of the first row
+ * @param a1 the second 16 bytes of the first row
+ * @param b0 the first 16 bytes of the second row
+ * @param b1 the second 16 bytes of the second row
+ * @return the 16 averages
+ */
+static __m128i
+I420Converter_halve_SSE2(__m128i a0, __m128i a1, __m128i b0, __m128i b1)
+{
+    return
+        _mm_packus_epi16(
+                I420Converter_round_SSE2(
+                        I420Converter_sumPairs_SSE2(a0, b0),
+                        2),
+                I420Converter_round_SSE2(
+                        I420Converter_sumPairs_SSE2(a1, b1),
+                        2));
+}
+
+/**
+ * Averages the 2x2 blocks of UV pairs of 16 consecutive interleaved UV pairs
+ * of two rows.
+ *
+ * @param a0 the first 8 UV pairs of the first row
+ * @param a1 the second 8 UV pairs of the first row
+ * @param b0 the first 8 UV pairs of the second row
+ * @param b1 the second 8 UV pairs of the second row
+ * @return the 8 averaged UV pairs
+ */
+static __m128i
+I420Converter_halveUV_SSE2(__m128i a0, __m128i a1, __m128i b0, __m128i b1)
+{
+    return
+        _mm_packus_epi16(
+                I420Converter_round_SSE2(I420Converter_sumUV_SSE2(a0, b0), 2),
+                I420Converter_round_SSE2(I420Converter_sumUV_SSE2(a1, b1), 2));
+}
+
+/**
+ * Divides 16-bit sums by a power of two, rounding half up.
+ *
+ * @param sums the 8 16-bit sums
+ * @param shift the base 2 logarithm of the divisor
+ * @return the 8 rounded quotients
+ */
+static __m128i
+I420Converter_round_SSE2(__m128i sums, int shift)
+{
+    return
+        _mm_srl_epi16(
+                _mm_add_epi16(sums, _mm_set1_epi16(1 << (shift - 1))),
+                _mm_cvtsi32_si128(shift));
+}
+
+/**
+ * Sums the 2x2 blocks of bytes of 16 consecutive bytes of two rows.
+ *
+ * @param a the 16 bytes of the first row
+ * @param b the 16 bytes of the second row
+ * @return the 8 sums in 16-bit lanes
+ */
+static __m128i
+I420Converter_sumPairs_SSE2(__m128i a, __m128i b)
+{
+    const __m128i mask = _mm_set1_epi16(0x00ff);
+
+    return
+        _mm_add_epi16(
+                _mm_add_epi16(_mm_and_si128(a, mask), _mm_srli_epi16(a, 8)),
+                _mm_add_epi16(_mm_and_si128(b, mask), _mm_srli_epi16(b, 8)));
+}
+
+/**
+ * Sums the 2x2 blocks of pixels of 4 consecutive 32-bit pixels of two rows,
+ * channel by channel.
+ *
+ * @param a the 4 pixels of the first row
+ * @param b the 4 pixels of the second row
+ * @return the channel sums of the 2 blocks in 16-bit lanes
+ */
+static __m128i
+I420Converter_sumRGB32_SSE2(__m128i a, __m128i b)
+{
+    const __m128i zero = _mm_setzero_si128();
+    __m128i lo
+        = _mm_add_epi16(
+                _mm_unpacklo_epi8(a, zero),
+                _mm_unpacklo_epi8(b, zero));
+    __m128i hi
+        = _mm_add_epi16(
+                _mm_unpackhi_epi8(a, zero),
+                _mm_unpackhi_epi8(b, zero));
+
+    return
+        _mm_unpacklo_epi64(
+                _mm_add_epi16(lo, _mm_srli_si128(lo, 8)),
+                _mm_add_epi16(hi, _mm_srli_si128(hi, 8)));
+}
+
+/**
+ * Sums the 2x2 blocks of UV pairs of 8 consecutive interleaved UV pairs of
+ * two rows.
+ *
+ * @param a the 8 UV pairs of the first row
+ * @param b the 8 UV pairs of the second row
+ * @return the 4 summed UV pairs in 16-bit lanes
+ */
+static __m128i
+I420Converter_sumUV_SSE2(__m128i a, __m128i b)
+{
+    const __m128i zero = _mm_setzero_si128();
+    __m128i lo
+        = _mm_add_epi16(
+                _mm_unpacklo_epi8(a, zero),
+                _mm_unpacklo_epi8(b, zero));
+    __m128i hi
+        = _mm_add_epi16(
+                _mm_unpackhi_epi8(a, zero),
+                _mm_unpackhi_epi8(b, zero));
+
+    /* Add the horizontally adjacent UV pairs and gather the sums. */
+    lo = _mm_add_epi16(lo, _mm_srli_epi64(lo, 32));
+    hi = _mm_add_epi16(hi, _mm_srli_epi64(hi, 32));
+    return
+        _mm_unpacklo_epi64(
+                _mm_shuffle_epi32(lo, _MM_SHUFFLE(3, 1, 2, 0)),
+                _mm_shuffle_epi32(hi, _MM_SHUFFLE(3, 1, 2, 0)));
+}
+#endif /* #ifdef I420CONVERTER_SSE2 */
+
+#ifdef I420CONVERTER_NEON
+/**
+ * Averages four vectors of bytes lane by lane. The sums are computed in
+ * 16-bit lanes so that the averages are rounded exactly like the C routines
+ * round them.
+ *
+ * @return the 16 averages
+ */
+static uint8x16_t
+I420Converter_average4_NEON
+    (uint8x16_t a, uint8x16_t b, uint8x16_t c, uint8x16_t d)
+{
+    uint16x8_t lo
+        = vaddq_u16(
+                vaddl_u8(vget_low_u8(a), vget_low_u8(b)),
+                vaddl_u8(vget_low_u8(c), vget_low_u8(d)));
+    uint16x8_t hi
+        = vaddq_u16(
+                vaddl_u8(vget_high_u8(a), vget_high_u8(b)),
+                vaddl_u8(vget_high_u8(c), vget_high_u8(d)));
+
+    return vcombine_u8(vrshrn_n_u16(lo, 2), vrshrn_n_u16(hi, 2));
+}
+
+/**
+ * Averages the 2x2 blocks of bytes of 16 consecutive bytes of two rows.
+ *
+ * @param a the 16 bytes of the first row
+ * @param b the 16 bytes of the second row
+ * @return the 8 averages
+ */
+static uint8x8_t
+I420Converter_halve_NEON(uint8x16_t a, uint8x16_t b)
+{
+    return vrshrn_n_u16(vpadalq_u8(vpaddlq_u8(a), b), 2);
+}
+#endif /* #ifdef I420CONVERTER_NEON */
+
+#ifdef I420CONVERTER_AVX2
+static int
+I420Converter_hasAVX2(void)
+{
+    static int hasAVX2 = -1;
+
+    if (hasAVX2 < 0)
+    {
+        __builtin_cpu_init();
+        hasAVX2 = __builtin_cpu_supports("avx2") ? 1 : 0;
+    }
+    return hasAVX2;
+}
+#endif /* #ifdef I420CONVERTER_AVX2 */
+
+static void
+I420Converter_nv12
+    (const uint8_t *const src[], const int srcStride[],
+        uint8_t *const dst[], const int dstStride[],
+        int width, int height)
+{
+    int chromaWidth = width / 2;
+    int y;
+
+    for (y = 0; y < height; y++)
+    {
+        memcpy(
+                dst[0] + y * dstStride[0],
+                src[0] + y * srcStride[0],
+                width);
+    }
+    for (y = 0; y < height / 2; y++)
+    {
+        const uint8_t *s = src[1] + y * srcStride[1];
+        uint8_t *u = dst[1] + y * dstStride[1];
+        uint8_t *v = dst[2] + y * dstStride[2];
+        int x = 0;
+
+#ifdef I420CONVERTER_AVX2
+        if (I420Converter_hasAVX2())
+            x = I420Converter_nv12UVRow_AVX2(s, u, v, x, chromaWidth);
+#endif
+#ifdef I420CONVERTER_SSE2
+        x = I420Converter_nv12UVRow_SSE2(s, u, v, x, chromaWidth);
+#endif
+#ifdef I420CONVERTER_NEON
+        x = I420Converter_nv12UVRow_NEON(s, u, v, x, chromaWidth);
+#endif
+        I420Converter_nv12UVRow_C(s, u, v, x, chromaWidth);
+    }
+}
+
+static void
+I420Converter_nv12Half
+    (const uint8_t *const src[], const int srcStride[],
+        uint8_t *const dst[], const int dstStride[],
+        int width, int height)
+{
+    int chromaWidth = width / 2;
+    int y;
+
+    for (y = 0; y < height; y++)
+    {
+        const uint8_t *s0 = src[0] + 2 * y * srcStride[0];
+        const uint8_t *s1 = s0 + srcStride[0];
+        uint8_t *d = dst[0] + y * dstStride[0];
+        int x = 0;
+
+#ifdef I420CONVERTER_SSE2
+        x = I420Converter_nv12HalfRows_SSE2(s0, s1, d, x, width);
+#endif
+#ifdef I420CONVERTER_NEON
+        x = I420Converter_nv12HalfRows_NEON(s0, s1, d, x, width);
+#endif
+        I420Converter_nv12HalfRows_C(s0, s1, d, x, width);
+    }
+    for (y = 0; y < height / 2; y++)
+    {
+        const uint8_t *s0 = src[1] + 2 * y * srcStride[1];
+        const uint8_t *s1 = s0 + srcStride[1];
+        uint8_t *u = dst[1] + y * dstStride[1];
+        uint8_t *v = dst[2] + y * dstStride[2];
+        int x = 0;
+
+#ifdef I420CONVERTER_SSE2
+        x = I420Converter_nv12HalfUVRows_SSE2(s0, s1, u, v, x, chromaWidth);
+#endif
+#ifdef I420CONVERTER_NEON
+        x = I420Converter_nv12HalfUVRows_NEON(s0, s1, u, v, x, chromaWidth);
+#endif
+        I420Converter_nv12HalfUVRows_C(s0, s1, u, v, x, chromaWidth);
+    }
+}
+
+static int
+I420Converter_nv12HalfRows_C
+    (const uint8_t *s0, const uint8_t *s1, uint8_t *d, int x, int width)
+{
+    for (; x < width; x++)
+    {
+        int i = 2 * x;
+
+        d[x] = (s0[i] + s0[i + 1] + s1[i] + s1[i + 1] + 2) >> 2;
+    }
+    return x;
+}
+
+#ifdef I420CONVERTER_NEON
+static int
+I420Converter_nv12HalfRows_NEON
+    (const uint8_t *s0, const uint8_t *s1, uint8_t *d, int x, int width)
+{
+    for (; x + 16 <= width; x += 16)
+    {
+        uint8x16x2_t a = vld2q_u8(s0 + 2 * x);
+        uint8x16x2_t b = vld2q_u8(s1 + 2 * x);
+
+        vst1q_u8(
+                d + x,
+                I420Converter_average4_NEON(
+                        a.val[0], a.val[1],
+                        b.val[0], b.val[1]));
+    }
+    return x;
+}
+#endif /* #ifdef I420CONVERTER_NEON */
+
+#ifdef I420CONVERTER_SSE2
+static int
+I420Converter_nv12HalfRows_SSE2
+    (const uint8_t *s0, const uint8_t *s1, uint8_t *d, int x, int width)
+{
+    for (; x + 16 <= width; x += 16)
+    {
+        const uint8_t *p0 = s0 + 2 * x;
+        const uint8_t *p1 = s1 + 2 * x;
+
+        _mm_storeu_si128(
+                (__m128i *) (d + x),
+                I420Converter_halve_SSE2(
+                        _mm_loadu_si128((const __m128i *) p0),
+                        _mm_loadu_si128((const __m128i *) (p0 + 16)),
+                        _mm_loadu_si128((const __m128i *) p1),
+                        _mm_loadu_si128((const __m128i *) (p1 + 16))));
+    }
+    return x;
+}
+#endif /* #ifdef I420CONVERTER_SSE2 */
+
+static int
+I420Converter_nv12HalfUVRows_C
+    (const uint8_t *s0, const uint8_t *s1, uint8_t *u, uint8_t *v, int x,
+        int width)
+{
+    for (; x < width; x++)
+    {
+        int i = 4 * x;
+
+        u[x] = (s0[i] + s0[i + 2] + s1[i] + s1[i + 2] + 2) >> 2;
+        v[x] = (s0[i + 1] + s0[i + 3] + s1[i + 1] + s1[i + 3] + 2) >> 2;
+    }
+    return x;
+}
+
+#ifdef I420CONVERTER_NEON
+static int
+I420Converter_nv12HalfUVRows_NEON
+    (const uint8_t *s0, const uint8_t *s1, uint8_t *u, uint8_t *v, int x,
+        int width)
+{
+    for (; x + 16 <= width; x += 16)
+    {
+        uint8x16x4_t a = vld4q_u8(s0 + 4 * x);
+        uint8x16x4_t b = vld4q_u8(s1 + 4 * x);
+
+        vst1q_u8(
+                u + x,
+                I420Converter_average4_NEON(
+                        a.val[0], a.val[2],
+                        b.val[0], b.val[2]));
+        vst1q_u8(
+                v + x,
+                I420Converter_average4_NEON(
+                        a.val[1], a.val[3],
+                        b.val[1], b.val[3]));
+    }
+    return x;
+}
+#endif /* #ifdef I420CONVERTER_NEON */
+
+#ifdef I420CONVERTER_SSE2
+static int
+I420Converter_nv12HalfUVRows_SSE2
+    (const uint8_t *s0, const uint8_t *s1, uint8_t *u, uint8_t *v, int x,
+        int width)
+{
+    for (; x + 8 <= width; x += 8)
+    {
+        const uint8_t *p0 = s0 + 4 * x;
+        const uint8_t *p1 = s1 + 4 * x;
+
+        I420Converter_storeUV_SSE2(
+                I420Converter_halveUV_SSE2(
+                        _mm_loadu_si128((const __m128i *) p0),
+                        _mm_loadu_si128((const __m128i *) (p0 + 16)),
+                        _mm_loadu_si128((const __m128i *) p1),
+                        _mm_loadu_si128((const __m128i *) (p1 + 16))),
+                u + x, v + x);
+    }
+    return x;
+}
+#endif /* #ifdef I420CONVERTER_SSE2 */
+
+#ifdef I420CONVERTER_AVX2
+__attribute__((target("avx2")))
+static int
+I420Converter_nv12UVRow_AVX2
+    (const uint8_t *s, uint8_t *u, uint8_t *v, int x, int width)
+{
+    const __m256i mask = _mm256_set1_epi16(0x00ff);
+
+    for (; x + 32 <= width; x += 32)
+    {
+        __m256i a = _mm256_loadu_si256((const __m256i *) (s + 2 * x));
+        __m256i b = _mm256_loadu_si256((const __m256i *) (s + 2 * x + 32));
+        __m256i us
+            = _mm256_packus_epi16(
+                    _mm256_and_si256(a, mask),
+                    _mm256_and_si256(b, mask));
+        __m256i vs
+            = _mm256_packus_epi16(
+                    _mm256_srli_epi16(a, 8),
+                    _mm256_srli_epi16(b, 8));
+
+        /* Undo the interleaving of the 128-bit lanes by the packing. */
+        _mm256_storeu_si256(
+                (__m256i *) (u + x),
+                _mm256_permute4x64_epi64(us, _MM_SHUFFLE(3, 1, 2, 0)));
+        _mm256_storeu_si256(
+                (__m256i *) (v + x),
+                _mm256_permute4x64_epi64(vs, _MM_SHUFFLE(3, 1, 2, 0)));
+    }
+    return x;
+}
+#endif /* #ifdef I420CONVERTER_AVX2 */
+
+static int
+I420Converter_nv12UVRow_C
+    (const uint8_t *s, uint8_t *u, uint8_t *v, int x, int width)
+{
+    for (; x < width; x++)
+    {
+        u[x] = s[2 * x];
+        v[x] = s[2 * x + 1];
+    }
+    return x;
+}
+
+#ifdef I420CONVERTER_NEON
+static int
+I420Converter_nv12UVRow_NEON
+    (const uint8_t *s, uint8_t *u, uint8_t *v, int x, int width)
+{
+    for (; x + 16 <= width; x += 16)
+    {
+        uint8x16x2_t uv = vld2q_u8(s + 2 * x);
+
+        vst1q_u8(u + x, uv.val[0]);
+        vst1q_u8(v + x, uv.val[1]);
+    }
+    return x;
+}
+#endif /* #ifdef I420CONVERTER_NEON */
+
+#ifdef I420CONVERTER_SSE2
+static int
+I420Converter_nv12UVRow_SSE2
+    (const uint8_t *s, uint8_t *u, uint8_t *v, int x, int width)
+{
+    const __m128i mask = _mm_set1_epi16(0x00ff);
+
+    for (; x + 16 <= width; x += 16)
+    {
+        __m128i a = _mm_loadu_si128((const __m128i *) (s + 2 * x));
+        __m128i b = _mm_loadu_si128((const __m128i *) (s + 2 * x + 16));
+
+        _mm_storeu_si128(
+                (__m128i *) (u + x),
+                _mm_packus_epi16(
+                        _mm_and_si128(a, mask),
+                        _mm_and_si128(b, mask)));
+        _mm_storeu_si128(
+                (__m128i *) (v + x),
+                _mm_packus_epi16(_mm_srli_epi16(a, 8), _mm_srli_epi16(b, 8)));
+    }
+    return x;
+}
+#endif /* #ifdef I420CONVERTER_SSE2 */
+
+/**
+ * Converts packed 4:2:2 YUV (i.e. YUYV or UYVY) to I420 at the same size.
+ *
+ * @param yOffset the offset of the first luma byte in a macropixel i.e.
+ * <tt>0</tt> for YUYV and <tt>1</tt> for UYVY
+ */
+static void
+I420Converter_packed422
+    (int yOffset,
+        const uint8_t *const src[], const int srcStride[],
+        uint8_t *const dst[], const int dstStride[],
+        int width, int height)
+{
+    int y;
+
+    for (y = 0; y < height; y += 2)
+    {
+        const uint8_t *s0 = src[0] + y * srcStride[0];
+        const uint8_t *s1 = s0 + srcStride[0];
+        uint8_t *y0 = dst[0] + y * dstStride[0];
+        uint8_t *y1 = y0 + dstStride[0];
+        uint8_t *u = dst[1] + (y / 2) * dstStride[1];
+        uint8_t *v = dst[2] + (y / 2) * dstStride[2];
+        int x = 0;
+
+#ifdef I420CONVERTER_AVX2
+        if (I420Converter_hasAVX2())
+        {
+            x
+                = I420Converter_packed422Rows_AVX2(
+                        s0, s1, yOffset, y0, y1, u, v, x, width);
+        }
+#endif
+#ifdef I420CONVERTER_SSE2
+        x
+            = I420Converter_packed422Rows_SSE2(
+                    s0, s1, yOffset, y0, y1, u, v, x, width);
+#endif
+#ifdef I420CONVERTER_NEON
+        x
+            = I420Converter_packed422Rows_NEON(
+                    s0, s1, yOffset, y0, y1, u, v, x, width);
+#endif
+        I420Converter_packed422Rows_C(s0, s1, yOffset, y0, y1, u, v, x, width);
+    }
+}
+
+/**
+ * Converts packed 4:2:2 YUV (i.e. YUYV or UYVY) to I420 downscaled by 2:1 in
+ * both dimensions with a box filter. Every four rows of the source produce two
+ * luma rows and one chroma row of the destination in one pass.
+ *
+ * @param yOffset the offset of the first luma byte in a macropixel i.e.
+ * <tt>0</tt> for YUYV and <tt>1</tt> for UYVY
+ */
+static void
+I420Converter_packed422Half
+    (int yOffset,
+        const uint8_t *const src[], const int srcStride[],
+        uint8_t *const dst[], const int dstStride[],
+        int width, int height)
+{
+    int y;
+
+    for (y = 0; y < height; y += 2)
+    {
+        const uint8_t *s[4];
+        uint8_t *y0 = dst[0] + y * dstStride[0];
+        uint8_t *y1 = y0 + dstStride[0];
+        uint8_t *u = dst[1] + (y / 2) * dstStride[1];
+        uint8_t *v = dst[2] + (y / 2) * dstStride[2];
+        int i;
+        int x = 0;
+
+        for (i = 0; i < 4; i++)
+            s[i] = src[0] + (2 * y + i) * srcStride[0];
+#ifdef I420CONVERTER_SSE2
+        x
+            = I420Converter_packed422HalfRows_SSE2(
+                    s, yOffset, y0, y1, u, v, x, width);
+#endif
+#ifdef I420CONVERTER_NEON
+        x
+            = I420Converter_packed422HalfRows_NEON(
+                    s, yOffset, y0, y1, u, v, x, width);
+#endif
+        I420Converter_packed422HalfRows_C(s, yOffset, y0, y1, u, v, x, width);
+    }
+}
+
+static int
+I420Converter_packed422HalfRows_C
+    (const uint8_t *const s[4], int yOffset,
+        uint8_t *y0, uint8_t *y1, uint8_t *u, uint8_t *v, int x, int width)
+{
+    int uOffset = 1 - yOffset;
+    int vOffset = 3 - yOffset;
+
+    /* A pixel of the destination is a macropixel of the source. */
+    for (; x < width; x += 2)
+    {
+        int i = 4 * x + yOffset;
+        int j = i + 4;
+        int c = 4 * x;
+
+        y0[x] = (s[0][i] + s[0][i + 2] + s[1][i] + s[1][i + 2] + 2) >> 2;
+        y0[x + 1] = (s[0][j] + s[0][j + 2] + s[1][j] + s[1][j + 2] + 2) >> 2;
+        y1[x] = (s[2][i] + s[2][i + 2] + s[3][i] + s[3][i + 2] + 2) >> 2;
+        y1[x + 1] = (s[2][j] + s[2][j + 2] + s[3][j] + s[3][j + 2] + 2) >> 2;
+        u[x / 2]
+            = (s[0][c + uOffset] + s[0][c + 4 + uOffset]
+                    + s[1][c + uOffset] + s[1][c + 4 + uOffset]
+                    + s[2][c + uOffset] + s[2][c + 4 + uOffset]
+                    + s[3][c + uOffset] + s[3][c + 4 + uOffset]
+                    + 4)
+                >> 3;
+        v[x / 2]
+            = (s[0][c + vOffset] + s[0][c + 4 + vOffset]
+                    + s[1][c + vOffset] + s[1][c + 4 + vOffset]
+                    + s[2][c + vOffset] + s[2][c + 4 + vOffset]
+                    + s[3][c + vOffset] + s[3][c + 4 + vOffset]
+                    + 4)
+                >> 3;
+    }
+    return x;
+}
+
+#ifdef I420CONVERTER_NEON
+static int
+I420Converter_packed422HalfRows_NEON
+    (const uint8_t *const s[4], int yOffset,
+        uint8_t *y0, uint8_t *y1, uint8_t *u, uint8_t *v, int x, int width)
+{
+    int y0Index = yOffset;
+    int y1Index = yOffset + 2;
+    int uIndex = 1 - yOffset;
+    int vIndex = 3 - yOffset;
+
+    for (; x + 16 <= width; x += 16)
+    {
+        uint8x16x4_t a = vld4q_u8(s[0] + 4 * x);
+        uint8x16x4_t b = vld4q_u8(s[1] + 4 * x);
+        uint8x16x4_t c = vld4q_u8(s[2] + 4 * x);
+        uint8x16x4_t d = vld4q_u8(s[3] + 4 * x);
+        uint16x8_t cu, cv;
+
+        vst1q_u8(
+                y0 + x,
+                I420Converter_average4_NEON(
+                        a.val[y0Index], a.val[y1Index],
+                        b.val[y0Index], b.val[y1Index]));
+        vst1q_u8(
+                y1 + x,
+                I420Converter_average4_NEON(
+                        c.val[y0Index], c.val[y1Index],
+                        d.val[y0Index], d.val[y1Index]));
+        /* Sum the 8 chroma samples of a destination pixel in 16 bits. */
+        cu = vpaddlq_u8(a.val[uIndex]);
+        cu = vpadalq_u8(cu, b.val[uIndex]);
+        cu = vpadalq_u8(cu, c.val[uIndex]);
+        cu = vpadalq_u8(cu, d.val[uIndex]);
+        cv = vpaddlq_u8(a.val[vIndex]);
+        cv = vpadalq_u8(cv, b.val[vIndex]);
+        cv = vpadalq_u8(cv, c.val[vIndex]);
+        cv = vpadalq_u8(cv, d.val[vIndex]);
+        vst1_u8(u + x / 2, vrshrn_n_u16(cu, 3));
+        vst1_u8(v + x / 2, vrshrn_n_u16(cv, 3));
+    }
+    return x;
+}
+#endif /* #ifdef I420CONVERTER_NEON */
+
+#ifdef I420CONVERTER_SSE2
+static int
+I420Converter_packed422HalfRows_SSE2
+    (const uint8_t *const s[4], int yOffset,
+        uint8_t *y0, uint8_t *y1, uint8_t *u, uint8_t *v, int x, int width)
+{
+    const __m128i mask = _mm_set1_epi16(0x00ff);
+
+    for (; x + 16 <= width; x += 16)
+    {
+        __m128i ys[4][2];
+        __m128i cs[4][2];
+        int i;
+
+        for (i = 0; i < 4; i++)
+        {
+            const uint8_t *p = s[i] + 4 * x;
+            __m128i q0 = _mm_loadu_si128((const __m128i *) p);
+            __m128i q1 = _mm_loadu_si128((const __m128i *) (p + 16));
+            __m128i q2 = _mm_loadu_si128((const __m128i *) (p + 32));
+            __m128i q3 = _mm_loadu_si128((const __m128i *) (p + 48));
+
+            if (yOffset)
+            {
+                ys[i][0]
+                    = _mm_packus_epi16(
+                            _mm_srli_epi16(q0, 8),
+                            _mm_srli_epi16(q1, 8));
+                ys[i][1]
+                    = _mm_packus_epi16(
+                            _mm_srli_epi16(q2, 8),
+                            _mm_srli_epi16(q3, 8));
+                cs[i][0]
+                    = _mm_packus_epi16(
+                            _mm_and_si128(q0, mask),
+                            _mm_and_si128(q1, mask));
+                cs[i][1]
+                    = _mm_packus_epi16(
+                            _mm_and_si128(q2, mask),
+                            _mm_and_si128(q3, mask));
+            }
+            else
+            {
+                ys[i][0]
+                    = _mm_packus_epi16(
+                            _mm_and_si128(q0, mask),
+                            _mm_and_si128(q1, mask));
+                ys[i][1]
+                    = _mm_packus_epi16(
+                            _mm_and_si128(q2, mask),
+                            _mm_and_si128(q3, mask));
+                cs[i][0]
+                    = _mm_packus_epi16(
+                            _mm_srli_epi16(q0, 8),
+                            _mm_srli_epi16(q1, 8));
+                cs[i][1]
+                    = _mm_packus_epi16(
+                            _mm_srli_epi16(q2, 8),
+                            _mm_srli_epi16(q3, 8));
+            }
+        }
+
+        _mm_storeu_si128(
+                (__m128i *) (y0 + x),
+                I420Converter_halve_SSE2(
+                        ys[0][0], ys[0][1],
+                        ys[1][0], ys[1][1]));
+        _mm_storeu_si128(
+                (__m128i *) (y1 + x),
+                I420Converter_halve_SSE2(
+                        ys[2][0], ys[2][1],
+                        ys[3][0], ys[3][1]));
+        /* Sum the 8 chroma samples of a destination pixel in 16 bits. */
+        I420Converter_storeUV_SSE2(
+                _mm_packus_epi16(
+                        I420Converter_round_SSE2(
+                                _mm_add_epi16(
+                                        I420Converter_sumUV_SSE2(
+                                                cs[0][0], cs[1][0]),
+                                        I420Converter_sumUV_SSE2(
+                                                cs[2][0], cs[3][0])),
+                                3),
+                        I420Converter_round_SSE2(
+                                _mm_add_epi16(
+                                        I420Converter_sumUV_SSE2(
+                                                cs[0][1], cs[1][1]),
+                                        I420Converter_sumUV_SSE2(
+                                                cs[2][1], cs[3][1])),
+                                3)),
+                u + x / 2, v + x / 2);
+    }
+    return x;
+}
+#endif /* #ifdef I420CONVERTER_SSE2 */
+
+#ifdef I420CONVERTER_AVX2
+__attribute__((target("avx2")))
+static int
+I420Converter_packed422Rows_AVX2
+    (const uint8_t *s0, const uint8_t *s1, int yOffset,
+        uint8_t *y0, uint8_t *y1, uint8_t *u, uint8_t *v, int x, int width)
+{
+    const __m256i mask = _mm256_set1_epi16(0x00ff);
+
+    for (; x + 32 <= width; x += 32)
+    {
+        __m256i a0 = _mm256_loadu_si256((const __m256i *) (s0 + 2 * x));
+        __m256i a1 = _mm256_loadu_si256((const __m256i *) (s0 + 2 * x + 32));
+        __m256i b0 = _mm256_loadu_si256((const __m256i *) (s1 + 2 * x));
+        __m256i b1 = _mm256_loadu_si256((const __m256i *) (s1 + 2 * x + 32));
+        __m256i ya, yb, ca, cb, c;
+
+        if (yOffset)
+        {
+            ya
+                = _mm256_packus_epi16(
+                        _mm256_srli_epi16(a0, 8),
+                        _mm256_srli_epi16(a1, 8));
+            yb
+                = _mm256_packus_epi16(
+                        _mm256_srli_epi16(b0, 8),
+                        _mm256_srli_epi16(b1, 8));
+            ca
+                = _mm256_packus_epi16(
+                        _mm256_and_si256(a0, mask),
+                        _mm256_and_si256(a1, mask));
+            cb
+                = _mm256_packus_epi16(
+                        _mm256_and_si256(b0, mask),
+                        _mm256_and_si256(b1, mask));
+        }
+        else
+        {
+            ya
+                = _mm256_packus_epi16(
+                        _mm256_and_si256(a0, mask),
+                        _mm256_and_si256(a1, mask));
+            yb
+                = _mm256_packus_epi16(
+                        _mm256_and_si256(b0, mask),
+                        _mm256_and_si256(b1, mask));
+            ca
+                = _mm256_packus_epi16(
+                        _mm256_srli_epi16(a0, 8),
+                        _mm256_srli_epi16(a1, 8));
+            cb
+                = _mm256_packus_epi16(
+                        _mm256_srli_epi16(b0, 8),
+                        _mm256_srli_epi16(b1, 8));
+        }
+
+        /* Undo the interleaving of the 128-bit lanes by the packing. */
+        _mm256_storeu_si256(
+                (__m256i *) (y0 + x),
+                _mm256_permute4x64_epi64(ya, _MM_SHUFFLE(3, 1, 2, 0)));
+        _mm256_storeu_si256(
+                (__m256i *) (y1 + x),
+                _mm256_permute4x64_epi64(yb, _MM_SHUFFLE(3, 1, 2, 0)));
+        c
+            = _mm256_permute4x64_epi64(
+                    _mm256_avg_epu8(ca, cb),
+                    _MM_SHUFFLE(3, 1, 2, 0));
+        c
+            = _mm256_permute4x64_epi64(
+                    _mm256_packus_epi16(
+                            _mm256_and_si256(c, mask),
+                            _mm256_srli_epi16(c, 8)),
+                    _MM_SHUFFLE(3, 1, 2, 0));
+        _mm_storeu_si128((__m128i *) (u + x / 2), _mm256_castsi256_si128(c));
+        _mm_storeu_si128(
+                (__m128i *) (v + x / 2),
+                _mm256_extracti128_si256(c, 1));
+    }
+    return x;
+}
+#endif /* #ifdef I420CONVERTER_AVX2 */
+
+static int
+I420Converter_packed422Rows_C
+    (const uint8_t *s0, const uint8_t *s1, int yOffset,
+        uint8_t *y0, uint8_t *y1, uint8_t *u, uint8_t *v, int x, int width)
+{
+    int uOffset = 1 - yOffset;
+    int vOffset = 3 - yOffset;
+
+    for (; x < width; x += 2)
+    {
+        const uint8_t *p0 = s0 + 2 * x;
+        const uint8_t *p1 = s1 + 2 * x;
+
+        y0[x] = p0[yOffset];
+        y0[x + 1] = p0[yOffset + 2];
+        y1[x] = p1[yOffset];
+        y1[x + 1] = p1[yOffset + 2];
+        u[x / 2] = (p0[uOffset] + p1[uOffset] + 1) >> 1;
+        v[x / 2] = (p0[vOffset] + p1[vOffset] + 1) >> 1;
+    }
+    return x;
+}
+
+#ifdef I420CONVERTER_NEON
+static int
+I420Converter_packed422Rows_NEON
+    (const uint8_t *s0, const uint8_t *s1, int yOffset,
+        uint8_t *y0, uint8_t *y1, uint8_t *u, uint8_t *v, int x, int width)
+{
+    int uIndex = 1 - yOffset;
+    int vIndex = 3 - yOffset;
+
+    for (; x + 32 <= width; x += 32)
+    {
+        uint8x16x4_t a = vld4q_u8(s0 + 2 * x);
+        uint8x16x4_t b = vld4q_u8(s1 + 2 * x);
+        uint8x16x2_t ya, yb;
+
+        ya.val[0] = a.val[yOffset];
+        ya.val[1] = a.val[yOffset + 2];
+        yb.val[0] = b.val[yOffset];
+        yb.val[1] = b.val[yOffset + 2];
+        vst2q_u8(y0 + x, ya);
+        vst2q_u8(y1 + x, yb);
+        vst1q_u8(u + x / 2, vrhaddq_u8(a.val[uIndex], b.val[uIndex]));
+        vst1q_u8(v + x / 2, vrhaddq_u8(a.val[vIndex], b.val[vIndex]));
+    }
+    return x;
+}
+#endif /* #ifdef I420CONVERTER_NEON */
+
+#ifdef I420CONVERTER_SSE2
+static int
+I420Converter_packed422Rows_SSE2
+    (const uint8_t *s0, const uint8_t *s1, int yOffset,
+        uint8_t *y0, uint8_t *y1, uint8_t *u, uint8_t *v, int x, int width)
+{
+    const __m128i mask = _mm_set1_epi16(0x00ff);
+
+    for (; x + 16 <= width; x += 16)
+    {
+        __m128i a0 = _mm_loadu_si128((const __m128i *) (s0 + 2 * x));
+        __m128i a1 = _mm_loadu_si128((const __m128i *) (s0 + 2 * x + 16));
+        __m128i b0 = _mm_loadu_si128((const __m128i *) (s1 + 2 * x));
+        __m128i b1 = _mm_loadu_si128((const __m128i *) (s1 + 2 * x + 16));
+        __m128i ya, yb, ca, cb;
+
+        if (yOffset)
+        {
+            ya = _mm_packus_epi16(_mm_srli_epi16(a0, 8), _mm_srli_epi16(a1, 8));
+            yb = _mm_packus_epi16(_mm_srli_epi16(b0, 8), _mm_srli_epi16(b1, 8));
+            ca
+                = _mm_packus_epi16(
+                        _mm_and_si128(a0, mask),
+                        _mm_and_si128(a1, mask));
+            cb
+                = _mm_packus_epi16(
+                        _mm_and_si128(b0, mask),
+                        _mm_and_si128(b1, mask));
+        }
+        else
+        {
+            ya
+                = _mm_packus_epi16(
+                        _mm_and_si128(a0, mask),
+                        _mm_and_si128(a1, mask));
+            yb
+                = _mm_packus_epi16(
+                        _mm_and_si128(b0, mask),
+                        _mm_and_si128(b1, mask));
+            ca = _mm_packus_epi16(_mm_srli_epi16(a0, 8), _mm_srli_epi16(a1, 8));
+            cb = _mm_packus_epi16(_mm_srli_epi16(b0, 8), _mm_srli_epi16(b1, 8));
+        }
+        _mm_storeu_si128((__m128i *) (y0 + x), ya);
+        _mm_storeu_si128((__m128i *) (y1 + x), yb);
+        I420Converter_storeUV_SSE2(_mm_avg_epu8(ca, cb), u + x / 2, v + x / 2);
+    }
+    return x;
+}
+#endif /* #ifdef I420CONVERTER_SSE2 */
+
+static int
+I420Converter_rgb32
+    (const uint8_t *const src[], const int srcStride[],
+        uint8_t *const dst[], const int dstStride[],
+        int width, int height)
+{
+    int y;
+
+    for (y = 0; y < height; y += 2)
+    {
+        const uint8_t *s0 = src[0] + y * srcStride[0];
+        uint8_t *y0 = dst[0] + y * dstStride[0];
+
+        I420Converter_rgb32RowPair(
+                (const uint32_t *) s0,
+                (const uint32_t *) (s0 + srcStride[0]),
+                y0,
+                y0 + dstStride[0],
+                dst[1] + (y / 2) * dstStride[1],
+                dst[2] + (y / 2) * dstStride[2],
+                width);
+    }
+    return 0;
+}
+
+/**
+ * Converts packed 32-bit RGB to I420 downscaled by 2:1 in both dimensions.
+ * Every four rows of the source are box-filtered into two rows of a small
+ * scratch buffer which are then converted while still in the cache.
+ */
+static int
+I420Converter_rgb32Half
+    (const uint8_t *const src[], const int srcStride[],
+        uint8_t *const dst[], const int dstStride[],
+        int width, int height)
+{
+    uint32_t *rows = malloc(2 * width * sizeof(uint32_t));
+    int y;
+
+    if (!rows)
+        return -1;
+    for (y = 0; y < height; y += 2)
+    {
+        int i;
+        uint8_t *y0 = dst[0] + y * dstStride[0];
+
+        for (i = 0; i < 2; i++)
+        {
+            const uint8_t *s0 = src[0] + (2 * y + 2 * i) * srcStride[0];
+            const uint32_t *r0 = (const uint32_t *) s0;
+            const uint32_t *r1 = (const uint32_t *) (s0 + srcStride[0]);
+            uint32_t *d = rows + i * width;
+            int x = 0;
+
+#ifdef I420CONVERTER_SSE2
+            x = I420Converter_rgb32HalfRow_SSE2(r0, r1, d, x, width);
+#endif
+#ifdef I420CONVERTER_NEON
+            x = I420Converter_rgb32HalfRow_NEON(r0, r1, d, x, width);
+#endif
+            I420Converter_rgb32HalfRow_C(r0, r1, d, x, width);
+        }
+        I420Converter_rgb32RowPair(
+                rows,
+                rows + width,
+                y0,
+                y0 + dstStride[0],
+                dst[1] + (y / 2) * dstStride[1],
+                dst[2] + (y / 2) * dstStride[2],
+                width);
+    }
+    free(rows);
+    return 0;
+}
+
+static int
+I420Converter_rgb32HalfRow_C
+    (const uint32_t *s0, const uint32_t *s1, uint32_t *d, int x, int width)
+{
+    for (; x < width; x++)
+    {
+        uint32_t p00 = s0[2 * x];
+        uint32_t p01 = s0[2 * x + 1];
+        uint32_t p10 = s1[2 * x];
+        uint32_t p11 = s1[2 * x + 1];
+        uint32_t p = 0;
+        int shift;
+
+        for (shift = 0; shift < 32; shift += 8)
+        {
+            uint32_t c
+                = (((p00 >> shift) & 0xff) + ((p01 >> shift) & 0xff)
+                        + ((p10 >> shift) & 0xff) + ((p11 >> shift) & 0xff)
+                        + 2)
+                    >> 2;
+
+            p |= c << shift;
+        }
+        d[x] = p;
+    }
+    return x;
+}
+
+#ifdef I420CONVERTER_NEON
+static int
+I420Converter_rgb32HalfRow_NEON
+    (const uint32_t *s0, const uint32_t *s1, uint32_t *d, int x, int width)
+{
+    for (; x + 8 <= width; x += 8)
+    {
+        uint8x16x4_t a = vld4q_u8((const uint8_t *) (s0 + 2 * x));
+        uint8x16x4_t b = vld4q_u8((const uint8_t *) (s1 + 2 * x));
+        uint8x8x4_t p;
+        int i;
+
+        for (i = 0; i < 4; i++)
+            p.val[i] = I420Converter_halve_NEON(a.val[i], b.val[i]);
+        vst4_u8((uint8_t *) (d + x), p);
+    }
+    return x;
+}
+#endif /* #ifdef I420CONVERTER_NEON */
+
+#ifdef I420CONVERTER_SSE2
+static int
+I420Converter_rgb32HalfRow_SSE2
+    (const uint32_t *s0, const uint32_t *s1, uint32_t *d, int x, int width)
+{
+    for (; x + 4 <= width; x += 4)
+    {
+        __m128i a
+            = I420Converter_sumRGB32_SSE2(
+                    _mm_loadu_si128((const __m128i *) (s0 + 2 * x)),
+                    _mm_loadu_si128((const __m128i *) (s1 + 2 * x)));
+        __m128i b
+            = I420Converter_sumRGB32_SSE2(
+                    _mm_loadu_si128((const __m128i *) (s0 + 2 * x + 4)),
+                    _mm_loadu_si128((const __m128i *) (s1 + 2 * x + 4)));
+
+        _mm_storeu_si128(
+                (__m128i *) (d + x),
+                _mm_packus_epi16(
+                        I420Converter_round_SSE2(a, 2),
+                        I420Converter_round_SSE2(b, 2)));
+    }
+    return x;
+}
+
+static __m128i
+I420Converter_rgb32Channel_SSE2(__m128i a, __m128i b, int shift)
+{
+    const __m128i mask = _mm_set1_epi32(0xff);
+
+    __m128i count = _mm_cvtsi32_si128(shift);
+
+    return
+        _mm_packs_epi32(
+                _mm_and_si128(_mm_srl_epi32(a, count), mask),
+                _mm_and_si128(_mm_srl_epi32(b, count), mask));
+}
+#endif /* #ifdef I420CONVERTER_SSE2 */
+
+static void
+I420Converter_rgb32RowPair
+    (const uint32_t *s0, const uint32_t *s1,
+        uint8_t *y0, uint8_t *y1, uint8_t *u, uint8_t *v, int width)
+{
+    int x = 0;
+
+#ifdef I420CONVERTER_SSE2
+    x = I420Converter_rgb32Rows_SSE2(s0, s1, y0, y1, u, v, x, width);
+#endif
+#ifdef I420CONVERTER_NEON
+    x = I420Converter_rgb32Rows_NEON(s0, s1, y0, y1, u, v, x, width);
+#endif
+    I420Converter_rgb32Rows_C(s0, s1, y0, y1, u, v, x, width);
+}
+
+static int
+I420Converter_rgb32Rows_C
+    (const uint32_t *s0, const uint32_t *s1,
+        uint8_t *y0, uint8_t *y1, uint8_t *u, uint8_t *v, int x, int width)
+{
+    for (; x < width; x += 2)
+    {
+        uint32_t p[4];
+        int r = 2, g = 2, b = 2;
+        int i;
+
+        p[0] = s0[x];
+        p[1] = s0[x + 1];
+        p[2] = s1[x];
+        p[3] = s1[x + 1];
+        for (i = 0; i < 4; i++)
+        {
+            int pr = (p[i] >> 16) & 0xff;
+            int pg = (p[i] >> 8) & 0xff;
+            int pb = p[i] & 0xff;
+
+            ((i < 2) ? y0 : y1)[x + (i & 1)]
+                = I420CONVERTER_RGB_TO_Y(pr, pg, pb);
+            r += pr;
+            g += pg;
+            b += pb;
+        }
+        r >>= 2;
+        g >>= 2;
+        b >>= 2;
+        u[x / 2] = I420CONVERTER_RGB_TO_U(r, g, b);
+        v[x / 2] = I420CONVERTER_RGB_TO_V(r, g, b);
+    }
+    return x;
+}
+
+#ifdef I420CONVERTER_NEON
+static int
+I420Converter_rgb32Rows_NEON
+    (const uint32_t *s0, const uint32_t *s1,
+        uint8_t *y0, uint8_t *y1, uint8_t *u, uint8_t *v, int x, int width)
+{
+    for (; x + 16 <= width; x += 16)
+    {
+        /* Little endian 0xAARRGGBB is B, G, R, A in memory. */
+        uint8x16x4_t a = vld4q_u8((const uint8_t *) (s0 + x));
+        uint8x16x4_t b = vld4q_u8((const uint8_t *) (s1 + x));
+        uint8x16x4_t *rows[2];
+        uint8_t *ys[2];
+        int16x8_t r, g, bl, cu, cv;
+        int i;
+
+        rows[0] = &a;
+        rows[1] = &b;
+        ys[0] = y0;
+        ys[1] = y1;
+        for (i = 0; i < 2; i++)
+        {
+            uint8x16x4_t *p = rows[i];
+            uint16x8_t lo, hi;
+
+            lo = vmull_u8(vget_low_u8(p->val[2]), vdup_n_u8(66));
+            lo = vmlal_u8(lo, vget_low_u8(p->val[1]), vdup_n_u8(129));
+            lo = vmlal_u8(lo, vget_low_u8(p->val[0]), vdup_n_u8(25));
+            hi = vmull_u8(vget_high_u8(p->val[2]), vdup_n_u8(66));
+            hi = vmlal_u8(hi, vget_high_u8(p->val[1]), vdup_n_u8(129));
+            hi = vmlal_u8(hi, vget_high_u8(p->val[0]), vdup_n_u8(25));
+            vst1q_u8(
+                    ys[i] + x,
+                    vaddq_u8(
+                            vcombine_u8(
+                                    vrshrn_n_u16(lo, 8),
+                                    vrshrn_n_u16(hi, 8)),
+                            vdupq_n_u8(16)));
+        }
+
+        r
+            = vreinterpretq_s16_u16(
+                    vrshrq_n_u16(
+                            vaddq_u16(
+                                    vpaddlq_u8(a.val[2]),
+                                    vpaddlq_u8(b.val[2])),
+                            2));
+        g
+            = vreinterpretq_s16_u16(
+                    vrshrq_n_u16(
+                            vaddq_u16(
+                                    vpaddlq_u8(a.val[1]),
+                                    vpaddlq_u8(b.val[1])),
+                            2));
+        bl
+            = vreinterpretq_s16_u16(
+                    vrshrq_n_u16(
+                            vaddq_u16(
+                                    vpaddlq_u8(a.val[0]),
+                                    vpaddlq_u8(b.val[0])),
+                            2));
+        cu = vmulq_n_s16(r, -38);
+        cu = vmlaq_n_s16(cu, g, -74);
+        cu = vmlaq_n_s16(cu, bl, 112);
+        cv = vmulq_n_s16(r, 112);
+        cv = vmlaq_n_s16(cv, g, -94);
+        cv = vmlaq_n_s16(cv, bl, -18);
+        vst1_u8(
+                u + x / 2,
+                vqmovun_s16(
+                        vaddq_s16(vrshrq_n_s16(cu, 8), vdupq_n_s16(128))));
+        vst1_u8(
+                v + x / 2,
+                vqmovun_s16(
+                        vaddq_s16(vrshrq_n_s16(cv, 8), vdupq_n_s16(128))));
+    }
+    return x;
+}
+#endif /* #ifdef I420CONVERTER_NEON */
+
+#ifdef I420CONVERTER_SSE2
+static int
+I420Converter_rgb32Rows_SSE2
+    (const uint32_t *s0, const uint32_t *s1,
+        uint8_t *y0, uint8_t *y1, uint8_t *u, uint8_t *v, int x, int width)
+{
+    const __m128i ones = _mm_set1_epi16(1);
+
+    for (; x + 8 <= width; x += 8)
+    {
+        __m128i a0 = _mm_loadu_si128((const __m128i *) (s0 + x));
+        __m128i a1 = _mm_loadu_si128((const __m128i *) (s0 + x + 4));
+        __m128i b0 = _mm_loadu_si128((const __m128i *) (s1 + x));
+        __m128i b1 = _mm_loadu_si128((const __m128i *) (s1 + x + 4));
+        __m128i ra = I420Converter_rgb32Channel_SSE2(a0, a1, 16);
+        __m128i ga = I420Converter_rgb32Channel_SSE2(a0, a1, 8);
+        __m128i ba = I420Converter_rgb32Channel_SSE2(a0, a1, 0);
+        __m128i rb = I420Converter_rgb32Channel_SSE2(b0, b1, 16);
+        __m128i gb = I420Converter_rgb32Channel_SSE2(b0, b1, 8);
+        __m128i bb = I420Converter_rgb32Channel_SSE2(b0, b1, 0);
+        __m128i ya, yb, ys, r, g, b, cu, cv, c;
+        int32_t uv;
+
+        /* The sums fit in unsigned 16 bits so the products may wrap. */
+        ya
+            = _mm_add_epi16(
+                    _mm_add_epi16(
+                            _mm_mullo_epi16(ra, _mm_set1_epi16(66)),
+                            _mm_mullo_epi16(ga, _mm_set1_epi16(129))),
+                    _mm_add_epi16(
+                            _mm_mullo_epi16(ba, _mm_set1_epi16(25)),
+                            _mm_set1_epi16(128)));
+        ya = _mm_add_epi16(_mm_srli_epi16(ya, 8), _mm_set1_epi16(16));
+        yb
+            = _mm_add_epi16(
+                    _mm_add_epi16(
+                            _mm_mullo_epi16(rb, _mm_set1_epi16(66)),
+                            _mm_mullo_epi16(gb, _mm_set1_epi16(129))),
+                    _mm_add_epi16(
+                            _mm_mullo_epi16(bb, _mm_set1_epi16(25)),
+                            _mm_set1_epi16(128)));
+        yb = _mm_add_epi16(_mm_srli_epi16(yb, 8), _mm_set1_epi16(16));
+        ys = _mm_packus_epi16(ya, yb);
+        _mm_storel_epi64((__m128i *) (y0 + x), ys);
+        _mm_storel_epi64((__m128i *) (y1 + x), _mm_srli_si128(ys, 8));
+
+        /* Average the 2x2 blocks i.e. sum the rows and the adjacent pairs. */
+        r = _mm_madd_epi16(_mm_add_epi16(ra, rb), ones);
+        g = _mm_madd_epi16(_mm_add_epi16(ga, gb), ones);
+        b = _mm_madd_epi16(_mm_add_epi16(ba, bb), ones);
+        r = _mm_srli_epi32(_mm_add_epi32(r, _mm_set1_epi32(2)), 2);
+        g = _mm_srli_epi32(_mm_add_epi32(g, _mm_set1_epi32(2)), 2);
+        b = _mm_srli_epi32(_mm_add_epi32(b, _mm_set1_epi32(2)), 2);
+        r = _mm_packs_epi32(r, r);
+        g = _mm_packs_epi32(g, g);
+        b = _mm_packs_epi32(b, b);
+        cu
+            = _mm_add_epi16(
+                    _mm_add_epi16(
+                            _mm_mullo_epi16(r, _mm_set1_epi16(-38)),
+                            _mm_mullo_epi16(g, _mm_set1_epi16(-74))),
+                    _mm_add_epi16(
+                            _mm_mullo_epi16(b, _mm_set1_epi16(112)),
+                            _mm_set1_epi16(128)));
+        cu = _mm_add_epi16(_mm_srai_epi16(cu, 8), _mm_set1_epi16(128));
+        cv
+            = _mm_add_epi16(
+                    _mm_add_epi16(
+                            _mm_mullo_epi16(r, _mm_set1_epi16(112)),
+                            _mm_mullo_epi16(g, _mm_set1_epi16(-94))),
+                    _mm_add_epi16(
+                            _mm_mullo_epi16(b, _mm_set1_epi16(-18)),
+                            _mm_set1_epi16(128)));
+        cv = _mm_add_epi16(_mm_srai_epi16(cv, 8), _mm_set1_epi16(128));
+        c = _mm_packus_epi16(cu, cv);
+        uv = _mm_cvtsi128_si32(c);
+        memcpy(u + x / 2, &uv, sizeof(uv));
+        uv = _mm_cvtsi128_si32(_mm_srli_si128(c, 8));
+        memcpy(v + x / 2, &uv, sizeof(uv));
+    }
+    return x;
+}
+
+/**
+ * Stores 8 interleaved UV pairs into the U and V planes.
+ *
+ * @param uv the 8 interleaved UV pairs
+ * @param u the U plane to store 8 bytes into
+ * @param v the V plane to store 8 bytes into
+ */
+static void
+I420Converter_storeUV_SSE2(__m128i uv, uint8_t *u, uint8_t *v)
+{
+    const __m128i mask = _mm_set1_epi16(0x00ff);
+
+    uv = _mm_packus_epi16(_mm_and_si128(uv, mask), _mm_srli_epi16(uv, 8));
+    _mm_storel_epi64((__m128i *) u, uv);
+    _mm_storel_epi64((__m128i *) v, _mm_srli_si128(uv, 8));
+}
+#endif /* #ifdef I420CONVERTER_SSE2 */
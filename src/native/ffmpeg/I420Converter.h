@@ -0,0 +1,64 @@
+/*
+ * Jitsi, the OpenSource Java VoIP and Instant Messaging client.
+ *
+ * Distributable under LGPL license.
+ * See terms of license at gnu.org.
+ */
+
+#ifndef _ORG_JITSI_IMPL_NEOMEDIA_CODEC_I420CONVERTER_H_
+#define _ORG_JITSI_IMPL_NEOMEDIA_CODEC_I420CONVERTER_H_
+
+#include <stdint.h>
+
+/** The source is NV12 i.e. a Y plane and an interleaved UV plane. */
+#define I420CONVERTER_NV12 1
+
+/**
+ * The source is packed 32-bit RGB in native endianness i.e.
+ * <tt>0xAARRGGBB</tt> when read as an <tt>uint32_t</tt>.
+ */
+#define I420CONVERTER_RGB32 2
+
+/** The source is packed 4:2:2 YUV in the order U Y0 V Y1. */
+#define I420CONVERTER_UYVY 3
+
+/** The source is packed 4:2:2 YUV in the order Y0 U Y1 V. */
+#define I420CONVERTER_YUYV 4
+
+/*
+ * The integer approximations of the ITU-R BT.601 conversion from full-range
+ * RGB to limited-range YUV.
+ */
+#define I420CONVERTER_RGB_TO_Y(r, g, b) \
+    ((((66 * (r)) + (129 * (g)) + (25 * (b)) + 128) >> 8) + 16)
+#define I420CONVERTER_RGB_TO_U(r, g, b) \
+    ((((-38 * (r)) - (74 * (g)) + (112 * (b)) + 128) >> 8) + 128)
+#define I420CONVERTER_RGB_TO_V(r, g, b) \
+    ((((112 * (r)) - (94 * (g)) - (18 * (b)) + 128) >> 8) + 128)
+
+/**
+ * Converts a picture in one of the <tt>I420CONVERTER_XXX</tt> formats to I420
+ * (i.e. planar YUV 4:2:0) either at the same size or downscaled by 2:1 in both
+ * dimensions, using SSE2/AVX2 or NEON where available.
+ *
+ * @param format the <tt>I420CONVERTER_XXX</tt> format of the source
+ * @param src the planes of the source (only <tt>NV12</tt> has a second one)
+ * @param srcStride the strides in bytes of the planes of the source
+ * @param srcWidth the width in pixels of the source
+ * @param srcHeight the height in pixels of the source
+ * @param dst the Y, U and V planes of the destination
+ * @param dstStride the strides in bytes of the planes of the destination
+ * @param dstWidth the width in pixels of the destination
+ * @param dstHeight the height in pixels of the destination
+ * @return <tt>0</tt> if the picture has been converted; <tt>-1</tt> if the
+ * conversion is not supported (e.g. odd sizes or a scale other than 1:1 or
+ * 2:1) and is to be carried out by a generic scaler
+ */
+int I420Converter_convert
+    (int format,
+        const uint8_t *const src[], const int srcStride[],
+        int srcWidth, int srcHeight,
+        uint8_t *const dst[], const int dstStride[],
+        int dstWidth, int dstHeight);
+
+#endif /* #ifndef _ORG_JITSI_IMPL_NEOMEDIA_CODEC_I420CONVERTER_H_ */
@@ -0,0 +1,147 @@
+/*
+ * Jitsi, the OpenSource Java VoIP and Instant Messaging client.
+ *
+ * Distributable under LGPL license.
+ * See terms of license at gnu.org.
+ */
+
+#include "MJPEGDecoder.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <libavcodec/avcodec.h>
+#include <libswscale/swscale.h>
+
+/**
+ * Represents a context of <tt>MJPEGDecoder_ffmpeg</tt> i.e. an FFmpeg MJPEG
+ * decoder and the scaler which converts its output into I420.
+ */
+typedef struct _MJPEGDecoderContext
+{
+    AVCodecContext *avctx;
+    AVFrame *avframe;
+    struct SwsContext *sws;
+} MJPEGDecoderContext;
+
+static void *MJPEGDecoder_alloc(void);
+static int MJPEGDecoder_decode(void *ctx, const uint8_t *src, int srcLength, uint8_t *const dst[], const int dstStride[], int dstWidth, int dstHeight);
+static void MJPEGDecoder_free(void *ctx);
+
+const MJPEGDecoder MJPEGDecoder_ffmpeg
+    = { MJPEGDecoder_alloc, MJPEGDecoder_decode, MJPEGDecoder_free };
+
+static void *
+MJPEGDecoder_alloc(void)
+{
+    MJPEGDecoderContext *ctx = calloc(1, sizeof(MJPEGDecoderContext));
+    AVCodec *codec;
+
+    if (!ctx)
+        return NULL;
+    codec = avcodec_find_decoder(CODEC_ID_MJPEG);
+    if (!codec)
+        goto error;
+    ctx->avctx = avcodec_alloc_context3(codec);
+    if (!(ctx->avctx))
+        goto error;
+    ctx->avctx->workaround_bugs = FF_BUG_AUTODETECT;
+    if (avcodec_open2(ctx->avctx, codec, NULL) < 0)
+    {
+        av_free(ctx->avctx);
+        ctx->avctx = NULL;
+        goto error;
+    }
+    ctx->avframe = avcodec_alloc_frame();
+    if (!(ctx->avframe))
+        goto error;
+    return ctx;
+
+error:
+    MJPEGDecoder_free(ctx);
+    return NULL;
+}
+
+static int
+MJPEGDecoder_decode
+    (void *ctx,
+        const uint8_t *src, int srcLength,
+        uint8_t *const dst[], const int dstStride[],
+        int dstWidth, int dstHeight)
+{
+    MJPEGDecoderContext *ctx_ = (MJPEGDecoderContext *) ctx;
+    AVFrame *avframe = ctx_->avframe;
+    AVPacket avpkt;
+    int gotPicture = 0;
+    int width, height;
+
+    av_init_packet(&avpkt);
+    avpkt.data = (uint8_t *) src;
+    avpkt.size = srcLength;
+    if ((avcodec_decode_video2(ctx_->avctx, avframe, &gotPicture, &avpkt) < 0)
+            || !gotPicture)
+        return -1;
+
+    width = ctx_->avctx->width;
+    height = ctx_->avctx->height;
+    if ((PIX_FMT_YUV420P == ctx_->avctx->pix_fmt)
+            && (width == dstWidth)
+            && (height == dstHeight))
+    {
+        int plane;
+
+        for (plane = 0; plane < 3; plane++)
+        {
+            int planeWidth = plane ? ((width + 1) / 2) : width;
+            int planeHeight = plane ? ((height + 1) / 2) : height;
+            int y;
+
+            for (y = 0; y < planeHeight; y++)
+            {
+                memcpy(
+                    dst[plane] + y * dstStride[plane],
+                    avframe->data[plane] + y * avframe->linesize[plane],
+                    planeWidth);
+            }
+        }
+    }
+    else
+    {
+        /*
+         * Cameras produce full-range YUVJ422P/YUVJ420P which swscale converts
+         * to the limited range that the encoders expect.
+         */
+        ctx_->sws
+            = sws_getCachedContext(
+                ctx_->sws,
+                width, height, ctx_->avctx->pix_fmt,
+                dstWidth, dstHeight, PIX_FMT_YUV420P,
+                SWS_BICUBIC,
+                NULL, NULL, NULL);
+        if (!(ctx_->sws))
+            return -1;
+        sws_scale(
+            ctx_->sws,
+            (const uint8_t * const *) avframe->data, avframe->linesize,
+            0, height,
+            (uint8_t **) dst, (int *) dstStride);
+    }
+    return 0;
+}
+
+static void
+MJPEGDecoder_free(void *ctx)
+{
+    MJPEGDecoderContext *ctx_ = (MJPEGDecoderContext *) ctx;
+
+    if (ctx_->avctx)
+    {
+        avcodec_close(ctx_->avctx);
+        av_free(ctx_->avctx);
+    }
+    if (ctx_->avframe)
+        avcodec_free_frame(&(ctx_->avframe));
+    if (ctx_->sws)
+        sws_freeContext(ctx_->sws);
+    free(ctx_);
+}
@@ -0,0 +1,66 @@
+/*
+ * Jitsi, the OpenSource Java VoIP and Instant Messaging client.
+ *
+ * Distributable under LGPL license.
+ * See terms of license at gnu.org.
+ */
+
+#ifndef _ORG_JITSI_IMPL_NEOMEDIA_CODEC_MJPEGDECODER_H_
+#define _ORG_JITSI_IMPL_NEOMEDIA_CODEC_MJPEGDECODER_H_
+
+#include <stdint.h>
+
+/**
+ * Represents the functions with which native code outside of the FFmpeg
+ * library (e.g. the Video for Linux Two API Specification capture engine)
+ * decodes (Motion) JPEG into I420 without linking to FFmpeg itself. A pointer
+ * to it is obtained through <tt>FFmpeg.mjpeg_decoder()</tt>.
+ */
+typedef struct _MJPEGDecoder
+{
+    /**
+     * Allocates a new decoder context. A context is to be used by a single
+     * thread at a time but multiple contexts may decode in parallel.
+     *
+     * @return a new decoder context or <tt>NULL</tt> on failure
+     */
+    void *(*alloc)(void);
+
+    /**
+     * Decodes a JPEG image into the planes of an I420 picture. The input is to
+     * be followed by at least <tt>MJPEGDECODER_PADDING_SIZE</tt> readable
+     * bytes.
+     *
+     * @param ctx the decoder context to decode with
+     * @param src the JPEG image to decode
+     * @param srcLength the length in bytes of <tt>src</tt>
+     * @param dst the Y, U and V planes to write the decoded picture into
+     * @param dstStride the strides in bytes of the planes of <tt>dst</tt>
+     * @param dstWidth the width in pixels of the picture to write
+     * @param dstHeight the height in pixels of the picture to write
+     * @return <tt>0</tt> if a picture has been written; otherwise, <tt>-1</tt>
+     */
+    int (*decode)
+        (void *ctx,
+            const uint8_t *src, int srcLength,
+            uint8_t *const dst[], const int dstStride[],
+            int dstWidth, int dstHeight);
+
+    /**
+     * Frees a decoder context allocated by {@link #alloc}.
+     *
+     * @param ctx the decoder context to free
+     */
+    void (*free)(void *ctx);
+} MJPEGDecoder;
+
+/**
+ * The number of bytes past the end of the input of
+ * <tt>MJPEGDecoder.decode</tt> which may be read.
+ */
+#define MJPEGDECODER_PADDING_SIZE 16
+
+/** The <tt>MJPEGDecoder</tt> implemented with FFmpeg. */
+extern const MJPEGDecoder MJPEGDecoder_ffmpeg;
+
+#endif /* #ifndef _ORG_JITSI_IMPL_NEOMEDIA_CODEC_MJPEGDECODER_H_ */
@@ -6,6 +6,10 @@
  */
 
 #include "org_jitsi_impl_neomedia_codec_FFmpeg.h"
+#include "FramePool.h"
+#include "H264Packetizer.h"
+#include "I420Converter.h"
+#include "MJPEGDecoder.h"
 
 #include <stdint.h>
 #include <stdio.h>
@@ -182,7 +186,7 @@ Java_org_jitsi_impl_neomedia_codec_FFmpeg_avcodec_1encode_1audio
 }
 
 JNIEXPORT jint JNICALL
-Java_org_jitsi_impl_neomedia_codec_FFmpeg_avcodec_1encode_1video
+Java_org_jitsi_impl_neomedia_codec_FFmpeg_avcodec_1encode_1video__J_3BIJ
     (JNIEnv *env, jclass clazz,
     jlong ctx, jbyteArray buf, jint buf_size, jlong frame)
 {
@@ -206,6 +210,19 @@ Java_org_jitsi_impl_neomedia_codec_FFmpeg_avcodec_1encode_1video
     return ret;
 }
 
+JNIEXPORT jint JNICALL
+Java_org_jitsi_impl_neomedia_codec_FFmpeg_avcodec_1encode_1video__JJIJ
+    (JNIEnv *env, jclass clazz,
+    jlong ctx, jlong buf, jint buf_size, jlong frame)
+{
+    return
+        (jint)
+            avcodec_encode_video(
+                    (AVCodecContext *) (intptr_t) ctx,
+                    (uint8_t *) (intptr_t) buf, (int) buf_size,
+                    (const AVFrame *) (intptr_t) frame);
+}
+
 JNIEXPORT jlong JNICALL
 Java_org_jitsi_impl_neomedia_codec_FFmpeg_avcodec_1find_1decoder
     (JNIEnv *env, jclass clazz, jint id)
@@ -439,6 +456,7 @@ Java_org_jitsi_impl_neomedia_codec_FFmpeg_avcodeccontext_1set_1size
 }
 
 DEFINE_AVCODECCONTEXT_I_PROPERTY_SETTER(thread_1count, thread_count)
+DEFINE_AVCODECCONTEXT_I_PROPERTY_SETTER(thread_1type, thread_type)
 DEFINE_AVCODECCONTEXT_I_PROPERTY_SETTER(ticks_1per_1frame, ticks_per_frame)
 
 JNIEXPORT void JNICALL
@@ -630,6 +648,20 @@ Java_org_jitsi_impl_neomedia_codec_FFmpeg_avfilter_1unref_1buffer
     avfilter_unref_buffer((AVFilterBufferRef *) (intptr_t) ref);
 }
 
+JNIEXPORT jlong JNICALL
+Java_org_jitsi_impl_neomedia_codec_FFmpeg_avframe_1get_1data
+    (JNIEnv *env, jclass clazz, jlong frame, jint plane)
+{
+    return (jlong) (intptr_t) (((AVFrame *) (intptr_t) frame)->data[plane]);
+}
+
+JNIEXPORT jint JNICALL
+Java_org_jitsi_impl_neomedia_codec_FFmpeg_avframe_1get_1linesize
+    (JNIEnv *env, jclass clazz, jlong frame, jint plane)
+{
+    return (jint) (((AVFrame *) (intptr_t) frame)->linesize[plane]);
+}
+
 JNIEXPORT jlong JNICALL
 Java_org_jitsi_impl_neomedia_codec_FFmpeg_avframe_1get_1pts
     (JNIEnv *env, jclass clazz, jlong frame)
@@ -637,6 +669,17 @@ Java_org_jitsi_impl_neomedia_codec_FFmpeg_avframe_1get_1pts
     return (jlong) (((AVFrame *) (intptr_t) frame)->pts);
 }
 
+JNIEXPORT jboolean JNICALL
+Java_org_jitsi_impl_neomedia_codec_FFmpeg_avframe_1ref
+    (JNIEnv *env, jclass clazz, jlong dst, jlong src)
+{
+    return
+        (FramePool_ref((AVFrame *) (intptr_t) dst, (AVFrame *) (intptr_t) src)
+                == 0)
+            ? JNI_TRUE
+            : JNI_FALSE;
+}
+
 JNIEXPORT void JNICALL
 Java_org_jitsi_impl_neomedia_codec_FFmpeg_avframe_1set_1data
     (JNIEnv *env, jclass clazz,
@@ -679,6 +722,13 @@ Java_org_jitsi_impl_neomedia_codec_FFmpeg_avframe_1set_1linesize
     frame_->linesize[2] = (int) linesize2;
 }
 
+JNIEXPORT void JNICALL
+Java_org_jitsi_impl_neomedia_codec_FFmpeg_avframe_1unref
+    (JNIEnv *env, jclass clazz, jlong frame)
+{
+    FramePool_unref((AVFrame *) (intptr_t) frame);
+}
+
 JNIEXPORT jint JNICALL
 Java_org_jitsi_impl_neomedia_codec_FFmpeg_avpicture_1fill
     (JNIEnv *env, jclass clazz, jlong picture, jlong ptr, jint pix_fmt,
@@ -693,6 +743,29 @@ Java_org_jitsi_impl_neomedia_codec_FFmpeg_avpicture_1fill
                     (int) width, (int) height);
 }
 
+JNIEXPORT jlong JNICALL
+Java_org_jitsi_impl_neomedia_codec_FFmpeg_framepool_1alloc
+    (JNIEnv *env, jclass clazz)
+{
+    return (jlong) (intptr_t) FramePool_alloc();
+}
+
+JNIEXPORT void JNICALL
+Java_org_jitsi_impl_neomedia_codec_FFmpeg_framepool_1free
+    (JNIEnv *env, jclass clazz, jlong pool)
+{
+    FramePool_free((FramePool *) (intptr_t) pool);
+}
+
+JNIEXPORT void JNICALL
+Java_org_jitsi_impl_neomedia_codec_FFmpeg_framepool_1install
+    (JNIEnv *env, jclass clazz, jlong pool, jlong ctx)
+{
+    FramePool_install(
+            (FramePool *) (intptr_t) pool,
+            (AVCodecContext *) (intptr_t) ctx);
+}
+
 JNIEXPORT jlong JNICALL
 Java_org_jitsi_impl_neomedia_codec_FFmpeg_get_1filtered_1video_1frame
     (JNIEnv *env, jclass clazz,
@@ -738,6 +811,167 @@ Java_org_jitsi_impl_neomedia_codec_FFmpeg_get_1filtered_1video_1frame
     return (jlong) (intptr_t) ref;
 }
 
+JNIEXPORT jint JNICALL
+Java_org_jitsi_impl_neomedia_codec_FFmpeg_h264_1packetize
+    (JNIEnv *env, jclass clazz,
+    jbyteArray src, jint src_offset, jint src_length,
+    jint max_payload_size, jboolean aggregate,
+    jbyteArray packets, jintArray payload_lengths)
+{
+    jsize packetsCapacity = (*env)->GetArrayLength(env, packets);
+    jsize payloadLengthsCapacity
+        = (*env)->GetArrayLength(env, payload_lengths);
+    uint8_t *srcPtr;
+    jint ret;
+
+    srcPtr = (*env)->GetPrimitiveArrayCritical(env, src, NULL);
+    if (srcPtr)
+    {
+        uint8_t *packetsPtr
+            = (*env)->GetPrimitiveArrayCritical(env, packets, NULL);
+
+        if (packetsPtr)
+        {
+            int *payloadLengthsPtr
+                = (*env)->GetPrimitiveArrayCritical(
+                        env,
+                        payload_lengths,
+                        NULL);
+
+            if (payloadLengthsPtr)
+            {
+                ret
+                    = H264Packetizer_packetize(
+                        srcPtr + src_offset, (int) src_length,
+                        (int) max_payload_size, (JNI_TRUE == aggregate),
+                        packetsPtr, (int) packetsCapacity,
+                        payloadLengthsPtr, (int) payloadLengthsCapacity);
+                (*env)->ReleasePrimitiveArrayCritical(
+                        env,
+                        payload_lengths, payloadLengthsPtr,
+                        (ret < 0) ? JNI_ABORT : 0);
+            }
+            else
+                ret = -1;
+            (*env)->ReleasePrimitiveArrayCritical(
+                    env,
+                    packets, packetsPtr,
+                    (ret < 0) ? JNI_ABORT : 0);
+        }
+        else
+            ret = -1;
+        (*env)->ReleasePrimitiveArrayCritical(env, src, srcPtr, JNI_ABORT);
+    }
+    else
+        ret = -1;
+    return ret;
+}
+
+/**
+ * Gets the <tt>I420CONVERTER_XXX</tt> format which corresponds to a specific
+ * FFmpeg pixel format.
+ *
+ * @return the <tt>I420CONVERTER_XXX</tt> format which corresponds to the
+ * specified FFmpeg pixel format or <tt>0</tt> if there is no such format
+ */
+static int
+i420_converter_format(int pix_fmt)
+{
+    switch (pix_fmt)
+    {
+    case PIX_FMT_NV12:
+        return I420CONVERTER_NV12;
+    case PIX_FMT_RGB32:
+        return I420CONVERTER_RGB32;
+    case PIX_FMT_UYVY422:
+        return I420CONVERTER_UYVY;
+    case PIX_FMT_YUYV422:
+        return I420CONVERTER_YUYV;
+    default:
+        return 0;
+    }
+}
+
+JNIEXPORT jint JNICALL
+Java_org_jitsi_impl_neomedia_codec_FFmpeg_i420_1convert__JIIILjava_lang_Object_2II
+    (JNIEnv *env, jclass clazz, jlong src, jint srcFormat, jint srcW,
+        jint srcH, jobject dst, jint dstW, jint dstH)
+{
+    AVPicture *srcPicture = (AVPicture *) (intptr_t) src;
+    int format = i420_converter_format((int) srcFormat);
+    uint8_t *dstPtr;
+    int ret;
+
+    if (!format)
+        return -1;
+    dstPtr = (*env)->GetPrimitiveArrayCritical(env, dst, NULL);
+    if (dstPtr)
+    {
+        AVPicture dstPicture;
+
+        avpicture_fill(
+            &dstPicture,
+            dstPtr, PIX_FMT_YUV420P, (int) dstW, (int) dstH);
+        ret
+            = I420Converter_convert(
+                format,
+                (const uint8_t * const *) srcPicture->data,
+                (const int *) srcPicture->linesize,
+                (int) srcW, (int) srcH,
+                (uint8_t * const *) dstPicture.data,
+                (const int *) dstPicture.linesize,
+                (int) dstW, (int) dstH);
+        (*env)->ReleasePrimitiveArrayCritical(
+                env,
+                dst, dstPtr,
+                ret ? JNI_ABORT : 0);
+    }
+    else
+        ret = -1;
+    return (jint) ret;
+}
+
+JNIEXPORT jint JNICALL
+Java_org_jitsi_impl_neomedia_codec_FFmpeg_i420_1convert__Ljava_lang_Object_2IIILjava_lang_Object_2II
+    (JNIEnv *env, jclass clazz, jobject src, jint srcFormat, jint srcW,
+        jint srcH, jobject dst, jint dstW, jint dstH)
+{
+    uint8_t *srcPtr;
+    jint ret;
+
+    if (!i420_converter_format((int) srcFormat))
+        return -1;
+    srcPtr = (*env)->GetPrimitiveArrayCritical(env, src, NULL);
+    if (srcPtr)
+    {
+        AVPicture srcPicture;
+
+        avpicture_fill(
+            &srcPicture,
+            srcPtr, (int) srcFormat, (int) srcW, (int) srcH);
+        ret
+            = Java_org_jitsi_impl_neomedia_codec_FFmpeg_i420_1convert__JIIILjava_lang_Object_2II(
+                env, clazz,
+                (jlong) (intptr_t) &srcPicture, srcFormat, srcW, srcH,
+                dst, dstW, dstH);
+        (*env)->ReleasePrimitiveArrayCritical(env, src, srcPtr, JNI_ABORT);
+    }
+    else
+        ret = -1;
+    return ret;
+}
+
+JNIEXPORT void JNICALL
+Java_org_jitsi_impl_neomedia_codec_FFmpeg_memcpy___3BIIJ
+    (JNIEnv *env, jclass clazz,
+    jbyteArray dst, jint dst_offset, jint dst_length, jlong src)
+{
+    (*env)->SetByteArrayRegion(
+            env,
+            dst, dst_offset, dst_length,
+            (jbyte *) (intptr_t) src);
+}
+
 JNIEXPORT void JNICALL
 Java_org_jitsi_impl_neomedia_codec_FFmpeg_memcpy___3IIIJ
     (JNIEnv *env, jclass clazz,
@@ -760,6 +994,13 @@ Java_org_jitsi_impl_neomedia_codec_FFmpeg_memcpy__J_3BII
             (jbyte *) (intptr_t) dst);
 }
 
+JNIEXPORT jlong JNICALL
+Java_org_jitsi_impl_neomedia_codec_FFmpeg_mjpeg_1decoder
+    (JNIEnv *env, jclass clazz)
+{
+    return (jlong) (intptr_t) &MJPEGDecoder_ffmpeg;
+}
+
 JNIEXPORT jint JNICALL
 Java_org_jitsi_impl_neomedia_codec_FFmpeg_PIX_1FMT_1BGR32
     (JNIEnv *env, jclass clazz)
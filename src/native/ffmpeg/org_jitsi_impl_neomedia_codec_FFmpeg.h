@@ -84,9 +84,17 @@ JNIEXPORT jint JNICALL Java_org_jitsi_impl_neomedia_codec_FFmpeg_avcodec_1encode
  * Method:    avcodec_encode_video
  * Signature: (J[BIJ)I
  */
-JNIEXPORT jint JNICALL Java_org_jitsi_impl_neomedia_codec_FFmpeg_avcodec_1encode_1video
+JNIEXPORT jint JNICALL Java_org_jitsi_impl_neomedia_codec_FFmpeg_avcodec_1encode_1video__J_3BIJ
   (JNIEnv *, jclass, jlong, jbyteArray, jint, jlong);
 
+/*
+ * Class:     org_jitsi_impl_neomedia_codec_FFmpeg
+ * Method:    avcodec_encode_video
+ * Signature: (JJIJ)I
+ */
+JNIEXPORT jint JNICALL Java_org_jitsi_impl_neomedia_codec_FFmpeg_avcodec_1encode_1video__JJIJ
+  (JNIEnv *, jclass, jlong, jlong, jint, jlong);
+
 /*
  * Class:     org_jitsi_impl_neomedia_codec_FFmpeg
  * Method:    avcodec_find_decoder
@@ -399,6 +407,14 @@ JNIEXPORT void JNICALL Java_org_jitsi_impl_neomedia_codec_FFmpeg_avcodeccontext_
 JNIEXPORT void JNICALL Java_org_jitsi_impl_neomedia_codec_FFmpeg_avcodeccontext_1set_1thread_1count
   (JNIEnv *, jclass, jlong, jint);
 
+/*
+ * Class:     org_jitsi_impl_neomedia_codec_FFmpeg
+ * Method:    avcodeccontext_set_thread_type
+ * Signature: (JI)V
+ */
+JNIEXPORT void JNICALL Java_org_jitsi_impl_neomedia_codec_FFmpeg_avcodeccontext_1set_1thread_1type
+  (JNIEnv *, jclass, jlong, jint);
+
 /*
  * Class:     org_jitsi_impl_neomedia_codec_FFmpeg
  * Method:    avcodeccontext_set_ticks_per_frame
@@ -487,6 +503,22 @@ JNIEXPORT void JNICALL Java_org_jitsi_impl_neomedia_codec_FFmpeg_avfilter_1regis
 JNIEXPORT void JNICALL Java_org_jitsi_impl_neomedia_codec_FFmpeg_avfilter_1unref_1buffer
   (JNIEnv *, jclass, jlong);
 
+/*
+ * Class:     org_jitsi_impl_neomedia_codec_FFmpeg
+ * Method:    avframe_get_data
+ * Signature: (JI)J
+ */
+JNIEXPORT jlong JNICALL Java_org_jitsi_impl_neomedia_codec_FFmpeg_avframe_1get_1data
+  (JNIEnv *, jclass, jlong, jint);
+
+/*
+ * Class:     org_jitsi_impl_neomedia_codec_FFmpeg
+ * Method:    avframe_get_linesize
+ * Signature: (JI)I
+ */
+JNIEXPORT jint JNICALL Java_org_jitsi_impl_neomedia_codec_FFmpeg_avframe_1get_1linesize
+  (JNIEnv *, jclass, jlong, jint);
+
 /*
  * Class:     org_jitsi_impl_neomedia_codec_FFmpeg
  * Method:    avframe_get_pts
@@ -495,6 +527,14 @@ JNIEXPORT void JNICALL Java_org_jitsi_impl_neomedia_codec_FFmpeg_avfilter_1unref
 JNIEXPORT jlong JNICALL Java_org_jitsi_impl_neomedia_codec_FFmpeg_avframe_1get_1pts
   (JNIEnv *, jclass, jlong);
 
+/*
+ * Class:     org_jitsi_impl_neomedia_codec_FFmpeg
+ * Method:    avframe_ref
+ * Signature: (JJ)Z
+ */
+JNIEXPORT jboolean JNICALL Java_org_jitsi_impl_neomedia_codec_FFmpeg_avframe_1ref
+  (JNIEnv *, jclass, jlong, jlong);
+
 /*
  * Class:     org_jitsi_impl_neomedia_codec_FFmpeg
  * Method:    avframe_set_data
@@ -519,6 +559,14 @@ JNIEXPORT void JNICALL Java_org_jitsi_impl_neomedia_codec_FFmpeg_avframe_1set_1k
 JNIEXPORT void JNICALL Java_org_jitsi_impl_neomedia_codec_FFmpeg_avframe_1set_1linesize
   (JNIEnv *, jclass, jlong, jint, jint, jint);
 
+/*
+ * Class:     org_jitsi_impl_neomedia_codec_FFmpeg
+ * Method:    avframe_unref
+ * Signature: (J)V
+ */
+JNIEXPORT void JNICALL Java_org_jitsi_impl_neomedia_codec_FFmpeg_avframe_1unref
+  (JNIEnv *, jclass, jlong);
+
 /*
  * Class:     org_jitsi_impl_neomedia_codec_FFmpeg
  * Method:    avpicture_fill
@@ -527,6 +575,30 @@ JNIEXPORT void JNICALL Java_org_jitsi_impl_neomedia_codec_FFmpeg_avframe_1set_1l
 JNIEXPORT jint JNICALL Java_org_jitsi_impl_neomedia_codec_FFmpeg_avpicture_1fill
   (JNIEnv *, jclass, jlong, jlong, jint, jint, jint);
 
+/*
+ * Class:     org_jitsi_impl_neomedia_codec_FFmpeg
+ * Method:    framepool_alloc
+ * Signature: ()J
+ */
+JNIEXPORT jlong JNICALL Java_org_jitsi_impl_neomedia_codec_FFmpeg_framepool_1alloc
+  (JNIEnv *, jclass);
+
+/*
+ * Class:     org_jitsi_impl_neomedia_codec_FFmpeg
+ * Method:    framepool_free
+ * Signature: (J)V
+ */
+JNIEXPORT void JNICALL Java_org_jitsi_impl_neomedia_codec_FFmpeg_framepool_1free
+  (JNIEnv *, jclass, jlong);
+
+/*
+ * Class:     org_jitsi_impl_neomedia_codec_FFmpeg
+ * Method:    framepool_install
+ * Signature: (JJ)V
+ */
+JNIEXPORT void JNICALL Java_org_jitsi_impl_neomedia_codec_FFmpeg_framepool_1install
+  (JNIEnv *, jclass, jlong, jlong);
+
 /*
  * Class:     org_jitsi_impl_neomedia_codec_FFmpeg
  * Method:    get_filtered_video_frame
@@ -535,6 +607,38 @@ JNIEXPORT jint JNICALL Java_org_jitsi_impl_neomedia_codec_FFmpeg_avpicture_1fill
 JNIEXPORT jlong JNICALL Java_org_jitsi_impl_neomedia_codec_FFmpeg_get_1filtered_1video_1frame
   (JNIEnv *, jclass, jlong, jint, jint, jint, jlong, jlong, jlong);
 
+/*
+ * Class:     org_jitsi_impl_neomedia_codec_FFmpeg
+ * Method:    h264_packetize
+ * Signature: ([BIIIZ[B[I)I
+ */
+JNIEXPORT jint JNICALL Java_org_jitsi_impl_neomedia_codec_FFmpeg_h264_1packetize
+  (JNIEnv *, jclass, jbyteArray, jint, jint, jint, jboolean, jbyteArray, jintArray);
+
+/*
+ * Class:     org_jitsi_impl_neomedia_codec_FFmpeg
+ * Method:    i420_convert
+ * Signature: (JIIILjava/lang/Object;II)I
+ */
+JNIEXPORT jint JNICALL Java_org_jitsi_impl_neomedia_codec_FFmpeg_i420_1convert__JIIILjava_lang_Object_2II
+  (JNIEnv *, jclass, jlong, jint, jint, jint, jobject, jint, jint);
+
+/*
+ * Class:     org_jitsi_impl_neomedia_codec_FFmpeg
+ * Method:    i420_convert
+ * Signature: (Ljava/lang/Object;IIILjava/lang/Object;II)I
+ */
+JNIEXPORT jint JNICALL Java_org_jitsi_impl_neomedia_codec_FFmpeg_i420_1convert__Ljava_lang_Object_2IIILjava_lang_Object_2II
+  (JNIEnv *, jclass, jobject, jint, jint, jint, jobject, jint, jint);
+
+/*
+ * Class:     org_jitsi_impl_neomedia_codec_FFmpeg
+ * Method:    memcpy
+ * Signature: ([BIIJ)V
+ */
+JNIEXPORT void JNICALL Java_org_jitsi_impl_neomedia_codec_FFmpeg_memcpy___3BIIJ
+  (JNIEnv *, jclass, jbyteArray, jint, jint, jlong);
+
 /*
  * Class:     org_jitsi_impl_neomedia_codec_FFmpeg
  * Method:    memcpy
@@ -551,6 +655,14 @@ JNIEXPORT void JNICALL Java_org_jitsi_impl_neomedia_codec_FFmpeg_memcpy___3IIIJ
 JNIEXPORT void JNICALL Java_org_jitsi_impl_neomedia_codec_FFmpeg_memcpy__J_3BII
   (JNIEnv *, jclass, jlong, jbyteArray, jint, jint);
 
+/*
+ * Class:     org_jitsi_impl_neomedia_codec_FFmpeg
+ * Method:    mjpeg_decoder
+ * Signature: ()J
+ */
+JNIEXPORT jlong JNICALL Java_org_jitsi_impl_neomedia_codec_FFmpeg_mjpeg_1decoder
+  (JNIEnv *, jclass);
+
 /*
  * Class:     org_jitsi_impl_neomedia_codec_FFmpeg
  * Method:    PIX_FMT_BGR32
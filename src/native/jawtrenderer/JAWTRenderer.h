@@ -33,6 +33,41 @@ jboolean JAWTRenderer_process
     (JNIEnv *env, jclass clazz,jlong handle, jobject component, jint *data,
         jint length, jint width, jint height);
 
+#if defined(__linux__) && !defined(__ANDROID__)
+/**
+ * Scales an I420 frame given as pointers to its Y, U and V planes into a
+ * rectangle of the I420 surface of a specific size which the renderer keeps
+ * and puts as a whole. The surface starts black and is (re)allocated when its
+ * size changes. If <tt>planes</tt> is <tt>NULL</tt>, the rectangle is
+ * cleared. The planes are only valid during the call.
+ */
+jboolean JAWTRenderer_composite
+    (JNIEnv *env, jclass clazz, jlong handle, jobject component,
+        char *const planes[3], const int strides[3], jint width, jint height,
+        jint x, jint y, jint boundsWidth, jint boundsHeight,
+        jint surfaceWidth, jint surfaceHeight);
+
+/**
+ * Releases a frame handed to <tt>JAWTRenderer_processPlanes</tt>. It is
+ * invoked exactly once per frame, possibly on another thread and after
+ * <tt>JAWTRenderer_processPlanes</tt> has returned.
+ */
+typedef void (*JAWTRenderer_ReleasePlanes)(void *opaque);
+
+/**
+ * Processes an I420 frame given as pointers to its Y, U and V planes and their
+ * strides (e.g. the picture of an FFmpeg <tt>AVFrame</tt>) rather than packed
+ * into a Java <tt>int[]</tt>. If <tt>release</tt> is <tt>NULL</tt>, the planes
+ * are only valid during the call. Otherwise, the renderer may keep and put the
+ * planes without copying them until it invokes <tt>release</tt> with
+ * <tt>opaque</tt>.
+ */
+jboolean JAWTRenderer_processPlanes
+    (JNIEnv *env, jclass clazz, jlong handle, jobject component,
+        char *const planes[3], const int strides[3], jint width, jint height,
+        JAWTRenderer_ReleasePlanes release, void *opaque);
+#endif /* #if defined(__linux__) && !defined(__ANDROID__) */
+
 #ifdef __APPLE__
 jstring JAWTRenderer_sysctlbyname(JNIEnv *env, jstring name);
 #endif /* #ifdef __APPLE__ */
@@ -12,8 +12,15 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/ipc.h>
+#include <sys/shm.h>
+#include <X11/extensions/XShm.h>
 #include <X11/extensions/Xvlib.h>
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif /* #ifdef __SSE2__ */
+
 typedef struct _JAWTRenderer
 {
     Display *display;
@@ -30,15 +37,96 @@ typedef struct _JAWTRenderer
     int dataOffsets[3];
     int dataPitches[3];
     jint dataWidth;
+
+    /**
+     * The indicator which determines whether the frames are to be put with
+     * XvShmPutImage i.e. through shared memory rather than the X socket.
+     */
+    Bool shm;
+    /**
+     * The two shared memory images which are written by
+     * <tt>JAWTRenderer_process</tt> and put by <tt>JAWTRenderer_paint</tt> in
+     * turn so that a frame is not written while the X server may still be
+     * reading it.
+     */
+    XvImage *shmImages[2];
+    XShmSegmentInfo shmInfos[2];
+    /** The index in <tt>shmImages</tt> of the image to be written next. */
+    int shmBack;
+    /**
+     * The indicator which determines whether the back image contains a frame
+     * which has not been put yet.
+     */
+    Bool shmBackIsReady;
+    /** The indicator which determines whether the front image may be put. */
+    Bool shmFrontIsValid;
+
+    /**
+     * The function which releases the frame handed to
+     * <tt>JAWTRenderer_processPlanes</tt> which <tt>image</tt> currently puts
+     * without it having been copied (if any) and its argument.
+     */
+    JAWTRenderer_ReleasePlanes heldRelease;
+    void *heldOpaque;
+    /**
+     * The planes of the frame handed to <tt>JAWTRenderer_processPlanes</tt>
+     * which is to be copied into the back shared memory image only when it is
+     * put (if any) i.e. which is not copied at all if a newer frame supersedes
+     * it first.
+     */
+    char *heldPlanes[3];
+    int heldStrides[3];
+    int heldWidth;
+    int heldHeight;
+
+    /**
+     * The memory in which <tt>JAWTRenderer_composite</tt> keeps the tables and
+     * the row with which it scales a frame into the surface.
+     */
+    char *scratch;
+    size_t scratchCapacity;
 }
 JAWTRenderer;
 
+static void _JAWTRenderer_blendRows
+    (unsigned char *dst, const unsigned char *row0, const unsigned char *row1,
+        int weight, int length);
+static void _JAWTRenderer_clearPlanes
+    (JAWTRenderer *renderer, int x, int y, int width, int height);
+static void _JAWTRenderer_copyPlanes
+    (char *const dst[3], const int dstPitches[3],
+        char *const src[3], const int srcPitches[3],
+        int width, int height);
+static Bool _JAWTRenderer_copyPlanesToData
+    (JAWTRenderer *renderer, char *const planes[3], const int strides[3],
+        int width, int height);
 static XvImage *_JAWTRenderer_createImage(JAWTRenderer *renderer);
+static Bool _JAWTRenderer_createShmImages
+    (JAWTRenderer *renderer, int width, int height);
 static int _JAWTRenderer_freeImage(JAWTRenderer *renderer);
+static void _JAWTRenderer_freeShmImages(JAWTRenderer *renderer);
+static void _JAWTRenderer_getImagePlanes(XvImage *image, char *planes[3]);
+static XvImage *_JAWTRenderer_getShmImage(JAWTRenderer *renderer);
 static XvPortID _JAWTRenderer_grabPort
     (JAWTRenderer *renderer, JAWT_X11DrawingSurfaceInfo *x11dsi);
+static int _JAWTRenderer_handleShmError(Display *display, XErrorEvent *event);
+static void _JAWTRenderer_releaseHeldPlanes(JAWTRenderer *renderer);
+static size_t _JAWTRenderer_reserveData
+    (JAWTRenderer *renderer, int width, int height);
+static void _JAWTRenderer_scalePlane
+    (char *dst, int dstPitch, int dstWidth, int dstHeight,
+        int left, int top, int right, int bottom,
+        const char *src, int srcPitch, int srcWidth, int srcHeight,
+        int *xs, unsigned char *row);
 static int _JAWTRenderer_ungrabPort(JAWTRenderer *renderer);
 
+/**
+ * The indicator which determines whether an X error has occurred while a
+ * shared memory segment was being attached by
+ * <tt>_JAWTRenderer_createShmImages</tt>.
+ */
+static Bool _JAWTRenderer_shmError = False;
+
 void
 JAWTRenderer_close
     (JNIEnv *jniEnv, jclass clazz, jlong handle, jobject component)
@@ -47,11 +135,123 @@ JAWTRenderer_close
 
     if (-1 != renderer->port)
         _JAWTRenderer_ungrabPort(renderer);
+    _JAWTRenderer_releaseHeldPlanes(renderer);
     if (renderer->data)
         free(renderer->data);
+    if (renderer->scratch)
+        free(renderer->scratch);
     free(renderer);
 }
 
+jboolean
+JAWTRenderer_composite
+    (JNIEnv *jniEnv, jclass clazz,
+     jlong handle, jobject component,
+     char *const planes[3], const int strides[3],
+     jint width, jint height,
+     jint x, jint y, jint boundsWidth, jint boundsHeight,
+     jint surfaceWidth, jint surfaceHeight)
+{
+    JAWTRenderer *renderer;
+    Bool relaidOut;
+    size_t dataLength;
+    int left, top, right, bottom;
+
+    renderer = (JAWTRenderer *) (intptr_t) handle;
+    _JAWTRenderer_releaseHeldPlanes(renderer);
+
+    /* I420 subsamples the chroma 2:1 so keep everything on even pixels. */
+    surfaceWidth &= ~1;
+    surfaceHeight &= ~1;
+    x &= ~1;
+    y &= ~1;
+    boundsWidth &= ~1;
+    boundsHeight &= ~1;
+    if ((surfaceWidth < 2) || (surfaceHeight < 2))
+        return JNI_FALSE;
+
+    relaidOut
+        = !(renderer->data)
+            || (renderer->dataWidth != surfaceWidth)
+            || (renderer->dataHeight != surfaceHeight);
+    dataLength
+        = _JAWTRenderer_reserveData(renderer, surfaceWidth, surfaceHeight);
+    if (!dataLength)
+        return JNI_FALSE;
+    /* A surface which has just been (re)laid out starts black. */
+    if (relaidOut)
+        _JAWTRenderer_clearPlanes(renderer, 0, 0, surfaceWidth, surfaceHeight);
+
+    /* Only the part of the bounds which is inside the surface is written. */
+    left = (x < 0) ? -x : 0;
+    top = (y < 0) ? -y : 0;
+    right = (x + boundsWidth > surfaceWidth) ? (surfaceWidth - x) : boundsWidth;
+    bottom
+        = (y + boundsHeight > surfaceHeight)
+            ? (surfaceHeight - y)
+            : boundsHeight;
+    if ((left < right) && (top < bottom))
+    {
+        if (planes && (width >= 2) && (height >= 2))
+        {
+            size_t scratchLength;
+            int *xs;
+            unsigned char *row;
+            int planeIndex;
+
+            /* A table entry per output column and a (padded) source row. */
+            scratchLength
+                = sizeof(int) * (size_t) (right - left) + width + 1 + 16;
+            if (!(renderer->scratch)
+                    || (renderer->scratchCapacity < scratchLength))
+            {
+                char *newScratch;
+
+                newScratch = realloc(renderer->scratch, scratchLength);
+                if (!newScratch)
+                    return JNI_FALSE;
+                renderer->scratch = newScratch;
+                renderer->scratchCapacity = scratchLength;
+            }
+            xs = (int *) (renderer->scratch);
+            row
+                = (unsigned char *)
+                    (renderer->scratch + sizeof(int) * (size_t) (right - left));
+            for (planeIndex = 0; planeIndex < 3; planeIndex++)
+            {
+                int shift;
+                int pitch;
+
+                shift = planeIndex ? 1 : 0;
+                pitch = renderer->dataPitches[planeIndex];
+                _JAWTRenderer_scalePlane(
+                        renderer->data
+                            + renderer->dataOffsets[planeIndex]
+                            + ((y + top) >> shift) * pitch
+                            + ((x + left) >> shift),
+                        pitch,
+                        boundsWidth >> shift, boundsHeight >> shift,
+                        left >> shift, top >> shift,
+                        right >> shift, bottom >> shift,
+                        planes[planeIndex], strides[planeIndex],
+                        width >> shift, height >> shift,
+                        xs, row);
+            }
+        }
+        else
+        {
+            _JAWTRenderer_clearPlanes(
+                    renderer,
+                    x + left, y + top,
+                    right - left, bottom - top);
+        }
+    }
+
+    /* Have JAWTRenderer_paint put the whole surface. */
+    renderer->dataLength = dataLength;
+    return JNI_TRUE;
+}
+
 jlong
 JAWTRenderer_open(JNIEnv *jniEnv, jclass clazz, jobject component)
 {
@@ -78,6 +278,22 @@ JAWTRenderer_open(JNIEnv *jniEnv, jclass clazz, jobject component)
                 renderer->dataHeight = 0;
                 renderer->dataLength = 0;
                 renderer->dataWidth = 0;
+
+                renderer->shm = False;
+                renderer->shmImages[0] = NULL;
+                renderer->shmImages[1] = NULL;
+                renderer->shmBack = 0;
+                renderer->shmBackIsReady = False;
+                renderer->shmFrontIsValid = False;
+
+                renderer->heldRelease = NULL;
+                renderer->heldOpaque = NULL;
+                renderer->heldPlanes[0] = NULL;
+                renderer->heldPlanes[1] = NULL;
+                renderer->heldPlanes[2] = NULL;
+
+                renderer->scratch = NULL;
+                renderer->scratchCapacity = 0;
             }
         }
         else
@@ -120,11 +336,26 @@ JAWTRenderer_paint
     if (-1 != port)
     {
         XvImage *image;
+        Bool shm;
 
-        if (renderer->data && renderer->dataLength)
-            image = _JAWTRenderer_createImage(renderer);
-        else
-            image = renderer->image;
+        /*
+         * Put the frames through shared memory if possible and fall back to
+         * the X socket otherwise.
+         */
+        image = renderer->shm ? _JAWTRenderer_getShmImage(renderer) : NULL;
+        shm = renderer->shm;
+        if (!shm)
+        {
+            if (renderer->data && renderer->dataLength)
+                image = _JAWTRenderer_createImage(renderer);
+            else
+            {
+                image = renderer->image;
+                /* The frame it put without copying may have been released. */
+                if (image && !(image->data))
+                    image = NULL;
+            }
+        }
         if (image)
         {
             Window root;
@@ -146,14 +377,29 @@ JAWTRenderer_paint
 
                 gc = XCreateGC(display, drawable, 0, NULL);
                 /* XXX How does one check that XCreateGC has succeeded? */
-                XvPutImage(
-                    display,
-                    port,
-                    drawable,
-                    gc,
-                    image,
-                    0, 0, image->width, image->height,
-                    0, 0, width, height);
+                if (shm)
+                {
+                    XvShmPutImage(
+                        display,
+                        port,
+                        drawable,
+                        gc,
+                        image,
+                        0, 0, image->width, image->height,
+                        0, 0, width, height,
+                        False);
+                }
+                else
+                {
+                    XvPutImage(
+                        display,
+                        port,
+                        drawable,
+                        gc,
+                        image,
+                        0, 0, image->width, image->height,
+                        0, 0, width, height);
+                }
                 XFreeGC(display, gc);
             }
         }
@@ -175,8 +421,44 @@ JAWTRenderer_process
         jint dataLength;
 
         renderer = (JAWTRenderer *) (intptr_t) handle;
-        rendererData = renderer->data;
         dataLength = sizeof(jint) * length;
+        _JAWTRenderer_releaseHeldPlanes(renderer);
+
+        /*
+         * If the shared memory images of the size of the frame have already
+         * been created, copy the frame straight into the one which is not
+         * (possibly) being read by the X server.
+         */
+        if (renderer->shmImages[0]
+                && (renderer->shmImages[0]->width == width)
+                && (renderer->shmImages[0]->height == height)
+                && (dataLength
+                        >= width * height + 2 * (width / 2) * (height / 2)))
+        {
+            XvImage *image;
+            char *imagePlanes[3];
+            char *dataPlanes[3];
+            int dataPitches[3];
+
+            image = renderer->shmImages[renderer->shmBack];
+            _JAWTRenderer_getImagePlanes(image, imagePlanes);
+            dataPitches[0] = width;
+            dataPitches[1] = width / 2;
+            dataPitches[2] = width / 2;
+            dataPlanes[0] = (char *) data;
+            dataPlanes[1] = dataPlanes[0] + width * height;
+            dataPlanes[2] = dataPlanes[1] + (width / 2) * (height / 2);
+            _JAWTRenderer_copyPlanes(
+                    imagePlanes, image->pitches,
+                    dataPlanes, dataPitches,
+                    width, height);
+            renderer->shmBackIsReady = True;
+            /* Any frame waiting in data is older than this one. */
+            renderer->dataLength = 0;
+            return JNI_TRUE;
+        }
+
+        rendererData = renderer->data;
         if (!rendererData || (renderer->dataCapacity < dataLength))
         {
             char *newData;
@@ -284,6 +566,257 @@ JAWTRenderer_process
     return JNI_TRUE;
 }
 
+jboolean
+JAWTRenderer_processPlanes
+    (JNIEnv *jniEnv, jclass clazz,
+     jlong handle, jobject component,
+     char *const planes[3], const int strides[3],
+     jint width, jint height,
+     JAWTRenderer_ReleasePlanes release, void *opaque)
+{
+    JAWTRenderer *renderer;
+    XvImage *image;
+    jboolean processed;
+
+    renderer = (JAWTRenderer *) (intptr_t) handle;
+    /* Whatever frame is held, it is superseded. */
+    _JAWTRenderer_releaseHeldPlanes(renderer);
+
+    processed = JNI_TRUE;
+    image
+        = renderer->shmImages[0]
+            ? renderer->shmImages[renderer->shmBack]
+            : NULL;
+    if (release && renderer->shm)
+    {
+        int planeIndex;
+
+        /*
+         * Put off the copying into shared memory until the frame is put so
+         * that a frame which is superseded before then is not copied at all.
+         */
+        for (planeIndex = 0; planeIndex < 3; planeIndex++)
+        {
+            renderer->heldPlanes[planeIndex] = planes[planeIndex];
+            renderer->heldStrides[planeIndex] = strides[planeIndex];
+        }
+        renderer->heldWidth = width;
+        renderer->heldHeight = height;
+        renderer->heldRelease = release;
+        renderer->heldOpaque = opaque;
+        renderer->dataLength = 0;
+    }
+    else if (image && (image->width == width) && (image->height == height))
+    {
+        char *imagePlanes[3];
+
+        /* Copy the frame once, straight into shared memory. */
+        _JAWTRenderer_getImagePlanes(image, imagePlanes);
+        _JAWTRenderer_copyPlanes(
+                imagePlanes, image->pitches,
+                planes, strides,
+                width, height);
+        renderer->shmBackIsReady = True;
+        renderer->dataLength = 0;
+    }
+    else
+    {
+        int planeIndex;
+
+        /*
+         * If the frame is laid out the way the XvImage (which is put through
+         * the X socket) wants it and it may be held, do not copy it at all.
+         */
+        image = renderer->shm ? NULL : renderer->image;
+        if (release
+                && image
+                && (image->width == width)
+                && (image->height == height))
+        {
+            for (planeIndex = 0; planeIndex < 3; planeIndex++)
+            {
+                if ((strides[planeIndex] != image->pitches[planeIndex])
+                        || ((planes[planeIndex] - planes[0])
+                                != (image->offsets[planeIndex]
+                                        - image->offsets[0])))
+                    break;
+            }
+        }
+        else
+            planeIndex = 0;
+        if (3 == planeIndex)
+        {
+            image->data = planes[0] - image->offsets[0];
+            renderer->heldRelease = release;
+            renderer->heldOpaque = opaque;
+            renderer->dataLength = 0;
+        }
+        else if (!_JAWTRenderer_copyPlanesToData(
+                renderer,
+                planes, strides,
+                width, height))
+            processed = JNI_FALSE;
+    }
+    if (release && (renderer->heldRelease != release))
+        release(opaque);
+    return processed;
+}
+
+/**
+ * Blends two rows of 8-bit samples with a weight in 1/256ths of the second
+ * one i.e. carries out the vertical pass of the bilinear scaling of
+ * <tt>_JAWTRenderer_scalePlane</tt>, 16 samples at a time with SSE2 where
+ * available.
+ */
+static void
+_JAWTRenderer_blendRows
+    (unsigned char *dst, const unsigned char *row0, const unsigned char *row1,
+        int weight, int length)
+{
+    int i;
+    int weight0;
+
+    i = 0;
+    weight0 = 256 - weight;
+#ifdef __SSE2__
+    {
+        __m128i w0, w1, round, zero;
+
+        w0 = _mm_set1_epi16((short) weight0);
+        w1 = _mm_set1_epi16((short) weight);
+        round = _mm_set1_epi16(128);
+        zero = _mm_setzero_si128();
+        for (; i + 16 <= length; i += 16)
+        {
+            __m128i a, b, lo, hi;
+
+            a = _mm_loadu_si128((const __m128i *) (row0 + i));
+            b = _mm_loadu_si128((const __m128i *) (row1 + i));
+            /* 255 * 256 + 128 still fits into an unsigned 16-bit lane. */
+            lo
+                = _mm_add_epi16(
+                        _mm_mullo_epi16(_mm_unpacklo_epi8(a, zero), w0),
+                        _mm_mullo_epi16(_mm_unpacklo_epi8(b, zero), w1));
+            hi
+                = _mm_add_epi16(
+                        _mm_mullo_epi16(_mm_unpackhi_epi8(a, zero), w0),
+                        _mm_mullo_epi16(_mm_unpackhi_epi8(b, zero), w1));
+            lo = _mm_srli_epi16(_mm_add_epi16(lo, round), 8);
+            hi = _mm_srli_epi16(_mm_add_epi16(hi, round), 8);
+            _mm_storeu_si128((__m128i *) (dst + i), _mm_packus_epi16(lo, hi));
+        }
+    }
+#endif /* #ifdef __SSE2__ */
+    for (; i < length; i++)
+        dst[i] = (row0[i] * weight0 + row1[i] * weight + 128) >> 8;
+}
+
+/**
+ * Fills a rectangle of the surface of <tt>JAWTRenderer_composite</tt> (i.e.
+ * the <tt>data</tt> of a <tt>JAWTRenderer</tt>) with black. The rectangle is
+ * in luma pixels and on even coordinates.
+ */
+static void
+_JAWTRenderer_clearPlanes
+    (JAWTRenderer *renderer, int x, int y, int width, int height)
+{
+    int planeIndex;
+
+    for (planeIndex = 0; planeIndex < 3; planeIndex++)
+    {
+        int shift;
+        int pitch;
+        char *row;
+        int rowIndex;
+
+        shift = planeIndex ? 1 : 0;
+        pitch = renderer->dataPitches[planeIndex];
+        row
+            = renderer->data
+                + renderer->dataOffsets[planeIndex]
+                + (y >> shift) * pitch
+                + (x >> shift);
+        for (rowIndex = 0; rowIndex < (height >> shift); rowIndex++)
+        {
+            memset(row, planeIndex ? 128 : 16, width >> shift);
+            row += pitch;
+        }
+    }
+}
+
+/**
+ * Copies the Y, U and V planes of an I420 frame between buffers which may
+ * have different offsets and pitches.
+ */
+static void
+_JAWTRenderer_copyPlanes
+    (char *const dst[3], const int dstPitches[3],
+        char *const src[3], const int srcPitches[3],
+        int width, int height)
+{
+    int planeIndex;
+
+    for (planeIndex = 0; planeIndex < 3; planeIndex++)
+    {
+        int planeWidth;
+        int planeHeight;
+        int dstPitch;
+        int srcPitch;
+        char *dstRow;
+        char *srcRow;
+
+        planeWidth = planeIndex ? (width / 2) : width;
+        planeHeight = planeIndex ? (height / 2) : height;
+        dstPitch = dstPitches[planeIndex];
+        srcPitch = srcPitches[planeIndex];
+        dstRow = dst[planeIndex];
+        srcRow = src[planeIndex];
+        if ((dstPitch == srcPitch) && (dstPitch == planeWidth))
+            memcpy(dstRow, srcRow, planeWidth * planeHeight);
+        else
+        {
+            int rowIndex;
+
+            for (rowIndex = 0; rowIndex < planeHeight; rowIndex++)
+            {
+                memcpy(dstRow, srcRow, planeWidth);
+                dstRow += dstPitch;
+                srcRow += srcPitch;
+            }
+        }
+    }
+}
+
+/**
+ * Copies the planes of a frame into the <tt>data</tt> of a
+ * <tt>JAWTRenderer</tt> i.e. where <tt>JAWTRenderer_process</tt> leaves the
+ * frames which <tt>JAWTRenderer_paint</tt> is to turn into an image.
+ */
+static Bool
+_JAWTRenderer_copyPlanesToData
+    (JAWTRenderer *renderer, char *const planes[3], const int strides[3],
+        int width, int height)
+{
+    size_t dataLength;
+    char *dataPlanes[3];
+    int planeIndex;
+
+    dataLength = _JAWTRenderer_reserveData(renderer, width, height);
+    if (!dataLength)
+        return False;
+
+    for (planeIndex = 0; planeIndex < 3; planeIndex++)
+    {
+        dataPlanes[planeIndex]
+            = renderer->data + renderer->dataOffsets[planeIndex];
+    }
+    _JAWTRenderer_copyPlanes(
+            dataPlanes, renderer->dataPitches,
+            planes, strides,
+            width, height);
+    renderer->dataLength = dataLength;
+    return True;
+}
 static XvImage *
 _JAWTRenderer_createImage(JAWTRenderer *renderer)
 {
@@ -495,6 +1028,101 @@ _JAWTRenderer_createImage(JAWTRenderer *renderer)
     return image;
 }
 
+/**
+ * Creates the two shared memory images of a specific size of a
+ * <tt>JAWTRenderer</tt> (if it does not have them already).
+ *
+ * @return <tt>True</tt> if the renderer has the shared memory images;
+ * otherwise, <tt>False</tt>
+ */
+static Bool
+_JAWTRenderer_createShmImages(JAWTRenderer *renderer, int width, int height)
+{
+    Display *display;
+    int imageIndex;
+
+    if (renderer->shmImages[0]
+            && (renderer->shmImages[0]->width == width)
+            && (renderer->shmImages[0]->height == height))
+        return True;
+    _JAWTRenderer_freeShmImages(renderer);
+
+    display = renderer->display;
+    for (imageIndex = 0; imageIndex < 2; imageIndex++)
+    {
+        XShmSegmentInfo *shmInfo;
+        XvImage *image;
+        int (*errorHandler)(Display *, XErrorEvent *);
+
+        shmInfo = renderer->shmInfos + imageIndex;
+        image
+            = XvShmCreateImage(
+                display,
+                renderer->port,
+                renderer->imageFormatID,
+                NULL,
+                width, height,
+                shmInfo);
+        if (!image)
+            break;
+        /*
+         * XvShmCreateImage is documented to enlarge width and height for some
+         * YUV formats and the images have to be of the size of the frames in
+         * order to be written straight into.
+         */
+        if ((image->width != width) || (image->height != height))
+        {
+            XFree(image);
+            break;
+        }
+
+        shmInfo->shmid = shmget(IPC_PRIVATE, image->data_size, IPC_CREAT | 0600);
+        if (-1 == shmInfo->shmid)
+        {
+            XFree(image);
+            break;
+        }
+        shmInfo->shmaddr = shmat(shmInfo->shmid, NULL, 0);
+        if ((void *) -1 == shmInfo->shmaddr)
+        {
+            shmctl(shmInfo->shmid, IPC_RMID, NULL);
+            XFree(image);
+            break;
+        }
+        shmInfo->readOnly = False;
+
+        /*
+         * XShmAttach fails asynchronously (e.g. for a remote X server) and
+         * the default X error handler would exit.
+         */
+        _JAWTRenderer_shmError = False;
+        errorHandler = XSetErrorHandler(_JAWTRenderer_handleShmError);
+        XShmAttach(display, shmInfo);
+        XSync(display, False);
+        XSetErrorHandler(errorHandler);
+        /*
+         * The segment will be destroyed as soon as both the X server and we
+         * have detached from it.
+         */
+        shmctl(shmInfo->shmid, IPC_RMID, NULL);
+        if (_JAWTRenderer_shmError)
+        {
+            shmdt(shmInfo->shmaddr);
+            XFree(image);
+            break;
+        }
+
+        image->data = shmInfo->shmaddr;
+        renderer->shmImages[imageIndex] = image;
+    }
+    if (!(renderer->shmImages[1]))
+    {
+        _JAWTRenderer_freeShmImages(renderer);
+        return False;
+    }
+    return True;
+}
+
 static int
 _JAWTRenderer_freeImage(JAWTRenderer *renderer)
 {
@@ -505,6 +1133,142 @@ _JAWTRenderer_freeImage(JAWTRenderer *renderer)
     return ret;
 }
 
+static void
+_JAWTRenderer_freeShmImages(JAWTRenderer *renderer)
+{
+    int imageIndex;
+
+    for (imageIndex = 0; imageIndex < 2; imageIndex++)
+    {
+        XvImage *image;
+
+        image = renderer->shmImages[imageIndex];
+        if (image)
+        {
+            XShmSegmentInfo *shmInfo;
+
+            shmInfo = renderer->shmInfos + imageIndex;
+            XShmDetach(renderer->display, shmInfo);
+            shmdt(shmInfo->shmaddr);
+            XFree(image);
+            renderer->shmImages[imageIndex] = NULL;
+        }
+    }
+    renderer->shmBack = 0;
+    renderer->shmBackIsReady = False;
+    renderer->shmFrontIsValid = False;
+}
+
+static void
+_JAWTRenderer_getImagePlanes(XvImage *image, char *planes[3])
+{
+    int planeIndex;
+
+    for (planeIndex = 0; planeIndex < 3; planeIndex++)
+        planes[planeIndex] = image->data + image->offsets[planeIndex];
+}
+
+/**
+ * Gets the shared memory image of a <tt>JAWTRenderer</tt> which is to be put
+ * i.e. the one with the latest processed frame. Disables the use of shared
+ * memory by the renderer if the images cannot be created.
+ *
+ * @return the shared memory image to be put or <tt>NULL</tt> if there is no
+ * frame to be put
+ */
+static XvImage *
+_JAWTRenderer_getShmImage(JAWTRenderer *renderer)
+{
+    /*
+     * A frame has been processed before the shared memory images of its size
+     * have been created (or the size of the frames has changed).
+     */
+    if (renderer->data && renderer->dataLength)
+    {
+        if (_JAWTRenderer_createShmImages(
+                renderer,
+                renderer->dataWidth, renderer->dataHeight))
+        {
+            XvImage *image;
+            char *imagePlanes[3];
+            char *dataPlanes[3];
+            int planeIndex;
+
+            image = renderer->shmImages[renderer->shmBack];
+            _JAWTRenderer_getImagePlanes(image, imagePlanes);
+            for (planeIndex = 0; planeIndex < 3; planeIndex++)
+            {
+                dataPlanes[planeIndex]
+                    = renderer->data + renderer->dataOffsets[planeIndex];
+            }
+            _JAWTRenderer_copyPlanes(
+                    imagePlanes, image->pitches,
+                    dataPlanes, renderer->dataPitches,
+                    renderer->dataWidth, renderer->dataHeight);
+            renderer->shmBackIsReady = True;
+            renderer->dataLength = 0;
+        }
+        else
+        {
+            /* Fall back to the X socket and leave it the frame in data. */
+            renderer->shm = False;
+            return NULL;
+        }
+    }
+    else if (renderer->heldPlanes[0])
+    {
+        Bool created;
+
+        created
+            = _JAWTRenderer_createShmImages(
+                    renderer,
+                    renderer->heldWidth, renderer->heldHeight);
+        if (created)
+        {
+            XvImage *image;
+            char *imagePlanes[3];
+
+            image = renderer->shmImages[renderer->shmBack];
+            _JAWTRenderer_getImagePlanes(image, imagePlanes);
+            _JAWTRenderer_copyPlanes(
+                    imagePlanes, image->pitches,
+                    renderer->heldPlanes, renderer->heldStrides,
+                    renderer->heldWidth, renderer->heldHeight);
+            renderer->shmBackIsReady = True;
+        }
+        else
+        {
+            /* Fall back to the X socket with a copy of the frame in data. */
+            renderer->shm = False;
+            _JAWTRenderer_copyPlanesToData(
+                    renderer,
+                    renderer->heldPlanes, renderer->heldStrides,
+                    renderer->heldWidth, renderer->heldHeight);
+        }
+        _JAWTRenderer_releaseHeldPlanes(renderer);
+        if (!created)
+            return NULL;
+    }
+    if (renderer->shmBackIsReady)
+    {
+        /*
+         * Make sure that the X server is done with the front image which is
+         * about to become the back image i.e. to be written by
+         * JAWTRenderer_process. It was put a frame ago so the round trip is
+         * not expected to wait for anything.
+         */
+        if (renderer->shmFrontIsValid)
+            XSync(renderer->display, False);
+        renderer->shmBack = 1 - renderer->shmBack;
+        renderer->shmBackIsReady = False;
+        renderer->shmFrontIsValid = True;
+    }
+    return
+        renderer->shmFrontIsValid
+            ? renderer->shmImages[1 - renderer->shmBack]
+            : NULL;
+}
+
 static XvPortID
 _JAWTRenderer_grabPort
     (JAWTRenderer *renderer, JAWT_X11DrawingSurfaceInfo *x11dsi)
@@ -621,9 +1385,211 @@ _JAWTRenderer_grabPort
         XvFreeAdaptorInfo(adaptorInfos);
     }
     renderer->port = grabbedPort;
+    if (-1 != grabbedPort)
+        renderer->shm = XShmQueryExtension(display);
     return grabbedPort;
 }
 
+static int
+_JAWTRenderer_handleShmError(Display *display, XErrorEvent *event)
+{
+    _JAWTRenderer_shmError = True;
+    return 0;
+}
+
+/**
+ * Releases the frame handed to <tt>JAWTRenderer_processPlanes</tt> which a
+ * <tt>JAWTRenderer</tt> puts without having copied it (if any).
+ */
+static void
+_JAWTRenderer_releaseHeldPlanes(JAWTRenderer *renderer)
+{
+    JAWTRenderer_ReleasePlanes release;
+
+    release = renderer->heldRelease;
+    if (release)
+    {
+        void *opaque;
+
+        opaque = renderer->heldOpaque;
+        renderer->heldRelease = NULL;
+        renderer->heldOpaque = NULL;
+        if (renderer->heldPlanes[0])
+        {
+            renderer->heldPlanes[0] = NULL;
+            renderer->heldPlanes[1] = NULL;
+            renderer->heldPlanes[2] = NULL;
+        }
+        else if (renderer->image)
+            renderer->image->data = NULL;
+        release(opaque);
+    }
+}
+
+/**
+ * Makes sure that the <tt>data</tt> of a <tt>JAWTRenderer</tt> is laid out
+ * for and may hold an I420 frame of a specific size.
+ *
+ * @return the number of bytes of <tt>data</tt> which the frame spans or
+ * <tt>0</tt> if the memory could not be allocated
+ */
+static size_t
+_JAWTRenderer_reserveData(JAWTRenderer *renderer, int width, int height)
+{
+    int *dataOffsets;
+    int *dataPitches;
+    size_t dataLength;
+    int planeIndex;
+
+    dataOffsets = renderer->dataOffsets;
+    dataPitches = renderer->dataPitches;
+    /*
+     * Keep the offsets and the pitches which the image has told us (if any)
+     * so that it does not have to move the data.
+     */
+    if ((renderer->dataWidth != width) || (renderer->dataHeight != height))
+    {
+        dataPitches[0] = width;
+        dataPitches[1] = width / 2;
+        dataPitches[2] = width / 2;
+        dataOffsets[0] = 0;
+        dataOffsets[1] = width * height;
+        dataOffsets[2] = dataOffsets[1] + (width / 2) * (height / 2);
+        renderer->dataWidth = width;
+        renderer->dataHeight = height;
+    }
+    dataLength = 0;
+    for (planeIndex = 0; planeIndex < 3; planeIndex++)
+    {
+        size_t planeEnd;
+
+        planeEnd
+            = dataOffsets[planeIndex]
+                + dataPitches[planeIndex]
+                    * (size_t) (planeIndex ? (height / 2) : height);
+        if (planeEnd > dataLength)
+            dataLength = planeEnd;
+    }
+    if (!(renderer->data) || (renderer->dataCapacity < dataLength))
+    {
+        char *newData;
+
+        newData = realloc(renderer->data, dataLength);
+        if (!newData)
+            return 0;
+        renderer->data = newData;
+        renderer->dataCapacity = dataLength;
+    }
+    return dataLength;
+}
+
+/**
+ * Scales a plane of 8-bit samples with bilinear filtering in 16.16 fixed
+ * point into (the part within <tt>left</tt>, <tt>top</tt>, <tt>right</tt> and
+ * <tt>bottom</tt> of) a <tt>dstWidth</tt> by <tt>dstHeight</tt> rectangle, the
+ * visible top-left pixel of which is at <tt>dst</tt>. Equal sizes are copied
+ * and a row which falls on a source row is not blended.
+ *
+ * @param xs a table of <tt>right - left</tt> entries to be written
+ * @param row a row of <tt>srcWidth + 1</tt> samples to be written
+ */
+static void
+_JAWTRenderer_scalePlane
+    (char *dst, int dstPitch, int dstWidth, int dstHeight,
+        int left, int top, int right, int bottom,
+        const char *src, int srcPitch, int srcWidth, int srcHeight,
+        int *xs, unsigned char *row)
+{
+    int xStep;
+    int yStep;
+    int i;
+    int j;
+
+    if ((srcWidth == dstWidth) && (srcHeight == dstHeight))
+    {
+        src += top * srcPitch + left;
+        for (j = top; j < bottom; j++)
+        {
+            memcpy(dst, src, right - left);
+            dst += dstPitch;
+            src += srcPitch;
+        }
+        return;
+    }
+
+    /*
+     * Map the centres of the output pixels onto the input and keep the
+     * integral part and the 8 most significant bits of the fraction.
+     */
+    xStep = (int) (((int64_t) srcWidth << 16) / dstWidth);
+    yStep = (int) (((int64_t) srcHeight << 16) / dstHeight);
+    for (i = left; i < right; i++)
+    {
+        int sx;
+
+        sx = i * xStep + xStep / 2 - 0x8000;
+        if (sx < 0)
+            sx = 0;
+        if ((sx >> 16) >= srcWidth - 1)
+            sx = (srcWidth - 1) << 16;
+        xs[i - left] = ((sx >> 16) << 8) | ((sx >> 8) & 0xff);
+    }
+    for (j = top; j < bottom; j++)
+    {
+        int sy;
+        int y0;
+        int weight;
+        const unsigned char *srcRow;
+        unsigned char *dstRow;
+
+        sy = j * yStep + yStep / 2 - 0x8000;
+        if (sy < 0)
+            sy = 0;
+        y0 = sy >> 16;
+        weight = (sy >> 8) & 0xff;
+        if (y0 >= srcHeight - 1)
+        {
+            y0 = srcHeight - 1;
+            weight = 0;
+        }
+
+        srcRow = (const unsigned char *) (src + y0 * srcPitch);
+        if (weight)
+        {
+            _JAWTRenderer_blendRows(
+                    row,
+                    srcRow, srcRow + srcPitch,
+                    weight,
+                    srcWidth);
+            srcRow = row;
+        }
+        dstRow = (unsigned char *) dst;
+        if (srcWidth == dstWidth)
+            memcpy(dstRow, srcRow + left, right - left);
+        else
+        {
+            for (i = 0; i < right - left; i++)
+            {
+                int x;
+                int x0;
+                int fx;
+
+                x = xs[i];
+                x0 = x >> 8;
+                fx = x & 0xff;
+                /* The last column has no right neighbour and a 0 weight. */
+                dstRow[i]
+                    = fx
+                        ? ((srcRow[x0] * (256 - fx) + srcRow[x0 + 1] * fx
+                                    + 128)
+                                >> 8)
+                        : srcRow[x0];
+            }
+        }
+        dst += dstPitch;
+    }
+}
+
 static int
 _JAWTRenderer_ungrabPort(JAWTRenderer *renderer)
 {
@@ -632,6 +1598,9 @@ _JAWTRenderer_ungrabPort(JAWTRenderer *renderer)
     /* The XvImage is created on the XvPortID. */
     if (renderer->image)
         _JAWTRenderer_freeImage(renderer);
+    _JAWTRenderer_freeShmImages(renderer);
+    /* The held frame is put by the XvImage. */
+    _JAWTRenderer_releaseHeldPlanes(renderer);
 
     ret = XvUngrabPort(renderer->display, renderer->port, CurrentTime);
     renderer->port = -1;
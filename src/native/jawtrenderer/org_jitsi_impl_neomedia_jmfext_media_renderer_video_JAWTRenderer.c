@@ -8,6 +8,21 @@
 #include "org_jitsi_impl_neomedia_jmfext_media_renderer_video_JAWTRenderer.h"
 #include "JAWTRenderer.h"
 
+#if defined(__linux__) && !defined(__ANDROID__)
+#include <stdint.h>
+
+/**
+ * Does not release the planes of a frame handed to
+ * <tt>JAWTRenderer_processPlanes</tt> by Java which keeps them valid (e.g. by
+ * holding a reference to the pooled picture of an <tt>AVFrame</tt>) until the
+ * next invocation of a <tt>JAWTRenderer</tt> function with the same handle.
+ */
+static void
+_JAWTRenderer_releaseHeldByJava(void *opaque)
+{
+}
+#endif /* #if defined(__linux__) && !defined(__ANDROID__) */
+
 JNIEXPORT void JNICALL
 Java_org_jitsi_impl_neomedia_jmfext_media_renderer_video_JAWTRenderer_close
     (JNIEnv *env, jclass clazz, jlong handle, jobject component)
@@ -15,6 +30,37 @@ Java_org_jitsi_impl_neomedia_jmfext_media_renderer_video_JAWTRenderer_close
     JAWTRenderer_close(env, clazz, handle, component);
 }
 
+JNIEXPORT jboolean JNICALL
+Java_org_jitsi_impl_neomedia_jmfext_media_renderer_video_JAWTRenderer_composite
+    (JNIEnv *env, jclass clazz, jlong handle, jobject component,
+        jlong y, jint yStride, jlong u, jint uStride, jlong v, jint vStride,
+        jint width, jint height,
+        jint boundsX, jint boundsY, jint boundsWidth, jint boundsHeight,
+        jint surfaceWidth, jint surfaceHeight)
+{
+#if defined(__linux__) && !defined(__ANDROID__)
+    char *planes[3];
+    int strides[3];
+
+    planes[0] = (char *) (intptr_t) y;
+    planes[1] = (char *) (intptr_t) u;
+    planes[2] = (char *) (intptr_t) v;
+    strides[0] = yStride;
+    strides[1] = uStride;
+    strides[2] = vStride;
+    return
+        JAWTRenderer_composite(
+                env, clazz,
+                handle, component,
+                y ? planes : NULL, strides,
+                width, height,
+                boundsX, boundsY, boundsWidth, boundsHeight,
+                surfaceWidth, surfaceHeight);
+#else /* #if defined(__linux__) && !defined(__ANDROID__) */
+    return JNI_FALSE;
+#endif /* #if defined(__linux__) && !defined(__ANDROID__) */
+}
+
 JNIEXPORT jlong JNICALL
 Java_org_jitsi_impl_neomedia_jmfext_media_renderer_video_JAWTRenderer_open
     (JNIEnv *env, jclass clazz, jobject component)
@@ -126,6 +172,39 @@ Java_org_jitsi_impl_neomedia_jmfext_media_renderer_video_JAWTRenderer_process
     return processed;
 }
 
+JNIEXPORT jboolean JNICALL
+Java_org_jitsi_impl_neomedia_jmfext_media_renderer_video_JAWTRenderer_processPlanes
+    (JNIEnv *env, jclass clazz, jlong handle, jobject component,
+        jlong y, jint yStride, jlong u, jint uStride, jlong v, jint vStride,
+        jint width, jint height, jboolean hold)
+{
+#if defined(__linux__) && !defined(__ANDROID__)
+    char *planes[3];
+    int strides[3];
+
+    planes[0] = (char *) (intptr_t) y;
+    planes[1] = (char *) (intptr_t) u;
+    planes[2] = (char *) (intptr_t) v;
+    strides[0] = yStride;
+    strides[1] = uStride;
+    strides[2] = vStride;
+    /*
+     * Unless Java holds the planes for the renderer, they are only valid
+     * during the call.
+     */
+    return
+        JAWTRenderer_processPlanes(
+                env, clazz,
+                handle, component,
+                planes, strides,
+                width, height,
+                (JNI_TRUE == hold) ? _JAWTRenderer_releaseHeldByJava : NULL,
+                NULL);
+#else /* #if defined(__linux__) && !defined(__ANDROID__) */
+    return JNI_FALSE;
+#endif /* #if defined(__linux__) && !defined(__ANDROID__) */
+}
+
 JNIEXPORT jstring JNICALL
 Java_org_jitsi_impl_neomedia_jmfext_media_renderer_video_JAWTRenderer_sysctlbyname
     (JNIEnv *env, jclass clazz, jstring name)
@@ -15,6 +15,14 @@ extern "C" {
 JNIEXPORT void JNICALL Java_org_jitsi_impl_neomedia_jmfext_media_renderer_video_JAWTRenderer_close
   (JNIEnv *, jclass, jlong, jobject);
 
+/*
+ * Class:     org_jitsi_impl_neomedia_jmfext_media_renderer_video_JAWTRenderer
+ * Method:    composite
+ * Signature: (JLjava/awt/Component;JIJIJIIIIIIIII)Z
+ */
+JNIEXPORT jboolean JNICALL Java_org_jitsi_impl_neomedia_jmfext_media_renderer_video_JAWTRenderer_composite
+  (JNIEnv *, jclass, jlong, jobject, jlong, jint, jlong, jint, jlong, jint, jint, jint, jint, jint, jint, jint, jint, jint);
+
 /*
  * Class:     org_jitsi_impl_neomedia_jmfext_media_renderer_video_JAWTRenderer
  * Method:    open
@@ -39,6 +47,14 @@ JNIEXPORT jboolean JNICALL Java_org_jitsi_impl_neomedia_jmfext_media_renderer_vi
 JNIEXPORT jboolean JNICALL Java_org_jitsi_impl_neomedia_jmfext_media_renderer_video_JAWTRenderer_process
   (JNIEnv *, jclass, jlong, jobject, jintArray, jint, jint, jint, jint);
 
+/*
+ * Class:     org_jitsi_impl_neomedia_jmfext_media_renderer_video_JAWTRenderer
+ * Method:    processPlanes
+ * Signature: (JLjava/awt/Component;JIJIJIIIZ)Z
+ */
+JNIEXPORT jboolean JNICALL Java_org_jitsi_impl_neomedia_jmfext_media_renderer_video_JAWTRenderer_processPlanes
+  (JNIEnv *, jclass, jlong, jobject, jlong, jint, jlong, jint, jlong, jint, jint, jint, jboolean);
+
 /*
  * Class:     org_jitsi_impl_neomedia_jmfext_media_renderer_video_JAWTRenderer
  * Method:    sysctlbyname
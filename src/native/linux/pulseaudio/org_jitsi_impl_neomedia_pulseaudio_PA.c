@@ -9,22 +9,301 @@
 
 #include "org_jitsi_impl_neomedia_pulseaudio_PA.h"
 
+#include "../../realtime/Realtime.h"
+
 #include <dlfcn.h>
+#include <errno.h>
 #include <pulse/pulseaudio.h>
 #include <stdint.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#define DEVICE_REGISTRY_SINK org_jitsi_impl_neomedia_pulseaudio_PA_DEVICE_REGISTRY_SINK
+#define DEVICE_REGISTRY_SOURCE org_jitsi_impl_neomedia_pulseaudio_PA_DEVICE_REGISTRY_SOURCE
+
+#define SCHED_POLICY_DEFAULT org_jitsi_impl_neomedia_pulseaudio_PA_SCHED_POLICY_DEFAULT
+#define SCHED_POLICY_FIFO org_jitsi_impl_neomedia_pulseaudio_PA_SCHED_POLICY_FIFO
+#define SCHED_POLICY_NICE org_jitsi_impl_neomedia_pulseaudio_PA_SCHED_POLICY_NICE
+#define SCHED_POLICY_RR org_jitsi_impl_neomedia_pulseaudio_PA_SCHED_POLICY_RR
+
+#define STREAM_STATS_BUFFER_LENGTH org_jitsi_impl_neomedia_pulseaudio_PA_STREAM_STATS_BUFFER_LENGTH
+#define STREAM_STATS_CALLBACK_INTERVAL_HISTOGRAM org_jitsi_impl_neomedia_pulseaudio_PA_STREAM_STATS_CALLBACK_INTERVAL_HISTOGRAM
+#define STREAM_STATS_CALLBACK_INTERVAL_HISTOGRAM_LENGTH org_jitsi_impl_neomedia_pulseaudio_PA_STREAM_STATS_CALLBACK_INTERVAL_HISTOGRAM_LENGTH
+#define STREAM_STATS_CALLBACK_INTERVAL_MAX org_jitsi_impl_neomedia_pulseaudio_PA_STREAM_STATS_CALLBACK_INTERVAL_MAX
+#define STREAM_STATS_CALLBACKS org_jitsi_impl_neomedia_pulseaudio_PA_STREAM_STATS_CALLBACKS
+#define STREAM_STATS_HOLES org_jitsi_impl_neomedia_pulseaudio_PA_STREAM_STATS_HOLES
+#define STREAM_STATS_LATENCY org_jitsi_impl_neomedia_pulseaudio_PA_STREAM_STATS_LATENCY
+#define STREAM_STATS_LENGTH org_jitsi_impl_neomedia_pulseaudio_PA_STREAM_STATS_LENGTH
+#define STREAM_STATS_OVERFLOWS org_jitsi_impl_neomedia_pulseaudio_PA_STREAM_STATS_OVERFLOWS
+#define STREAM_STATS_PUMP_OVERFLOWS org_jitsi_impl_neomedia_pulseaudio_PA_STREAM_STATS_PUMP_OVERFLOWS
+#define STREAM_STATS_PUMP_UNDERFLOWS org_jitsi_impl_neomedia_pulseaudio_PA_STREAM_STATS_PUMP_UNDERFLOWS
+#define STREAM_STATS_REQUEST_BYTES org_jitsi_impl_neomedia_pulseaudio_PA_STREAM_STATS_REQUEST_BYTES
+#define STREAM_STATS_REQUEST_BYTES_MAX org_jitsi_impl_neomedia_pulseaudio_PA_STREAM_STATS_REQUEST_BYTES_MAX
+#define STREAM_STATS_UNDERFLOWS org_jitsi_impl_neomedia_pulseaudio_PA_STREAM_STATS_UNDERFLOWS
+
+/**
+ * The time in microseconds over which the underflows of a playback stream are
+ * counted by the adaptive mode of its health counters.
+ */
+#define STREAM_STATS_ADAPTIVE_WINDOW (10 * PA_USEC_PER_SEC)
 
 typedef pa_operation * (*pa_context_set_source_output_volume_t)(pa_context *c, uint32_t idx, const pa_cvolume *volume, pa_context_success_cb_t cb, void *userdata);
 
+/** Represents a sink or a source cached by a <tt>PulseAudioDeviceRegistry</tt>. */
+typedef struct _PulseAudioDevice
+{
+    char *description;
+    uint32_t index;
+
+    /**
+     * The index of the monitor source of a sink or the index of the sink
+     * monitored by a source.
+     */
+    uint32_t monitor;
+    char *name;
+    struct _PulseAudioDevice *next;
+    pa_sample_spec sampleSpec;
+
+    /** <tt>DEVICE_REGISTRY_SINK</tt> or <tt>DEVICE_REGISTRY_SOURCE</tt>. */
+    jint type;
+} PulseAudioDevice;
+
+/**
+ * Represents a cache of the sinks and sources of a <tt>pa_context</tt> which
+ * is kept current by the subscription events of the context on the thread of
+ * the threaded mainloop. Accessed with the mainloop lock held.
+ */
+typedef struct
+{
+    pa_context *context;
+    PulseAudioDevice *devices;
+
+    /**
+     * The indicator which determines whether the cache has changed since
+     * #version was last incremented.
+     */
+    int dirty;
+    pa_threaded_mainloop *mainloop;
+    int operationCapacity;
+    int operationCount;
+
+    /**
+     * The info operations started by the registry. They are referenced until
+     * they are no longer running so that the freeing of the registry can
+     * cancel the ones whose callbacks would otherwise reference it.
+     */
+    pa_operation **operations;
+
+    /** The number of info operations which have not completed yet. */
+    int pendingOperations;
+
+    /**
+     * The number of times the cache has changed. Zero until the initial lists
+     * of sinks and sources have been retrieved.
+     */
+    jlong version;
+} PulseAudioDeviceRegistry;
+
+/**
+ * Represents the health counters of a <tt>pa_stream</tt> i.e. the underflows
+ * and overflows reported by the server, the intervals between consecutive
+ * read/write requests and the number of bytes readable/writable upon the
+ * requests. The counters are updated on the thread of the threaded mainloop.
+ */
+typedef struct
+{
+    /**
+     * The maximum number of underflows per #STREAM_STATS_ADAPTIVE_WINDOW which
+     * the adaptive mode tolerates before it grows the buffer of #stream.
+     */
+    jint adaptiveGlitches;
+
+    /**
+     * The upper bound in bytes of the target length of the buffer of #stream
+     * in the adaptive mode. Zero if the adaptive mode is disabled.
+     */
+    uint32_t adaptiveMaxLength;
+
+    /**
+     * The lower bound in bytes of the target length of the buffer of #stream
+     * in the adaptive mode.
+     */
+    uint32_t adaptiveMinLength;
+
+    /**
+     * The number of underflows since #adaptiveWindowStart which occurred
+     * while audio was available to be written i.e. which the adaptive mode
+     * attributes to a too short buffer.
+     */
+    jlong adaptiveWindowUnderflows;
+
+    /**
+     * The time in microseconds at which the adaptive mode started counting
+     * the underflows of #stream anew.
+     */
+    pa_usec_t adaptiveWindowStart;
+
+    /** The time in microseconds of the latest read/write request. */
+    pa_usec_t lastRequestTime;
+
+    /**
+     * The time in microseconds of the latest underflow which occurred while
+     * #starved was set. Zero if there is no such underflow or it has been
+     * accounted for already.
+     */
+    pa_usec_t lastStarvedUnderflowTime;
+
+    /**
+     * The indicator which determines whether #stream is a playback stream
+     * (i.e. requests writes) or a record stream (i.e. requests reads).
+     */
+    int playback;
+
+    /**
+     * The weak reference to the <tt>stream_request_cb_t</tt> to be invoked
+     * after a read/write request has been recorded.
+     */
+    jweak requestCb;
+
+    /**
+     * The indicator which determines whether the latest attempt to write into
+     * #stream found no audio to be written.
+     */
+    int starved;
+    pa_stream *stream;
+
+    /**
+     * The values of the counters indexed by the <tt>STREAM_STATS_XXX</tt>
+     * constants.
+     */
+    jlong values[STREAM_STATS_LENGTH];
+} PulseAudioStreamStats;
+
+/**
+ * Represents a native I/O pump of a <tt>pa_stream</tt> which services the
+ * read/write requests of the stream on the thread of the threaded mainloop
+ * and hands the audio over to/from Java through a single-producer,
+ * single-consumer ring buffer. The Java thread blocks on an eventfd instead of
+ * on the mainloop lock.
+ */
+typedef struct
+{
+    /** The ring buffer of the audio. */
+    jbyte *buffer;
+
+    /** The capacity in bytes of #buffer. */
+    size_t capacity;
+
+    /**
+     * The eventfd which is signaled by the thread of the threaded mainloop
+     * whenever audio (to be read) or space (to be written) becomes available
+     * in #buffer or the pump gets interrupted.
+     */
+    int eventfd;
+
+    /**
+     * The indicator which determines whether the Java thread reading from or
+     * writing to this pump is not to block anymore.
+     */
+    int interrupted;
+
+    /**
+     * The eventfd which is signaled by the Java thread whenever it writes
+     * audio into #buffer so that the thread of the threaded mainloop writes it
+     * into #stream. Used by playback pumps only.
+     */
+    int kickEventfd;
+
+    /** The mainloop event which watches #kickEventfd. */
+    pa_io_event *kickEvent;
+    pa_mainloop_api *mainloopApi;
+
+    /**
+     * The indicator which determines whether this pump and #buffer are locked
+     * into RAM.
+     */
+    int memoryLocked;
+
+    /**
+     * The indicator which determines whether #stream is a playback stream
+     * (i.e. requests writes) or a record stream (i.e. requests reads).
+     */
+    int playback;
+
+    /**
+     * The number of bytes consumed from #buffer since the initialization of
+     * this pump. Written by the consumer only.
+     */
+    size_t readIndex;
+
+    /** The optional health counters of #stream. */
+    PulseAudioStreamStats *stats;
+    pa_stream *stream;
+
+    /**
+     * The number of bytes produced into #buffer since the initialization of
+     * this pump. Written by the producer only.
+     */
+    size_t writeIndex;
+} PulseAudioPump;
+
+/**
+ * Represents a request to set the scheduling policy of the thread of a
+ * threaded mainloop which is carried out on that thread.
+ */
+typedef struct
+{
+    /** The indicator which determines whether the request has been served. */
+    int done;
+    pa_threaded_mainloop *m;
+    jint policy;
+    jint priority;
+
+    /**
+     * The <tt>SCHED_POLICY_XXX</tt> constant which specifies the scheduling
+     * policy which took effect.
+     */
+    jint result;
+} PulseAudioSchedPolicyRequest;
+
 static void PulseAudio_contextStateCallback(pa_context *c, void *userdata);
+static void PulseAudio_copyFromRing(void *dst, const jbyte *ring, size_t capacity, size_t index, size_t length);
+static void PulseAudio_copyToRing(jbyte *ring, size_t capacity, size_t index, const void *src, size_t length);
+static void PulseAudio_deviceRegistryChanged(PulseAudioDeviceRegistry *registry);
+static void PulseAudio_deviceRegistryFree(PulseAudioDeviceRegistry *registry);
+static void PulseAudio_deviceRegistryOperation(PulseAudioDeviceRegistry *registry, pa_operation *o);
+static void PulseAudio_deviceRegistryOperationCompleted(PulseAudioDeviceRegistry *registry);
+static void PulseAudio_deviceRegistryPut(PulseAudioDeviceRegistry *registry, jint type, uint32_t index, uint32_t monitor, const pa_sample_spec *sampleSpec, const char *name, const char *description);
+static void PulseAudio_deviceRegistryRemove(PulseAudioDeviceRegistry *registry, jint type, uint32_t index);
+static void PulseAudio_deviceRegistrySinkInfoCallback(pa_context *c, const pa_sink_info *i, int eol, void *userdata);
+static void PulseAudio_deviceRegistrySourceInfoCallback(pa_context *c, const pa_source_info *i, int eol, void *userdata);
+static void PulseAudio_deviceRegistrySubscribeCallback(pa_context *c, pa_subscription_event_type_t t, uint32_t idx, void *userdata);
 #if (PA_MAJOR >= 1)
 static jlongArray PulseAudio_getFormatInfos(JNIEnv *env, jclass clazz, jsize length, pa_format_info **formats);
 #endif /* #if (PA_MAJOR >= 1) */
 static void PulseAudio_infoCallback(pa_context *c, jlong i, int eol, void *userdata, jmethodID methodID);
+static void PulseAudio_pumpFill(PulseAudioPump *pump, size_t nbytes);
+static void PulseAudio_pumpKickCallback(pa_mainloop_api *api, pa_io_event *e, int fd, pa_io_event_flags_t events, void *userdata);
+static void PulseAudio_pumpReadCallback(pa_stream *s, size_t nbytes, void *userdata);
+static void PulseAudio_pumpSignal(int fd);
+static void PulseAudio_pumpWait(int fd);
+static void PulseAudio_pumpWriteCallback(pa_stream *s, size_t nbytes, void *userdata);
+static jbyte *PulseAudio_putInt(jbyte *p, jint i);
+static jbyte *PulseAudio_putLong(jbyte *p, jlong l);
+static jbyte *PulseAudio_putString(jbyte *p, const char *str);
+static void PulseAudio_schedPolicyRequestCallback(pa_mainloop_api *api, void *userdata);
 static void PulseAudio_sinkInfoCallback(pa_context *c, const pa_sink_info *i, int eol, void *userdata);
 static void PulseAudio_sourceInfoCallback(pa_context *c, const pa_source_info *i, int eol, void *userdata);
 static void PulseAudio_stateCallback(void *userdata);
 static void PulseAudio_streamRequestCallback(pa_stream *s, size_t nbytes, void *userdata);
 static void PulseAudio_streamStateCallback(pa_stream *s, void *userdata);
+static void PulseAudio_streamStatsAdapt(PulseAudioStreamStats *streamStats, pa_usec_t now);
+static void PulseAudio_streamStatsOverflowCallback(pa_stream *s, void *userdata);
+static void PulseAudio_streamStatsRequest(PulseAudioStreamStats *streamStats, size_t nbytes);
+static void PulseAudio_streamStatsRequestCallback(pa_stream *s, size_t nbytes, void *userdata);
+static void PulseAudio_streamStatsUnderflowCallback(pa_stream *s, void *userdata);
+static void PulseAudio_streamStatsWrite(PulseAudioStreamStats *streamStats, size_t available);
 
 static pa_context_set_source_output_volume_t PulseAudio_contextSetSourceOutputVolume = NULL;
 static jclass PulseAudio_runnableClass = NULL;
@@ -252,6 +531,120 @@ Java_org_jitsi_impl_neomedia_pulseaudio_PA_cvolume_1set
                     (pa_volume_t) v);
 }
 
+JNIEXPORT void JNICALL
+Java_org_jitsi_impl_neomedia_pulseaudio_PA_device_1registry_1free
+    (JNIEnv *env, jclass clazz, jlong r)
+{
+    PulseAudioDeviceRegistry *registry
+        = (PulseAudioDeviceRegistry *) (intptr_t) r;
+
+    pa_context_set_subscribe_callback(registry->context, NULL, NULL);
+    PulseAudio_deviceRegistryFree(registry);
+}
+
+JNIEXPORT jbyteArray JNICALL
+Java_org_jitsi_impl_neomedia_pulseaudio_PA_device_1registry_1get_1snapshot
+    (JNIEnv *env, jclass clazz, jlong r)
+{
+    PulseAudioDeviceRegistry *registry
+        = (PulseAudioDeviceRegistry *) (intptr_t) r;
+    PulseAudioDevice *device;
+    jint count = 0;
+    size_t length = 8 /* version */ + 4 /* count */;
+    jbyte *snapshot;
+    jbyte *p;
+    jbyteArray ret;
+
+    for (device = registry->devices; device; device = device->next)
+    {
+        count++;
+        length
+            += 6 * 4 /* type, index, monitor, format, channels, rate */
+                + 4 + strlen(device->name)
+                + 4 + (device->description ? strlen(device->description) : 0);
+    }
+
+    p = snapshot = pa_xmalloc(length);
+    p = PulseAudio_putLong(p, registry->version);
+    p = PulseAudio_putInt(p, count);
+    for (device = registry->devices; device; device = device->next)
+    {
+        p = PulseAudio_putInt(p, device->type);
+        p = PulseAudio_putInt(p, device->index);
+        p = PulseAudio_putInt(p, device->monitor);
+        p = PulseAudio_putInt(p, device->sampleSpec.format);
+        p = PulseAudio_putInt(p, device->sampleSpec.channels);
+        p = PulseAudio_putInt(p, device->sampleSpec.rate);
+        p = PulseAudio_putString(p, device->name);
+        p = PulseAudio_putString(p, device->description);
+    }
+
+    ret = (*env)->NewByteArray(env, length);
+    if (ret)
+        (*env)->SetByteArrayRegion(env, ret, 0, length, snapshot);
+    pa_xfree(snapshot);
+    return ret;
+}
+
+JNIEXPORT jlong JNICALL
+Java_org_jitsi_impl_neomedia_pulseaudio_PA_device_1registry_1get_1version
+    (JNIEnv *env, jclass clazz, jlong r)
+{
+    return ((PulseAudioDeviceRegistry *) (intptr_t) r)->version;
+}
+
+JNIEXPORT jlong JNICALL
+Java_org_jitsi_impl_neomedia_pulseaudio_PA_device_1registry_1new
+    (JNIEnv *env, jclass clazz, jlong m, jlong c)
+{
+    PulseAudioDeviceRegistry *registry
+        = pa_xmalloc0(sizeof(PulseAudioDeviceRegistry));
+    pa_operation *o;
+
+    registry->context = (pa_context *) (intptr_t) c;
+    registry->mainloop = (pa_threaded_mainloop *) (intptr_t) m;
+
+    /*
+     * Subscribe before retrieving the initial lists so that no change goes
+     * unnoticed in between.
+     */
+    pa_context_set_subscribe_callback(
+            registry->context,
+            PulseAudio_deviceRegistrySubscribeCallback,
+            registry);
+    o
+        = pa_context_subscribe(
+                registry->context,
+                PA_SUBSCRIPTION_MASK_SINK | PA_SUBSCRIPTION_MASK_SOURCE,
+                NULL,
+                NULL);
+    if (!o)
+    {
+        pa_context_set_subscribe_callback(registry->context, NULL, NULL);
+        PulseAudio_deviceRegistryFree(registry);
+        return 0;
+    }
+    pa_operation_unref(o);
+
+    PulseAudio_deviceRegistryOperation(
+            registry,
+            pa_context_get_sink_info_list(
+                    registry->context,
+                    PulseAudio_deviceRegistrySinkInfoCallback,
+                    registry));
+    PulseAudio_deviceRegistryOperation(
+            registry,
+            pa_context_get_source_info_list(
+                    registry->context,
+                    PulseAudio_deviceRegistrySourceInfoCallback,
+                    registry));
+    /* Do not leave the registry without a version if both requests failed. */
+    if (!(registry->pendingOperations))
+        PulseAudio_deviceRegistryChanged(registry);
+
+    return (intptr_t) registry;
+}
+
 #if (PA_MAJOR >= 1)
 JNIEXPORT jint JNICALL
 Java_org_jitsi_impl_neomedia_pulseaudio_PA_format_1info_1get_1encoding
@@ -372,6 +765,238 @@ Java_org_jitsi_impl_neomedia_pulseaudio_PA_proplist_1sets
     return ret;
 }
 
+JNIEXPORT void JNICALL
+Java_org_jitsi_impl_neomedia_pulseaudio_PA_pump_1free
+    (JNIEnv *env, jclass clazz, jlong pump)
+{
+    PulseAudioPump *p = (PulseAudioPump *) (intptr_t) pump;
+
+    if (p->playback)
+    {
+        pa_stream_set_write_callback(p->stream, NULL, NULL);
+        if (p->kickEvent)
+            p->mainloopApi->io_free(p->kickEvent);
+        if (p->kickEventfd != -1)
+            close(p->kickEventfd);
+    }
+    else
+        pa_stream_set_read_callback(p->stream, NULL, NULL);
+    close(p->eventfd);
+    if (p->memoryLocked)
+    {
+        Realtime_unlockMemory(p->buffer, p->capacity);
+        Realtime_unlockMemory(p, sizeof(PulseAudioPump));
+    }
+    Realtime_free(p->buffer);
+    Realtime_free(p);
+}
+
+JNIEXPORT jboolean JNICALL
+Java_org_jitsi_impl_neomedia_pulseaudio_PA_pump_1lock_1memory
+    (JNIEnv *env, jclass clazz, jlong pump)
+{
+    PulseAudioPump *p = (PulseAudioPump *) (intptr_t) pump;
+
+    if (!(p->memoryLocked)
+            && !Realtime_lockMemory(p, sizeof(PulseAudioPump)))
+    {
+        if (Realtime_lockMemory(p->buffer, p->capacity))
+            Realtime_unlockMemory(p, sizeof(PulseAudioPump));
+        else
+            p->memoryLocked = 1;
+    }
+    return p->memoryLocked ? JNI_TRUE : JNI_FALSE;
+}
+
+JNIEXPORT jlong JNICALL
+Java_org_jitsi_impl_neomedia_pulseaudio_PA_pump_1new
+    (JNIEnv *env, jclass clazz, jlong m, jlong s, jint capacity,
+        jboolean playback, jlong stats)
+{
+    PulseAudioPump *pump;
+
+    if (capacity <= 0)
+        return 0;
+
+    /*
+     * The pump and its ring buffer are touched by the thread of the threaded
+     * mainloop so they are allocated in pages of their own which may be
+     * locked into RAM.
+     */
+    pump = Realtime_alloc(sizeof(PulseAudioPump));
+    if (!pump)
+        return 0;
+    pump->buffer = Realtime_alloc(capacity);
+    if (!(pump->buffer))
+    {
+        Realtime_free(pump);
+        return 0;
+    }
+    pump->capacity = capacity;
+    pump->kickEventfd = -1;
+    pump->mainloopApi
+        = pa_threaded_mainloop_get_api((pa_threaded_mainloop *) (intptr_t) m);
+    pump->playback = (JNI_TRUE == playback);
+    pump->stats = (PulseAudioStreamStats *) (intptr_t) stats;
+    pump->stream = (pa_stream *) (intptr_t) s;
+
+    pump->eventfd = eventfd(0, EFD_CLOEXEC);
+    if (pump->eventfd == -1)
+    {
+        Realtime_free(pump->buffer);
+        Realtime_free(pump);
+        return 0;
+    }
+    if (pump->playback)
+    {
+        pump->kickEventfd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+        if (pump->kickEventfd != -1)
+        {
+            pump->kickEvent
+                = pump->mainloopApi->io_new(
+                        pump->mainloopApi,
+                        pump->kickEventfd,
+                        PA_IO_EVENT_INPUT,
+                        PulseAudio_pumpKickCallback,
+                        pump);
+        }
+        if (!(pump->kickEvent))
+        {
+            Java_org_jitsi_impl_neomedia_pulseaudio_PA_pump_1free(
+                    env, clazz,
+                    (intptr_t) pump);
+            return 0;
+        }
+        pa_stream_set_write_callback(
+                pump->stream,
+                PulseAudio_pumpWriteCallback,
+                pump);
+    }
+    else
+    {
+        pa_stream_set_read_callback(
+                pump->stream,
+                PulseAudio_pumpReadCallback,
+                pump);
+    }
+    return (intptr_t) pump;
+}
+
+JNIEXPORT jint JNICALL
+Java_org_jitsi_impl_neomedia_pulseaudio_PA_pump_1read
+    (JNIEnv *env, jclass clazz, jlong pump, jbyteArray data, jint offset,
+        jint length)
+{
+    PulseAudioPump *p = (PulseAudioPump *) (intptr_t) pump;
+    size_t capacity = p->capacity;
+    jint read = 0;
+
+    while (read < length)
+    {
+        size_t readIndex = p->readIndex;
+        size_t available
+            = __atomic_load_n(&(p->writeIndex), __ATOMIC_ACQUIRE) - readIndex;
+
+        if (available)
+        {
+            size_t index = readIndex % capacity;
+            size_t tail = capacity - index;
+
+            if (available > (size_t) (length - read))
+                available = length - read;
+            if (tail > available)
+                tail = available;
+            (*env)->SetByteArrayRegion(
+                    env,
+                    data, offset + read, tail,
+                    p->buffer + index);
+            if (tail < available)
+            {
+                (*env)->SetByteArrayRegion(
+                        env,
+                        data, offset + read + tail, available - tail,
+                        p->buffer);
+            }
+            __atomic_store_n(
+                    &(p->readIndex),
+                    readIndex + available,
+                    __ATOMIC_RELEASE);
+            read += available;
+        }
+        else if (__atomic_load_n(&(p->interrupted), __ATOMIC_ACQUIRE))
+            break;
+        else
+            PulseAudio_pumpWait(p->eventfd);
+    }
+    return read;
+}
+
+JNIEXPORT void JNICALL
+Java_org_jitsi_impl_neomedia_pulseaudio_PA_pump_1set_1interrupted
+    (JNIEnv *env, jclass clazz, jlong pump, jboolean interrupted)
+{
+    PulseAudioPump *p = (PulseAudioPump *) (intptr_t) pump;
+
+    __atomic_store_n(
+            &(p->interrupted),
+            (JNI_TRUE == interrupted),
+            __ATOMIC_RELEASE);
+    if (JNI_TRUE == interrupted)
+        PulseAudio_pumpSignal(p->eventfd);
+}
+
+JNIEXPORT jint JNICALL
+Java_org_jitsi_impl_neomedia_pulseaudio_PA_pump_1write
+    (JNIEnv *env, jclass clazz, jlong pump, jbyteArray data, jint offset,
+        jint length)
+{
+    PulseAudioPump *p = (PulseAudioPump *) (intptr_t) pump;
+    size_t capacity = p->capacity;
+    jint written = 0;
+
+    while (written < length)
+    {
+        size_t writeIndex = p->writeIndex;
+        size_t free
+            = capacity
+                - (writeIndex
+                    - __atomic_load_n(&(p->readIndex), __ATOMIC_ACQUIRE));
+
+        if (free)
+        {
+            size_t index = writeIndex % capacity;
+            size_t tail = capacity - index;
+
+            if (free > (size_t) (length - written))
+                free = length - written;
+            if (tail > free)
+                tail = free;
+            (*env)->GetByteArrayRegion(
+                    env,
+                    data, offset + written, tail,
+                    p->buffer + index);
+            if (tail < free)
+            {
+                (*env)->GetByteArrayRegion(
+                        env,
+                        data, offset + written + tail, free - tail,
+                        p->buffer);
+            }
+            __atomic_store_n(
+                    &(p->writeIndex),
+                    writeIndex + free,
+                    __ATOMIC_RELEASE);
+            written += free;
+            PulseAudio_pumpSignal(p->kickEventfd);
+        }
+        else if (__atomic_load_n(&(p->interrupted), __ATOMIC_ACQUIRE))
+            break;
+        else
+            PulseAudio_pumpWait(p->eventfd);
+    }
+    return written;
+}
+
 JNIEXPORT void JNICALL
 Java_org_jitsi_impl_neomedia_pulseaudio_PA_sample_1spec_1free
     (JNIEnv *env, jclass clazz, jlong ss)
@@ -622,6 +1247,19 @@ Java_org_jitsi_impl_neomedia_pulseaudio_PA_stream_1get_1index
     return pa_stream_get_index((pa_stream *) (intptr_t) s);
 }
 
+JNIEXPORT jlong JNICALL
+Java_org_jitsi_impl_neomedia_pulseaudio_PA_stream_1get_1latency
+    (JNIEnv *env, jclass clazz, jlong s)
+{
+    pa_usec_t latency;
+    int negative;
+
+    if (pa_stream_get_latency((pa_stream *) (intptr_t) s, &latency, &negative)
+            < 0)
+        return -1;
+    return negative ? 0 : (jlong) latency;
+}
+
 JNIEXPORT jint JNICALL
 Java_org_jitsi_impl_neomedia_pulseaudio_PA_stream_1get_1state
     (JNIEnv *env, jclass clazz, jlong s)
@@ -685,14 +1323,29 @@ Java_org_jitsi_impl_neomedia_pulseaudio_PA_stream_1readable_1size
 
 JNIEXPORT void JNICALL
 Java_org_jitsi_impl_neomedia_pulseaudio_PA_stream_1set_1read_1callback
-    (JNIEnv *env, jclass clazz, jlong s, jobject cb)
+    (JNIEnv *env, jclass clazz, jlong s, jobject cb, jlong stats)
 {
     jweak weakCb = cb ? (*env)->NewWeakGlobalRef(env, cb) : NULL;
+    PulseAudioStreamStats *streamStats
+        = (PulseAudioStreamStats *) (intptr_t) stats;
 
-    pa_stream_set_read_callback(
-            (pa_stream *) (intptr_t) s,
-            weakCb ? PulseAudio_streamRequestCallback : NULL,
-            (void *) weakCb);
+    if (streamStats)
+    {
+        if (streamStats->requestCb)
+            (*env)->DeleteWeakGlobalRef(env, streamStats->requestCb);
+        streamStats->requestCb = weakCb;
+        pa_stream_set_read_callback(
+                (pa_stream *) (intptr_t) s,
+                weakCb ? PulseAudio_streamStatsRequestCallback : NULL,
+                weakCb ? (void *) streamStats : NULL);
+    }
+    else
+    {
+        pa_stream_set_read_callback(
+                (pa_stream *) (intptr_t) s,
+                weakCb ? PulseAudio_streamRequestCallback : NULL,
+                (void *) weakCb);
+    }
 }
 
 JNIEXPORT void JNICALL
@@ -709,14 +1362,119 @@ Java_org_jitsi_impl_neomedia_pulseaudio_PA_stream_1set_1state_1callback
 
 JNIEXPORT void
 JNICALL Java_org_jitsi_impl_neomedia_pulseaudio_PA_stream_1set_1write_1callback
-    (JNIEnv *env, jclass clazz, jlong s, jobject cb)
+    (JNIEnv *env, jclass clazz, jlong s, jobject cb, jlong stats)
 {
     jweak weakCb = cb ? (*env)->NewWeakGlobalRef(env, cb) : NULL;
+    PulseAudioStreamStats *streamStats
+        = (PulseAudioStreamStats *) (intptr_t) stats;
 
-    pa_stream_set_write_callback(
-            (pa_stream *) (intptr_t) s,
-            weakCb ? PulseAudio_streamRequestCallback : NULL,
-            (void *) weakCb);
+    if (streamStats)
+    {
+        if (streamStats->requestCb)
+            (*env)->DeleteWeakGlobalRef(env, streamStats->requestCb);
+        streamStats->requestCb = weakCb;
+        pa_stream_set_write_callback(
+                (pa_stream *) (intptr_t) s,
+                weakCb ? PulseAudio_streamStatsRequestCallback : NULL,
+                weakCb ? (void *) streamStats : NULL);
+    }
+    else
+    {
+        pa_stream_set_write_callback(
+                (pa_stream *) (intptr_t) s,
+                weakCb ? PulseAudio_streamRequestCallback : NULL,
+                (void *) weakCb);
+    }
+}
+
+JNIEXPORT void JNICALL
+Java_org_jitsi_impl_neomedia_pulseaudio_PA_stream_1stats_1free
+    (JNIEnv *env, jclass clazz, jlong stats)
+{
+    PulseAudioStreamStats *streamStats
+        = (PulseAudioStreamStats *) (intptr_t) stats;
+    pa_stream *stream = streamStats->stream;
+
+    /*
+     * Make sure that the native callbacks of the stream will not refer to the
+     * freed memory.
+     */
+    pa_stream_set_overflow_callback(stream, NULL, NULL);
+    pa_stream_set_underflow_callback(stream, NULL, NULL);
+    if (streamStats->requestCb)
+    {
+        if (streamStats->playback)
+            pa_stream_set_write_callback(stream, NULL, NULL);
+        else
+            pa_stream_set_read_callback(stream, NULL, NULL);
+        (*env)->DeleteWeakGlobalRef(env, streamStats->requestCb);
+    }
+    pa_xfree(streamStats);
+}
+
+JNIEXPORT void JNICALL
+Java_org_jitsi_impl_neomedia_pulseaudio_PA_stream_1stats_1get
+    (JNIEnv *env, jclass clazz, jlong stats, jlongArray values)
+{
+    PulseAudioStreamStats *streamStats
+        = (PulseAudioStreamStats *) (intptr_t) stats;
+    jsize length = (*env)->GetArrayLength(env, values);
+
+    if (length > STREAM_STATS_LENGTH)
+        length = STREAM_STATS_LENGTH;
+    if (length > 0)
+    {
+        (*env)->SetLongArrayRegion(
+                env,
+                values, 0, length, streamStats->values);
+    }
+}
+
+JNIEXPORT jlong JNICALL
+Java_org_jitsi_impl_neomedia_pulseaudio_PA_stream_1stats_1new
+    (JNIEnv *env, jclass clazz, jlong s, jboolean playback)
+{
+    PulseAudioStreamStats *streamStats
+        = pa_xmalloc0(sizeof(PulseAudioStreamStats));
+
+    if (streamStats)
+    {
+        pa_stream *stream = (pa_stream *) (intptr_t) s;
+
+        streamStats->playback = (JNI_TRUE == playback);
+        streamStats->stream = stream;
+        pa_stream_set_overflow_callback(
+                stream,
+                PulseAudio_streamStatsOverflowCallback,
+                streamStats);
+        pa_stream_set_underflow_callback(
+                stream,
+                PulseAudio_streamStatsUnderflowCallback,
+                streamStats);
+    }
+    return (intptr_t) streamStats;
+}
+
+JNIEXPORT void JNICALL
+Java_org_jitsi_impl_neomedia_pulseaudio_PA_stream_1stats_1set_1adaptive
+    (JNIEnv *env, jclass clazz, jlong stats, jint minLength, jint maxLength,
+        jint glitches)
+{
+    PulseAudioStreamStats *streamStats
+        = (PulseAudioStreamStats *) (intptr_t) stats;
+
+    /* The server reports underflows of playback streams only. */
+    if (!(streamStats->playback) || (minLength <= 0) || (maxLength < minLength))
+        streamStats->adaptiveMaxLength = 0;
+    else
+    {
+        streamStats->adaptiveGlitches = (glitches < 0) ? 0 : glitches;
+        streamStats->adaptiveMaxLength = maxLength;
+        streamStats->adaptiveMinLength = minLength;
+        streamStats->adaptiveWindowStart = pa_rtclock_now();
+        streamStats->adaptiveWindowUnderflows = 0;
+        streamStats->lastStarvedUnderflowTime = 0;
+    }
 }
 
 JNIEXPORT void JNICALL
@@ -829,6 +1587,33 @@ Java_org_jitsi_impl_neomedia_pulseaudio_PA_threaded_1mainloop_1signal
             (int) waitForAccept);
 }
 
+JNIEXPORT jint JNICALL
+Java_org_jitsi_impl_neomedia_pulseaudio_PA_threaded_1mainloop_1set_1sched_1policy
+    (JNIEnv *env, jclass clazz, jlong m, jint policy, jint priority)
+{
+    pa_threaded_mainloop *mainloop = (pa_threaded_mainloop *) (intptr_t) m;
+    PulseAudioSchedPolicyRequest request;
+
+    if (pa_threaded_mainloop_in_thread(mainloop))
+        return Realtime_setThreadSchedPolicy(policy, priority);
+
+    request.done = 0;
+    request.m = mainloop;
+    request.policy = policy;
+    request.priority = priority;
+    request.result = SCHED_POLICY_DEFAULT;
+
+    pa_threaded_mainloop_lock(mainloop);
+    pa_mainloop_api_once(
+            pa_threaded_mainloop_get_api(mainloop),
+            PulseAudio_schedPolicyRequestCallback,
+            &request);
+    while (!request.done)
+        pa_threaded_mainloop_wait(mainloop);
+    pa_threaded_mainloop_unlock(mainloop);
+    return request.result;
+}
+
 JNIEXPORT jint JNICALL
 Java_org_jitsi_impl_neomedia_pulseaudio_PA_threaded_1mainloop_1start
     (JNIEnv *env, jclass clazz, jlong m)
@@ -1007,6 +1792,291 @@ PulseAudio_contextStateCallback(pa_context *c, void *userdata)
     PulseAudio_stateCallback(userdata);
 }
 
+static void
+PulseAudio_copyFromRing
+    (void *dst, const jbyte *ring, size_t capacity, size_t index,
+        size_t length)
+{
+    size_t tail;
+
+    index %= capacity;
+    tail = capacity - index;
+    if (tail > length)
+        tail = length;
+    memcpy(dst, ring + index, tail);
+    if (tail < length)
+        memcpy(((jbyte *) dst) + tail, ring, length - tail);
+}
+
+/**
+ * Copies bytes into a ring buffer wrapping around at its capacity. If the
+ * source is <tt>NULL</tt> (e.g. a hole in a record stream), silence is copied
+ * instead.
+ */
+static void
+PulseAudio_copyToRing
+    (jbyte *ring, size_t capacity, size_t index, const void *src,
+        size_t length)
+{
+    size_t tail;
+
+    index %= capacity;
+    tail = capacity - index;
+    if (tail > length)
+        tail = length;
+    if (src)
+    {
+        memcpy(ring + index, src, tail);
+        if (tail < length)
+            memcpy(ring, ((const jbyte *) src) + tail, length - tail);
+    }
+    else
+    {
+        memset(ring + index, 0, tail);
+        if (tail < length)
+            memset(ring, 0, length - tail);
+    }
+}
+
+/**
+ * Notes that the cache of a specific <tt>PulseAudioDeviceRegistry</tt> has
+ * changed. The version of the registry is incremented once no info operation
+ * is pending anymore so that a snapshot never reflects a partial update.
+ */
+static void
+PulseAudio_deviceRegistryChanged(PulseAudioDeviceRegistry *registry)
+{
+    registry->dirty = 1;
+    if (!(registry->pendingOperations))
+    {
+        registry->dirty = 0;
+        registry->version++;
+        pa_threaded_mainloop_signal(registry->mainloop, 0);
+    }
+}
+
+static void
+PulseAudio_deviceRegistryFree(PulseAudioDeviceRegistry *registry)
+{
+    PulseAudioDevice *device = registry->devices;
+    int i;
+
+    /*
+     * The callbacks of the pending operations reference the registry. They
+     * never run once the context has failed or terminated so the operations
+     * are cancelled rather than waited for.
+     */
+    for (i = 0; i < registry->operationCount; i++)
+    {
+        pa_operation *o = registry->operations[i];
+
+        if (pa_operation_get_state(o) == PA_OPERATION_RUNNING)
+            pa_operation_cancel(o);
+        pa_operation_unref(o);
+    }
+    pa_xfree(registry->operations);
+
+    while (device)
+    {
+        PulseAudioDevice *next = device->next;
+
+        pa_xfree(device->description);
+        pa_xfree(device->name);
+        pa_xfree(device);
+        device = next;
+    }
+    pa_xfree(registry);
+}
+
+static void
+PulseAudio_deviceRegistryOperation
+    (PulseAudioDeviceRegistry *registry, pa_operation *o)
+{
+    if (o)
+    {
+        int i;
+        int count = 0;
+
+        /* Release the operations which are no longer running. */
+        for (i = 0; i < registry->operationCount; i++)
+        {
+            pa_operation *operation = registry->operations[i];
+
+            if (pa_operation_get_state(operation) == PA_OPERATION_RUNNING)
+                registry->operations[count++] = operation;
+            else
+                pa_operation_unref(operation);
+        }
+        registry->operationCount = count;
+
+        if (registry->operationCount == registry->operationCapacity)
+        {
+            registry->operationCapacity
+                = registry->operationCapacity
+                    ? (2 * registry->operationCapacity)
+                    : 4;
+            registry->operations
+                = pa_xrealloc(
+                        registry->operations,
+                        registry->operationCapacity * sizeof(pa_operation *));
+        }
+        registry->operations[registry->operationCount++] = o;
+        registry->pendingOperations++;
+    }
+}
+
+static void
+PulseAudio_deviceRegistryOperationCompleted(PulseAudioDeviceRegistry *registry)
+{
+    registry->pendingOperations--;
+    if (!(registry->pendingOperations)
+            && (registry->dirty || !(registry->version)))
+        PulseAudio_deviceRegistryChanged(registry);
+}
+
+static void
+PulseAudio_deviceRegistryPut
+    (PulseAudioDeviceRegistry *registry, jint type, uint32_t index,
+        uint32_t monitor, const pa_sample_spec *sampleSpec, const char *name,
+        const char *description)
+{
+    PulseAudioDevice **tail = &(registry->devices);
+    PulseAudioDevice *device;
+
+    while ((device = *tail))
+    {
+        if ((device->type == type) && (device->index == index))
+            break;
+        tail = &(device->next);
+    }
+    if (device)
+    {
+        pa_xfree(device->description);
+        pa_xfree(device->name);
+    }
+    else
+    {
+        /* Append in order to preserve the order reported by the server. */
+        device = pa_xmalloc0(sizeof(PulseAudioDevice));
+        device->index = index;
+        device->type = type;
+        *tail = device;
+    }
+    device->description = description ? pa_xstrdup(description) : NULL;
+    device->monitor = monitor;
+    device->name = pa_xstrdup(name ? name : "");
+    device->sampleSpec = *sampleSpec;
+    PulseAudio_deviceRegistryChanged(registry);
+}
+
+static void
+PulseAudio_deviceRegistryRemove
+    (PulseAudioDeviceRegistry *registry, jint type, uint32_t index)
+{
+    PulseAudioDevice **prev = &(registry->devices);
+    PulseAudioDevice *device;
+
+    while ((device = *prev))
+    {
+        if ((device->type == type) && (device->index == index))
+        {
+            *prev = device->next;
+            pa_xfree(device->description);
+            pa_xfree(device->name);
+            pa_xfree(device);
+            PulseAudio_deviceRegistryChanged(registry);
+            break;
+        }
+        prev = &(device->next);
+    }
+}
+
+static void
+PulseAudio_deviceRegistrySinkInfoCallback
+    (pa_context *c, const pa_sink_info *i, int eol, void *userdata)
+{
+    PulseAudioDeviceRegistry *registry = (PulseAudioDeviceRegistry *) userdata;
+
+    if (eol)
+        PulseAudio_deviceRegistryOperationCompleted(registry);
+    else if (i)
+    {
+        PulseAudio_deviceRegistryPut(
+                registry,
+                DEVICE_REGISTRY_SINK,
+                i->index,
+                i->monitor_source,
+                &(i->sample_spec),
+                i->name,
+                i->description);
+    }
+}
+
+static void
+PulseAudio_deviceRegistrySourceInfoCallback
+    (pa_context *c, const pa_source_info *i, int eol, void *userdata)
+{
+    PulseAudioDeviceRegistry *registry = (PulseAudioDeviceRegistry *) userdata;
+
+    if (eol)
+        PulseAudio_deviceRegistryOperationCompleted(registry);
+    else if (i)
+    {
+        PulseAudio_deviceRegistryPut(
+                registry,
+                DEVICE_REGISTRY_SOURCE,
+                i->index,
+                i->monitor_of_sink,
+                &(i->sample_spec),
+                i->name,
+                i->description);
+    }
+}
+
+static void
+PulseAudio_deviceRegistrySubscribeCallback
+    (pa_context *c, pa_subscription_event_type_t t, uint32_t idx,
+        void *userdata)
+{
+    PulseAudioDeviceRegistry *registry = (PulseAudioDeviceRegistry *) userdata;
+    jint type;
+
+    switch (t & PA_SUBSCRIPTION_EVENT_FACILITY_MASK)
+    {
+    case PA_SUBSCRIPTION_EVENT_SINK:
+        type = DEVICE_REGISTRY_SINK;
+        break;
+    case PA_SUBSCRIPTION_EVENT_SOURCE:
+        type = DEVICE_REGISTRY_SOURCE;
+        break;
+    default:
+        return;
+    }
+
+    if ((t & PA_SUBSCRIPTION_EVENT_TYPE_MASK) == PA_SUBSCRIPTION_EVENT_REMOVE)
+        PulseAudio_deviceRegistryRemove(registry, type, idx);
+    else if (DEVICE_REGISTRY_SINK == type)
+    {
+        PulseAudio_deviceRegistryOperation(
+                registry,
+                pa_context_get_sink_info_by_index(
+                        c,
+                        idx,
+                        PulseAudio_deviceRegistrySinkInfoCallback,
+                        registry));
+    }
+    else
+    {
+        PulseAudio_deviceRegistryOperation(
+                registry,
+                pa_context_get_source_info_by_index(
+                        c,
+                        idx,
+                        PulseAudio_deviceRegistrySourceInfoCallback,
+                        registry));
+    }
+}
+
 #if (PA_MAJOR >= 1)
 static jlongArray
 PulseAudio_getFormatInfos
@@ -1064,6 +2134,205 @@ PulseAudio_infoCallback
     }
 }
 
+/**
+ * Writes the audio available in the ring buffer of a specific playback
+ * <tt>PulseAudioPump</tt> into its stream up to a specific number of bytes.
+ * Invoked on the thread of the threaded mainloop.
+ */
+static void
+PulseAudio_pumpFill(PulseAudioPump *pump, size_t nbytes)
+{
+    size_t readIndex = pump->readIndex;
+    size_t available
+        = __atomic_load_n(&(pump->writeIndex), __ATOMIC_ACQUIRE) - readIndex;
+
+    if (nbytes > available)
+    {
+        if (pump->stats && !available)
+            pump->stats->values[STREAM_STATS_PUMP_UNDERFLOWS]++;
+        nbytes = available;
+    }
+    if (pump->stats)
+        PulseAudio_streamStatsWrite(pump->stats, available);
+    while (nbytes)
+    {
+        void *data = NULL;
+        size_t length = nbytes;
+
+        /* Copy straight into the memory of the stream to avoid one more copy. */
+        if ((pa_stream_begin_write(pump->stream, &data, &length) < 0)
+                || !data
+                || !length)
+            break;
+        if (length > nbytes)
+            length = nbytes;
+        PulseAudio_copyFromRing(
+                data,
+                pump->buffer, pump->capacity,
+                readIndex,
+                length);
+        if (pa_stream_write(
+                    pump->stream,
+                    data, length,
+                    NULL,
+                    0,
+                    PA_SEEK_RELATIVE)
+                < 0)
+        {
+            pa_stream_cancel_write(pump->stream);
+            break;
+        }
+        readIndex += length;
+        nbytes -= length;
+    }
+    if (readIndex != pump->readIndex)
+    {
+        __atomic_store_n(&(pump->readIndex), readIndex, __ATOMIC_RELEASE);
+        PulseAudio_pumpSignal(pump->eventfd);
+    }
+}
+
+static void
+PulseAudio_pumpKickCallback
+    (pa_mainloop_api *api, pa_io_event *e, int fd, pa_io_event_flags_t events,
+        void *userdata)
+{
+    PulseAudioPump *pump = (PulseAudioPump *) userdata;
+    uint64_t value;
+    size_t writableSize;
+
+    while (read(fd, &value, sizeof(value)) > 0);
+    writableSize = pa_stream_writable_size(pump->stream);
+    if (writableSize != (size_t) -1)
+        PulseAudio_pumpFill(pump, writableSize);
+}
+
+static void
+PulseAudio_pumpReadCallback(pa_stream *s, size_t nbytes, void *userdata)
+{
+    PulseAudioPump *pump = (PulseAudioPump *) userdata;
+    size_t writeIndex = pump->writeIndex;
+
+    if (pump->stats)
+        PulseAudio_streamStatsRequest(pump->stats, nbytes);
+    for (;;)
+    {
+        const void *bytes = NULL;
+        size_t free;
+
+        nbytes = 0;
+        if ((pa_stream_peek(s, &bytes, &nbytes) < 0) || !nbytes)
+            break;
+
+        free
+            = pump->capacity
+                - (writeIndex
+                    - __atomic_load_n(&(pump->readIndex), __ATOMIC_ACQUIRE));
+        if (nbytes > free)
+        {
+            /*
+             * The consumer owns the oldest audio so the newest is dropped
+             * when the consumer does not keep up.
+             */
+            if (pump->stats)
+                pump->stats->values[STREAM_STATS_PUMP_OVERFLOWS]++;
+        }
+        else
+        {
+            PulseAudio_copyToRing(
+                    pump->buffer, pump->capacity,
+                    writeIndex,
+                    bytes, nbytes);
+            if (!bytes && pump->stats)
+                pump->stats->values[STREAM_STATS_HOLES]++;
+            writeIndex += nbytes;
+        }
+        pa_stream_drop(s);
+    }
+    if (writeIndex != pump->writeIndex)
+    {
+        __atomic_store_n(&(pump->writeIndex), writeIndex, __ATOMIC_RELEASE);
+        PulseAudio_pumpSignal(pump->eventfd);
+    }
+}
+
+static void
+PulseAudio_pumpSignal(int fd)
+{
+    uint64_t value = 1;
+
+    while ((write(fd, &value, sizeof(value)) < 0) && (errno == EINTR));
+}
+
+/** Blocks the calling thread until a specific eventfd is signaled. */
+static void
+PulseAudio_pumpWait(int fd)
+{
+    uint64_t value;
+
+    while ((read(fd, &value, sizeof(value)) < 0) && (errno == EINTR));
+}
+
+static void
+PulseAudio_pumpWriteCallback(pa_stream *s, size_t nbytes, void *userdata)
+{
+    PulseAudioPump *pump = (PulseAudioPump *) userdata;
+
+    if (pump->stats)
+        PulseAudio_streamStatsRequest(pump->stats, nbytes);
+    PulseAudio_pumpFill(pump, nbytes);
+}
+
+/** Writes a specific <tt>jint</tt> in big-endian byte order. */
+static jbyte *
+PulseAudio_putInt(jbyte *p, jint i)
+{
+    p[0] = (jbyte) (i >> 24);
+    p[1] = (jbyte) (i >> 16);
+    p[2] = (jbyte) (i >> 8);
+    p[3] = (jbyte) i;
+    return p + 4;
+}
+
+static jbyte *
+PulseAudio_putLong(jbyte *p, jlong l)
+{
+    p = PulseAudio_putInt(p, (jint) (l >> 32));
+    return PulseAudio_putInt(p, (jint) l);
+}
+
+/**
+ * Writes the length in bytes of a specific UTF-8 string followed by its bytes.
+ * A <tt>NULL</tt> string is written as the length <tt>-1</tt>.
+ */
+static jbyte *
+PulseAudio_putString(jbyte *p, const char *str)
+{
+    if (str)
+    {
+        size_t length = strlen(str);
+
+        p = PulseAudio_putInt(p, (jint) length);
+        memcpy(p, str, length);
+        p += length;
+    }
+    else
+        p = PulseAudio_putInt(p, -1);
+    return p;
+}
+
+static void
+PulseAudio_schedPolicyRequestCallback(pa_mainloop_api *api, void *userdata)
+{
+    PulseAudioSchedPolicyRequest *request
+        = (PulseAudioSchedPolicyRequest *) userdata;
+
+    request->result
+        = Realtime_setThreadSchedPolicy(request->policy, request->priority);
+    request->done = 1;
+    pa_threaded_mainloop_signal(request->m, 0);
+}
+
 static void
 PulseAudio_sinkInfoCallback
     (pa_context *c, const pa_sink_info *i, int eol, void *userdata)
@@ -1157,3 +2426,183 @@ PulseAudio_streamStateCallback(pa_stream *s, void *userdata)
 {
     PulseAudio_stateCallback(userdata);
 }
+
+/**
+ * Updates the latency of the stream of specific health counters and, if their
+ * adaptive mode is enabled, grows the target length of the buffer of the
+ * stream as soon as more underflows than tolerated occur within
+ * #STREAM_STATS_ADAPTIVE_WINDOW and shrinks it after a window with at most
+ * half of the tolerated underflows. Thus the target length converges on the
+ * smallest one which keeps the underflows within the tolerated rate.
+ */
+static void
+PulseAudio_streamStatsAdapt(PulseAudioStreamStats *streamStats, pa_usec_t now)
+{
+    pa_stream *stream = streamStats->stream;
+    jlong *values = streamStats->values;
+    pa_usec_t latency;
+    int negative;
+    const pa_buffer_attr *attr;
+    jlong underflows;
+    uint32_t length;
+
+    if (pa_stream_get_latency(stream, &latency, &negative) >= 0)
+        values[STREAM_STATS_LATENCY] = negative ? 0 : (jlong) latency;
+
+    if (!(streamStats->adaptiveMaxLength))
+        return;
+    attr = pa_stream_get_buffer_attr(stream);
+    if (!attr)
+        return;
+
+    length = attr->tlength;
+    values[STREAM_STATS_BUFFER_LENGTH] = length;
+    underflows = streamStats->adaptiveWindowUnderflows;
+    if (underflows > streamStats->adaptiveGlitches)
+        length += length / 2;
+    else if (now - streamStats->adaptiveWindowStart
+            >= STREAM_STATS_ADAPTIVE_WINDOW)
+    {
+        if (underflows * 2 <= streamStats->adaptiveGlitches)
+            length -= length / 8;
+    }
+    else
+        return;
+
+    if (length < streamStats->adaptiveMinLength)
+        length = streamStats->adaptiveMinLength;
+    else if (length > streamStats->adaptiveMaxLength)
+        length = streamStats->adaptiveMaxLength;
+    streamStats->adaptiveWindowStart = now;
+    streamStats->adaptiveWindowUnderflows = 0;
+
+    if (length != attr->tlength)
+    {
+        pa_buffer_attr newAttr = *attr;
+        pa_operation *o;
+
+        /* Let the server derive the prebuffering and the request size. */
+        newAttr.tlength = length;
+        newAttr.prebuf = (uint32_t) -1;
+        newAttr.minreq = (uint32_t) -1;
+        o = pa_stream_set_buffer_attr(stream, &newAttr, NULL, NULL);
+        if (o)
+        {
+            pa_operation_unref(o);
+            values[STREAM_STATS_BUFFER_LENGTH] = length;
+        }
+    }
+}
+
+static void
+PulseAudio_streamStatsOverflowCallback(pa_stream *s, void *userdata)
+{
+    ((PulseAudioStreamStats *) userdata)->values[STREAM_STATS_OVERFLOWS]++;
+}
+
+static void
+PulseAudio_streamStatsRequest(PulseAudioStreamStats *streamStats, size_t nbytes)
+{
+    jlong *values = streamStats->values;
+    pa_usec_t now = pa_rtclock_now();
+
+    values[STREAM_STATS_CALLBACKS]++;
+    values[STREAM_STATS_REQUEST_BYTES] = nbytes;
+    if (values[STREAM_STATS_REQUEST_BYTES_MAX] < (jlong) nbytes)
+        values[STREAM_STATS_REQUEST_BYTES_MAX] = nbytes;
+    if (streamStats->lastRequestTime)
+    {
+        jlong interval = (jlong) (now - streamStats->lastRequestTime) * 1000;
+        jlong intervalInMillis = interval / 1000000;
+        int bin = 0;
+
+        if (values[STREAM_STATS_CALLBACK_INTERVAL_MAX] < interval)
+            values[STREAM_STATS_CALLBACK_INTERVAL_MAX] = interval;
+
+        /*
+         * The first bin counts the intervals shorter than a millisecond, each
+         * subsequent bin doubles the upper bound of the previous one and the
+         * last bin counts whatever remains.
+         */
+        while ((intervalInMillis > 0)
+                && (bin < STREAM_STATS_CALLBACK_INTERVAL_HISTOGRAM_LENGTH - 1))
+        {
+            intervalInMillis >>= 1;
+            bin++;
+        }
+        values[STREAM_STATS_CALLBACK_INTERVAL_HISTOGRAM + bin]++;
+    }
+    streamStats->lastRequestTime = now;
+
+    PulseAudio_streamStatsAdapt(streamStats, now);
+}
+
+static void
+PulseAudio_streamStatsRequestCallback(pa_stream *s, size_t nbytes, void *userdata)
+{
+    PulseAudioStreamStats *streamStats = (PulseAudioStreamStats *) userdata;
+
+    PulseAudio_streamStatsRequest(streamStats, nbytes);
+    PulseAudio_streamRequestCallback(s, nbytes, streamStats->requestCb);
+}
+
+static void
+PulseAudio_streamStatsUnderflowCallback(pa_stream *s, void *userdata)
+{
+    PulseAudioStreamStats *streamStats = (PulseAudioStreamStats *) userdata;
+    pa_usec_t now = pa_rtclock_now();
+
+    streamStats->values[STREAM_STATS_UNDERFLOWS]++;
+    /*
+     * If there was no audio to be written, a longer buffer would not have
+     * prevented the underflow. Whether the audio was merely late is decided
+     * once it arrives.
+     */
+    if (streamStats->starved)
+        streamStats->lastStarvedUnderflowTime = now;
+    else
+        streamStats->adaptiveWindowUnderflows++;
+    PulseAudio_streamStatsAdapt(streamStats, now);
+}
+
+/**
+ * Records an attempt to write into the stream of specific health counters.
+ * An underflow which occurred while there was no audio to be written is
+ * attributed to a too short buffer only if the audio arrives within the
+ * target length of the buffer after the underflow i.e. if it was late rather
+ * than absent (e.g. because the playback was paused or on hold).
+ *
+ * @param streamStats the health counters of the stream written into
+ * @param available the number of bytes which were available to be written
+ */
+static void
+PulseAudio_streamStatsWrite(PulseAudioStreamStats *streamStats, size_t available)
+{
+    pa_usec_t underflowTime;
+    const pa_buffer_attr *attr;
+    const pa_sample_spec *ss;
+    pa_usec_t now;
+
+    if (!available)
+    {
+        streamStats->starved = 1;
+        return;
+    }
+    streamStats->starved = 0;
+
+    underflowTime = streamStats->lastStarvedUnderflowTime;
+    if (!underflowTime)
+        return;
+    streamStats->lastStarvedUnderflowTime = 0;
+
+    attr = pa_stream_get_buffer_attr(streamStats->stream);
+    ss = pa_stream_get_sample_spec(streamStats->stream);
+    now = pa_rtclock_now();
+    if (attr
+            && ss
+            && (now - underflowTime <= pa_bytes_to_usec(attr->tlength, ss)))
+    {
+        streamStats->adaptiveWindowUnderflows++;
+        PulseAudio_streamStatsAdapt(streamStats, now);
+    }
+}
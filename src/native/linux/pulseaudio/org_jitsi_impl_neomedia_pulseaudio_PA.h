@@ -7,6 +7,46 @@
 #ifdef __cplusplus
 extern "C" {
 #endif
+#undef org_jitsi_impl_neomedia_pulseaudio_PA_DEVICE_REGISTRY_SINK
+#define org_jitsi_impl_neomedia_pulseaudio_PA_DEVICE_REGISTRY_SINK 0L
+#undef org_jitsi_impl_neomedia_pulseaudio_PA_DEVICE_REGISTRY_SOURCE
+#define org_jitsi_impl_neomedia_pulseaudio_PA_DEVICE_REGISTRY_SOURCE 1L
+#undef org_jitsi_impl_neomedia_pulseaudio_PA_SCHED_POLICY_DEFAULT
+#define org_jitsi_impl_neomedia_pulseaudio_PA_SCHED_POLICY_DEFAULT 0L
+#undef org_jitsi_impl_neomedia_pulseaudio_PA_SCHED_POLICY_FIFO
+#define org_jitsi_impl_neomedia_pulseaudio_PA_SCHED_POLICY_FIFO 1L
+#undef org_jitsi_impl_neomedia_pulseaudio_PA_SCHED_POLICY_NICE
+#define org_jitsi_impl_neomedia_pulseaudio_PA_SCHED_POLICY_NICE 3L
+#undef org_jitsi_impl_neomedia_pulseaudio_PA_SCHED_POLICY_RR
+#define org_jitsi_impl_neomedia_pulseaudio_PA_SCHED_POLICY_RR 2L
+#undef org_jitsi_impl_neomedia_pulseaudio_PA_STREAM_STATS_BUFFER_LENGTH
+#define org_jitsi_impl_neomedia_pulseaudio_PA_STREAM_STATS_BUFFER_LENGTH 19L
+#undef org_jitsi_impl_neomedia_pulseaudio_PA_STREAM_STATS_CALLBACKS
+#define org_jitsi_impl_neomedia_pulseaudio_PA_STREAM_STATS_CALLBACKS 0L
+#undef org_jitsi_impl_neomedia_pulseaudio_PA_STREAM_STATS_CALLBACK_INTERVAL_HISTOGRAM
+#define org_jitsi_impl_neomedia_pulseaudio_PA_STREAM_STATS_CALLBACK_INTERVAL_HISTOGRAM 6L
+#undef org_jitsi_impl_neomedia_pulseaudio_PA_STREAM_STATS_CALLBACK_INTERVAL_HISTOGRAM_LENGTH
+#define org_jitsi_impl_neomedia_pulseaudio_PA_STREAM_STATS_CALLBACK_INTERVAL_HISTOGRAM_LENGTH 10L
+#undef org_jitsi_impl_neomedia_pulseaudio_PA_STREAM_STATS_CALLBACK_INTERVAL_MAX
+#define org_jitsi_impl_neomedia_pulseaudio_PA_STREAM_STATS_CALLBACK_INTERVAL_MAX 1L
+#undef org_jitsi_impl_neomedia_pulseaudio_PA_STREAM_STATS_HOLES
+#define org_jitsi_impl_neomedia_pulseaudio_PA_STREAM_STATS_HOLES 16L
+#undef org_jitsi_impl_neomedia_pulseaudio_PA_STREAM_STATS_LATENCY
+#define org_jitsi_impl_neomedia_pulseaudio_PA_STREAM_STATS_LATENCY 20L
+#undef org_jitsi_impl_neomedia_pulseaudio_PA_STREAM_STATS_LENGTH
+#define org_jitsi_impl_neomedia_pulseaudio_PA_STREAM_STATS_LENGTH 21L
+#undef org_jitsi_impl_neomedia_pulseaudio_PA_STREAM_STATS_OVERFLOWS
+#define org_jitsi_impl_neomedia_pulseaudio_PA_STREAM_STATS_OVERFLOWS 2L
+#undef org_jitsi_impl_neomedia_pulseaudio_PA_STREAM_STATS_PUMP_OVERFLOWS
+#define org_jitsi_impl_neomedia_pulseaudio_PA_STREAM_STATS_PUMP_OVERFLOWS 17L
+#undef org_jitsi_impl_neomedia_pulseaudio_PA_STREAM_STATS_PUMP_UNDERFLOWS
+#define org_jitsi_impl_neomedia_pulseaudio_PA_STREAM_STATS_PUMP_UNDERFLOWS 18L
+#undef org_jitsi_impl_neomedia_pulseaudio_PA_STREAM_STATS_REQUEST_BYTES
+#define org_jitsi_impl_neomedia_pulseaudio_PA_STREAM_STATS_REQUEST_BYTES 4L
+#undef org_jitsi_impl_neomedia_pulseaudio_PA_STREAM_STATS_REQUEST_BYTES_MAX
+#define org_jitsi_impl_neomedia_pulseaudio_PA_STREAM_STATS_REQUEST_BYTES_MAX 5L
+#undef org_jitsi_impl_neomedia_pulseaudio_PA_STREAM_STATS_UNDERFLOWS
+#define org_jitsi_impl_neomedia_pulseaudio_PA_STREAM_STATS_UNDERFLOWS 3L
 /*
  * Class:     org_jitsi_impl_neomedia_pulseaudio_PA
  * Method:    buffer_attr_free
@@ -127,6 +167,38 @@ JNIEXPORT jlong JNICALL Java_org_jitsi_impl_neomedia_pulseaudio_PA_cvolume_1new
 JNIEXPORT jlong JNICALL Java_org_jitsi_impl_neomedia_pulseaudio_PA_cvolume_1set
   (JNIEnv *, jclass, jlong, jint, jint);
 
+/*
+ * Class:     org_jitsi_impl_neomedia_pulseaudio_PA
+ * Method:    device_registry_free
+ * Signature: (J)V
+ */
+JNIEXPORT void JNICALL Java_org_jitsi_impl_neomedia_pulseaudio_PA_device_1registry_1free
+  (JNIEnv *, jclass, jlong);
+
+/*
+ * Class:     org_jitsi_impl_neomedia_pulseaudio_PA
+ * Method:    device_registry_get_snapshot
+ * Signature: (J)[B
+ */
+JNIEXPORT jbyteArray JNICALL Java_org_jitsi_impl_neomedia_pulseaudio_PA_device_1registry_1get_1snapshot
+  (JNIEnv *, jclass, jlong);
+
+/*
+ * Class:     org_jitsi_impl_neomedia_pulseaudio_PA
+ * Method:    device_registry_get_version
+ * Signature: (J)J
+ */
+JNIEXPORT jlong JNICALL Java_org_jitsi_impl_neomedia_pulseaudio_PA_device_1registry_1get_1version
+  (JNIEnv *, jclass, jlong);
+
+/*
+ * Class:     org_jitsi_impl_neomedia_pulseaudio_PA
+ * Method:    device_registry_new
+ * Signature: (JJ)J
+ */
+JNIEXPORT jlong JNICALL Java_org_jitsi_impl_neomedia_pulseaudio_PA_device_1registry_1new
+  (JNIEnv *, jclass, jlong, jlong);
+
 /*
  * Class:     org_jitsi_impl_neomedia_pulseaudio_PA
  * Method:    format_info_get_encoding
@@ -199,6 +271,54 @@ JNIEXPORT jlong JNICALL Java_org_jitsi_impl_neomedia_pulseaudio_PA_proplist_1new
 JNIEXPORT jint JNICALL Java_org_jitsi_impl_neomedia_pulseaudio_PA_proplist_1sets
   (JNIEnv *, jclass, jlong, jstring, jstring);
 
+/*
+ * Class:     org_jitsi_impl_neomedia_pulseaudio_PA
+ * Method:    pump_free
+ * Signature: (J)V
+ */
+JNIEXPORT void JNICALL Java_org_jitsi_impl_neomedia_pulseaudio_PA_pump_1free
+  (JNIEnv *, jclass, jlong);
+
+/*
+ * Class:     org_jitsi_impl_neomedia_pulseaudio_PA
+ * Method:    pump_lock_memory
+ * Signature: (J)Z
+ */
+JNIEXPORT jboolean JNICALL Java_org_jitsi_impl_neomedia_pulseaudio_PA_pump_1lock_1memory
+  (JNIEnv *, jclass, jlong);
+
+/*
+ * Class:     org_jitsi_impl_neomedia_pulseaudio_PA
+ * Method:    pump_new
+ * Signature: (JJIZJ)J
+ */
+JNIEXPORT jlong JNICALL Java_org_jitsi_impl_neomedia_pulseaudio_PA_pump_1new
+  (JNIEnv *, jclass, jlong, jlong, jint, jboolean, jlong);
+
+/*
+ * Class:     org_jitsi_impl_neomedia_pulseaudio_PA
+ * Method:    pump_read
+ * Signature: (J[BII)I
+ */
+JNIEXPORT jint JNICALL Java_org_jitsi_impl_neomedia_pulseaudio_PA_pump_1read
+  (JNIEnv *, jclass, jlong, jbyteArray, jint, jint);
+
+/*
+ * Class:     org_jitsi_impl_neomedia_pulseaudio_PA
+ * Method:    pump_set_interrupted
+ * Signature: (JZ)V
+ */
+JNIEXPORT void JNICALL Java_org_jitsi_impl_neomedia_pulseaudio_PA_pump_1set_1interrupted
+  (JNIEnv *, jclass, jlong, jboolean);
+
+/*
+ * Class:     org_jitsi_impl_neomedia_pulseaudio_PA
+ * Method:    pump_write
+ * Signature: (J[BII)I
+ */
+JNIEXPORT jint JNICALL Java_org_jitsi_impl_neomedia_pulseaudio_PA_pump_1write
+  (JNIEnv *, jclass, jlong, jbyteArray, jint, jint);
+
 /*
  * Class:     org_jitsi_impl_neomedia_pulseaudio_PA
  * Method:    sample_spec_free
@@ -407,6 +527,14 @@ JNIEXPORT jstring JNICALL Java_org_jitsi_impl_neomedia_pulseaudio_PA_stream_1get
 JNIEXPORT jint JNICALL Java_org_jitsi_impl_neomedia_pulseaudio_PA_stream_1get_1index
   (JNIEnv *, jclass, jlong);
 
+/*
+ * Class:     org_jitsi_impl_neomedia_pulseaudio_PA
+ * Method:    stream_get_latency
+ * Signature: (J)J
+ */
+JNIEXPORT jlong JNICALL Java_org_jitsi_impl_neomedia_pulseaudio_PA_stream_1get_1latency
+  (JNIEnv *, jclass, jlong);
+
 /*
  * Class:     org_jitsi_impl_neomedia_pulseaudio_PA
  * Method:    stream_get_state
@@ -442,10 +570,10 @@ JNIEXPORT jint JNICALL Java_org_jitsi_impl_neomedia_pulseaudio_PA_stream_1readab
 /*
  * Class:     org_jitsi_impl_neomedia_pulseaudio_PA
  * Method:    stream_set_read_callback
- * Signature: (JLnet/java/sip/communicator/impl/neomedia/pulseaudio/PA/stream_request_cb_t;)V
+ * Signature: (JLorg/jitsi/impl/neomedia/pulseaudio/PA/stream_request_cb_t;J)V
  */
 JNIEXPORT void JNICALL Java_org_jitsi_impl_neomedia_pulseaudio_PA_stream_1set_1read_1callback
-  (JNIEnv *, jclass, jlong, jobject);
+  (JNIEnv *, jclass, jlong, jobject, jlong);
 
 /*
  * Class:     org_jitsi_impl_neomedia_pulseaudio_PA
@@ -458,10 +586,42 @@ JNIEXPORT void JNICALL Java_org_jitsi_impl_neomedia_pulseaudio_PA_stream_1set_1s
 /*
  * Class:     org_jitsi_impl_neomedia_pulseaudio_PA
  * Method:    stream_set_write_callback
- * Signature: (JLnet/java/sip/communicator/impl/neomedia/pulseaudio/PA/stream_request_cb_t;)V
+ * Signature: (JLorg/jitsi/impl/neomedia/pulseaudio/PA/stream_request_cb_t;J)V
  */
 JNIEXPORT void JNICALL Java_org_jitsi_impl_neomedia_pulseaudio_PA_stream_1set_1write_1callback
-  (JNIEnv *, jclass, jlong, jobject);
+  (JNIEnv *, jclass, jlong, jobject, jlong);
+
+/*
+ * Class:     org_jitsi_impl_neomedia_pulseaudio_PA
+ * Method:    stream_stats_free
+ * Signature: (J)V
+ */
+JNIEXPORT void JNICALL Java_org_jitsi_impl_neomedia_pulseaudio_PA_stream_1stats_1free
+  (JNIEnv *, jclass, jlong);
+
+/*
+ * Class:     org_jitsi_impl_neomedia_pulseaudio_PA
+ * Method:    stream_stats_get
+ * Signature: (J[J)V
+ */
+JNIEXPORT void JNICALL Java_org_jitsi_impl_neomedia_pulseaudio_PA_stream_1stats_1get
+  (JNIEnv *, jclass, jlong, jlongArray);
+
+/*
+ * Class:     org_jitsi_impl_neomedia_pulseaudio_PA
+ * Method:    stream_stats_new
+ * Signature: (JZ)J
+ */
+JNIEXPORT jlong JNICALL Java_org_jitsi_impl_neomedia_pulseaudio_PA_stream_1stats_1new
+  (JNIEnv *, jclass, jlong, jboolean);
+
+/*
+ * Class:     org_jitsi_impl_neomedia_pulseaudio_PA
+ * Method:    stream_stats_set_adaptive
+ * Signature: (JIII)V
+ */
+JNIEXPORT void JNICALL Java_org_jitsi_impl_neomedia_pulseaudio_PA_stream_1stats_1set_1adaptive
+  (JNIEnv *, jclass, jlong, jint, jint, jint);
 
 /*
  * Class:     org_jitsi_impl_neomedia_pulseaudio_PA
@@ -527,6 +687,14 @@ JNIEXPORT void JNICALL Java_org_jitsi_impl_neomedia_pulseaudio_PA_threaded_1main
 JNIEXPORT jlong JNICALL Java_org_jitsi_impl_neomedia_pulseaudio_PA_threaded_1mainloop_1new
   (JNIEnv *, jclass);
 
+/*
+ * Class:     org_jitsi_impl_neomedia_pulseaudio_PA
+ * Method:    threaded_mainloop_set_sched_policy
+ * Signature: (JII)I
+ */
+JNIEXPORT jint JNICALL Java_org_jitsi_impl_neomedia_pulseaudio_PA_threaded_1mainloop_1set_1sched_1policy
+  (JNIEnv *, jclass, jlong, jint, jint);
+
 /*
  * Class:     org_jitsi_impl_neomedia_pulseaudio_PA
  * Method:    threaded_mainloop_signal
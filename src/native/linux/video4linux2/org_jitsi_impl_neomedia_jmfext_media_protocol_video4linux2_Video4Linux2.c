@@ -5,19 +5,570 @@
  * See terms of license at gnu.org.
  */
 
+#define _GNU_SOURCE
+
 #include "org_jitsi_impl_neomedia_jmfext_media_protocol_video4linux2_Video4Linux2.h"
 
+#include <errno.h>
 #include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/ioctl.h>
 #include <sys/mman.h>
 #include <sys/select.h>
+#include <time.h>
 #include <unistd.h>
 
 #include <linux/videodev2.h>
 
+#include "MJPEGDecoder.h"
+
+/**
+ * The number of bytes past the image in a <tt>V4L2_MEMORY_USERPTR</tt> buffer
+ * which FFmpeg may read when decoding or converting the frame in place.
+ */
+#define CAPTURE_PADDING_SIZE 64
+
+/**
+ * The number of buckets of the histogram of the times taken to decode frames.
+ * Bucket <tt>0</tt> counts the decodes which took less than a millisecond,
+ * bucket <tt>i</tt> those which took less than <tt>2^i</tt> milliseconds and
+ * the last one all the rest.
+ */
+#define CAPTURE_DECODE_TIME_COUNT 8
+
+struct _Video4Linux2Capture;
+
+/**
+ * Represents a buffer of a <tt>Video4Linux2Capture</tt> i.e. a frame in its
+ * pool. A frame is given back to the driver as soon as it is no longer
+ * referenced so the captured media data is never copied.
+ */
+typedef struct _Video4Linux2Frame
+{
+    size_t capacity;
+    struct _Video4Linux2Capture *capture;
+    void *data;
+
+    /**
+     * Whether this frame holds a decoded picture and is in the pool of the
+     * decode threads rather than a buffer of the driver.
+     */
+    int decoded;
+    uint32_t index;
+    size_t length;
+
+    /**
+     * The number of references to this frame. It is guarded by the
+     * <tt>mutex</tt> of {@link #capture}. A frame with zero references is
+     * enqueued to the driver while the capture is started.
+     */
+    int refCount;
+
+    /**
+     * The sequence number which the driver has assigned to this frame. A gap
+     * between consecutive frames tells the number of dropped frames.
+     */
+    uint32_t sequence;
+
+    /**
+     * The capture time of this frame in nanoseconds on the
+     * <tt>CLOCK_MONOTONIC</tt> clock as set by the driver or <tt>0</tt> if the
+     * driver does not use that clock.
+     */
+    int64_t timestamp;
+} Video4Linux2Frame;
+
+/**
+ * Represents a decode thread of a <tt>Video4Linux2Capture</tt> and the
+ * decoder context which it exclusively uses.
+ */
+typedef struct _Video4Linux2Decoder
+{
+    struct _Video4Linux2Capture *capture;
+    void *ctx;
+
+    /**
+     * The buffer into which a captured frame is copied before it is decoded
+     * if the buffer of the driver does not leave
+     * <tt>MJPEGDECODER_PADDING_SIZE</tt> bytes past the end of the frame
+     * (e.g. a <tt>V4L2_MEMORY_MMAP</tt> buffer filled up to its length).
+     */
+    uint8_t *padded;
+    size_t paddedCapacity;
+    pthread_t thread;
+} Video4Linux2Decoder;
+
+/**
+ * Represents the outcome of the decoding of a frame which is to be published
+ * in the order in which the frames were captured.
+ */
+typedef struct _Video4Linux2Decoding
+{
+    int done;
+
+    /** The decoded frame or <tt>NULL</tt> if the decoding failed. */
+    Video4Linux2Frame *frame;
+} Video4Linux2Decoding;
+
+/**
+ * Represents a native capture engine which owns the buffers of a Video for
+ * Linux Two API Specification device and dequeues/enqueues them on a
+ * dedicated thread so that Java only pulls the latest frame. The buffers are
+ * either mapped from the driver (<tt>V4L2_MEMORY_MMAP</tt>) or page-aligned
+ * memory allocated by the engine which the driver writes into directly
+ * (<tt>V4L2_MEMORY_USERPTR</tt>).
+ *
+ * If a <tt>MJPEGDecoder</tt> is set, the captured frames are decoded by a
+ * number of decode threads in parallel into a pool of I420 frames which are
+ * published in the order of their capture.
+ */
+typedef struct _Video4Linux2Capture
+{
+    size_t decodedFrameCount;
+    Video4Linux2Frame *decodedFrames;
+    const MJPEGDecoder *decoder;
+    size_t decoderCount;
+    Video4Linux2Decoder *decoders;
+
+    /** The number of frames taken for decoding by the decode threads. */
+    uint64_t decodeSequence;
+
+    /** The histogram of the times taken to decode frames. */
+    uint64_t decodeTimes[CAPTURE_DECODE_TIME_COUNT];
+
+    /**
+     * The outcomes of the decodings which have not been published yet indexed
+     * by their sequence modulo {@link #decoderCount}.
+     */
+    Video4Linux2Decoding *decodings;
+    int fd;
+    size_t frameCount;
+    Video4Linux2Frame *frames;
+    int freed;
+    int height;
+
+    /**
+     * The captured frames waiting for a decode thread in a ring of
+     * {@link #decoderCount} elements.
+     */
+    size_t jobCount;
+    size_t jobHead;
+    Video4Linux2Frame **jobs;
+    Video4Linux2Frame *latest;
+    enum v4l2_memory memory;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+
+    /**
+     * The number of frames published by the capture thread. Compared with
+     * {@link #read} to tell whether {@link #latest} has been read already.
+     */
+    uint64_t published;
+
+    /** The sequence of the next decoding to be published. */
+    uint64_t publishSequence;
+
+    /** The number of frames currently enqueued to the driver. */
+    size_t queued;
+    uint64_t read;
+    int started;
+    size_t startedDecoderCount;
+
+    /**
+     * Serializes the starting and stopping of the capture and guards #started
+     * and #startedDecoderCount. Unlike #mutex, it is not taken by the capture
+     * and decode threads so it is held while they are joined.
+     */
+    pthread_mutex_t startMutex;
+    int stopped;
+    pthread_t thread;
+
+    /**
+     * The number of Java threads which are either waiting inside
+     * <tt>capture_read</tt> or hold a frame. The capture is only destroyed
+     * once there are none.
+     */
+    int users;
+
+    /**
+     * The pipe through which {@link #thread} is woken up from <tt>poll()</tt>
+     * when the capture is stopped.
+     */
+    int wakeupFds[2];
+    int width;
+} Video4Linux2Capture;
+
+static void *Video4Linux2_captureDecode(void *arg);
+static void Video4Linux2_captureDecodeReset(Video4Linux2Capture *capture);
+static void Video4Linux2_captureDestroy(Video4Linux2Capture *capture);
+static void Video4Linux2_captureFreeDecoder(Video4Linux2Capture *capture);
+static void Video4Linux2_capturePublish(Video4Linux2Capture *capture, Video4Linux2Frame *frame);
+static void Video4Linux2_capturePublishDecoded(Video4Linux2Capture *capture);
+static int Video4Linux2_captureQbuf(Video4Linux2Capture *capture, Video4Linux2Frame *frame);
+static void *Video4Linux2_captureRun(void *arg);
+static int Video4Linux2_captureStop(Video4Linux2Capture *capture);
+static int Video4Linux2_captureStopLocked(Video4Linux2Capture *capture);
+static int Video4Linux2_captureStreamoff(Video4Linux2Capture *capture);
+static void Video4Linux2_captureSubmit(Video4Linux2Capture *capture, Video4Linux2Frame *frame);
+static void Video4Linux2_frameUnref(Video4Linux2Frame *frame);
+
+JNIEXPORT void JNICALL
+Java_org_jitsi_impl_neomedia_jmfext_media_protocol_video4linux2_Video4Linux2_capture_1free
+    (JNIEnv *jniEnv, jclass clazz, jlong ptr)
+{
+    Video4Linux2Capture *capture = (Video4Linux2Capture *) (intptr_t) ptr;
+    int destroy;
+
+    Video4Linux2_captureStop(capture);
+    pthread_mutex_lock(&(capture->mutex));
+    capture->freed = 1;
+    destroy = (capture->users == 0);
+    pthread_mutex_unlock(&(capture->mutex));
+    if (destroy)
+        Video4Linux2_captureDestroy(capture);
+}
+
+JNIEXPORT jint JNICALL
+Java_org_jitsi_impl_neomedia_jmfext_media_protocol_video4linux2_Video4Linux2_capture_1getDecodeTimes
+    (JNIEnv *jniEnv, jclass clazz, jlong ptr, jlongArray decodeTimes)
+{
+    Video4Linux2Capture *capture = (Video4Linux2Capture *) (intptr_t) ptr;
+    jlong decodeTimes_[CAPTURE_DECODE_TIME_COUNT];
+    jsize length = (*jniEnv)->GetArrayLength(jniEnv, decodeTimes);
+    jsize i;
+
+    if (length > CAPTURE_DECODE_TIME_COUNT)
+        length = CAPTURE_DECODE_TIME_COUNT;
+    pthread_mutex_lock(&(capture->mutex));
+    for (i = 0; i < length; i++)
+        decodeTimes_[i] = (jlong) (capture->decodeTimes[i]);
+    pthread_mutex_unlock(&(capture->mutex));
+    (*jniEnv)->SetLongArrayRegion(jniEnv, decodeTimes, 0, length, decodeTimes_);
+    return CAPTURE_DECODE_TIME_COUNT;
+}
+
+JNIEXPORT jlong JNICALL
+Java_org_jitsi_impl_neomedia_jmfext_media_protocol_video4linux2_Video4Linux2_capture_1new
+    (JNIEnv *jniEnv, jclass clazz, jint fd, jint count, jint memory)
+{
+    Video4Linux2Capture *capture;
+    struct v4l2_requestbuffers requestbuffers;
+    size_t i;
+    size_t pageSize = 0;
+    size_t userptrCapacity = 0;
+
+    if ((V4L2_MEMORY_MMAP != memory) && (V4L2_MEMORY_USERPTR != memory))
+        return 0;
+    capture = calloc(1, sizeof(Video4Linux2Capture));
+    if (!capture)
+        return 0;
+    capture->fd = fd;
+    capture->memory = memory;
+    capture->wakeupFds[0] = -1;
+    capture->wakeupFds[1] = -1;
+    if (pthread_mutex_init(&(capture->mutex), NULL))
+    {
+        free(capture);
+        return 0;
+    }
+    if (pthread_cond_init(&(capture->cond), NULL))
+    {
+        pthread_mutex_destroy(&(capture->mutex));
+        free(capture);
+        return 0;
+    }
+    if (pthread_mutex_init(&(capture->startMutex), NULL))
+    {
+        pthread_cond_destroy(&(capture->cond));
+        pthread_mutex_destroy(&(capture->mutex));
+        free(capture);
+        return 0;
+    }
+
+    if (V4L2_MEMORY_USERPTR == memory)
+    {
+        struct v4l2_format format;
+
+        memset(&format, 0, sizeof(format));
+        format.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        if ((ioctl(fd, VIDIOC_G_FMT, &format) == -1)
+                || (format.fmt.pix.sizeimage == 0))
+            goto error;
+        pageSize = sysconf(_SC_PAGESIZE);
+        userptrCapacity
+            = ((format.fmt.pix.sizeimage + CAPTURE_PADDING_SIZE + pageSize - 1)
+                    / pageSize)
+                * pageSize;
+    }
+
+    memset(&requestbuffers, 0, sizeof(requestbuffers));
+    requestbuffers.count = count;
+    requestbuffers.memory = memory;
+    requestbuffers.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    if (ioctl(fd, VIDIOC_REQBUFS, &requestbuffers) == -1)
+        goto error;
+    /*
+     * Even if the driver has granted no buffers, it may have allocated
+     * resources upon the request which are to be released upon destruction.
+     */
+    capture->frameCount = requestbuffers.count;
+    if (capture->frameCount < 1)
+        goto error;
+
+    capture->frames = calloc(capture->frameCount, sizeof(Video4Linux2Frame));
+    if (!(capture->frames))
+        goto error;
+    for (i = 0; i < capture->frameCount; i++)
+    {
+        Video4Linux2Frame *frame = capture->frames + i;
+
+        frame->capture = capture;
+        frame->index = i;
+        if (V4L2_MEMORY_USERPTR == memory)
+        {
+            if (posix_memalign(&(frame->data), pageSize, userptrCapacity))
+            {
+                frame->data = NULL;
+                goto error;
+            }
+            frame->capacity = userptrCapacity;
+        }
+        else
+        {
+            struct v4l2_buffer buffer;
+            void *mmapped;
+
+            memset(&buffer, 0, sizeof(buffer));
+            buffer.index = i;
+            buffer.memory = V4L2_MEMORY_MMAP;
+            buffer.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+            if (ioctl(fd, VIDIOC_QUERYBUF, &buffer) == -1)
+                goto error;
+            mmapped
+                = mmap(
+                        NULL,
+                        buffer.length,
+                        PROT_READ | PROT_WRITE,
+                        MAP_SHARED,
+                        fd,
+                        buffer.m.offset);
+            if (MAP_FAILED == mmapped)
+                goto error;
+            frame->capacity = buffer.length;
+            frame->data = mmapped;
+        }
+    }
+
+    if (pipe(capture->wakeupFds) == -1)
+    {
+        capture->wakeupFds[0] = -1;
+        capture->wakeupFds[1] = -1;
+        goto error;
+    }
+    if (fcntl(capture->wakeupFds[0], F_SETFL, O_NONBLOCK) == -1)
+        goto error;
+    capture->stopped = 1;
+    return (jlong) (intptr_t) capture;
+
+error:
+    Video4Linux2_captureDestroy(capture);
+    return 0;
+}
+
+JNIEXPORT jlong JNICALL
+Java_org_jitsi_impl_neomedia_jmfext_media_protocol_video4linux2_Video4Linux2_capture_1read
+    (JNIEnv *jniEnv, jclass clazz, jlong ptr)
+{
+    Video4Linux2Capture *capture = (Video4Linux2Capture *) (intptr_t) ptr;
+    Video4Linux2Frame *frame = NULL;
+
+    pthread_mutex_lock(&(capture->mutex));
+    (capture->users)++;
+    while (!(capture->stopped)
+            && (!(capture->latest) || (capture->published == capture->read)))
+        pthread_cond_wait(&(capture->cond), &(capture->mutex));
+    if (!(capture->stopped) && capture->latest)
+    {
+        frame = capture->latest;
+        (frame->refCount)++;
+        capture->read = capture->published;
+    }
+    else
+        (capture->users)--;
+    pthread_mutex_unlock(&(capture->mutex));
+    return (jlong) (intptr_t) frame;
+}
+
+JNIEXPORT jint JNICALL
+Java_org_jitsi_impl_neomedia_jmfext_media_protocol_video4linux2_Video4Linux2_capture_1setDecoder
+    (JNIEnv *jniEnv, jclass clazz, jlong ptr, jlong decoder, jint threadCount)
+{
+    Video4Linux2Capture *capture = (Video4Linux2Capture *) (intptr_t) ptr;
+    struct v4l2_format format;
+    size_t chromaSize, i, size;
+    jint ret = -1;
+
+    pthread_mutex_lock(&(capture->startMutex));
+    if (capture->started || capture->decoder || !decoder || (threadCount < 1))
+        goto unlock;
+
+    memset(&format, 0, sizeof(format));
+    format.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    if (ioctl(capture->fd, VIDIOC_G_FMT, &format) == -1)
+        goto unlock;
+    capture->width = format.fmt.pix.width;
+    capture->height = format.fmt.pix.height;
+    if ((capture->width < 1) || (capture->height < 1))
+        goto unlock;
+    chromaSize = ((capture->width + 1) / 2) * ((capture->height + 1) / 2);
+    size = capture->width * capture->height + 2 * chromaSize;
+
+    capture->decoder = (const MJPEGDecoder *) (intptr_t) decoder;
+    capture->decoders = calloc(threadCount, sizeof(Video4Linux2Decoder));
+    capture->decodings = calloc(threadCount, sizeof(Video4Linux2Decoding));
+    capture->jobs = calloc(threadCount, sizeof(Video4Linux2Frame *));
+    /*
+     * Each decode thread writes into a frame, one frame is the latest and Java
+     * holds at most two while it moves on to the next one.
+     */
+    capture->decodedFrames
+        = calloc(threadCount + 3, sizeof(Video4Linux2Frame));
+    if (!(capture->decoders)
+            || !(capture->decodings)
+            || !(capture->jobs)
+            || !(capture->decodedFrames))
+        goto error;
+    capture->decoderCount = threadCount;
+    capture->decodedFrameCount = threadCount + 3;
+    for (i = 0; i < capture->decoderCount; i++)
+    {
+        Video4Linux2Decoder *decoder_ = capture->decoders + i;
+
+        decoder_->capture = capture;
+        decoder_->ctx = capture->decoder->alloc();
+        if (!(decoder_->ctx))
+            goto error;
+    }
+    for (i = 0; i < capture->decodedFrameCount; i++)
+    {
+        Video4Linux2Frame *frame = capture->decodedFrames + i;
+
+        frame->capture = capture;
+        frame->decoded = 1;
+        frame->index = i;
+        if (posix_memalign(&(frame->data), 32, size + CAPTURE_PADDING_SIZE))
+        {
+            frame->data = NULL;
+            goto error;
+        }
+        frame->capacity = size + CAPTURE_PADDING_SIZE;
+        frame->length = size;
+    }
+    ret = 0;
+    goto unlock;
+
+error:
+    Video4Linux2_captureFreeDecoder(capture);
+unlock:
+    pthread_mutex_unlock(&(capture->startMutex));
+    return ret;
+}
+
+JNIEXPORT jint JNICALL
+Java_org_jitsi_impl_neomedia_jmfext_media_protocol_video4linux2_Video4Linux2_capture_1start
+    (JNIEnv *jniEnv, jclass clazz, jlong ptr)
+{
+    Video4Linux2Capture *capture = (Video4Linux2Capture *) (intptr_t) ptr;
+    enum v4l2_buf_type type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    size_t i;
+    char value;
+    int ret = 0;
+
+    pthread_mutex_lock(&(capture->startMutex));
+    if (capture->started)
+    {
+        pthread_mutex_unlock(&(capture->startMutex));
+        return 0;
+    }
+
+    /* Consume any stop request left over from a previous stop. */
+    while (read(capture->wakeupFds[0], &value, sizeof(value)) > 0);
+
+    /*
+     * The frames which Java still holds from before a previous stop will be
+     * enqueued when they are released.
+     */
+    pthread_mutex_lock(&(capture->mutex));
+    for (i = 0; i < capture->frameCount; i++)
+    {
+        Video4Linux2Frame *frame = capture->frames + i;
+
+        if ((frame->refCount == 0)
+                && (Video4Linux2_captureQbuf(capture, frame) == -1))
+        {
+            ret = -1;
+            break;
+        }
+    }
+    if (ret == 0)
+        capture->stopped = 0;
+    pthread_mutex_unlock(&(capture->mutex));
+
+    if ((ret == 0) && (ioctl(capture->fd, VIDIOC_STREAMON, &type) == -1))
+        ret = -1;
+    if ((ret == 0)
+            && pthread_create(
+                    &(capture->thread),
+                    NULL,
+                    Video4Linux2_captureRun,
+                    capture))
+        ret = -1;
+    if (ret == 0)
+    {
+        capture->started = 1;
+        /* The decode threads are joined along with the capture thread. */
+        while (capture->startedDecoderCount < capture->decoderCount)
+        {
+            Video4Linux2Decoder *decoder
+                = capture->decoders + capture->startedDecoderCount;
+
+            if (pthread_create(
+                    &(decoder->thread),
+                    NULL,
+                    Video4Linux2_captureDecode,
+                    decoder))
+            {
+                Video4Linux2_captureStopLocked(capture);
+                ret = -1;
+                break;
+            }
+            (capture->startedDecoderCount)++;
+        }
+    }
+    else
+    {
+        pthread_mutex_lock(&(capture->mutex));
+        capture->stopped = 1;
+        pthread_mutex_unlock(&(capture->mutex));
+        /* Dequeue the buffers queued above. */
+        Video4Linux2_captureStreamoff(capture);
+    }
+    pthread_mutex_unlock(&(capture->startMutex));
+    return ret;
+}
+
+JNIEXPORT jint JNICALL
+Java_org_jitsi_impl_neomedia_jmfext_media_protocol_video4linux2_Video4Linux2_capture_1stop
+    (JNIEnv *jniEnv, jclass clazz, jlong ptr)
+{
+    return
+        Video4Linux2_captureStop((Video4Linux2Capture *) (intptr_t) ptr);
+}
+
 JNIEXPORT jint JNICALL
 Java_org_jitsi_impl_neomedia_jmfext_media_protocol_video4linux2_Video4Linux2_close
     (JNIEnv *jniEnv, jclass clazz, jint fd)
@@ -25,6 +576,51 @@ Java_org_jitsi_impl_neomedia_jmfext_media_protocol_video4linux2_Video4Linux2_clo
     return close(fd);
 }
 
+JNIEXPORT jlong JNICALL
+Java_org_jitsi_impl_neomedia_jmfext_media_protocol_video4linux2_Video4Linux2_frame_1getData
+    (JNIEnv *jniEnv, jclass clazz, jlong frame)
+{
+    return (jlong) (intptr_t) (((Video4Linux2Frame *) (intptr_t) frame)->data);
+}
+
+JNIEXPORT jint JNICALL
+Java_org_jitsi_impl_neomedia_jmfext_media_protocol_video4linux2_Video4Linux2_frame_1getLength
+    (JNIEnv *jniEnv, jclass clazz, jlong frame)
+{
+    return ((Video4Linux2Frame *) (intptr_t) frame)->length;
+}
+
+JNIEXPORT jint JNICALL
+Java_org_jitsi_impl_neomedia_jmfext_media_protocol_video4linux2_Video4Linux2_frame_1getSequence
+    (JNIEnv *jniEnv, jclass clazz, jlong frame)
+{
+    return (jint) (((Video4Linux2Frame *) (intptr_t) frame)->sequence);
+}
+
+JNIEXPORT jlong JNICALL
+Java_org_jitsi_impl_neomedia_jmfext_media_protocol_video4linux2_Video4Linux2_frame_1getTimestamp
+    (JNIEnv *jniEnv, jclass clazz, jlong frame)
+{
+    return (jlong) (((Video4Linux2Frame *) (intptr_t) frame)->timestamp);
+}
+
+JNIEXPORT void JNICALL
+Java_org_jitsi_impl_neomedia_jmfext_media_protocol_video4linux2_Video4Linux2_frame_1release
+    (JNIEnv *jniEnv, jclass clazz, jlong ptr)
+{
+    Video4Linux2Frame *frame = (Video4Linux2Frame *) (intptr_t) ptr;
+    Video4Linux2Capture *capture = frame->capture;
+    int destroy;
+
+    pthread_mutex_lock(&(capture->mutex));
+    Video4Linux2_frameUnref(frame);
+    (capture->users)--;
+    destroy = capture->freed && (capture->users == 0);
+    pthread_mutex_unlock(&(capture->mutex));
+    if (destroy)
+        Video4Linux2_captureDestroy(capture);
+}
+
 JNIEXPORT void JNICALL
 Java_org_jitsi_impl_neomedia_jmfext_media_protocol_video4linux2_Video4Linux2_free
     (JNIEnv *jniEnv, jclass clazz, jlong ptr)
@@ -401,3 +997,590 @@ Java_org_jitsi_impl_neomedia_jmfext_media_protocol_video4linux2_Video4Linux2_VID
 {
     return VIDIOC_STREAMON;
 }
+
+/**
+ * Runs a decode thread of a <tt>Video4Linux2Capture</tt> i.e. takes the oldest
+ * captured frame waiting to be decoded, decodes it into a free frame of the
+ * pool of decoded frames and publishes the outcome in the order of capture.
+ * A decode thread does not take a frame while as many decodings as there are
+ * decode threads await publication so that the outcomes fit in
+ * <tt>decodings</tt>.
+ *
+ * @param arg the <tt>Video4Linux2Decoder</tt> to run the decode thread of
+ * @return <tt>NULL</tt>
+ */
+static void *
+Video4Linux2_captureDecode(void *arg)
+{
+    Video4Linux2Decoder *decoder = (Video4Linux2Decoder *) arg;
+    Video4Linux2Capture *capture = decoder->capture;
+    int width = capture->width;
+    int height = capture->height;
+    size_t lumaSize = width * height;
+    size_t chromaSize = ((width + 1) / 2) * ((height + 1) / 2);
+    int stride[3];
+
+    stride[0] = width;
+    stride[1] = (width + 1) / 2;
+    stride[2] = stride[1];
+
+    pthread_mutex_lock(&(capture->mutex));
+    while (1)
+    {
+        Video4Linux2Frame *input;
+        Video4Linux2Frame *output = NULL;
+        uint64_t sequence;
+        Video4Linux2Decoding *decoding;
+        size_t i;
+
+        while (!(capture->stopped)
+                && ((capture->jobCount == 0)
+                    || (capture->decodeSequence - capture->publishSequence
+                            >= capture->decoderCount)))
+            pthread_cond_wait(&(capture->cond), &(capture->mutex));
+        if (capture->stopped)
+            break;
+
+        input = capture->jobs[capture->jobHead];
+        capture->jobHead = (capture->jobHead + 1) % capture->decoderCount;
+        (capture->jobCount)--;
+        sequence = (capture->decodeSequence)++;
+        for (i = 0; i < capture->decodedFrameCount; i++)
+        {
+            if (capture->decodedFrames[i].refCount == 0)
+            {
+                output = capture->decodedFrames + i;
+                /* The reference of this decode thread. */
+                output->refCount = 1;
+                break;
+            }
+        }
+        pthread_mutex_unlock(&(capture->mutex));
+
+        /* Drop the frame if Java holds all decoded frames. */
+        if (output)
+        {
+            const uint8_t *src = input->data;
+            uint8_t *dst[3];
+            struct timespec begin, end;
+            int decoded;
+
+            dst[0] = output->data;
+            dst[1] = dst[0] + lumaSize;
+            dst[2] = dst[1] + chromaSize;
+            clock_gettime(CLOCK_MONOTONIC, &begin);
+            if (input->length + MJPEGDECODER_PADDING_SIZE > input->capacity)
+            {
+                size_t capacity = input->length + MJPEGDECODER_PADDING_SIZE;
+
+                if (decoder->paddedCapacity < capacity)
+                {
+                    uint8_t *padded = realloc(decoder->padded, capacity);
+
+                    if (padded)
+                    {
+                        decoder->padded = padded;
+                        decoder->paddedCapacity = capacity;
+                    }
+                }
+                if (decoder->paddedCapacity >= capacity)
+                {
+                    memcpy(decoder->padded, src, input->length);
+                    memset(
+                            decoder->padded + input->length,
+                            0,
+                            MJPEGDECODER_PADDING_SIZE);
+                    src = decoder->padded;
+                }
+                else
+                    src = NULL;
+            }
+            decoded
+                = src
+                    && (capture->decoder->decode(
+                                decoder->ctx,
+                                src, input->length,
+                                dst, stride,
+                                width, height)
+                            == 0);
+            clock_gettime(CLOCK_MONOTONIC, &end);
+
+            pthread_mutex_lock(&(capture->mutex));
+            if (decoded)
+            {
+                int64_t elapsed
+                    = ((int64_t) (end.tv_sec - begin.tv_sec)) * 1000
+                        + (end.tv_nsec - begin.tv_nsec) / 1000000;
+                int bucket = 0;
+
+                while ((bucket < CAPTURE_DECODE_TIME_COUNT - 1)
+                        && (elapsed >= (((int64_t) 1) << bucket)))
+                    bucket++;
+                (capture->decodeTimes[bucket])++;
+                output->sequence = input->sequence;
+                output->timestamp = input->timestamp;
+            }
+            else
+            {
+                Video4Linux2_frameUnref(output);
+                output = NULL;
+            }
+        }
+        else
+            pthread_mutex_lock(&(capture->mutex));
+
+        Video4Linux2_frameUnref(input);
+        decoding = capture->decodings + (sequence % capture->decoderCount);
+        decoding->done = 1;
+        decoding->frame = output;
+        Video4Linux2_capturePublishDecoded(capture);
+    }
+    pthread_mutex_unlock(&(capture->mutex));
+    return NULL;
+}
+
+/**
+ * Drops the frames of a <tt>Video4Linux2Capture</tt> which wait to be decoded
+ * or published after its decode threads have exited. The caller holds the
+ * <tt>mutex</tt> of <tt>capture</tt>.
+ *
+ * @param capture the <tt>Video4Linux2Capture</tt> to reset the decoding of
+ */
+static void
+Video4Linux2_captureDecodeReset(Video4Linux2Capture *capture)
+{
+    size_t i;
+
+    while (capture->jobCount)
+    {
+        Video4Linux2_frameUnref(capture->jobs[capture->jobHead]);
+        capture->jobHead = (capture->jobHead + 1) % capture->decoderCount;
+        (capture->jobCount)--;
+    }
+    capture->jobHead = 0;
+    for (i = 0; i < capture->decoderCount; i++)
+    {
+        Video4Linux2Decoding *decoding = capture->decodings + i;
+
+        if (decoding->frame)
+        {
+            Video4Linux2_frameUnref(decoding->frame);
+            decoding->frame = NULL;
+        }
+        decoding->done = 0;
+    }
+    capture->decodeSequence = 0;
+    capture->publishSequence = 0;
+}
+
+static void
+Video4Linux2_captureDestroy(Video4Linux2Capture *capture)
+{
+    Video4Linux2_captureFreeDecoder(capture);
+    if (capture->frames)
+    {
+        size_t i;
+
+        for (i = 0; i < capture->frameCount; i++)
+        {
+            Video4Linux2Frame *frame = capture->frames + i;
+
+            if (frame->data)
+            {
+                if (V4L2_MEMORY_USERPTR == capture->memory)
+                    free(frame->data);
+                else
+                    munmap(frame->data, frame->capacity);
+            }
+        }
+        free(capture->frames);
+    }
+    if (capture->frameCount)
+    {
+        struct v4l2_requestbuffers requestbuffers;
+
+        /* Release the buffers of the driver. */
+        memset(&requestbuffers, 0, sizeof(requestbuffers));
+        requestbuffers.memory = capture->memory;
+        requestbuffers.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        ioctl(capture->fd, VIDIOC_REQBUFS, &requestbuffers);
+    }
+    if (capture->wakeupFds[0] != -1)
+        close(capture->wakeupFds[0]);
+    if (capture->wakeupFds[1] != -1)
+        close(capture->wakeupFds[1]);
+    pthread_cond_destroy(&(capture->cond));
+    pthread_mutex_destroy(&(capture->mutex));
+    pthread_mutex_destroy(&(capture->startMutex));
+    free(capture);
+}
+
+/**
+ * Frees the decoder contexts and the pool of decoded frames of a
+ * <tt>Video4Linux2Capture</tt> and unsets its <tt>MJPEGDecoder</tt>.
+ *
+ * @param capture the <tt>Video4Linux2Capture</tt> to free the decoding
+ * resources of
+ */
+static void
+Video4Linux2_captureFreeDecoder(Video4Linux2Capture *capture)
+{
+    size_t i;
+
+    if (capture->decoders)
+    {
+        for (i = 0; i < capture->decoderCount; i++)
+        {
+            void *ctx = capture->decoders[i].ctx;
+
+            if (ctx)
+                capture->decoder->free(ctx);
+            if (capture->decoders[i].padded)
+                free(capture->decoders[i].padded);
+        }
+        free(capture->decoders);
+        capture->decoders = NULL;
+    }
+    if (capture->decodedFrames)
+    {
+        for (i = 0; i < capture->decodedFrameCount; i++)
+        {
+            void *data = capture->decodedFrames[i].data;
+
+            if (data)
+                free(data);
+        }
+        free(capture->decodedFrames);
+        capture->decodedFrames = NULL;
+    }
+    if (capture->decodings)
+    {
+        free(capture->decodings);
+        capture->decodings = NULL;
+    }
+    if (capture->jobs)
+    {
+        free(capture->jobs);
+        capture->jobs = NULL;
+    }
+    capture->decodedFrameCount = 0;
+    capture->decoder = NULL;
+    capture->decoderCount = 0;
+}
+
+/**
+ * Publishes a specific frame as the latest one of a
+ * <tt>Video4Linux2Capture</tt> in place of the previous latest frame. The
+ * caller holds the <tt>mutex</tt> of <tt>capture</tt> and transfers a
+ * reference to <tt>frame</tt>.
+ *
+ * @param capture the <tt>Video4Linux2Capture</tt> to publish <tt>frame</tt> of
+ * @param frame the <tt>Video4Linux2Frame</tt> to publish
+ */
+static void
+Video4Linux2_capturePublish
+    (Video4Linux2Capture *capture, Video4Linux2Frame *frame)
+{
+    if (capture->latest)
+        Video4Linux2_frameUnref(capture->latest);
+    capture->latest = frame;
+    (capture->published)++;
+    pthread_cond_broadcast(&(capture->cond));
+}
+
+/**
+ * Publishes the decoded frames of a <tt>Video4Linux2Capture</tt> which are
+ * next in the order of capture. A frame decoded before the frames captured
+ * ahead of it waits for them so that the published frames never go back in
+ * time. The caller holds the <tt>mutex</tt> of <tt>capture</tt>.
+ *
+ * @param capture the <tt>Video4Linux2Capture</tt> to publish the decoded
+ * frames of
+ */
+static void
+Video4Linux2_capturePublishDecoded(Video4Linux2Capture *capture)
+{
+    while (1)
+    {
+        Video4Linux2Decoding *decoding
+            = capture->decodings
+                + (capture->publishSequence % capture->decoderCount);
+        Video4Linux2Frame *frame;
+
+        if (!(decoding->done))
+            break;
+        frame = decoding->frame;
+        decoding->done = 0;
+        decoding->frame = NULL;
+        (capture->publishSequence)++;
+        if (frame)
+        {
+            if (capture->stopped)
+                Video4Linux2_frameUnref(frame);
+            else
+                Video4Linux2_capturePublish(capture, frame);
+        }
+    }
+    /* The decode threads may be waiting for the decodings to be published. */
+    pthread_cond_broadcast(&(capture->cond));
+}
+
+/**
+ * Enqueues a specific frame of a <tt>Video4Linux2Capture</tt> to the driver.
+ * The caller holds the <tt>mutex</tt> of <tt>capture</tt>.
+ *
+ * @param capture the <tt>Video4Linux2Capture</tt> which owns <tt>frame</tt>
+ * @param frame the <tt>Video4Linux2Frame</tt> to enqueue
+ * @return the return value of the <tt>VIDIOC_QBUF</tt> ioctl
+ */
+static int
+Video4Linux2_captureQbuf
+    (Video4Linux2Capture *capture, Video4Linux2Frame *frame)
+{
+    struct v4l2_buffer buffer;
+    int ret;
+
+    memset(&buffer, 0, sizeof(buffer));
+    buffer.index = frame->index;
+    buffer.memory = capture->memory;
+    buffer.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    if (V4L2_MEMORY_USERPTR == capture->memory)
+    {
+        buffer.length = frame->capacity;
+        buffer.m.userptr = (unsigned long) (frame->data);
+    }
+    ret = ioctl(capture->fd, VIDIOC_QBUF, &buffer);
+    if (ret != -1)
+    {
+        (capture->queued)++;
+        /* The capture thread may be waiting for a buffer to be enqueued. */
+        pthread_cond_broadcast(&(capture->cond));
+    }
+    return ret;
+}
+
+/**
+ * Runs the capture thread of a <tt>Video4Linux2Capture</tt> i.e. waits for the
+ * device to fill a buffer, dequeues it and publishes its frame as the latest
+ * one. The frame is enqueued back to the driver once it is neither the latest
+ * one nor held by Java. When Java holds all frames, the thread waits for one
+ * of them to be released rather than poll a device without enqueued buffers.
+ *
+ * @param arg the <tt>Video4Linux2Capture</tt> to run the capture thread of
+ * @return <tt>NULL</tt>
+ */
+static void *
+Video4Linux2_captureRun(void *arg)
+{
+    Video4Linux2Capture *capture = (Video4Linux2Capture *) arg;
+    struct pollfd fds[2];
+
+    fds[0].fd = capture->fd;
+    fds[0].events = POLLIN;
+    fds[1].fd = capture->wakeupFds[0];
+    fds[1].events = POLLIN;
+
+    while (1)
+    {
+        struct v4l2_buffer buffer;
+        Video4Linux2Frame *frame;
+        int stopped;
+
+        pthread_mutex_lock(&(capture->mutex));
+        while (!(capture->stopped) && (capture->queued == 0))
+            pthread_cond_wait(&(capture->cond), &(capture->mutex));
+        stopped = capture->stopped;
+        pthread_mutex_unlock(&(capture->mutex));
+        if (stopped)
+            break;
+
+        fds[0].revents = 0;
+        fds[1].revents = 0;
+        if (poll(fds, 2, -1) == -1)
+        {
+            if (EINTR == errno)
+                continue;
+            break;
+        }
+        if (fds[1].revents)
+            break;
+        if (fds[0].revents & (POLLERR | POLLHUP | POLLNVAL))
+            break;
+
+        memset(&buffer, 0, sizeof(buffer));
+        buffer.memory = capture->memory;
+        buffer.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        if (ioctl(capture->fd, VIDIOC_DQBUF, &buffer) == -1)
+        {
+            if ((EAGAIN == errno) || (EINTR == errno))
+                continue;
+            break;
+        }
+        if (buffer.index >= capture->frameCount)
+            continue;
+
+        frame = capture->frames + buffer.index;
+        pthread_mutex_lock(&(capture->mutex));
+        (capture->queued)--;
+        frame->length
+            = (buffer.bytesused > frame->capacity)
+                ? frame->capacity
+                : buffer.bytesused;
+        frame->sequence = buffer.sequence;
+#ifdef V4L2_BUF_FLAG_TIMESTAMP_MONOTONIC
+        if ((buffer.flags & V4L2_BUF_FLAG_TIMESTAMP_MASK)
+                == V4L2_BUF_FLAG_TIMESTAMP_MONOTONIC)
+        {
+            frame->timestamp
+                = ((int64_t) buffer.timestamp.tv_sec) * 1000000000LL
+                    + ((int64_t) buffer.timestamp.tv_usec) * 1000LL;
+        }
+        else
+#endif
+            frame->timestamp = 0;
+        /* The reference of either latest or the decode job. */
+        frame->refCount = 1;
+        if (capture->decoder)
+            Video4Linux2_captureSubmit(capture, frame);
+        else
+            Video4Linux2_capturePublish(capture, frame);
+        pthread_mutex_unlock(&(capture->mutex));
+    }
+
+    /* Wake up the Java readers if the device failed. */
+    pthread_mutex_lock(&(capture->mutex));
+    capture->stopped = 1;
+    if (capture->latest)
+    {
+        Video4Linux2_frameUnref(capture->latest);
+        capture->latest = NULL;
+    }
+    pthread_cond_broadcast(&(capture->cond));
+    pthread_mutex_unlock(&(capture->mutex));
+    return NULL;
+}
+
+static int
+Video4Linux2_captureStop(Video4Linux2Capture *capture)
+{
+    int ret;
+
+    pthread_mutex_lock(&(capture->startMutex));
+    ret = Video4Linux2_captureStopLocked(capture);
+    pthread_mutex_unlock(&(capture->startMutex));
+    return ret;
+}
+
+/**
+ * Stops a specific <tt>Video4Linux2Capture</tt> i.e. joins its capture and
+ * decode threads and stops the streaming of its device. The caller holds the
+ * <tt>startMutex</tt> of <tt>capture</tt>.
+ *
+ * @param capture the <tt>Video4Linux2Capture</tt> to stop
+ * @return <tt>0</tt> upon success; otherwise, <tt>-1</tt>
+ */
+static int
+Video4Linux2_captureStopLocked(Video4Linux2Capture *capture)
+{
+    size_t i;
+    char value = 1;
+    ssize_t written;
+    int ret;
+
+    if (!(capture->started))
+        return 0;
+
+    pthread_mutex_lock(&(capture->mutex));
+    capture->stopped = 1;
+    pthread_cond_broadcast(&(capture->cond));
+    pthread_mutex_unlock(&(capture->mutex));
+    do
+        written = write(capture->wakeupFds[1], &value, sizeof(value));
+    while ((written == -1) && (EINTR == errno));
+    /*
+     * The threads are joined even if the capture thread could not be woken
+     * up because they must not outlive the capture. The capture thread still
+     * notices the stop once the device delivers a frame or fails.
+     */
+    pthread_join(capture->thread, NULL);
+    for (i = 0; i < capture->startedDecoderCount; i++)
+        pthread_join(capture->decoders[i].thread, NULL);
+    capture->startedDecoderCount = 0;
+    capture->started = 0;
+
+    if (capture->decoder)
+    {
+        pthread_mutex_lock(&(capture->mutex));
+        Video4Linux2_captureDecodeReset(capture);
+        pthread_mutex_unlock(&(capture->mutex));
+    }
+    ret = Video4Linux2_captureStreamoff(capture);
+    return (written == sizeof(value)) ? ret : -1;
+}
+
+/**
+ * Stops the streaming of the device of a specific
+ * <tt>Video4Linux2Capture</tt> which implicitly dequeues all of its buffers.
+ *
+ * @param capture the <tt>Video4Linux2Capture</tt> to stop the streaming of
+ * @return the return value of the <tt>VIDIOC_STREAMOFF</tt> ioctl
+ */
+static int
+Video4Linux2_captureStreamoff(Video4Linux2Capture *capture)
+{
+    enum v4l2_buf_type type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    int ret;
+
+    pthread_mutex_lock(&(capture->mutex));
+    ret = ioctl(capture->fd, VIDIOC_STREAMOFF, &type);
+    capture->queued = 0;
+    pthread_mutex_unlock(&(capture->mutex));
+    return ret;
+}
+
+/**
+ * Submits a specific captured frame of a <tt>Video4Linux2Capture</tt> to its
+ * decode threads. If as many frames as there are decode threads are already
+ * waiting, the oldest of them is dropped rather than fall further behind the
+ * device. The caller holds the <tt>mutex</tt> of <tt>capture</tt> and
+ * transfers a reference to <tt>frame</tt>.
+ *
+ * @param capture the <tt>Video4Linux2Capture</tt> to submit <tt>frame</tt> to
+ * @param frame the <tt>Video4Linux2Frame</tt> to be decoded
+ */
+static void
+Video4Linux2_captureSubmit
+    (Video4Linux2Capture *capture, Video4Linux2Frame *frame)
+{
+    if (capture->jobCount == capture->decoderCount)
+    {
+        Video4Linux2_frameUnref(capture->jobs[capture->jobHead]);
+        capture->jobHead = (capture->jobHead + 1) % capture->decoderCount;
+        (capture->jobCount)--;
+    }
+    capture->jobs[(capture->jobHead + capture->jobCount) % capture->decoderCount]
+        = frame;
+    (capture->jobCount)++;
+    pthread_cond_broadcast(&(capture->cond));
+}
+
+/**
+ * Removes a reference to a specific <tt>Video4Linux2Frame</tt> and enqueues
+ * it back to the driver if it is no longer referenced and its capture is
+ * started. A decoded frame which is no longer referenced simply becomes free
+ * for the decode threads again. The caller holds the <tt>mutex</tt> of the
+ * <tt>capture</tt> of <tt>frame</tt>.
+ *
+ * @param frame the <tt>Video4Linux2Frame</tt> to remove a reference to
+ */
+static void
+Video4Linux2_frameUnref(Video4Linux2Frame *frame)
+{
+    if ((frame->refCount > 0) && (--(frame->refCount) == 0))
+    {
+        Video4Linux2Capture *capture = frame->capture;
+
+        if (!(frame->decoded) && !(capture->stopped))
+            Video4Linux2_captureQbuf(capture, frame);
+    }
+}
@@ -14,6 +14,62 @@
 #ifdef __cplusplus
 extern "C" {
 #endif
+/*
+ * Class:     org_jitsi_impl_neomedia_jmfext_media_protocol_video4linux2_Video4Linux2
+ * Method:    capture_free
+ * Signature: (J)V
+ */
+JNIEXPORT void JNICALL Java_org_jitsi_impl_neomedia_jmfext_media_protocol_video4linux2_Video4Linux2_capture_1free
+  (JNIEnv *, jclass, jlong);
+
+/*
+ * Class:     org_jitsi_impl_neomedia_jmfext_media_protocol_video4linux2_Video4Linux2
+ * Method:    capture_getDecodeTimes
+ * Signature: (J[J)I
+ */
+JNIEXPORT jint JNICALL Java_org_jitsi_impl_neomedia_jmfext_media_protocol_video4linux2_Video4Linux2_capture_1getDecodeTimes
+  (JNIEnv *, jclass, jlong, jlongArray);
+
+/*
+ * Class:     org_jitsi_impl_neomedia_jmfext_media_protocol_video4linux2_Video4Linux2
+ * Method:    capture_new
+ * Signature: (III)J
+ */
+JNIEXPORT jlong JNICALL Java_org_jitsi_impl_neomedia_jmfext_media_protocol_video4linux2_Video4Linux2_capture_1new
+  (JNIEnv *, jclass, jint, jint, jint);
+
+/*
+ * Class:     org_jitsi_impl_neomedia_jmfext_media_protocol_video4linux2_Video4Linux2
+ * Method:    capture_read
+ * Signature: (J)J
+ */
+JNIEXPORT jlong JNICALL Java_org_jitsi_impl_neomedia_jmfext_media_protocol_video4linux2_Video4Linux2_capture_1read
+  (JNIEnv *, jclass, jlong);
+
+/*
+ * Class:     org_jitsi_impl_neomedia_jmfext_media_protocol_video4linux2_Video4Linux2
+ * Method:    capture_setDecoder
+ * Signature: (JJI)I
+ */
+JNIEXPORT jint JNICALL Java_org_jitsi_impl_neomedia_jmfext_media_protocol_video4linux2_Video4Linux2_capture_1setDecoder
+  (JNIEnv *, jclass, jlong, jlong, jint);
+
+/*
+ * Class:     org_jitsi_impl_neomedia_jmfext_media_protocol_video4linux2_Video4Linux2
+ * Method:    capture_start
+ * Signature: (J)I
+ */
+JNIEXPORT jint JNICALL Java_org_jitsi_impl_neomedia_jmfext_media_protocol_video4linux2_Video4Linux2_capture_1start
+  (JNIEnv *, jclass, jlong);
+
+/*
+ * Class:     org_jitsi_impl_neomedia_jmfext_media_protocol_video4linux2_Video4Linux2
+ * Method:    capture_stop
+ * Signature: (J)I
+ */
+JNIEXPORT jint JNICALL Java_org_jitsi_impl_neomedia_jmfext_media_protocol_video4linux2_Video4Linux2_capture_1stop
+  (JNIEnv *, jclass, jlong);
+
 /*
  * Class:     org_jitsi_impl_neomedia_jmfext_media_protocol_video4linux2_Video4Linux2
  * Method:    close
@@ -22,6 +78,46 @@ extern "C" {
 JNIEXPORT jint JNICALL Java_org_jitsi_impl_neomedia_jmfext_media_protocol_video4linux2_Video4Linux2_close
   (JNIEnv *, jclass, jint);
 
+/*
+ * Class:     org_jitsi_impl_neomedia_jmfext_media_protocol_video4linux2_Video4Linux2
+ * Method:    frame_getData
+ * Signature: (J)J
+ */
+JNIEXPORT jlong JNICALL Java_org_jitsi_impl_neomedia_jmfext_media_protocol_video4linux2_Video4Linux2_frame_1getData
+  (JNIEnv *, jclass, jlong);
+
+/*
+ * Class:     org_jitsi_impl_neomedia_jmfext_media_protocol_video4linux2_Video4Linux2
+ * Method:    frame_getLength
+ * Signature: (J)I
+ */
+JNIEXPORT jint JNICALL Java_org_jitsi_impl_neomedia_jmfext_media_protocol_video4linux2_Video4Linux2_frame_1getLength
+  (JNIEnv *, jclass, jlong);
+
+/*
+ * Class:     org_jitsi_impl_neomedia_jmfext_media_protocol_video4linux2_Video4Linux2
+ * Method:    frame_getSequence
+ * Signature: (J)I
+ */
+JNIEXPORT jint JNICALL Java_org_jitsi_impl_neomedia_jmfext_media_protocol_video4linux2_Video4Linux2_frame_1getSequence
+  (JNIEnv *, jclass, jlong);
+
+/*
+ * Class:     org_jitsi_impl_neomedia_jmfext_media_protocol_video4linux2_Video4Linux2
+ * Method:    frame_getTimestamp
+ * Signature: (J)J
+ */
+JNIEXPORT jlong JNICALL Java_org_jitsi_impl_neomedia_jmfext_media_protocol_video4linux2_Video4Linux2_frame_1getTimestamp
+  (JNIEnv *, jclass, jlong);
+
+/*
+ * Class:     org_jitsi_impl_neomedia_jmfext_media_protocol_video4linux2_Video4Linux2
+ * Method:    frame_release
+ * Signature: (J)V
+ */
+JNIEXPORT void JNICALL Java_org_jitsi_impl_neomedia_jmfext_media_protocol_video4linux2_Video4Linux2_frame_1release
+  (JNIEnv *, jclass, jlong);
+
 /*
  * Class:     org_jitsi_impl_neomedia_jmfext_media_protocol_video4linux2_Video4Linux2
  * Method:    free
@@ -0,0 +1,62 @@
+/*
+ * Jitsi, the OpenSource Java VoIP and Instant Messaging client.
+ *
+ * Distributable under LGPL license.
+ * See terms of license at gnu.org.
+ */
+
+#ifndef _ORG_JITSI_IMPL_NEOMEDIA_PORTAUDIO_CLOCK_H_
+#define _ORG_JITSI_IMPL_NEOMEDIA_PORTAUDIO_CLOCK_H_
+
+#include <stdint.h>
+
+#ifdef _WIN32
+#include <windows.h>
+
+/**
+ * Gets the current value of a monotonic clock in nanoseconds. The value is only
+ * meaningful when compared to another value returned by the function.
+ *
+ * @return the current value of a monotonic clock in nanoseconds
+ */
+static inline int64_t Clock_nanoTime()
+{
+    static LARGE_INTEGER frequency;
+    LARGE_INTEGER counter;
+
+    if (!frequency.QuadPart && !QueryPerformanceFrequency(&frequency))
+        return 0;
+    QueryPerformanceCounter(&counter);
+    return
+        (int64_t)
+            ((counter.QuadPart / frequency.QuadPart) * 1000000000LL
+                + ((counter.QuadPart % frequency.QuadPart) * 1000000000LL)
+                    / frequency.QuadPart);
+}
+
+#elif defined(__APPLE__) /* #ifdef _WIN32 */
+#include <mach/mach_time.h>
+
+static inline int64_t Clock_nanoTime()
+{
+    static mach_timebase_info_data_t timebase;
+
+    if (!timebase.denom)
+        mach_timebase_info(&timebase);
+    return (int64_t) (mach_absolute_time() * timebase.numer / timebase.denom);
+}
+
+#else /* #ifdef _WIN32 */
+#include <time.h>
+
+static inline int64_t Clock_nanoTime()
+{
+    struct timespec ts;
+
+    if (clock_gettime(CLOCK_MONOTONIC, &ts))
+        return 0;
+    return ((int64_t) ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+#endif /* #ifdef _WIN32 */
+
+#endif /* #ifndef _ORG_JITSI_IMPL_NEOMEDIA_PORTAUDIO_CLOCK_H_ */
@@ -5,11 +5,15 @@
  * See terms of license at gnu.org.
  */
 
+#define _GNU_SOURCE
+
 #include "org_jitsi_impl_neomedia_portaudio_Pa.h"
 
 #include "AudioQualityImprovement.h"
+#include "Clock.h"
 #include "ConditionVariable.h"
 #include "Mutex.h"
+#include "../realtime/Realtime.h"
 
 #include <portaudio.h>
 #include <stdint.h>
@@ -22,6 +26,51 @@
     #include "WMME_DSound.h"
 #endif /* #ifdef _WIN32 */
 
+#define SCHED_POLICY_DEFAULT org_jitsi_impl_neomedia_portaudio_Pa_SCHED_POLICY_DEFAULT
+#define SCHED_POLICY_FIFO org_jitsi_impl_neomedia_portaudio_Pa_SCHED_POLICY_FIFO
+#define SCHED_POLICY_NICE org_jitsi_impl_neomedia_portaudio_Pa_SCHED_POLICY_NICE
+#define SCHED_POLICY_RR org_jitsi_impl_neomedia_portaudio_Pa_SCHED_POLICY_RR
+
+#define STREAM_STATS_AQI_TIME org_jitsi_impl_neomedia_portaudio_Pa_STREAM_STATS_AQI_TIME
+#define STREAM_STATS_CALLBACK_INTERVAL_HISTOGRAM org_jitsi_impl_neomedia_portaudio_Pa_STREAM_STATS_CALLBACK_INTERVAL_HISTOGRAM
+#define STREAM_STATS_CALLBACK_INTERVAL_HISTOGRAM_LENGTH org_jitsi_impl_neomedia_portaudio_Pa_STREAM_STATS_CALLBACK_INTERVAL_HISTOGRAM_LENGTH
+#define STREAM_STATS_CALLBACK_INTERVAL_MAX org_jitsi_impl_neomedia_portaudio_Pa_STREAM_STATS_CALLBACK_INTERVAL_MAX
+#define STREAM_STATS_CALLBACKS org_jitsi_impl_neomedia_portaudio_Pa_STREAM_STATS_CALLBACKS
+#define STREAM_STATS_INPUT_FILL org_jitsi_impl_neomedia_portaudio_Pa_STREAM_STATS_INPUT_FILL
+#define STREAM_STATS_INPUT_FILL_MAX org_jitsi_impl_neomedia_portaudio_Pa_STREAM_STATS_INPUT_FILL_MAX
+#define STREAM_STATS_INPUT_OVERFLOWS org_jitsi_impl_neomedia_portaudio_Pa_STREAM_STATS_INPUT_OVERFLOWS
+#define STREAM_STATS_INPUT_UNDERFLOWS org_jitsi_impl_neomedia_portaudio_Pa_STREAM_STATS_INPUT_UNDERFLOWS
+#define STREAM_STATS_LENGTH org_jitsi_impl_neomedia_portaudio_Pa_STREAM_STATS_LENGTH
+#define STREAM_STATS_MUTEX_BLOCKED_TIME org_jitsi_impl_neomedia_portaudio_Pa_STREAM_STATS_MUTEX_BLOCKED_TIME
+#define STREAM_STATS_OUTPUT_FILL org_jitsi_impl_neomedia_portaudio_Pa_STREAM_STATS_OUTPUT_FILL
+#define STREAM_STATS_OUTPUT_FILL_MAX org_jitsi_impl_neomedia_portaudio_Pa_STREAM_STATS_OUTPUT_FILL_MAX
+#define STREAM_STATS_OUTPUT_OVERFLOWS org_jitsi_impl_neomedia_portaudio_Pa_STREAM_STATS_OUTPUT_OVERFLOWS
+#define STREAM_STATS_OUTPUT_UNDERFLOWS org_jitsi_impl_neomedia_portaudio_Pa_STREAM_STATS_OUTPUT_UNDERFLOWS
+
+/**
+ * Represents the health counters of a <tt>PortAudioStream</tt> i.e. the
+ * underflows and overflows reported by PortAudio and by the pseudo-blocking
+ * stream interface implementation, the intervals between consecutive
+ * transfers, the fill levels of the pseudo-blocking buffers and the time spent
+ * in audio quality improvement and blocked on the mutexes. The counters are
+ * updated without synchronization and are therefore read approximately.
+ */
+typedef struct
+{
+    /**
+     * The values of the counters indexed by the
+     * <tt>STREAM_STATS_XXX</tt> constants.
+     */
+    jlong values[STREAM_STATS_LENGTH];
+
+    /**
+     * The time in nanoseconds of the latest transfer i.e. invocation of the
+     * stream callback or, for blocking streams, of <tt>Pa_ReadStream</tt> or
+     * <tt>Pa_WriteStream</tt>.
+     */
+    jlong lastTransferTime;
+} PortAudioStreamStats;
+
 typedef struct
 {
     AudioQualityImprovement *audioQualityImprovement;
@@ -39,21 +88,61 @@ typedef struct
     ConditionVariable *inputCondVar;
     long inputFrameSize;
 
+    /**
+     * The index in #input of the first i.e. oldest byte of the
+     * pseudo-blocking input buffer which is used as a ring buffer.
+     */
+    size_t inputIndex;
+
     /** The input latency of #stream. */
     jlong inputLatency;
     size_t inputLength;
     Mutex *inputMutex;
+
+    /**
+     * The indicator which determines whether our pseudo-blocking
+     * Pa_ReadStream() is copying the oldest bytes out of #input without
+     * holding #inputMutex i.e. whether the stream callback is to drop the
+     * newest input instead of the oldest upon overflow.
+     */
+    jboolean inputReading;
+
+    /**
+     * The native memory in which the audio quality improvement processes the
+     * input read by Pa_ReadStream() or <tt>NULL</tt>.
+     */
+    void *inputScratch;
+    size_t inputScratchCapacity;
+
+    /**
+     * The indicator which determines whether this <tt>PortAudioStream</tt> and
+     * its pseudo-blocking buffers are locked into RAM.
+     */
+    jboolean memoryLocked;
     Mutex *mutex;
     void *output;
     size_t outputCapacity;
     ConditionVariable *outputCondVar;
     long outputFrameSize;
 
+    /**
+     * The index in #output of the first i.e. oldest byte of the
+     * pseudo-blocking output buffer which is used as a ring buffer.
+     */
+    size_t outputIndex;
+
     /** The output latency of #stream. */
     jlong outputLatency;
     size_t outputLength;
     Mutex *outputMutex;
 
+    /**
+     * The native memory in which the audio quality improvement processes the
+     * output written by Pa_WriteStream() or <tt>NULL</tt>.
+     */
+    void *outputScratch;
+    size_t outputScratchCapacity;
+
     /**
      * The indicator which determines whether this <tt>PortAudioStream</tt>
      * implements the blocking stream interface on top of the non-blocking
@@ -63,6 +152,30 @@ typedef struct
     jlong retainCount;
     double sampleRate;
     int sampleSizeInBits;
+
+    /**
+     * The <tt>SCHED_POLICY_XXX</tt> constant which specifies the scheduling
+     * policy which took effect on the thread transferring the audio of #stream.
+     */
+    jint schedPolicy;
+
+    /**
+     * The indicator which determines whether #schedPolicyRequest has been
+     * applied to the thread transferring the audio of #stream.
+     */
+    jboolean schedPolicyApplied;
+
+    /**
+     * The <tt>SCHED_POLICY_XXX</tt> constant which specifies the scheduling
+     * policy requested for the thread transferring the audio of #stream.
+     */
+    jint schedPolicyRequest;
+
+    /** The real-time priority requested along with #schedPolicyRequest. */
+    jint schedPriority;
+
+    /** The health counters of #stream. */
+    PortAudioStreamStats stats;
     PaStream *stream;
     jobject streamCallback;
     jmethodID streamCallbackMethodID;
@@ -125,6 +238,29 @@ static void *PortAudioStream_allocPseudoBlockingBuffer
     void **bufferPtr, size_t *bufferLengthPtr, size_t *bufferCapacityPtr,
     Mutex **bufferMutexPtr, ConditionVariable **bufferCondVarPtr);
 static void PortAudioStream_free(JNIEnv *env, PortAudioStream *stream);
+
+/**
+ * Gets the (at most two) contiguous regions which make up a specific number of
+ * bytes starting at a specific index in a (ring) buffer used by the
+ * pseudo-blocking stream interface implementation of a
+ * <tt>PortAudioStream</tt> i.e. the bytes to be read out of it or the free
+ * space to be written into it.
+ *
+ * @param buffer the buffer to get the regions of
+ * @param capacity the capacity in bytes of <tt>buffer</tt>
+ * @param index the index in <tt>buffer</tt> of the first byte of the regions.
+ * May exceed <tt>capacity</tt> in which case it wraps around.
+ * @param length the number of bytes in the regions
+ * @param regions the array of two elements to receive the locations of the
+ * regions
+ * @param regionLengths the array of two elements to receive the numbers of
+ * bytes in the regions
+ * @return the number of regions stored in <tt>regions</tt> and
+ * <tt>regionLengths</tt>
+ */
+static int PortAudioStream_getPseudoBlockingBufferRegions
+    (void *buffer, size_t capacity, size_t index, size_t length,
+    jbyte *regions[2], size_t regionLengths[2]);
 static int PortAudioStream_javaCallback
     (const void *input,
     void *output,
@@ -135,8 +271,25 @@ static int PortAudioStream_javaCallback
 static void PortAudioStream_javaFinishedCallback(void *userData);
 static PortAudioStream * PortAudioStream_new
     (JNIEnv *env, jobject streamCallback);
+
+/**
+ * Removes a specific number of bytes from the beginning of a (ring) buffer used
+ * by the pseudo-blocking stream interface implementation of a
+ * <tt>PortAudioStream</tt> and optionally copies them out of it.
+ *
+ * @param buffer the buffer to remove the bytes from
+ * @param capacity the capacity in bytes of <tt>buffer</tt>
+ * @param length the number of bytes to remove from <tt>buffer</tt>
+ * @param bufferIndexPtr a pointer to the index in <tt>buffer</tt> of its first
+ * byte
+ * @param bufferLengthPtr a pointer to the number of bytes in <tt>buffer</tt>
+ * @param dst the location to copy the removed bytes to or <tt>NULL</tt> to
+ * discard them
+ */
 static void PortAudioStream_popFromPseudoBlockingBuffer
-    (void *buffer, size_t length, size_t *bufferLengthPtr);
+    (void *buffer, size_t capacity, size_t length,
+    size_t *bufferIndexPtr, size_t *bufferLengthPtr,
+    void *dst);
 static int PortAudioStream_pseudoBlockingCallback
     (const void *input,
     void *output,
@@ -145,9 +298,113 @@ static int PortAudioStream_pseudoBlockingCallback
     PaStreamCallbackFlags statusFlags,
     void *userData);
 static void PortAudioStream_pseudoBlockingFinishedCallback(void *userData);
+
+/**
+ * Appends a specific number of bytes to the end of a (ring) buffer used by the
+ * pseudo-blocking stream interface implementation of a
+ * <tt>PortAudioStream</tt>. The caller is responsible for making sure that the
+ * buffer has enough free space.
+ *
+ * @param buffer the buffer to append the bytes to
+ * @param capacity the capacity in bytes of <tt>buffer</tt>
+ * @param bufferIndex the index in <tt>buffer</tt> of its first byte
+ * @param bufferLengthPtr a pointer to the number of bytes in <tt>buffer</tt>
+ * @param src the bytes to append to <tt>buffer</tt>
+ * @param length the number of bytes to append to <tt>buffer</tt>
+ */
+static void PortAudioStream_pushToPseudoBlockingBuffer
+    (void *buffer, size_t capacity,
+    size_t bufferIndex, size_t *bufferLengthPtr,
+    const void *src, size_t length);
+
+/**
+ * Reads a specific number of frames from a specific input
+ * <tt>PortAudioStream</tt> into a specific Java <tt>byte</tt> array and
+ * improves their audio quality if possible. The bytes of a pseudo-blocking
+ * stream are copied straight out of its (ring) buffer into the array unless
+ * their audio quality is to be improved in native memory first.
+ *
+ * @param env the <tt>JNIEnv</tt> of the calling thread
+ * @param stream the <tt>PortAudioStream</tt> to read from
+ * @param buffer the Java <tt>byte</tt> array to read into
+ * @param frames the number of frames to read
+ * @return <tt>paNoError</tt> upon success; otherwise, the error code
+ */
+static PaError PortAudioStream_read
+    (JNIEnv *env, PortAudioStream *stream, jbyteArray buffer, jlong frames);
 static void PortAudioStream_release(PortAudioStream *stream);
+
+/**
+ * Makes sure that a scratch buffer in native memory of a
+ * <tt>PortAudioStream</tt> has at least a specific capacity.
+ *
+ * @param scratchPtr a pointer to the scratch buffer
+ * @param scratchCapacityPtr a pointer to the capacity in bytes of the scratch
+ * buffer
+ * @param capacity the minimum capacity in bytes of the scratch buffer
+ * @return the scratch buffer upon success; otherwise, <tt>NULL</tt>
+ */
+static jbyte *PortAudioStream_reserveScratch
+    (void **scratchPtr, size_t *scratchCapacityPtr, size_t capacity);
 static void PortAudioStream_retain(PortAudioStream *stream);
 
+/**
+ * Applies the scheduling policy requested for a specific
+ * <tt>PortAudioStream</tt> to the calling thread if it has not been applied
+ * yet. Invoked only on the native thread which transfers the audio of the
+ * stream i.e. the stream callback thread (which is also the one feeding the
+ * buffers of a pseudo-blocking stream) because the policy is never restored.
+ *
+ * @param stream the <tt>PortAudioStream</tt> which is to have its requested
+ * scheduling policy applied to the calling thread
+ */
+static void PortAudioStream_setThreadSchedPolicy(PortAudioStream *stream);
+
+/**
+ * Writes a specific number of frames from a specific Java <tt>byte</tt> array
+ * into a specific output <tt>PortAudioStream</tt> a specific number of times.
+ * Improves the audio quality of the written frames if possible. The bytes are
+ * copied straight out of the array into the (ring) buffer of a pseudo-blocking
+ * stream unless their audio quality is to be improved in native memory too.
+ *
+ * @param env the <tt>JNIEnv</tt> of the calling thread
+ * @param stream the <tt>PortAudioStream</tt> to write into
+ * @param buffer the Java <tt>byte</tt> array to write from
+ * @param offset the offset in <tt>buffer</tt> of the first byte to write.
+ * Each write starts where the previous one has ended.
+ * @param frames the number of frames to write with a single write
+ * @param numberOfWrites the number of writes to perform
+ * @return <tt>paNoError</tt> upon success; otherwise, the error code
+ */
+static PaError PortAudioStream_write
+    (JNIEnv *env, PortAudioStream *stream,
+    jbyteArray buffer, jint offset, jlong frames, jint numberOfWrites);
+
+/**
+ * Records the current fill level of a pseudo-blocking buffer of a
+ * <tt>PortAudioStream</tt> and updates the respective maximum.
+ *
+ * @param stats the <tt>PortAudioStreamStats</tt> to record into
+ * @param index the <tt>STREAM_STATS_XXX</tt> index of the fill level to record
+ * which is immediately followed by the index of its maximum
+ * @param length the current length in bytes of the pseudo-blocking buffer
+ */
+static void PortAudioStreamStats_fill
+    (PortAudioStreamStats *stats, int index, size_t length);
+
+/**
+ * Records a transfer of audio data i.e. an invocation of the stream callback
+ * or, for blocking streams, of <tt>Pa_ReadStream</tt> or
+ * <tt>Pa_WriteStream</tt>. Counts the underflows and overflows signaled by
+ * <tt>statusFlags</tt> and updates the histogram of the intervals between
+ * consecutive transfers.
+ *
+ * @param stats the <tt>PortAudioStreamStats</tt> to record into
+ * @param statusFlags the <tt>PaStreamCallbackFlags</tt> reported by PortAudio
+ */
+static void PortAudioStreamStats_transfer
+    (PortAudioStreamStats *stats, PaStreamCallbackFlags statusFlags);
+
 static const char *AUDIO_QUALITY_IMPROVEMENT_STRING_ID = "portaudio";
 #define LATENCY_HIGH org_jitsi_impl_neomedia_portaudio_Pa_LATENCY_HIGH
 #define LATENCY_LOW org_jitsi_impl_neomedia_portaudio_Pa_LATENCY_LOW
@@ -349,6 +606,26 @@ Java_org_jitsi_impl_neomedia_portaudio_Pa_GetStreamReadAvailable
             ((PortAudioStream *) (intptr_t) stream)->stream);
 }
 
+JNIEXPORT jint JNICALL
+Java_org_jitsi_impl_neomedia_portaudio_Pa_GetStreamSchedPolicy
+    (JNIEnv *env, jclass clazz, jlong stream)
+{
+    return ((PortAudioStream *) (intptr_t) stream)->schedPolicy;
+}
+
+JNIEXPORT void JNICALL
+Java_org_jitsi_impl_neomedia_portaudio_Pa_GetStreamStats
+    (JNIEnv *env, jclass clazz, jlong stream, jlongArray stats)
+{
+    PortAudioStream *s = (PortAudioStream *) (intptr_t) stream;
+    jsize length = (*env)->GetArrayLength(env, stats);
+
+    if (length > STREAM_STATS_LENGTH)
+        length = STREAM_STATS_LENGTH;
+    if (length > 0)
+        (*env)->SetLongArrayRegion(env, stats, 0, length, s->stats.values);
+}
+
 JNIEXPORT jlong JNICALL
 Java_org_jitsi_impl_neomedia_portaudio_Pa_GetStreamWriteAvailable
     (JNIEnv *env, jclass clazz, jlong stream)
@@ -713,93 +990,14 @@ JNIEXPORT void JNICALL
 Java_org_jitsi_impl_neomedia_portaudio_Pa_ReadStream
     (JNIEnv *env, jclass clazz, jlong stream, jbyteArray buffer, jlong frames)
 {
-    jbyte* data = (*env)->GetByteArrayElements(env, buffer, NULL);
-
-    if (data)
-    {
-        PortAudioStream *s = (PortAudioStream *) (intptr_t) stream;
-        PaError err;
-        jlong framesInBytes = frames * s->inputFrameSize;
-
-        if (s->pseudoBlocking)
-        {
-            if (Mutex_lock(s->inputMutex))
-                err = paInternalError;
-            else
-            {
-                jlong bytesRead = 0;
-
-                err = paNoError;
-                while (bytesRead < framesInBytes)
-                {
-                    jlong bytesToRead;
-
-                    if (JNI_TRUE == s->finished)
-                    {
-                        err = paStreamIsStopped;
-                        break;
-                    }
-                    if (!(s->inputLength))
-                    {
-                        ConditionVariable_wait(s->inputCondVar, s->inputMutex);
-                        continue;
-                    }
-
-                    bytesToRead = framesInBytes - bytesRead;
-                    if (bytesToRead > s->inputLength)
-                        bytesToRead = s->inputLength;
-                    memcpy(data + bytesRead, s->input, bytesToRead);
-                    PortAudioStream_popFromPseudoBlockingBuffer(
-                        s->input,
-                        bytesToRead,
-                        &(s->inputLength));
-                    bytesRead += bytesToRead;
-                }
-                Mutex_unlock(s->inputMutex);
-            }
-
-            /* Improve the audio quality of the input if possible. */
-            if ((paNoError == err) && s->audioQualityImprovement)
-            {
-                AudioQualityImprovement_process(
-                    s->audioQualityImprovement,
-                    AUDIO_QUALITY_IMPROVEMENT_SAMPLE_ORIGIN_INPUT,
-                    s->sampleRate,
-                    s->sampleSizeInBits,
-                    s->channels,
-                    s->inputLatency,
-                    data, framesInBytes);
-            }
-        }
-        else
-        {
-            err = Pa_ReadStream(s->stream, data, frames);
-            if ((paNoError == err) || (paInputOverflowed == err))
-            {
-                err = paNoError;
-
-                if (s->audioQualityImprovement)
-                {
-                    AudioQualityImprovement_process(
-                        s->audioQualityImprovement,
-                        AUDIO_QUALITY_IMPROVEMENT_SAMPLE_ORIGIN_INPUT,
-                        s->sampleRate,
-                        s->sampleSizeInBits,
-                        s->channels,
-                        s->inputLatency,
-                        data, framesInBytes);
-                }
-            }
-        }
+    PaError err
+        = PortAudioStream_read(
+            env,
+            (PortAudioStream *) (intptr_t) stream,
+            buffer, frames);
 
-        if (paNoError == err)
-            (*env)->ReleaseByteArrayElements(env, buffer, data, 0);
-        else
-        {
-            (*env)->ReleaseByteArrayElements(env, buffer, data, JNI_ABORT);
-            PortAudio_throwException(env, err);
-        }
-    }
+    if ((paNoError != err) && (JNI_FALSE == (*env)->ExceptionCheck(env)))
+        PortAudio_throwException(env, err);
 }
 
 JNIEXPORT void JNICALL
@@ -828,6 +1026,43 @@ Java_org_jitsi_impl_neomedia_portaudio_Pa_setEchoFilterLengthInMillis
     }
 }
 
+JNIEXPORT jboolean JNICALL
+Java_org_jitsi_impl_neomedia_portaudio_Pa_SetStreamSchedPolicy
+    (JNIEnv *env, jclass clazz, jlong stream, jint policy, jint priority)
+{
+    PortAudioStream *s = (PortAudioStream *) (intptr_t) stream;
+
+    s->schedPolicyRequest = policy;
+    s->schedPriority = priority;
+    s->schedPolicyApplied = JNI_FALSE;
+
+    /*
+     * Lock the memory touched by the audio thread so that it does not incur
+     * page faults which would defeat the purpose of the scheduling policy.
+     */
+    if ((SCHED_POLICY_DEFAULT != policy) && (JNI_FALSE == s->memoryLocked))
+    {
+        if (!Realtime_lockMemory(s, sizeof(PortAudioStream)))
+        {
+            if (s->input
+                    && Realtime_lockMemory(s->input, s->inputCapacity))
+            {
+                Realtime_unlockMemory(s, sizeof(PortAudioStream));
+            }
+            else if (s->output
+                    && Realtime_lockMemory(s->output, s->outputCapacity))
+            {
+                if (s->input)
+                    Realtime_unlockMemory(s->input, s->inputCapacity);
+                Realtime_unlockMemory(s, sizeof(PortAudioStream));
+            }
+            else
+                s->memoryLocked = JNI_TRUE;
+        }
+    }
+    return s->memoryLocked;
+}
+
 JNIEXPORT void JNICALL
 Java_org_jitsi_impl_neomedia_portaudio_Pa_StartStream
     (JNIEnv *env, jclass clazz, jlong stream)
@@ -835,6 +1070,9 @@ Java_org_jitsi_impl_neomedia_portaudio_Pa_StartStream
     PortAudioStream *s = (PortAudioStream *) (intptr_t) stream;
     PaError err;
 
+    /* The host API may start a new thread to transfer the audio. */
+    if (SCHED_POLICY_DEFAULT != s->schedPolicyRequest)
+        s->schedPolicyApplied = JNI_FALSE;
     if (s->pseudoBlocking)
     {
         PortAudioStream_retain(s);
@@ -907,118 +1145,13 @@ Java_org_jitsi_impl_neomedia_portaudio_Pa_WriteStream
     jbyteArray buffer, jint offset, jlong frames,
     jint numberOfWrites)
 {
-    jbyte *bufferBytes;
-    jbyte* data;
-    PortAudioStream *s;
-    jint i;
-    PaError err = paNoError;
-    jlong framesInBytes;
-    AudioQualityImprovement *aqi;
-    double sampleRate;
-    unsigned long sampleSizeInBits;
-    int channels;
-    jlong outputLatency;
-
-    bufferBytes = (*env)->GetByteArrayElements(env, buffer, NULL);
-    if (!bufferBytes)
-        return;
-    data = bufferBytes + offset;
-
-    s = (PortAudioStream *) (intptr_t) stream;
-    framesInBytes = frames * s->outputFrameSize;
-    aqi = s->audioQualityImprovement;
-    sampleRate = s->sampleRate;
-    sampleSizeInBits = s->sampleSizeInBits;
-    channels = s->channels;
-    outputLatency = s->outputLatency;
-
-    if (s->pseudoBlocking)
-    {
-        for (i = 0; i < numberOfWrites; i++)
-        {
-            if (Mutex_lock(s->outputMutex))
-                err = paInternalError;
-            else
-            {
-                jlong bytesWritten = 0;
-
-                err = paNoError;
-                while (bytesWritten < framesInBytes)
-                {
-                    size_t outputCapacity = s->outputCapacity - s->outputLength;
-                    jlong bytesToWrite;
-
-                    if (JNI_TRUE == s->finished)
-                    {
-                        err = paStreamIsStopped;
-                        break;
-                    }
-                    if (outputCapacity < 1)
-                    {
-                        ConditionVariable_wait(
-                            s->outputCondVar,
-                            s->outputMutex);
-                        continue;
-                    }
-
-                    bytesToWrite = framesInBytes - bytesWritten;
-                    if (bytesToWrite > outputCapacity)
-                        bytesToWrite = outputCapacity;
-                    memcpy(
-                        ((jbyte *) s->output) + s->outputLength,
-                        data + bytesWritten,
-                        bytesToWrite);
-
-                    s->outputLength += bytesToWrite;
-                    bytesWritten += bytesToWrite;
-                }
-                Mutex_unlock(s->outputMutex);
-            }
-
-            if (paNoError == err)
-            {
-                if (aqi)
-                {
-                    AudioQualityImprovement_process(
-                        aqi,
-                        AUDIO_QUALITY_IMPROVEMENT_SAMPLE_ORIGIN_OUTPUT,
-                        sampleRate, sampleSizeInBits, channels,
-                        outputLatency,
-                        data, framesInBytes);
-                }
-
-                data += framesInBytes;
-            }
-        }
-    }
-    else
-    {
-        PaStream *paStream = s->stream;
-
-        for (i = 0; i < numberOfWrites; i++)
-        {
-            err = Pa_WriteStream(paStream, data, frames);
-            if ((paNoError != err) && (paOutputUnderflowed != err))
-                break;
-            else
-            {
-                if (aqi)
-                {
-                    AudioQualityImprovement_process(
-                        aqi,
-                        AUDIO_QUALITY_IMPROVEMENT_SAMPLE_ORIGIN_OUTPUT,
-                        sampleRate, sampleSizeInBits, channels,
-                        outputLatency,
-                        data, framesInBytes);
-                }
-                data += framesInBytes;
-            }
-        }
-    }
-
-    (*env)->ReleaseByteArrayElements(env, buffer, bufferBytes, JNI_ABORT);
+    PaError err
+        = PortAudioStream_write(
+            env,
+            (PortAudioStream *) (intptr_t) stream,
+            buffer, offset, frames, numberOfWrites);
 
-    if ((paNoError != err) && (paOutputUnderflowed != err))
+    if ((paNoError != err) && (JNI_FALSE == (*env)->ExceptionCheck(env)))
         PortAudio_throwException(env, err);
 }
 
@@ -1389,7 +1522,7 @@ PortAudioStream_allocPseudoBlockingBuffer
     void **bufferPtr, size_t *bufferLengthPtr, size_t *bufferCapacityPtr,
     Mutex **bufferMutexPtr, ConditionVariable **bufferCondVarPtr)
 {
-    void *buffer = malloc(capacity);
+    void *buffer = Realtime_alloc(capacity);
 
     if (buffer)
     {
@@ -1413,13 +1546,13 @@ PortAudioStream_allocPseudoBlockingBuffer
             else
             {
                 Mutex_free(mutex);
-                free(buffer);
+                Realtime_free(buffer);
                 buffer = NULL;
             }
         }
         else
         {
-            free(buffer);
+            Realtime_free(buffer);
             buffer = NULL;
         }
     }
@@ -1435,7 +1568,11 @@ PortAudioStream_free(JNIEnv *env, PortAudioStream *stream)
     if (stream->inputMutex && !Mutex_lock(stream->inputMutex))
     {
         if (stream->input)
-            free(stream->input);
+        {
+            if (stream->memoryLocked)
+                Realtime_unlockMemory(stream->input, stream->inputCapacity);
+            Realtime_free(stream->input);
+        }
         ConditionVariable_free(stream->inputCondVar);
         Mutex_unlock(stream->inputMutex);
         Mutex_free(stream->inputMutex);
@@ -1444,19 +1581,56 @@ PortAudioStream_free(JNIEnv *env, PortAudioStream *stream)
     if (stream->outputMutex && !Mutex_lock(stream->outputMutex))
     {
         if (stream->output)
-            free(stream->output);
+        {
+            if (stream->memoryLocked)
+                Realtime_unlockMemory(stream->output, stream->outputCapacity);
+            Realtime_free(stream->output);
+        }
         ConditionVariable_free(stream->outputCondVar);
         Mutex_unlock(stream->outputMutex);
         Mutex_free(stream->outputMutex);
     }
 
+    free(stream->inputScratch);
+    free(stream->outputScratch);
+
     if (stream->audioQualityImprovement)
         AudioQualityImprovement_release(stream->audioQualityImprovement);
 
     if (stream->mutex)
         Mutex_free(stream->mutex);
 
-    free(stream);
+    if (stream->memoryLocked)
+        Realtime_unlockMemory(stream, sizeof(PortAudioStream));
+    Realtime_free(stream);
+}
+
+static int
+PortAudioStream_getPseudoBlockingBufferRegions
+    (void *buffer, size_t capacity, size_t index, size_t length,
+    jbyte *regions[2], size_t regionLengths[2])
+{
+    size_t tailLength;
+
+    if (!length)
+        return 0;
+
+    if (index >= capacity)
+        index -= capacity;
+    tailLength = capacity - index;
+    regions[0] = ((jbyte *) buffer) + index;
+    if (tailLength >= length)
+    {
+        regionLengths[0] = length;
+        return 1;
+    }
+    else
+    {
+        regionLengths[0] = tailLength;
+        regions[1] = (jbyte *) buffer;
+        regionLengths[1] = length - tailLength;
+        return 2;
+    }
 }
 
 static int
@@ -1474,6 +1648,8 @@ PortAudioStream_javaCallback
     jmethodID streamCallbackMethodID;
     int ret;
 
+    PortAudioStream_setThreadSchedPolicy(s);
+    PortAudioStreamStats_transfer(&(s->stats), statusFlags);
     if (!streamCallback)
         return paContinue;
 
@@ -1583,7 +1759,11 @@ PortAudioStream_javaFinishedCallback(void *userData)
 static PortAudioStream *
 PortAudioStream_new(JNIEnv *env, jobject streamCallback)
 {
-    PortAudioStream *s = calloc(1, sizeof(PortAudioStream));
+    /*
+     * The audio threads touch the PortAudioStream so it is allocated in pages
+     * of its own which may be locked into RAM.
+     */
+    PortAudioStream *s = Realtime_alloc(sizeof(PortAudioStream));
 
     if (!s)
     {
@@ -1591,11 +1771,16 @@ PortAudioStream_new(JNIEnv *env, jobject streamCallback)
         return NULL;
     }
 
+    /* Leave the scheduling policy of the audio threads intact by default. */
+    s->schedPolicy = SCHED_POLICY_DEFAULT;
+    s->schedPolicyApplied = JNI_TRUE;
+    s->schedPolicyRequest = SCHED_POLICY_DEFAULT;
+
     if (streamCallback)
     {
         if ((*env)->GetJavaVM(env, &(s->vm)) < 0)
         {
-            free(s);
+            Realtime_free(s);
             PortAudio_throwException(env, paInternalError);
             return NULL;
         }
@@ -1603,7 +1788,7 @@ PortAudioStream_new(JNIEnv *env, jobject streamCallback)
         s->streamCallback = (*env)->NewGlobalRef(env, streamCallback);
         if (!(s->streamCallback))
         {
-            free(s);
+            Realtime_free(s);
             PortAudio_throwException(env, paInsufficientMemory);
             return NULL;
         }
@@ -1614,16 +1799,32 @@ PortAudioStream_new(JNIEnv *env, jobject streamCallback)
 
 static void
 PortAudioStream_popFromPseudoBlockingBuffer
-    (void *buffer, size_t length, size_t *bufferLengthPtr)
+    (void *buffer, size_t capacity, size_t length,
+    size_t *bufferIndexPtr, size_t *bufferLengthPtr,
+    void *dst)
 {
-    size_t i;
-    size_t newLength = *bufferLengthPtr - length;
-    jbyte *oldBuffer = (jbyte *) buffer;
-    jbyte *newBuffer = ((jbyte *) buffer) + length;
+    size_t bufferIndex = *bufferIndexPtr;
 
-    for (i = 0; i < newLength; i++)
-        *oldBuffer++ = *newBuffer++;
-    *bufferLengthPtr = newLength;
+    if (dst)
+    {
+        size_t tailLength = capacity - bufferIndex;
+
+        if (tailLength > length)
+            tailLength = length;
+        memcpy(dst, ((jbyte *) buffer) + bufferIndex, tailLength);
+        if (tailLength < length)
+            memcpy(((jbyte *) dst) + tailLength, buffer, length - tailLength);
+    }
+
+    bufferIndex += length;
+    if (bufferIndex >= capacity)
+        bufferIndex -= capacity;
+    *bufferLengthPtr -= length;
+    /*
+     * Keep the free space contiguous for as long as possible when the buffer
+     * gets emptied.
+     */
+    *bufferIndexPtr = *bufferLengthPtr ? bufferIndex : 0;
 }
 
 static int
@@ -1637,11 +1838,19 @@ PortAudioStream_pseudoBlockingCallback
 {
     PortAudioStream *s = (PortAudioStream *) userData;
 
+    PortAudioStream_setThreadSchedPolicy(s);
+    PortAudioStreamStats_transfer(&(s->stats), statusFlags);
     if (input && s->inputMutex && !Mutex_lock(s->inputMutex))
     {
         size_t inputLength = frameCount * s->inputFrameSize;
         size_t newInputLength;
-        void *inputInStream;
+
+        if (inputLength > s->inputCapacity)
+        {
+            input
+                = ((const jbyte *) input) + (inputLength - s->inputCapacity);
+            inputLength = s->inputCapacity;
+        }
 
         /*
          * Remember the specified input so that it can be retrieved later on in
@@ -1650,14 +1859,35 @@ PortAudioStream_pseudoBlockingCallback
         newInputLength = s->inputLength + inputLength;
         if (newInputLength > s->inputCapacity)
         {
-            PortAudioStream_popFromPseudoBlockingBuffer(
-                s->input,
-                newInputLength - s->inputCapacity,
-                &(s->inputLength));
+            s->stats.values[STREAM_STATS_INPUT_OVERFLOWS]++;
+            if (JNI_TRUE == s->inputReading)
+            {
+                /*
+                 * The reader has not kept up but it is copying the oldest
+                 * input out right now so the newest input is dropped.
+                 */
+                inputLength = s->inputCapacity - s->inputLength;
+            }
+            else
+            {
+                /*
+                 * The reader has not kept up so the oldest input is dropped.
+                 */
+                PortAudioStream_popFromPseudoBlockingBuffer(
+                    s->input, s->inputCapacity,
+                    newInputLength - s->inputCapacity,
+                    &(s->inputIndex), &(s->inputLength),
+                    NULL);
+            }
         }
-        inputInStream = ((jbyte *) (s->input)) + s->inputLength;
-        memcpy(inputInStream, input, inputLength);
-        s->inputLength += inputLength;
+        PortAudioStream_pushToPseudoBlockingBuffer(
+            s->input, s->inputCapacity,
+            s->inputIndex, &(s->inputLength),
+            input, inputLength);
+        PortAudioStreamStats_fill(
+            &(s->stats),
+            STREAM_STATS_INPUT_FILL,
+            s->inputLength);
 
         ConditionVariable_notify(s->inputCondVar);
         Mutex_unlock(s->inputMutex);
@@ -1669,13 +1899,19 @@ PortAudioStream_pseudoBlockingCallback
 
         if (availableOutputLength > s->outputLength)
             availableOutputLength = s->outputLength;
-        memcpy(output, s->output, availableOutputLength);
         PortAudioStream_popFromPseudoBlockingBuffer(
-            s->output,
+            s->output, s->outputCapacity,
             availableOutputLength,
-            &(s->outputLength));
+            &(s->outputIndex), &(s->outputLength),
+            output);
+        PortAudioStreamStats_fill(
+            &(s->stats),
+            STREAM_STATS_OUTPUT_FILL,
+            s->outputLength);
         if (availableOutputLength < outputLength)
         {
+            /* The writer has not kept up so silence is played instead. */
+            s->stats.values[STREAM_STATS_OUTPUT_UNDERFLOWS]++;
             memset(
                 ((jbyte *) output) + availableOutputLength,
                 0,
@@ -1711,6 +1947,184 @@ PortAudioStream_pseudoBlockingFinishedCallback(void *userData)
     PortAudioStream_release(s);
 }
 
+static void
+PortAudioStream_pushToPseudoBlockingBuffer
+    (void *buffer, size_t capacity,
+    size_t bufferIndex, size_t *bufferLengthPtr,
+    const void *src, size_t length)
+{
+    size_t tailIndex = bufferIndex + *bufferLengthPtr;
+    size_t tailLength;
+
+    if (tailIndex >= capacity)
+        tailIndex -= capacity;
+    tailLength = capacity - tailIndex;
+    if (tailLength > length)
+        tailLength = length;
+    memcpy(((jbyte *) buffer) + tailIndex, src, tailLength);
+    if (tailLength < length)
+        memcpy(buffer, ((const jbyte *) src) + tailLength, length - tailLength);
+    *bufferLengthPtr += length;
+}
+
+static PaError
+PortAudioStream_read
+    (JNIEnv *env, PortAudioStream *s, jbyteArray buffer, jlong frames)
+{
+    PaError err;
+    jlong framesInBytes = frames * s->inputFrameSize;
+    jbyte *scratch = NULL;
+
+    if ((framesInBytes < 0)
+            || ((*env)->GetArrayLength(env, buffer) < framesInBytes))
+        return paBadBufferPtr;
+
+    /*
+     * The audio quality improvement and Pa_ReadStream() work on native memory
+     * so the bytes are read into the Java array out of a scratch buffer then.
+     */
+    if (s->audioQualityImprovement || !(s->pseudoBlocking))
+    {
+        scratch
+            = PortAudioStream_reserveScratch(
+                &(s->inputScratch), &(s->inputScratchCapacity),
+                framesInBytes);
+        if (!scratch)
+            return paInsufficientMemory;
+    }
+
+    if (s->pseudoBlocking)
+    {
+        jlong blockedTime = Clock_nanoTime();
+
+        if (Mutex_lock(s->inputMutex))
+            err = paInternalError;
+        else
+        {
+            jlong bytesRead = 0;
+
+            s->stats.values[STREAM_STATS_MUTEX_BLOCKED_TIME]
+                += Clock_nanoTime() - blockedTime;
+            err = paNoError;
+            while (bytesRead < framesInBytes)
+            {
+                jlong bytesToRead;
+                jbyte *regions[2];
+                size_t regionLengths[2];
+                int regionCount;
+                int r;
+
+                if (JNI_TRUE == s->finished)
+                {
+                    err = paStreamIsStopped;
+                    break;
+                }
+                if (!(s->inputLength))
+                {
+                    blockedTime = Clock_nanoTime();
+                    ConditionVariable_wait(s->inputCondVar, s->inputMutex);
+                    s->stats.values[STREAM_STATS_MUTEX_BLOCKED_TIME]
+                        += Clock_nanoTime() - blockedTime;
+                    continue;
+                }
+
+                bytesToRead = framesInBytes - bytesRead;
+                if (bytesToRead > s->inputLength)
+                    bytesToRead = s->inputLength;
+                regionCount
+                    = PortAudioStream_getPseudoBlockingBufferRegions(
+                        s->input, s->inputCapacity,
+                        s->inputIndex, bytesToRead,
+                        regions, regionLengths);
+
+                /*
+                 * The stream callback only appends to the buffer while the
+                 * oldest bytes are being copied out of it so the mutex is not
+                 * held while the JNI copies into the Java array.
+                 */
+                s->inputReading = JNI_TRUE;
+                Mutex_unlock(s->inputMutex);
+                for (r = 0; r < regionCount; r++)
+                {
+                    if (scratch)
+                    {
+                        memcpy(
+                            scratch + bytesRead,
+                            regions[r], regionLengths[r]);
+                    }
+                    else
+                    {
+                        (*env)->SetByteArrayRegion(
+                            env, buffer,
+                            (jsize) bytesRead, (jsize) regionLengths[r],
+                            regions[r]);
+                    }
+                    bytesRead += regionLengths[r];
+                }
+                blockedTime = Clock_nanoTime();
+                if (Mutex_lock(s->inputMutex))
+                {
+                    err = paInternalError;
+                    break;
+                }
+                s->stats.values[STREAM_STATS_MUTEX_BLOCKED_TIME]
+                    += Clock_nanoTime() - blockedTime;
+                s->inputReading = JNI_FALSE;
+
+                PortAudioStream_popFromPseudoBlockingBuffer(
+                    s->input, s->inputCapacity,
+                    bytesToRead,
+                    &(s->inputIndex), &(s->inputLength),
+                    NULL);
+            }
+            if (paInternalError != err)
+            {
+                PortAudioStreamStats_fill(
+                    &(s->stats),
+                    STREAM_STATS_INPUT_FILL,
+                    s->inputLength);
+                Mutex_unlock(s->inputMutex);
+            }
+        }
+    }
+    else
+    {
+        err = Pa_ReadStream(s->stream, scratch, frames);
+        PortAudioStreamStats_transfer(
+            &(s->stats),
+            (paInputOverflowed == err) ? paInputOverflow : 0);
+        if (paInputOverflowed == err)
+            err = paNoError;
+    }
+
+    if ((paNoError == err) && scratch)
+    {
+        /* Improve the audio quality of the input if possible. */
+        if (s->audioQualityImprovement)
+        {
+            jlong aqiTime = Clock_nanoTime();
+
+            AudioQualityImprovement_process(
+                s->audioQualityImprovement,
+                AUDIO_QUALITY_IMPROVEMENT_SAMPLE_ORIGIN_INPUT,
+                s->sampleRate,
+                s->sampleSizeInBits,
+                s->channels,
+                s->inputLatency,
+                scratch, framesInBytes);
+            s->stats.values[STREAM_STATS_AQI_TIME]
+                += Clock_nanoTime() - aqiTime;
+        }
+
+        (*env)->SetByteArrayRegion(
+            env, buffer,
+            0, (jsize) framesInBytes,
+            scratch);
+    }
+
+    return err;
+}
+
 static void
 PortAudioStream_release(PortAudioStream *stream)
 {
@@ -1727,6 +2141,22 @@ PortAudioStream_release(PortAudioStream *stream)
     }
 }
 
+static jbyte *
+PortAudioStream_reserveScratch
+    (void **scratchPtr, size_t *scratchCapacityPtr, size_t capacity)
+{
+    if (*scratchCapacityPtr < capacity)
+    {
+        void *scratch = realloc(*scratchPtr, capacity);
+
+        if (!scratch)
+            return NULL;
+        *scratchPtr = scratch;
+        *scratchCapacityPtr = capacity;
+    }
+    return (jbyte *) (*scratchPtr);
+}
+
 static void
 PortAudioStream_retain(PortAudioStream *stream)
 {
@@ -1736,3 +2166,249 @@ PortAudioStream_retain(PortAudioStream *stream)
         Mutex_unlock(stream->mutex);
     }
 }
+
+static void
+PortAudioStream_setThreadSchedPolicy(PortAudioStream *stream)
+{
+    if (JNI_FALSE == stream->schedPolicyApplied)
+    {
+        stream->schedPolicyApplied = JNI_TRUE;
+        stream->schedPolicy
+            = Realtime_setThreadSchedPolicy(
+                    stream->schedPolicyRequest,
+                    stream->schedPriority);
+    }
+}
+
+static void
+PortAudioStreamStats_fill
+    (PortAudioStreamStats *stats, int index, size_t length)
+{
+    jlong *values = stats->values;
+
+    values[index] = length;
+    if (values[index + 1] < (jlong) length)
+        values[index + 1] = length;
+}
+
+static void
+PortAudioStreamStats_transfer
+    (PortAudioStreamStats *stats, PaStreamCallbackFlags statusFlags)
+{
+    jlong *values = stats->values;
+    jlong now = Clock_nanoTime();
+    jlong lastTransferTime = stats->lastTransferTime;
+
+    values[STREAM_STATS_CALLBACKS]++;
+    if (statusFlags & paInputUnderflow)
+        values[STREAM_STATS_INPUT_UNDERFLOWS]++;
+    if (statusFlags & paInputOverflow)
+        values[STREAM_STATS_INPUT_OVERFLOWS]++;
+    if (statusFlags & paOutputUnderflow)
+        values[STREAM_STATS_OUTPUT_UNDERFLOWS]++;
+    if (statusFlags & paOutputOverflow)
+        values[STREAM_STATS_OUTPUT_OVERFLOWS]++;
+
+    if (lastTransferTime)
+    {
+        jlong interval = now - lastTransferTime;
+        jlong intervalInMillis = interval / 1000000;
+        int bin = 0;
+
+        if (values[STREAM_STATS_CALLBACK_INTERVAL_MAX] < interval)
+            values[STREAM_STATS_CALLBACK_INTERVAL_MAX] = interval;
+
+        /*
+         * The first bin counts the intervals shorter than a millisecond, each
+         * subsequent bin doubles the upper bound of the previous one and the
+         * last bin counts whatever remains.
+         */
+        while ((intervalInMillis > 0)
+                && (bin < STREAM_STATS_CALLBACK_INTERVAL_HISTOGRAM_LENGTH - 1))
+        {
+            intervalInMillis >>= 1;
+            bin++;
+        }
+        values[STREAM_STATS_CALLBACK_INTERVAL_HISTOGRAM + bin]++;
+    }
+    stats->lastTransferTime = now;
+}
+
+static PaError
+PortAudioStream_write
+    (JNIEnv *env, PortAudioStream *s,
+    jbyteArray buffer, jint offset, jlong frames, jint numberOfWrites)
+{
+    jint i;
+    PaError err = paNoError;
+    jlong framesInBytes = frames * s->outputFrameSize;
+    AudioQualityImprovement *aqi = s->audioQualityImprovement;
+    double sampleRate = s->sampleRate;
+    unsigned long sampleSizeInBits = s->sampleSizeInBits;
+    int channels = s->channels;
+    jlong outputLatency = s->outputLatency;
+    jbyte *scratch = NULL;
+
+    if ((offset < 0) || (framesInBytes < 0) || (numberOfWrites < 0)
+            || ((*env)->GetArrayLength(env, buffer)
+                    < offset + framesInBytes * numberOfWrites))
+        return paBadBufferPtr;
+
+    /*
+     * The audio quality improvement and Pa_WriteStream() work on native memory
+     * so the bytes are written out of the Java array into a scratch buffer
+     * then.
+     */
+    if (aqi || !(s->pseudoBlocking))
+    {
+        scratch
+            = PortAudioStream_reserveScratch(
+                &(s->outputScratch), &(s->outputScratchCapacity),
+                framesInBytes);
+        if (!scratch)
+            return paInsufficientMemory;
+    }
+
+    for (i = 0; i < numberOfWrites; i++)
+    {
+        if (scratch)
+        {
+            (*env)->GetByteArrayRegion(
+                env, buffer,
+                (jsize) offset, (jsize) framesInBytes,
+                scratch);
+        }
+
+        if (s->pseudoBlocking)
+        {
+            jlong blockedTime = Clock_nanoTime();
+
+            if (Mutex_lock(s->outputMutex))
+                err = paInternalError;
+            else
+            {
+                jlong bytesWritten = 0;
+
+                s->stats.values[STREAM_STATS_MUTEX_BLOCKED_TIME]
+                    += Clock_nanoTime() - blockedTime;
+                err = paNoError;
+                while (bytesWritten < framesInBytes)
+                {
+                    size_t outputCapacity = s->outputCapacity - s->outputLength;
+                    size_t outputIndex = s->outputIndex + s->outputLength;
+                    jlong bytesToWrite;
+                    jbyte *regions[2];
+                    size_t regionLengths[2];
+                    int regionCount;
+                    int r;
+
+                    if (JNI_TRUE == s->finished)
+                    {
+                        err = paStreamIsStopped;
+                        break;
+                    }
+                    if (outputCapacity < 1)
+                    {
+                        blockedTime = Clock_nanoTime();
+                        ConditionVariable_wait(
+                            s->outputCondVar,
+                            s->outputMutex);
+                        s->stats.values[STREAM_STATS_MUTEX_BLOCKED_TIME]
+                            += Clock_nanoTime() - blockedTime;
+                        continue;
+                    }
+
+                    bytesToWrite = framesInBytes - bytesWritten;
+                    if (bytesToWrite > outputCapacity)
+                        bytesToWrite = outputCapacity;
+                    if (outputIndex >= s->outputCapacity)
+                        outputIndex -= s->outputCapacity;
+                    regionCount
+                        = PortAudioStream_getPseudoBlockingBufferRegions(
+                            s->output, s->outputCapacity,
+                            outputIndex, bytesToWrite,
+                            regions, regionLengths);
+
+                    /*
+                     * The stream callback only consumes the bytes already in
+                     * the buffer while the free space is being copied into
+                     * so the mutex is not held while the JNI copies out of the
+                     * Java array.
+                     */
+                    Mutex_unlock(s->outputMutex);
+                    for (r = 0; r < regionCount; r++)
+                    {
+                        if (scratch)
+                        {
+                            memcpy(
+                                regions[r],
+                                scratch + bytesWritten, regionLengths[r]);
+                        }
+                        else
+                        {
+                            (*env)->GetByteArrayRegion(
+                                env, buffer,
+                                (jsize) (offset + bytesWritten),
+                                (jsize) regionLengths[r],
+                                regions[r]);
+                        }
+                        bytesWritten += regionLengths[r];
+                    }
+                    blockedTime = Clock_nanoTime();
+                    if (Mutex_lock(s->outputMutex))
+                    {
+                        err = paInternalError;
+                        break;
+                    }
+                    s->stats.values[STREAM_STATS_MUTEX_BLOCKED_TIME]
+                        += Clock_nanoTime() - blockedTime;
+
+                    /*
+                     * The stream callback rewinds the buffer whenever it
+                     * empties it so the bytes just copied start it then.
+                     */
+                    if (!(s->outputLength))
+                        s->outputIndex = outputIndex;
+                    s->outputLength += bytesToWrite;
+                }
+                if (paInternalError != err)
+                {
+                    PortAudioStreamStats_fill(
+                        &(s->stats),
+                        STREAM_STATS_OUTPUT_FILL,
+                        s->outputLength);
+                    Mutex_unlock(s->outputMutex);
+                }
+            }
+        }
+        else
+        {
+            err = Pa_WriteStream(s->stream, scratch, frames);
+            PortAudioStreamStats_transfer(
+                &(s->stats),
+                (paOutputUnderflowed == err) ? paOutputUnderflow : 0);
+            if (paOutputUnderflowed == err)
+                err = paNoError;
+        }
+
+        if (paNoError != err)
+            break;
+
+        if (aqi)
+        {
+            jlong aqiTime = Clock_nanoTime();
+
+            AudioQualityImprovement_process(
+                aqi,
+                AUDIO_QUALITY_IMPROVEMENT_SAMPLE_ORIGIN_OUTPUT,
+                sampleRate, sampleSizeInBits, channels,
+                outputLatency,
+                scratch, framesInBytes);
+            s->stats.values[STREAM_STATS_AQI_TIME]
+                += Clock_nanoTime() - aqiTime;
+        }
+        offset += framesInBytes;
+    }
+
+    return err;
+}
@@ -13,6 +13,44 @@ extern "C" {
 #define org_jitsi_impl_neomedia_portaudio_Pa_LATENCY_LOW -2.0
 #undef org_jitsi_impl_neomedia_portaudio_Pa_LATENCY_UNSPECIFIED
 #define org_jitsi_impl_neomedia_portaudio_Pa_LATENCY_UNSPECIFIED 0.0
+#undef org_jitsi_impl_neomedia_portaudio_Pa_SCHED_POLICY_DEFAULT
+#define org_jitsi_impl_neomedia_portaudio_Pa_SCHED_POLICY_DEFAULT 0L
+#undef org_jitsi_impl_neomedia_portaudio_Pa_SCHED_POLICY_FIFO
+#define org_jitsi_impl_neomedia_portaudio_Pa_SCHED_POLICY_FIFO 1L
+#undef org_jitsi_impl_neomedia_portaudio_Pa_SCHED_POLICY_NICE
+#define org_jitsi_impl_neomedia_portaudio_Pa_SCHED_POLICY_NICE 3L
+#undef org_jitsi_impl_neomedia_portaudio_Pa_SCHED_POLICY_RR
+#define org_jitsi_impl_neomedia_portaudio_Pa_SCHED_POLICY_RR 2L
+#undef org_jitsi_impl_neomedia_portaudio_Pa_STREAM_STATS_AQI_TIME
+#define org_jitsi_impl_neomedia_portaudio_Pa_STREAM_STATS_AQI_TIME 10L
+#undef org_jitsi_impl_neomedia_portaudio_Pa_STREAM_STATS_CALLBACKS
+#define org_jitsi_impl_neomedia_portaudio_Pa_STREAM_STATS_CALLBACKS 0L
+#undef org_jitsi_impl_neomedia_portaudio_Pa_STREAM_STATS_CALLBACK_INTERVAL_HISTOGRAM
+#define org_jitsi_impl_neomedia_portaudio_Pa_STREAM_STATS_CALLBACK_INTERVAL_HISTOGRAM 12L
+#undef org_jitsi_impl_neomedia_portaudio_Pa_STREAM_STATS_CALLBACK_INTERVAL_HISTOGRAM_LENGTH
+#define org_jitsi_impl_neomedia_portaudio_Pa_STREAM_STATS_CALLBACK_INTERVAL_HISTOGRAM_LENGTH 10L
+#undef org_jitsi_impl_neomedia_portaudio_Pa_STREAM_STATS_CALLBACK_INTERVAL_MAX
+#define org_jitsi_impl_neomedia_portaudio_Pa_STREAM_STATS_CALLBACK_INTERVAL_MAX 1L
+#undef org_jitsi_impl_neomedia_portaudio_Pa_STREAM_STATS_INPUT_FILL
+#define org_jitsi_impl_neomedia_portaudio_Pa_STREAM_STATS_INPUT_FILL 6L
+#undef org_jitsi_impl_neomedia_portaudio_Pa_STREAM_STATS_INPUT_FILL_MAX
+#define org_jitsi_impl_neomedia_portaudio_Pa_STREAM_STATS_INPUT_FILL_MAX 7L
+#undef org_jitsi_impl_neomedia_portaudio_Pa_STREAM_STATS_INPUT_OVERFLOWS
+#define org_jitsi_impl_neomedia_portaudio_Pa_STREAM_STATS_INPUT_OVERFLOWS 2L
+#undef org_jitsi_impl_neomedia_portaudio_Pa_STREAM_STATS_INPUT_UNDERFLOWS
+#define org_jitsi_impl_neomedia_portaudio_Pa_STREAM_STATS_INPUT_UNDERFLOWS 3L
+#undef org_jitsi_impl_neomedia_portaudio_Pa_STREAM_STATS_LENGTH
+#define org_jitsi_impl_neomedia_portaudio_Pa_STREAM_STATS_LENGTH 22L
+#undef org_jitsi_impl_neomedia_portaudio_Pa_STREAM_STATS_MUTEX_BLOCKED_TIME
+#define org_jitsi_impl_neomedia_portaudio_Pa_STREAM_STATS_MUTEX_BLOCKED_TIME 11L
+#undef org_jitsi_impl_neomedia_portaudio_Pa_STREAM_STATS_OUTPUT_FILL
+#define org_jitsi_impl_neomedia_portaudio_Pa_STREAM_STATS_OUTPUT_FILL 8L
+#undef org_jitsi_impl_neomedia_portaudio_Pa_STREAM_STATS_OUTPUT_FILL_MAX
+#define org_jitsi_impl_neomedia_portaudio_Pa_STREAM_STATS_OUTPUT_FILL_MAX 9L
+#undef org_jitsi_impl_neomedia_portaudio_Pa_STREAM_STATS_OUTPUT_OVERFLOWS
+#define org_jitsi_impl_neomedia_portaudio_Pa_STREAM_STATS_OUTPUT_OVERFLOWS 4L
+#undef org_jitsi_impl_neomedia_portaudio_Pa_STREAM_STATS_OUTPUT_UNDERFLOWS
+#define org_jitsi_impl_neomedia_portaudio_Pa_STREAM_STATS_OUTPUT_UNDERFLOWS 5L
 /*
  * Class:     org_jitsi_impl_neomedia_portaudio_Pa
  * Method:    AbortStream
@@ -181,6 +219,22 @@ JNIEXPORT jint JNICALL Java_org_jitsi_impl_neomedia_portaudio_Pa_GetSampleSize
 JNIEXPORT jlong JNICALL Java_org_jitsi_impl_neomedia_portaudio_Pa_GetStreamReadAvailable
   (JNIEnv *, jclass, jlong);
 
+/*
+ * Class:     org_jitsi_impl_neomedia_portaudio_Pa
+ * Method:    GetStreamSchedPolicy
+ * Signature: (J)I
+ */
+JNIEXPORT jint JNICALL Java_org_jitsi_impl_neomedia_portaudio_Pa_GetStreamSchedPolicy
+  (JNIEnv *, jclass, jlong);
+
+/*
+ * Class:     org_jitsi_impl_neomedia_portaudio_Pa
+ * Method:    GetStreamStats
+ * Signature: (J[J)V
+ */
+JNIEXPORT void JNICALL Java_org_jitsi_impl_neomedia_portaudio_Pa_GetStreamStats
+  (JNIEnv *, jclass, jlong, jlongArray);
+
 /*
  * Class:     org_jitsi_impl_neomedia_portaudio_Pa
  * Method:    GetStreamWriteAvailable
@@ -269,6 +323,14 @@ JNIEXPORT void JNICALL Java_org_jitsi_impl_neomedia_portaudio_Pa_setDenoise
 JNIEXPORT void JNICALL Java_org_jitsi_impl_neomedia_portaudio_Pa_setEchoFilterLengthInMillis
   (JNIEnv *, jclass, jlong, jlong);
 
+/*
+ * Class:     org_jitsi_impl_neomedia_portaudio_Pa
+ * Method:    SetStreamSchedPolicy
+ * Signature: (JII)Z
+ */
+JNIEXPORT jboolean JNICALL Java_org_jitsi_impl_neomedia_portaudio_Pa_SetStreamSchedPolicy
+  (JNIEnv *, jclass, jlong, jint, jint);
+
 /*
  * Class:     org_jitsi_impl_neomedia_portaudio_Pa
  * Method:    StartStream
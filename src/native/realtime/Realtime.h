@@ -0,0 +1,193 @@
+/*
+ * Jitsi, the OpenSource Java VoIP and Instant Messaging client.
+ *
+ * Distributable under LGPL license.
+ * See terms of license at gnu.org.
+ */
+
+#ifndef _ORG_JITSI_IMPL_NEOMEDIA_REALTIME_H_
+#define _ORG_JITSI_IMPL_NEOMEDIA_REALTIME_H_
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * The scheduling policies which may be requested for the audio threads. The
+ * values are shared with the SCHED_POLICY_XXX constants of the Java classes
+ * Pa and PA.
+ */
+#define REALTIME_SCHED_POLICY_DEFAULT 0
+#define REALTIME_SCHED_POLICY_FIFO 1
+#define REALTIME_SCHED_POLICY_RR 2
+#define REALTIME_SCHED_POLICY_NICE 3
+
+#ifdef _WIN32
+#include <windows.h>
+
+/**
+ * Allocates a zero-initialized region of memory which starts at a page
+ * boundary and occupies its pages alone so that it may be locked into RAM
+ * and unlocked without affecting other allocations.
+ *
+ * @param len the length in bytes of the region of memory to allocate
+ * @return the start of the allocated region of memory upon success;
+ * otherwise, <tt>NULL</tt>
+ */
+static inline void *Realtime_alloc(size_t len)
+{
+    return VirtualAlloc(NULL, len, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+}
+
+static inline void Realtime_free(void *addr)
+{
+    VirtualFree(addr, 0, MEM_RELEASE);
+}
+
+/**
+ * Locks a region of memory allocated by <tt>Realtime_alloc</tt> into RAM so
+ * that the audio threads accessing it do not incur page faults.
+ *
+ * @param addr the start of the region of memory to lock
+ * @param len the length in bytes of the region of memory to lock
+ * @return zero upon success; otherwise, non-zero
+ */
+static inline int Realtime_lockMemory(void *addr, size_t len)
+{
+    return VirtualLock(addr, len) ? 0 : -1;
+}
+
+/**
+ * Elevates the scheduling priority of the calling thread. Windows has no
+ * real-time scheduling policies available to a regular process so the
+ * real-time policies are approximated with the time-critical priority of the
+ * normal priority class.
+ *
+ * @param policy the <tt>REALTIME_SCHED_POLICY_XXX</tt> constant which
+ * specifies the requested scheduling policy
+ * @param priority the requested real-time priority
+ * @return the <tt>REALTIME_SCHED_POLICY_XXX</tt> constant which specifies the
+ * scheduling policy which took effect
+ */
+static inline int Realtime_setThreadSchedPolicy(int policy, int priority)
+{
+    (void) priority;
+
+    if ((REALTIME_SCHED_POLICY_DEFAULT != policy)
+            && SetThreadPriority(
+                    GetCurrentThread(),
+                    THREAD_PRIORITY_TIME_CRITICAL))
+        return REALTIME_SCHED_POLICY_NICE;
+    return REALTIME_SCHED_POLICY_DEFAULT;
+}
+
+static inline void Realtime_unlockMemory(void *addr, size_t len)
+{
+    VirtualUnlock(addr, len);
+}
+
+#else /* #ifdef _WIN32 */
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#endif /* #ifdef __linux__ */
+
+/**
+ * The nice level to fall back to if a real-time scheduling policy is denied.
+ * It matches the highest priority which RealtimeKit grants to the threads of
+ * desktop applications by default.
+ */
+#define REALTIME_NICE_LEVEL -11
+
+/**
+ * Allocates a zero-initialized region of memory which starts at a page
+ * boundary and occupies its pages alone so that it may be locked into RAM
+ * and unlocked without affecting other allocations (<tt>munlock</tt> unlocks
+ * whole pages no matter how many times they have been locked).
+ *
+ * @param len the length in bytes of the region of memory to allocate
+ * @return the start of the allocated region of memory upon success;
+ * otherwise, <tt>NULL</tt>
+ */
+static inline void *Realtime_alloc(size_t len)
+{
+    long pageSize = sysconf(_SC_PAGESIZE);
+    void *addr;
+
+    if (pageSize <= 0)
+        pageSize = 4096;
+    len = (len + pageSize - 1) & ~((size_t) pageSize - 1);
+    if (posix_memalign(&addr, (size_t) pageSize, len))
+        return NULL;
+    memset(addr, 0, len);
+    return addr;
+}
+
+static inline void Realtime_free(void *addr)
+{
+    free(addr);
+}
+
+static inline int Realtime_lockMemory(void *addr, size_t len)
+{
+    return mlock(addr, len);
+}
+
+/**
+ * Sets the scheduling policy of the calling thread. If the requested real-time
+ * policy is denied (e.g. because of <tt>RLIMIT_RTPRIO</tt>), falls back to
+ * a negative nice level of the calling thread where threads have their own
+ * nice levels (i.e. on Linux).
+ *
+ * @param policy the <tt>REALTIME_SCHED_POLICY_XXX</tt> constant which
+ * specifies the requested scheduling policy
+ * @param priority the requested real-time priority, clamped to the range
+ * supported by the requested policy
+ * @return the <tt>REALTIME_SCHED_POLICY_XXX</tt> constant which specifies the
+ * scheduling policy which took effect
+ */
+static inline int Realtime_setThreadSchedPolicy(int policy, int priority)
+{
+    if ((REALTIME_SCHED_POLICY_FIFO == policy)
+            || (REALTIME_SCHED_POLICY_RR == policy))
+    {
+        int sched
+            = (REALTIME_SCHED_POLICY_FIFO == policy) ? SCHED_FIFO : SCHED_RR;
+        int min = sched_get_priority_min(sched);
+        int max = sched_get_priority_max(sched);
+        struct sched_param param;
+
+        if (priority < min)
+            priority = min;
+        else if (priority > max)
+            priority = max;
+        param.sched_priority = priority;
+#ifdef SCHED_RESET_ON_FORK
+        /* Do not let processes forked by the JVM inherit the policy. */
+        sched |= SCHED_RESET_ON_FORK;
+#endif /* #ifdef SCHED_RESET_ON_FORK */
+        if (!pthread_setschedparam(pthread_self(), sched, &param))
+            return policy;
+    }
+#ifdef __linux__
+    if ((REALTIME_SCHED_POLICY_DEFAULT != policy)
+            && !setpriority(
+                    PRIO_PROCESS,
+                    (id_t) syscall(SYS_gettid),
+                    REALTIME_NICE_LEVEL))
+        return REALTIME_SCHED_POLICY_NICE;
+#endif /* #ifdef __linux__ */
+    return REALTIME_SCHED_POLICY_DEFAULT;
+}
+
+static inline void Realtime_unlockMemory(void *addr, size_t len)
+{
+    munlock(addr, len);
+}
+#endif /* #ifdef _WIN32 */
+
+#endif /* #ifndef _ORG_JITSI_IMPL_NEOMEDIA_REALTIME_H_ */
@@ -36,6 +36,8 @@ typedef unsigned __int8 uint8_t;
 
 #include <stdint.h>
 
+#include <pthread.h>
+#include <time.h>
 #include <sys/types.h>
 #include <sys/ipc.h>
 #include <sys/shm.h>
@@ -43,11 +45,32 @@ typedef unsigned __int8 uint8_t;
 #include <X11/Xlib.h>
 #include <X11/Xutil.h>
 #include <X11/extensions/XShm.h>
+#include <X11/extensions/Xdamage.h>
+#include <X11/extensions/Xfixes.h>
+
+#include "I420Converter.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+#include <arm_neon.h>
+#endif
 
 #endif
 
 #include "org_jitsi_impl_neomedia_imgstreaming_ScreenCapture.h"
 
+/**
+ * \brief Maximum number of damaged rectangles grabbed and reported one by
+ * one. More are grabbed and reported as their bounding box.
+ */
+#define DAMAGE_MAX_RECTS 16
+
+/**
+ * \brief Maximum number of regions grabbed in parallel by a session.
+ */
+#define REGIONS_MAX 16
+
 #if defined(_WIN32) || defined (_WIN64)
 
 /**
@@ -373,142 +396,200 @@ static int quartz_grab_screen(jbyte* data, unsigned int display, int x, int y, i
 
 #else /* Unix */
 
+struct x11_session;
+
 /**
- * \brief Grab X11 screen.
- * \param x11display display string (i.e. :0.0), if NULL getenv("DISPLAY") is used
- * \param data array that will contain screen capture
- * \param displayIndex display index
- * \param x x position to start capture
- * \param y y position to start capture
- * \param w capture width
- * \param h capture height 
- * \return 0 if success, -1 otherwise
+ * \struct x11_cursor
+ * \brief Image of the X11 cursor as got from XFixes.
  */
-static int x11_grab_screen(jbyte* data, unsigned int displayIndex, int x, int y, int w, int h)
+struct x11_cursor
+{
+  int x; /**< x position of the top-left corner of the cursor on the screen */
+  int y; /**< y position of the top-left corner of the cursor on the screen */
+  int width; /**< width of the cursor */
+  int height; /**< height of the cursor */
+  unsigned long serial; /**< serial number of the cursor image */
+  uint32_t* pixels; /**< premultiplied ARGB pixels of the cursor or NULL */
+  size_t pixels_size; /**< number of pixels allocated */
+};
+
+/**
+ * \struct x11_worker
+ * \brief Thread grabbing regions for an X11 session with its own display
+ * connection (a display connection is not to be used by several threads at a
+ * time).
+ */
+struct x11_worker
+{
+  struct x11_session* owner; /**< session the worker grabs regions for */
+  struct x11_session* session; /**< session of the worker or NULL */
+  pthread_t thread; /**< thread of the worker */
+  int failed; /**< whether the worker could not be started */
+  unsigned int round; /**< last round of jobs seen by the worker */
+  int job; /**< whether the worker has a job in the current round */
+  jbyte* data; /**< where to store the grabbed region */
+  int stride; /**< number of bytes between two rows of data */
+  int x; /**< x position of the region */
+  int y; /**< y position of the region */
+  int w; /**< width of the region */
+  int h; /**< height of the region */
+  int ret; /**< result of the job */
+  int64_t time; /**< duration of the job in nanoseconds */
+};
+
+/**
+ * \struct x11_session
+ * \brief X11 screen capture session i.e. the display connection and the SHM
+ * image which are kept alive between grabs.
+ */
+struct x11_session
+{
+  Display* display; /**< X11 display */
+  Window root_window; /**< X11 root window of the screen */
+  Visual* visual; /**< default visual of the screen */
+  int depth; /**< default depth of the screen */
+  int width; /**< current width of the screen */
+  int height; /**< current height of the screen */
+  int shm_support; /**< whether SHM is to be used */
+  XImage* img; /**< SHM image reused between grabs or NULL */
+  XShmSegmentInfo shm_info; /**< SHM segment of img */
+  int damage_support; /**< whether XDamage is to be used */
+  Damage damage; /**< damage of the root window or None */
+  jbyte* frame; /**< ARGB frame patched by damage grabs or NULL */
+  int frame_x; /**< x position of frame on the screen */
+  int frame_y; /**< y position of frame on the screen */
+  int frame_w; /**< width of frame */
+  int frame_h; /**< height of frame */
+  uint8_t* picture; /**< I420 picture reconverted by damage grabs or NULL */
+  int picture_x; /**< x position of the area of picture on the screen */
+  int picture_y; /**< y position of the area of picture on the screen */
+  int picture_w; /**< width of the area of picture on the screen */
+  int picture_h; /**< height of the area of picture on the screen */
+  int picture_dw; /**< width of picture */
+  int picture_dh; /**< height of picture */
+  unsigned int display_index; /**< display index the session is opened on */
+  int cursor_support; /**< whether XFixes cursor images are available */
+  int draw_cursor; /**< whether the cursor is composited into grabs */
+  struct x11_cursor cursor; /**< last cursor image got */
+  XRectangle damage_cursor; /**< cursor area drawn by the last damage grab */
+  unsigned long damage_cursor_serial; /**< cursor drawn by the last damage grab */
+  struct x11_worker workers[REGIONS_MAX - 1]; /**< region grabbing threads */
+  pthread_mutex_t workers_mutex; /**< mutex of the jobs of workers */
+  pthread_cond_t workers_cond; /**< signaled when a round of jobs starts */
+  pthread_cond_t workers_done_cond; /**< signaled when a round of jobs ends */
+  unsigned int workers_round; /**< current round of jobs */
+  int workers_pending; /**< number of jobs in progress in the current round */
+  int workers_stopping; /**< whether workers are to exit */
+};
+
+/**
+ * \brief Convert a row of 32-bit xRGB pixels in host byte order to ARGB
+ * bytes.
+ * \param src row of pixels
+ * \param dst row that will contain the ARGB bytes
+ * \param w number of pixels in the row
+ */
+static void x11_convert_row_xrgb32(const uint32_t* src, uint8_t* dst, int w)
 {
-  const char* display_str; /* display string */
-  Display* display = NULL; /* X11 display */
-  Visual* visual = NULL;
-  int screen = 0; /* X11 screen */
-  Window root_window = 0; /* X11 root window of a screen */
-  int width = 0;
-  int height = 0;
-  int depth = 0;
-  int shm_support = 0;
-  XImage* img = NULL;
-  XShmSegmentInfo shm_info;
-  size_t off = 0;
   int i = 0;
-  int j = 0;
-  size_t size = 0;
-  uint32_t test = 1;
-  int little_endian = *((uint8_t*)&test);
-  char buf[16];
-  
-  snprintf(buf, sizeof(buf), ":0.%u", displayIndex);
-  display_str = buf;
 
-  /* open current X11 display */
-  display = XOpenDisplay(display_str);
+#if defined(__SSE2__)
+  const __m128i alpha = _mm_set1_epi32((int) 0xff000000);
 
-  if(!display)
+  /* byte swap 4 pixels at a time i.e. BGRx in memory becomes ARGB */
+  for(; i + 4 <= w ; i += 4)
   {
-    /* fprintf(stderr, "Cannot open X11 display!\n"); */
-    return -1;
-  }
-  
-  screen = DefaultScreen(display);
-  root_window = RootWindow(display, screen);
-  visual = DefaultVisual(display, screen);
-  width = DisplayWidth(display, screen);
-  height = DisplayHeight(display, screen);
-  depth = DefaultDepth(display, screen);
+    __m128i p = _mm_loadu_si128((const __m128i*)(src + i));
 
-  /* check that user-defined parameters are in image */
-  if((w + x) > width || (h + y) > height)
-  {
-    XCloseDisplay(display);
-    return -1;
+    p = _mm_or_si128(p, alpha);
+    p = _mm_or_si128(_mm_slli_epi32(p, 16), _mm_srli_epi32(p, 16));
+    p = _mm_or_si128(_mm_slli_epi16(p, 8), _mm_srli_epi16(p, 8));
+    _mm_storeu_si128((__m128i*)(dst + 4 * i), p);
   }
+#elif defined(__ARM_NEON) && (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+  const uint32x4_t alpha = vdupq_n_u32(0xff000000);
 
-  size = w * h;
-
-  /* test is XServer support SHM */
-  shm_support = XShmQueryExtension(display);
+  /* byte swap 4 pixels at a time i.e. BGRx in memory becomes ARGB */
+  for(; i + 4 <= w ; i += 4)
+  {
+    uint32x4_t p = vorrq_u32(vld1q_u32(src + i), alpha);
 
-  /* fprintf(stderr, "Display=%s width=%d height=%d depth=%d SHM=%s\n", display_str, width, height, depth, shm_support ? "true" : "false"); */
+    vst1q_u8(dst + 4 * i, vrev32q_u8(vreinterpretq_u8_u32(p)));
+  }
+#endif
 
-  if(shm_support)
+  for(; i < w ; i++)
   {
-    /* fprintf(stderr, "Use XShmGetImage\n"); */
-
-    /* create image for SHM use */
-    img = XShmCreateImage(display, visual, depth, ZPixmap, NULL, &shm_info, w, h);
+    uint32_t pixel = src[i];
+    uint8_t* d = dst + 4 * i;
 
-    if(!img)
-    {
-      /* fprintf(stderr, "Image cannot be created!\n"); */
-      XCloseDisplay(display);
-      return -1;
-    }
+    d[0] = 0xff;
+    d[1] = (pixel >> 16) & 0xff;
+    d[2] = (pixel >> 8) & 0xff;
+    d[3] = pixel & 0xff;
+  }
+}
 
-    /* setup SHM stuff */
-    shm_info.shmid = shmget(IPC_PRIVATE, img->bytes_per_line * img->height, IPC_CREAT | 0777);
-    shm_info.shmaddr = (char*)shmat(shm_info.shmid, NULL, 0);
-    img->data = shm_info.shmaddr;
-    shmctl(shm_info.shmid, IPC_RMID, NULL);
-    shm_info.readOnly = 0;
+/**
+ * \brief Tell whether the pixels of an X11 image are 32-bit xRGB words in the
+ * byte order of the host (i.e. the common 24/32-bit TrueColor visuals).
+ * \param img X11 image
+ * \return 1 if so, 0 otherwise
+ */
+static int x11_image_is_xrgb32(XImage* img)
+{
+  uint32_t test = 1;
+  int little_endian = *((uint8_t*)&test);
 
-    /* attach segment and grab screen */
-    if((shm_info.shmaddr == (void*)-1) || !XShmAttach(display, &shm_info))
-    {
-      /* fprintf(stderr, "Cannot use shared memory!\n"); */
-      if(shm_info.shmaddr != (void*)-1)
-      {
-        shmdt(shm_info.shmaddr);
-      }
+  return img->bits_per_pixel == 32
+      && img->red_mask == 0xff0000
+      && img->green_mask == 0xff00
+      && img->blue_mask == 0xff
+      && img->byte_order == (little_endian ? LSBFirst : MSBFirst);
+}
 
-      img->data = NULL;
-      XDestroyImage(img);
-      img = NULL;
-      shm_support = 0;
-    }
-    else if(!XShmGetImage(display, root_window, img, x, y, 0xffffffff))
-    {
-      /* fprintf(stderr, "Cannot grab image!\n"); */
-      XShmDetach(display, &shm_info);
-      shmdt(shm_info.shmaddr);
-      XDestroyImage(img);
-      img = NULL;
-      shm_support = 0;
-    }
-  }
+/**
+ * \brief Convert an X11 image to ARGB bytes.
+ * \param img X11 image
+ * \param data array that will contain the ARGB pixels
+ * \param stride number of bytes between two rows of data
+ * \param w width of the image
+ * \param h height of the image
+ */
+static void x11_convert_argb(XImage* img, jbyte* data, int stride, int w, int h)
+{
+  size_t off = 0;
+  int i = 0;
+  int j = 0;
+  uint32_t test = 1;
+  int little_endian = *((uint8_t*)&test);
 
-  /* if XSHM is not available or has failed 
-   * use XGetImage
+  /* fast path for the common 24/32-bit TrueColor visuals whose pixels are
+   * 32-bit xRGB words in the byte order of the host
    */
-  if(!img)
+  if(x11_image_is_xrgb32(img))
   {
-    /* fprintf(stderr, "Use XGetImage\n"); */
-    img = XGetImage(display, root_window, x, y, w, h, 0xffffffff, ZPixmap);
-
-    if(!img)
+    for(j = 0 ; j < h ; j++)
     {
-      /* fprintf(stderr, "Cannot grab image!\n"); */
-      XCloseDisplay(display);
-      return -1;
+      x11_convert_row_xrgb32(
+          (const uint32_t*)(img->data + j * img->bytes_per_line),
+          (uint8_t*)data + off,
+          w);
+      off += stride;
     }
+    return;
   }
 
   /* convert to bytes but keep ARGB */
   for(j = 0 ; j < h ; j++)
   {
+    off = (size_t) j * stride;
     for(i = 0 ; i < w ; i++)
     {
       /* do not care about high 32-bit for Linux 64 bit 
        * machine (sizeof(unsigned long) = 8)
        */
-      uint32_t pixel = (uint32_t)XGetPixel(img, i, j) | (0xff << 24);
+      uint32_t pixel = (uint32_t)XGetPixel(img, i, j) | (0xffU << 24);
       
       /* Java int is always big endian so output as ARGB */
       if(little_endian)
@@ -517,118 +598,1893 @@ static int x11_grab_screen(jbyte* data, unsigned int displayIndex, int x, int y,
         uint8_t r = (pixel >> 16) & 0xff;
         uint8_t g = (pixel >> 8) & 0xff;
         uint8_t b = pixel & 0xff;
-        pixel = b << 24 | g << 16 | r << 8 | 0xff;
+        pixel = (uint32_t)b << 24 | g << 16 | r << 8 | 0xff;
       }
       
       memcpy(data + off, &pixel, 4);
       off += 4;
     }
   }
+}
+
+/**
+ * \brief Free the SHM image of an X11 session (if any).
+ * \param session X11 session
+ */
+static void x11_session_free_image(struct x11_session* session)
+{
+  if(session->img)
+  {
+    XShmDetach(session->display, &session->shm_info);
+    shmdt(session->shm_info.shmaddr);
+    session->img->data = NULL;
+    XDestroyImage(session->img);
+    session->img = NULL;
+  }
+}
 
-  /* free X11 resources and close display */
-  XDestroyImage(img);
-  
-  if(shm_support)
+/**
+ * \brief Create the SHM image of an X11 session.
+ * \param session X11 session
+ * \param w image width
+ * \param h image height
+ * \return 0 if success, -1 otherwise
+ */
+static int x11_session_create_image(struct x11_session* session, int w, int h)
+{
+  XShmSegmentInfo* shm_info = &session->shm_info;
+  XImage* img = NULL;
+
+  /* create image for SHM use */
+  img = XShmCreateImage(session->display, session->visual, session->depth,
+      ZPixmap, NULL, shm_info, w, h);
+
+  if(!img)
   {
-    XShmDetach(display, &shm_info);
-    shmdt(shm_info.shmaddr);
+    /* fprintf(stderr, "Image cannot be created!\n"); */
+    return -1;
   }
 
-  XCloseDisplay(display);
+  /* setup SHM stuff */
+  shm_info->shmid = shmget(IPC_PRIVATE, img->bytes_per_line * img->height, IPC_CREAT | 0777);
+  shm_info->shmaddr = (char*)shmat(shm_info->shmid, NULL, 0);
+  img->data = shm_info->shmaddr;
+  shmctl(shm_info->shmid, IPC_RMID, NULL);
+  shm_info->readOnly = 0;
+
+  /* attach segment */
+  if((shm_info->shmaddr == (void*)-1) || !XShmAttach(session->display, shm_info))
+  {
+    /* fprintf(stderr, "Cannot use shared memory!\n"); */
+    if(shm_info->shmaddr != (void*)-1)
+    {
+      shmdt(shm_info->shmaddr);
+    }
+
+    img->data = NULL;
+    XDestroyImage(img);
+    return -1;
+  }
 
-  /* return array */
+  session->img = img;
   return 0;
 }
 
-#endif
+/**
+ * \brief Close an X11 session and free its resources.
+ * \param session X11 session
+ */
+static void x11_session_close(struct x11_session* session)
+{
+  int i = 0;
+
+  /* stop the workers and close their own sessions */
+  pthread_mutex_lock(&session->workers_mutex);
+  session->workers_stopping = 1;
+  pthread_cond_broadcast(&session->workers_cond);
+  pthread_mutex_unlock(&session->workers_mutex);
+  for(i = 0 ; i < REGIONS_MAX - 1 ; i++)
+  {
+    struct x11_worker* worker = &session->workers[i];
+
+    if(worker->session)
+    {
+      pthread_join(worker->thread, NULL);
+      x11_session_close(worker->session);
+    }
+  }
+  pthread_cond_destroy(&session->workers_done_cond);
+  pthread_cond_destroy(&session->workers_cond);
+  pthread_mutex_destroy(&session->workers_mutex);
+
+  x11_session_free_image(session);
+  if(session->damage != None)
+  {
+    XDamageDestroy(session->display, session->damage);
+  }
+  free(session->frame);
+  free(session->picture);
+  free(session->cursor.pixels);
+  XCloseDisplay(session->display);
+  free(session);
+}
 
 /**
- * \brief JNI native method to grab desktop screen and retrieve ARGB pixels.
- * \param env JVM environment
- * \param clazz NativeScreenCapture Java class
- * \param display display index
- * \param x x position to start capture
- * \param y y position to start capture
- * \param width capture width
- * \param height capture height
- * \param output output buffer, screen bytes will be stored in
- * \return true if success, false otherwise
+ * \brief Open an X11 session.
+ * \param displayIndex display index
+ * \return X11 session or NULL if failure
  */
-JNIEXPORT jboolean JNICALL
-Java_org_jitsi_impl_neomedia_imgstreaming_ScreenCapture_grabScreen__IIIII_3B
-    (JNIEnv* env, jclass clazz, jint display, jint x, jint y, jint width, jint height, jbyteArray output)
+static struct x11_session* x11_session_open(unsigned int displayIndex)
 {
-  jint size = width * height * 4;
-  jbyte* data = NULL;
+  const char* display_str; /* display string */
+  Display* display = NULL; /* X11 display */
+  int screen = 0; /* X11 screen */
+  struct x11_session* session = NULL;
+  char buf[16];
 
-  clazz = clazz; /* not used */
+  snprintf(buf, sizeof(buf), ":0.%u", displayIndex);
+  display_str = buf;
 
-  if(!output || (*env)->GetArrayLength(env, output) < size)
+  /* open current X11 display */
+  display = XOpenDisplay(display_str);
+
+  if(!display)
   {
-    return JNI_FALSE;
+    /* fprintf(stderr, "Cannot open X11 display!\n"); */
+    return NULL;
   }
 
-  data = (*env)->GetPrimitiveArrayCritical(env, output, 0);
+  session = calloc(1, sizeof(struct x11_session));
 
-  if(!data)
+  if(!session)
   {
-    return JNI_FALSE;
+    XCloseDisplay(display);
+    return NULL;
   }
 
-#if defined (_WIN32) || defined(_WIN64)
-  if(windows_grab_screen(data, display, x, y, width, height) == -1)
-#elif defined(__APPLE__)
-    if(quartz_grab_screen(data, display, x, y, width, height) == -1)
-#else /* Unix */
-  if(x11_grab_screen(data, display, x, y, width, height) == -1)
-#endif
+  screen = DefaultScreen(display);
+  session->display = display;
+  session->root_window = RootWindow(display, screen);
+  session->visual = DefaultVisual(display, screen);
+  session->width = DisplayWidth(display, screen);
+  session->height = DisplayHeight(display, screen);
+  session->depth = DefaultDepth(display, screen);
+
+  /* test is XServer support SHM */
+  session->shm_support = XShmQueryExtension(display);
+
+  /* test is XServer support XFixes (for the cursor image and regions) and
+   * XDamage
+   */
   {
-    (*env)->ReleasePrimitiveArrayCritical(env, output, data, 0);
-    return JNI_FALSE;
+    int event_base;
+    int error_base;
+    int major = 0;
+    int minor = 0;
+    int damage_major = 0;
+    int damage_minor = 0;
+
+    session->cursor_support
+      = XFixesQueryExtension(display, &event_base, &error_base)
+        && XFixesQueryVersion(display, &major, &minor);
+    session->damage_support
+      = session->cursor_support
+        && (major >= 2)
+        && XDamageQueryExtension(display, &event_base, &error_base)
+        && XDamageQueryVersion(display, &damage_major, &damage_minor);
   }
+  session->damage = None;
+  session->display_index = displayIndex;
 
-  (*env)->ReleasePrimitiveArrayCritical(env, output, data, 0);
-  return JNI_TRUE;
+  if(pthread_mutex_init(&session->workers_mutex, NULL) != 0)
+  {
+    XCloseDisplay(display);
+    free(session);
+    return NULL;
+  }
+  if(pthread_cond_init(&session->workers_cond, NULL) != 0)
+  {
+    pthread_mutex_destroy(&session->workers_mutex);
+    XCloseDisplay(display);
+    free(session);
+    return NULL;
+  }
+  if(pthread_cond_init(&session->workers_done_cond, NULL) != 0)
+  {
+    pthread_cond_destroy(&session->workers_cond);
+    pthread_mutex_destroy(&session->workers_mutex);
+    XCloseDisplay(display);
+    free(session);
+    return NULL;
+  }
+
+  /* be notified when the resolution of the screen changes */
+  XSelectInput(display, session->root_window, StructureNotifyMask);
+
+  /* fprintf(stderr, "Display=%s width=%d height=%d depth=%d SHM=%s\n", display_str, session->width, session->height, session->depth, session->shm_support ? "true" : "false"); */
+
+  return session;
 }
 
 /**
- * \brief JNI native method to grab desktop screen and retrieve ARGB pixels.
- * \param env JVM environment
- * \param clazz NativeScreenCapture Java class
- * \param display display index
+ * \brief Process the pending events of an X11 session i.e. follow changes
+ * of the resolution of its screen.
+ * \param session X11 session
+ */
+static void x11_session_update(struct x11_session* session)
+{
+  Display* display = session->display;
+
+  while(XPending(display) > 0)
+  {
+    XEvent event;
+
+    XNextEvent(display, &event);
+    if((event.type == ConfigureNotify)
+        && (event.xconfigure.window == session->root_window))
+    {
+      session->width = event.xconfigure.width;
+      session->height = event.xconfigure.height;
+    }
+  }
+}
+
+/**
+ * \brief Get an image of X11 screen in an X11 session.
+ * \param session X11 session
  * \param x x position to start capture
  * \param y y position to start capture
- * \param width capture width
- * \param height capture height
- * \param output native output buffer
- * \return true if success, false otherwise
+ * \param w capture width
+ * \param h capture height 
+ * \return image to be released with x11_session_release_image or NULL if
+ * failure
  */
-JNIEXPORT jboolean JNICALL
-Java_org_jitsi_impl_neomedia_imgstreaming_ScreenCapture_grabScreen__IIIIIJI
-    (JNIEnv* env, jclass clazz, jint display, jint x, jint y, jint width, jint height, jlong output, jint outputLength)
+static XImage* x11_session_get_image(struct x11_session* session, int x, int y, int w, int h)
 {
-  jint size = width * height * 4;
-  jbyte* data = (jbyte*) (intptr_t) output;
+  XImage* img = NULL;
 
-  /* not used */
-  clazz = clazz;
-  env = env;
+  x11_session_update(session);
 
-  if(!data || outputLength < size)
+  /* check that user-defined parameters are in image */
+  if(x < 0 || y < 0 || w <= 0 || h <= 0
+      || (w + x) > session->width || (h + y) > session->height)
   {
-    return JNI_FALSE;
+    return NULL;
   }
 
-#if defined (_WIN32) || defined(_WIN64)
-  if(windows_grab_screen(data, display, x, y, width, height) == -1)
-#elif defined(__APPLE__)
-    if(quartz_grab_screen(data, display, x, y, width, height) == -1)
-#else /* Unix */
-  if(x11_grab_screen(data, display, x, y, width, height) == -1)
-#endif
+  if(session->shm_support)
   {
-    return JNI_FALSE;
-  }
+    /* fprintf(stderr, "Use XShmGetImage\n"); */
+
+    /* the SHM image is only recreated when the capture size changes */
+    if(session->img
+        && (session->img->width != w || session->img->height != h))
+    {
+      x11_session_free_image(session);
+    }
+    if(!session->img && x11_session_create_image(session, w, h) == -1)
+    {
+      session->shm_support = 0;
+    }
+    else if(!XShmGetImage(session->display, session->root_window, session->img, x, y, 0xffffffff))
+    {
+      /* fprintf(stderr, "Cannot grab image!\n"); */
+      x11_session_free_image(session);
+      session->shm_support = 0;
+    }
+    else
+    {
+      img = session->img;
+    }
+  }
+
+  /* if XSHM is not available or has failed 
+   * use XGetImage
+   */
+  if(!img)
+  {
+    /* fprintf(stderr, "Use XGetImage\n"); */
+    img = XGetImage(session->display, session->root_window, x, y, w, h, 0xffffffff, ZPixmap);
+
+    if(!img)
+    {
+      /* fprintf(stderr, "Cannot grab image!\n"); */
+      return NULL;
+    }
+  }
+
+  return img;
+}
+
+/**
+ * \brief Release an image got with x11_session_get_image.
+ * \param session X11 session
+ * \param img X11 image
+ */
+static void x11_session_release_image(struct x11_session* session, XImage* img)
+{
+  /* the SHM image is kept for the next grab */
+  if(img != session->img)
+  {
+    XDestroyImage(img);
+  }
+}
+
+/**
+ * \brief Grab X11 screen in an X11 session.
+ * \param session X11 session
+ * \param data array that will contain screen capture
+ * \param stride number of bytes between two rows of data
+ * \param x x position to start capture
+ * \param y y position to start capture
+ * \param w capture width
+ * \param h capture height 
+ * \return 0 if success, -1 otherwise
+ */
+static int x11_session_grab(struct x11_session* session, jbyte* data, int stride, int x, int y, int w, int h)
+{
+  XImage* img = x11_session_get_image(session, x, y, w, h);
+
+  if(!img)
+  {
+    return -1;
+  }
+
+  x11_convert_argb(img, data, stride, w, h);
+  x11_session_release_image(session, img);
+  return 0;
+}
+
+/**
+ * \brief Get the current image and position of the cursor in an X11 session.
+ * \param session X11 session
+ * \return 0 if success, -1 otherwise
+ */
+static int x11_session_get_cursor(struct x11_session* session)
+{
+  struct x11_cursor* cursor = &session->cursor;
+  XFixesCursorImage* image = NULL;
+  size_t size = 0;
+  size_t i = 0;
+
+  if(!session->cursor_support)
+  {
+    return -1;
+  }
+
+  image = XFixesGetCursorImage(session->display);
+  if(!image)
+  {
+    return -1;
+  }
+
+  size = (size_t) image->width * image->height;
+  if(size > cursor->pixels_size)
+  {
+    uint32_t* pixels = realloc(cursor->pixels, size * sizeof(uint32_t));
+
+    if(!pixels)
+    {
+      XFree(image);
+      return -1;
+    }
+    cursor->pixels = pixels;
+    cursor->pixels_size = size;
+  }
+
+  /* XFixes stores the 32-bit pixels in unsigned long (i.e. 64-bit on Linux
+   * 64 bit)
+   */
+  for(i = 0 ; i < size ; i++)
+  {
+    cursor->pixels[i] = (uint32_t) image->pixels[i];
+  }
+  cursor->x = image->x - image->xhot;
+  cursor->y = image->y - image->yhot;
+  cursor->width = image->width;
+  cursor->height = image->height;
+  cursor->serial = image->cursor_serial;
+
+  XFree(image);
+  return 0;
+}
+
+/**
+ * \brief Blend a component of a premultiplied cursor pixel over a component
+ * of a screen pixel.
+ * \param s component of the cursor pixel
+ * \param d component of the screen pixel
+ * \param ia 255 minus alpha of the cursor pixel
+ * \return blended component
+ */
+static uint32_t x11_blend(uint32_t s, uint32_t d, uint32_t ia)
+{
+  uint32_t v = s + (d * ia + 127) / 255;
+
+  return v > 255 ? 255 : v;
+}
+
+/**
+ * \brief Composite the cursor over a capture area.
+ * \param cursor cursor image
+ * \param data pixels of the capture area
+ * \param stride number of bytes between two rows of data
+ * \param x x position of the capture area on the screen
+ * \param y y position of the capture area on the screen
+ * \param w width of the capture area
+ * \param h height of the capture area
+ * \param argb 1 if data contains ARGB bytes, 0 if it contains 32-bit xRGB
+ * words in host byte order
+ * \param rect if not NULL, will contain the area covered by the cursor
+ * relative to the capture area (empty if none)
+ */
+static void x11_composite_cursor(const struct x11_cursor* cursor, uint8_t* data, int stride, int x, int y, int w, int h, int argb, XRectangle* rect)
+{
+  /* clip the cursor to the capture area */
+  int x0 = cursor->x > x ? cursor->x : x;
+  int y0 = cursor->y > y ? cursor->y : y;
+  int x1 = cursor->x + cursor->width;
+  int y1 = cursor->y + cursor->height;
+  int i = 0;
+  int j = 0;
+
+  if(x1 > x + w)
+  {
+    x1 = x + w;
+  }
+  if(y1 > y + h)
+  {
+    y1 = y + h;
+  }
+  if(!cursor->pixels || x1 <= x0 || y1 <= y0)
+  {
+    if(rect)
+    {
+      rect->width = 0;
+      rect->height = 0;
+    }
+    return;
+  }
+
+  for(j = y0 ; j < y1 ; j++)
+  {
+    const uint32_t* src = cursor->pixels + (size_t) (j - cursor->y) * cursor->width;
+    uint8_t* dst = data + (size_t) (j - y) * stride;
+
+    for(i = x0 ; i < x1 ; i++)
+    {
+      uint32_t c = src[i - cursor->x];
+      uint32_t ia = 255 - (c >> 24);
+      uint8_t* d = dst + (size_t) (i - x) * 4;
+
+      if(ia == 255)
+      {
+        continue;
+      }
+
+      if(argb)
+      {
+        d[1] = x11_blend((c >> 16) & 0xff, d[1], ia);
+        d[2] = x11_blend((c >> 8) & 0xff, d[2], ia);
+        d[3] = x11_blend(c & 0xff, d[3], ia);
+      }
+      else
+      {
+        uint32_t p = 0;
+
+        memcpy(&p, d, 4);
+        p = (p & 0xff000000)
+          | x11_blend((c >> 16) & 0xff, (p >> 16) & 0xff, ia) << 16
+          | x11_blend((c >> 8) & 0xff, (p >> 8) & 0xff, ia) << 8
+          | x11_blend(c & 0xff, p & 0xff, ia);
+        memcpy(d, &p, 4);
+      }
+    }
+  }
+
+  if(rect)
+  {
+    rect->x = x0 - x;
+    rect->y = y0 - y;
+    rect->width = x1 - x0;
+    rect->height = y1 - y0;
+  }
+}
+
+/**
+ * \brief Composite the current cursor over a capture area if the session
+ * draws the cursor.
+ * \param session X11 session
+ * \param data pixels of the capture area
+ * \param stride number of bytes between two rows of data
+ * \param x x position of the capture area on the screen
+ * \param y y position of the capture area on the screen
+ * \param w width of the capture area
+ * \param h height of the capture area
+ * \param argb 1 if data contains ARGB bytes, 0 if it contains 32-bit xRGB
+ * words in host byte order
+ * \param rect if not NULL, will contain the area covered by the cursor
+ * relative to the capture area (empty if none)
+ */
+static void x11_session_draw_cursor(struct x11_session* session, uint8_t* data, int stride, int x, int y, int w, int h, int argb, XRectangle* rect)
+{
+  if(session->draw_cursor && x11_session_get_cursor(session) == 0)
+  {
+    x11_composite_cursor(&session->cursor, data, stride, x, y, w, h, argb, rect);
+  }
+  else if(rect)
+  {
+    rect->width = 0;
+    rect->height = 0;
+  }
+}
+
+/**
+ * \brief Get the area of a capture area the current cursor would be drawn
+ * over if the session draws the cursor.
+ * \param session X11 session
+ * \param x x position of the capture area on the screen
+ * \param y y position of the capture area on the screen
+ * \param w width of the capture area
+ * \param h height of the capture area
+ * \param rect will contain the area covered by the cursor relative to the
+ * capture area (empty if none)
+ */
+static void x11_session_get_cursor_rect(struct x11_session* session, int x, int y, int w, int h, XRectangle* rect)
+{
+  const struct x11_cursor* cursor = &session->cursor;
+  int x0 = 0;
+  int y0 = 0;
+  int x1 = 0;
+  int y1 = 0;
+
+  rect->width = 0;
+  rect->height = 0;
+  if(!session->draw_cursor || x11_session_get_cursor(session) == -1)
+  {
+    return;
+  }
+
+  x0 = cursor->x > x ? cursor->x : x;
+  y0 = cursor->y > y ? cursor->y : y;
+  x1 = cursor->x + cursor->width;
+  y1 = cursor->y + cursor->height;
+  if(x1 > x + w)
+  {
+    x1 = x + w;
+  }
+  if(y1 > y + h)
+  {
+    y1 = y + h;
+  }
+  if(cursor->pixels && x1 > x0 && y1 > y0)
+  {
+    rect->x = x0 - x;
+    rect->y = y0 - y;
+    rect->width = x1 - x0;
+    rect->height = y1 - y0;
+  }
+}
+
+/**
+ * \brief Add the red, green and blue of a row of 32-bit xRGB pixels in host
+ * byte order to per-column sums.
+ * \param src row of pixels
+ * \param r_sums sums of red
+ * \param g_sums sums of green
+ * \param b_sums sums of blue
+ * \param w number of pixels in the row
+ */
+static void x11_sum_row(const uint32_t* restrict src, uint32_t* restrict r_sums, uint32_t* restrict g_sums, uint32_t* restrict b_sums, int w)
+{
+  int i = 0;
+
+  /* the restrict pointers let the compiler vectorize */
+  for(i = 0 ; i < w ; i++)
+  {
+    uint32_t pixel = src[i];
+
+    r_sums[i] += (pixel >> 16) & 0xff;
+    g_sums[i] += (pixel >> 8) & 0xff;
+    b_sums[i] += pixel & 0xff;
+  }
+}
+
+/**
+ * \brief Convert 32-bit xRGB pixels in host byte order to I420 at any size
+ * with a box filter i.e. every destination pixel is the average of the source
+ * pixels it covers.
+ * \param src source pixels
+ * \param src_stride number of bytes between two rows of src
+ * \param sw source width
+ * \param sh source height
+ * \param dst Y, U and V planes of the destination
+ * \param dst_stride strides of the planes of dst
+ * \param dw destination width (even)
+ * \param dh destination height (even)
+ * \return 0 if success, -1 otherwise
+ */
+static int x11_scale_i420(const uint8_t* src, int src_stride, int sw, int sh, uint8_t* const dst[], const int dst_stride[], int dw, int dh)
+{
+  int* xs = malloc((dw + 1) * sizeof(int));
+  uint32_t* x_recips = malloc(dw * sizeof(uint32_t));
+  uint32_t* sums = malloc(3 * sw * sizeof(uint32_t));
+  uint32_t* rows = malloc(2 * dw * sizeof(uint32_t));
+  int x = 0;
+  int y = 0;
+
+  if(!xs || !x_recips || !sums || !rows)
+  {
+    free(xs);
+    free(x_recips);
+    free(sums);
+    free(rows);
+    return -1;
+  }
+
+  /* the source columns covered by every destination column and the 16.16
+   * reciprocals of their numbers which replace the divisions of the sums
+   */
+  for(x = 0 ; x <= dw ; x++)
+  {
+    xs[x] = (int)(((int64_t) x * sw) / dw);
+  }
+  for(x = 0 ; x < dw ; x++)
+  {
+    uint32_t n = xs[x + 1] > xs[x] ? xs[x + 1] - xs[x] : 1;
+
+    x_recips[x] = (65536 + n / 2) / n;
+  }
+
+  for(y = 0 ; y < dh ; y++)
+  {
+    int y0 = (int)(((int64_t) y * sh) / dh);
+    int y1 = (int)(((int64_t) (y + 1) * sh) / dh);
+    uint32_t* r_sums = sums;
+    uint32_t* g_sums = sums + sw;
+    uint32_t* b_sums = sums + 2 * sw;
+    uint32_t* row = rows + (y & 1) * dw;
+    uint32_t y_recip = 0;
+    int sy = 0;
+
+    if(y1 <= y0)
+    {
+      y1 = y0 + 1;
+    }
+
+    /* sum the source rows covered by the destination row column by column
+     * first and then the columns covered by every destination column
+     */
+    memset(sums, 0, 3 * sw * sizeof(uint32_t));
+    for(sy = y0 ; sy < y1 ; sy++)
+    {
+      x11_sum_row((const uint32_t*)(src + (size_t) sy * src_stride), r_sums, g_sums, b_sums, sw);
+    }
+    y_recip = (65536 + (y1 - y0) / 2) / (y1 - y0);
+    for(x = 0 ; x < dw ; x++)
+    {
+      int x1 = xs[x + 1] > xs[x] ? xs[x + 1] : xs[x] + 1;
+      uint64_t recip = (uint64_t) x_recips[x] * y_recip;
+      uint32_t r = 0;
+      uint32_t g = 0;
+      uint32_t b = 0;
+      int sx = 0;
+
+      for(sx = xs[x] ; sx < x1 ; sx++)
+      {
+        r += r_sums[sx];
+        g += g_sums[sx];
+        b += b_sums[sx];
+      }
+      row[x]
+        = (uint32_t)((r * recip + 0x80000000ULL) >> 32) << 16
+          | (uint32_t)((g * recip + 0x80000000ULL) >> 32) << 8
+          | (uint32_t)((b * recip + 0x80000000ULL) >> 32);
+    }
+
+    /* a pair of rows makes a row of chroma */
+    if(y & 1)
+    {
+      uint8_t* y_row0 = dst[0] + (size_t) (y - 1) * dst_stride[0];
+      uint8_t* y_row1 = y_row0 + dst_stride[0];
+      uint8_t* u = dst[1] + (size_t) (y / 2) * dst_stride[1];
+      uint8_t* v = dst[2] + (size_t) (y / 2) * dst_stride[2];
+
+      for(x = 0 ; x < dw ; x += 2)
+      {
+        uint32_t p00 = rows[x];
+        uint32_t p01 = rows[x + 1];
+        uint32_t p10 = rows[dw + x];
+        uint32_t p11 = rows[dw + x + 1];
+        int r00 = (p00 >> 16) & 0xff, g00 = (p00 >> 8) & 0xff, b00 = p00 & 0xff;
+        int r01 = (p01 >> 16) & 0xff, g01 = (p01 >> 8) & 0xff, b01 = p01 & 0xff;
+        int r10 = (p10 >> 16) & 0xff, g10 = (p10 >> 8) & 0xff, b10 = p10 & 0xff;
+        int r11 = (p11 >> 16) & 0xff, g11 = (p11 >> 8) & 0xff, b11 = p11 & 0xff;
+        int r = (r00 + r01 + r10 + r11 + 2) >> 2;
+        int g = (g00 + g01 + g10 + g11 + 2) >> 2;
+        int b = (b00 + b01 + b10 + b11 + 2) >> 2;
+
+        y_row0[x] = I420CONVERTER_RGB_TO_Y(r00, g00, b00);
+        y_row0[x + 1] = I420CONVERTER_RGB_TO_Y(r01, g01, b01);
+        y_row1[x] = I420CONVERTER_RGB_TO_Y(r10, g10, b10);
+        y_row1[x + 1] = I420CONVERTER_RGB_TO_Y(r11, g11, b11);
+        u[x / 2] = I420CONVERTER_RGB_TO_U(r, g, b);
+        v[x / 2] = I420CONVERTER_RGB_TO_V(r, g, b);
+      }
+    }
+  }
+
+  free(xs);
+  free(x_recips);
+  free(sums);
+  free(rows);
+  return 0;
+}
+
+/**
+ * \brief Grab X11 screen in an X11 session and convert it straight to I420 at
+ * a specific size.
+ * \param session X11 session
+ * \param data buffer that will contain the Y, U and V planes one after the
+ * other
+ * \param x x position to start capture
+ * \param y y position to start capture
+ * \param w capture width
+ * \param h capture height
+ * \param dw width of the I420 picture (even)
+ * \param dh height of the I420 picture (even)
+ * \param cursor if not NULL, will contain the area covered by the cursor
+ * relative to the capture area (empty if none)
+ * \return 0 if success, -1 otherwise
+ */
+static int x11_session_grab_i420(struct x11_session* session, uint8_t* data, int x, int y, int w, int h, int dw, int dh, XRectangle* cursor)
+{
+  XImage* img = x11_session_get_image(session, x, y, w, h);
+  uint32_t* pixels = NULL;
+  const uint8_t* src[1];
+  int src_stride[1];
+  uint8_t* dst[3];
+  int dst_stride[3];
+  int ret = 0;
+
+  if(!img)
+  {
+    return -1;
+  }
+
+  if(x11_image_is_xrgb32(img))
+  {
+    src[0] = (const uint8_t*) img->data;
+    src_stride[0] = img->bytes_per_line;
+  }
+  else
+  {
+    int i = 0;
+    int j = 0;
+
+    /* exotic visuals go through XGetPixel */
+    pixels = malloc((size_t) w * h * sizeof(uint32_t));
+    if(!pixels)
+    {
+      x11_session_release_image(session, img);
+      return -1;
+    }
+    for(j = 0 ; j < h ; j++)
+    {
+      for(i = 0 ; i < w ; i++)
+      {
+        pixels[(size_t) j * w + i] = (uint32_t)XGetPixel(img, i, j);
+      }
+    }
+    src[0] = (const uint8_t*) pixels;
+    src_stride[0] = w * 4;
+  }
+
+  /* the image is ours until released so the cursor is drawn right into it */
+  x11_session_draw_cursor(session, (uint8_t*) src[0], src_stride[0], x, y, w, h, 0, cursor);
+
+  dst[0] = data;
+  dst[1] = dst[0] + (size_t) dw * dh;
+  dst[2] = dst[1] + (size_t) (dw / 2) * (dh / 2);
+  dst_stride[0] = dw;
+  dst_stride[1] = dw / 2;
+  dst_stride[2] = dw / 2;
+
+  /* SIMD conversion at 1:1 and 2:1, box filter at any other size */
+  if(I420Converter_convert(I420CONVERTER_RGB32, src, src_stride, w, h, dst, dst_stride, dw, dh) == -1)
+  {
+    ret = x11_scale_i420(src[0], src_stride[0], w, h, dst, dst_stride, dw, dh);
+  }
+
+  free(pixels);
+  x11_session_release_image(session, img);
+  return ret;
+}
+
+/**
+ * \brief Grab an area of X11 screen in an X11 session reusing the SHM
+ * segment of its last full grab if the area fits in it.
+ * \param session X11 session
+ * \param data array that will contain the area
+ * \param stride number of bytes between two rows of data
+ * \param x x position of the area
+ * \param y y position of the area
+ * \param w width of the area
+ * \param h height of the area
+ * \return 0 if success, -1 otherwise
+ */
+static int x11_session_grab_area(struct x11_session* session, jbyte* data, int stride, int x, int y, int w, int h)
+{
+  XImage* img = NULL;
+  int shm = 0;
+
+  if(session->img && w <= session->img->width && h <= session->img->height)
+  {
+    /* an image header of the size of the area over the same segment */
+    img = XShmCreateImage(session->display, session->visual, session->depth,
+        ZPixmap, session->shm_info.shmaddr, &session->shm_info, w, h);
+
+    if(img && XShmGetImage(session->display, session->root_window, img, x, y, 0xffffffff))
+    {
+      shm = 1;
+    }
+    else if(img)
+    {
+      img->data = NULL;
+      XDestroyImage(img);
+      img = NULL;
+    }
+  }
+
+  if(!img)
+  {
+    img = XGetImage(session->display, session->root_window, x, y, w, h, 0xffffffff, ZPixmap);
+
+    if(!img)
+    {
+      return -1;
+    }
+  }
+
+  x11_convert_argb(img, data, stride, w, h);
+
+  if(shm)
+  {
+    img->data = NULL;
+  }
+  XDestroyImage(img);
+  return 0;
+}
+
+/**
+ * \brief Fetch and reset the damage of the screen accumulated since the
+ * previous damage grab in an X11 session.
+ * \param session X11 session
+ * \param x x position of the capture area
+ * \param y y position of the capture area
+ * \param w width of the capture area
+ * \param h height of the capture area
+ * \param report array of at least DAMAGE_MAX_RECTS rectangles that will
+ * contain the damaged rectangles clipped to and relative to the capture area
+ * \return number of rectangles stored in report
+ */
+static int x11_session_fetch_damage(struct x11_session* session, int x, int y, int w, int h, XRectangle* report)
+{
+  Display* display = session->display;
+  XserverRegion region = XFixesCreateRegion(display, NULL, 0);
+  XRectangle* dirty = NULL;
+  XRectangle bounds;
+  int dirty_count = 0;
+  int count = 0;
+  int i = 0;
+
+  XDamageSubtract(display, session->damage, None, region);
+  dirty = XFixesFetchRegionAndBounds(display, region, &dirty_count, &bounds);
+  XFixesDestroyRegion(display, region);
+
+  for(i = 0 ; i < dirty_count ; i++)
+  {
+    /* too many rectangles are reported as their bounding box */
+    XRectangle* r = dirty_count > DAMAGE_MAX_RECTS ? &bounds : &dirty[i];
+    /* clip to the capture area */
+    int x0 = r->x > x ? r->x : x;
+    int y0 = r->y > y ? r->y : y;
+    int x1 = r->x + r->width;
+    int y1 = r->y + r->height;
+
+    if(x1 > x + w)
+    {
+      x1 = x + w;
+    }
+    if(y1 > y + h)
+    {
+      y1 = y + h;
+    }
+    if(x1 > x0 && y1 > y0)
+    {
+      report[count].x = x0 - x;
+      report[count].y = y0 - y;
+      report[count].width = x1 - x0;
+      report[count].height = y1 - y0;
+      count++;
+    }
+    if(r == &bounds)
+    {
+      break;
+    }
+  }
+  if(dirty)
+  {
+    XFree(dirty);
+  }
+  return count;
+}
+
+/**
+ * \brief Track the area covered by the cursor between damage grabs in an X11
+ * session. Its previous and current areas are damaged when it changes.
+ * \param session X11 session
+ * \param cursor area covered by the cursor drawn by the current grab
+ * \param report array that will have the damaged cursor areas appended
+ * \param count number of rectangles in report
+ * \return new number of rectangles in report
+ */
+static int x11_session_damage_cursor(struct x11_session* session, const XRectangle* cursor, XRectangle* report, int count)
+{
+  if(cursor->width != session->damage_cursor.width
+      || cursor->height != session->damage_cursor.height
+      || cursor->x != session->damage_cursor.x
+      || cursor->y != session->damage_cursor.y
+      || (cursor->width && session->cursor.serial != session->damage_cursor_serial))
+  {
+    if(session->damage_cursor.width && session->damage_cursor.height)
+    {
+      report[count++] = session->damage_cursor;
+    }
+    if(cursor->width && cursor->height)
+    {
+      report[count++] = *cursor;
+    }
+  }
+  session->damage_cursor = *cursor;
+  session->damage_cursor_serial = session->cursor.serial;
+  return count;
+}
+
+/**
+ * \brief Store damaged rectangles as x, y, width and height or their bounding
+ * box if they do not fit.
+ * \param dirty damaged rectangles
+ * \param dirty_count number of rectangles in dirty
+ * \param rects array that will contain the rectangles
+ * \param rects_length length of rects (at least 4)
+ * \return number of rectangles stored in rects
+ */
+static int x11_report_damage(XRectangle* dirty, int dirty_count, jint* rects, int rects_length)
+{
+  int count = 0;
+  int i = 0;
+
+  if(dirty_count * 4 > rects_length)
+  {
+    int x0 = dirty[0].x;
+    int y0 = dirty[0].y;
+    int x1 = 0;
+    int y1 = 0;
+
+    for(i = 0 ; i < dirty_count ; i++)
+    {
+      if(dirty[i].x < x0) x0 = dirty[i].x;
+      if(dirty[i].y < y0) y0 = dirty[i].y;
+      if(dirty[i].x + dirty[i].width > x1) x1 = dirty[i].x + dirty[i].width;
+      if(dirty[i].y + dirty[i].height > y1) y1 = dirty[i].y + dirty[i].height;
+    }
+    dirty[0].x = x0;
+    dirty[0].y = y0;
+    dirty[0].width = x1 - x0;
+    dirty[0].height = y1 - y0;
+    dirty_count = 1;
+  }
+  for(i = 0 ; i < dirty_count && (count + 4) <= rects_length ; i++)
+  {
+    rects[count++] = dirty[i].x;
+    rects[count++] = dirty[i].y;
+    rects[count++] = dirty[i].width;
+    rects[count++] = dirty[i].height;
+  }
+
+  return count / 4;
+}
+
+/**
+ * \brief Grab X11 screen in an X11 session tracking the damaged areas of the
+ * screen. Only the areas damaged since the previous grab are grabbed and
+ * patched into the frame of the session which is then copied into data.
+ * \param session X11 session
+ * \param data array that will contain screen capture
+ * \param x x position to start capture
+ * \param y y position to start capture
+ * \param w capture width
+ * \param h capture height
+ * \param rects array that will contain the x, y, width and height of the
+ * damaged rectangles relative to the capture area
+ * \param rects_length length of rects (at least 4)
+ * \return number of rectangles stored in rects (i.e. 0 if the capture area
+ * has not changed), -1 if failure
+ */
+static int x11_session_grab_damage(struct x11_session* session, jbyte* data, int x, int y, int w, int h, jint* rects, int rects_length)
+{
+  Display* display = session->display;
+  XRectangle report[DAMAGE_MAX_RECTS + 2];
+  XRectangle cursor = { 0, 0, 0, 0 };
+  int count = 0;
+  int i = 0;
+
+  x11_session_update(session);
+
+  /* check that user-defined parameters are in image */
+  if(rects_length < 4 || x < 0 || y < 0 || w <= 0 || h <= 0
+      || (w + x) > session->width || (h + y) > session->height)
+  {
+    return -1;
+  }
+
+  if(!session->damage_support)
+  {
+    /* every grab is a full grab */
+    if(x11_session_grab(session, data, w * 4, x, y, w, h) == -1)
+    {
+      return -1;
+    }
+    x11_session_draw_cursor(session, (uint8_t*) data, w * 4, x, y, w, h, 1, NULL);
+    rects[0] = 0;
+    rects[1] = 0;
+    rects[2] = w;
+    rects[3] = h;
+    return 1;
+  }
+
+  if(session->damage == None)
+  {
+    session->damage = XDamageCreate(display, session->root_window, XDamageReportNonEmpty);
+  }
+
+  /* the damage is subtracted here so the I420 picture would miss it */
+  free(session->picture);
+  session->picture = NULL;
+
+  if(!session->frame
+      || session->frame_x != x || session->frame_y != y
+      || session->frame_w != w || session->frame_h != h)
+  {
+    /* (re)initialize the frame with a full grab, damage from now on is
+     * picked up by the next grab
+     */
+    free(session->frame);
+    session->frame = malloc((size_t) w * h * 4);
+    if(!session->frame)
+    {
+      return -1;
+    }
+    XDamageSubtract(display, session->damage, None, None);
+    if(x11_session_grab(session, session->frame, w * 4, x, y, w, h) == -1)
+    {
+      free(session->frame);
+      session->frame = NULL;
+      return -1;
+    }
+    session->frame_x = x;
+    session->frame_y = y;
+    session->frame_w = w;
+    session->frame_h = h;
+
+    report[0].x = 0;
+    report[0].y = 0;
+    report[0].width = w;
+    report[0].height = h;
+    count = 1;
+  }
+  else
+  {
+    count = x11_session_fetch_damage(session, x, y, w, h, report);
+
+    for(i = 0 ; i < count ; i++)
+    {
+      if(x11_session_grab_area(session,
+            session->frame + ((size_t) report[i].y * w + report[i].x) * 4, w * 4,
+            x + report[i].x, y + report[i].y, report[i].width, report[i].height) == -1)
+      {
+        /* the damage is gone so the frame is to be grabbed in full again */
+        free(session->frame);
+        session->frame = NULL;
+        return -1;
+      }
+    }
+  }
+
+  /* the cursor is drawn over a copy of the frame so that it leaves no trail
+   * in the frame
+   */
+  memcpy(data, session->frame, (size_t) w * h * 4);
+  x11_session_draw_cursor(session, (uint8_t*) data, w * 4, x, y, w, h, 1, &cursor);
+  count = x11_session_damage_cursor(session, &cursor, report, count);
+
+  return x11_report_damage(report, count, rects, rects_length);
+}
+
+/**
+ * \brief Grab X11 screen in an X11 session tracking the damaged areas of the
+ * screen and convert it to I420 at a specific size. The I420 picture of the
+ * session is only grabbed and converted again when the capture area has been
+ * damaged (or the cursor has changed) since the previous grab, it is then
+ * copied into data.
+ * \param session X11 session
+ * \param data buffer that will contain the Y, U and V planes one after the
+ * other
+ * \param x x position to start capture
+ * \param y y position to start capture
+ * \param w capture width
+ * \param h capture height
+ * \param dw width of the I420 picture (even)
+ * \param dh height of the I420 picture (even)
+ * \param rects array that will contain the x, y, width and height of the
+ * damaged rectangles relative to the I420 picture
+ * \param rects_length length of rects (at least 4)
+ * \return number of rectangles stored in rects (i.e. 0 if the capture area
+ * has not changed), -1 if failure
+ */
+static int x11_session_grab_i420_damage(struct x11_session* session, uint8_t* data, int x, int y, int w, int h, int dw, int dh, jint* rects, int rects_length)
+{
+  Display* display = session->display;
+  size_t size = (size_t) dw * dh * 3 / 2;
+  XRectangle report[DAMAGE_MAX_RECTS + 4];
+  XRectangle cursor = { 0, 0, 0, 0 };
+  int count = 0;
+  int i = 0;
+
+  x11_session_update(session);
+
+  /* check that user-defined parameters are in image */
+  if(rects_length < 4 || x < 0 || y < 0 || w <= 0 || h <= 0
+      || (w + x) > session->width || (h + y) > session->height)
+  {
+    return -1;
+  }
+
+  if(!session->damage_support)
+  {
+    /* every grab is a full grab */
+    if(x11_session_grab_i420(session, data, x, y, w, h, dw, dh, NULL) == -1)
+    {
+      return -1;
+    }
+    rects[0] = 0;
+    rects[1] = 0;
+    rects[2] = dw;
+    rects[3] = dh;
+    return 1;
+  }
+
+  if(session->damage == None)
+  {
+    session->damage = XDamageCreate(display, session->root_window, XDamageReportNonEmpty);
+  }
+
+  /* the damage is subtracted here so the ARGB frame would miss it */
+  free(session->frame);
+  session->frame = NULL;
+
+  if(!session->picture
+      || session->picture_x != x || session->picture_y != y
+      || session->picture_w != w || session->picture_h != h
+      || session->picture_dw != dw || session->picture_dh != dh)
+  {
+    free(session->picture);
+    session->picture = malloc(size);
+    if(!session->picture)
+    {
+      return -1;
+    }
+    session->picture_x = x;
+    session->picture_y = y;
+    session->picture_w = w;
+    session->picture_h = h;
+    session->picture_dw = dw;
+    session->picture_dh = dh;
+    XDamageSubtract(display, session->damage, None, None);
+
+    report[0].x = 0;
+    report[0].y = 0;
+    report[0].width = w;
+    report[0].height = h;
+    count = 1;
+  }
+  else
+  {
+    count = x11_session_fetch_damage(session, x, y, w, h, report);
+    x11_session_get_cursor_rect(session, x, y, w, h, &cursor);
+    count = x11_session_damage_cursor(session, &cursor, report, count);
+  }
+
+  if(count)
+  {
+    /* the cursor may have changed since it was checked */
+    if(x11_session_grab_i420(session, session->picture, x, y, w, h, dw, dh, &cursor) == -1)
+    {
+      free(session->picture);
+      session->picture = NULL;
+      return -1;
+    }
+    count = x11_session_damage_cursor(session, &cursor, report, count);
+  }
+  memcpy(data, session->picture, size);
+
+  /* scale the rectangles to the picture and align them to its chroma */
+  for(i = 0 ; i < count ; i++)
+  {
+    int x0 = (int) ((int64_t) report[i].x * dw / w) & ~1;
+    int y0 = (int) ((int64_t) report[i].y * dh / h) & ~1;
+    int x1 = (int) (((int64_t) (report[i].x + report[i].width) * dw + w - 1) / w);
+    int y1 = (int) (((int64_t) (report[i].y + report[i].height) * dh + h - 1) / h);
+
+    x1 = (x1 + 1) & ~1;
+    y1 = (y1 + 1) & ~1;
+    report[i].x = x0;
+    report[i].y = y0;
+    report[i].width = (x1 > dw ? dw : x1) - x0;
+    report[i].height = (y1 > dh ? dh : y1) - y0;
+  }
+
+  return x11_report_damage(report, count, rects, rects_length);
+}
+
+/**
+ * \brief Get the time of the monotonic clock.
+ * \return time in nanoseconds
+ */
+static int64_t x11_time_ns(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (int64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+/**
+ * \brief Grab a region of X11 screen in an X11 session and time it.
+ * \param session X11 session
+ * \param data array that will contain the region
+ * \param stride number of bytes between two rows of data
+ * \param x x position of the region
+ * \param y y position of the region
+ * \param w width of the region
+ * \param h height of the region
+ * \param time will contain the duration of the grab in nanoseconds
+ * \return 0 if success, -1 otherwise
+ */
+static int x11_session_grab_timed(struct x11_session* session, jbyte* data, int stride, int x, int y, int w, int h, int64_t* time)
+{
+  int64_t start = x11_time_ns();
+  int ret = x11_session_grab(session, data, stride, x, y, w, h);
+
+  *time = x11_time_ns() - start;
+  return ret;
+}
+
+/**
+ * \brief Thread function of a worker: grab the region of its job in each
+ * round of jobs until the owner session is closed.
+ * \param arg worker
+ * \return NULL
+ */
+static void* x11_worker_run(void* arg)
+{
+  struct x11_worker* worker = arg;
+  struct x11_session* owner = worker->owner;
+
+  pthread_mutex_lock(&owner->workers_mutex);
+  for(;;)
+  {
+    while(!owner->workers_stopping && owner->workers_round == worker->round)
+    {
+      pthread_cond_wait(&owner->workers_cond, &owner->workers_mutex);
+    }
+    if(owner->workers_stopping)
+    {
+      break;
+    }
+    worker->round = owner->workers_round;
+
+    if(worker->job)
+    {
+      pthread_mutex_unlock(&owner->workers_mutex);
+      worker->ret = x11_session_grab_timed(worker->session, worker->data, worker->stride, worker->x, worker->y, worker->w, worker->h, &worker->time);
+      pthread_mutex_lock(&owner->workers_mutex);
+
+      worker->job = 0;
+      if(--owner->workers_pending == 0)
+      {
+        pthread_cond_signal(&owner->workers_done_cond);
+      }
+    }
+  }
+  pthread_mutex_unlock(&owner->workers_mutex);
+  return NULL;
+}
+
+/**
+ * \brief Start a worker of an X11 session i.e. open its own X11 session and
+ * start its thread. Must be called with the workers mutex of the owner
+ * session locked.
+ * \param owner X11 session the worker grabs regions for
+ * \param worker worker
+ * \return 0 if success, -1 otherwise
+ */
+static int x11_worker_start(struct x11_session* owner, struct x11_worker* worker)
+{
+  if(worker->failed)
+  {
+    return -1;
+  }
+
+  worker->owner = owner;
+  worker->round = owner->workers_round;
+  worker->job = 0;
+  worker->session = x11_session_open(owner->display_index);
+  if(!worker->session)
+  {
+    worker->failed = 1;
+    return -1;
+  }
+  if(pthread_create(&worker->thread, NULL, x11_worker_run, worker) != 0)
+  {
+    x11_session_close(worker->session);
+    worker->session = NULL;
+    worker->failed = 1;
+    return -1;
+  }
+  return 0;
+}
+
+/**
+ * \brief Grab several regions of X11 screen (e.g. the monitors of a
+ * multi-monitor setup) in parallel in an X11 session and stitch them into one
+ * ARGB buffer. The first region is grabbed by the calling thread and the
+ * others by workers of the session, each with its own display connection.
+ * \param session X11 session
+ * \param regions x, y, width and height of each region on the screen followed
+ * by its x and y position in data
+ * \param count number of regions
+ * \param data array that will contain the regions
+ * \param length length of data in bytes
+ * \param dw width of data in pixels
+ * \param times array that will contain the duration in nanoseconds of the
+ * grab of each region
+ * \return 0 if success, -1 otherwise
+ */
+static int x11_session_grab_regions(struct x11_session* session, const jint* regions, int count, jbyte* data, size_t length, int dw, jlong* times)
+{
+  int serial[REGIONS_MAX];
+  int serial_count = 0;
+  int ret = 0;
+  int i = 0;
+
+  if(count < 1 || count > REGIONS_MAX || dw <= 0)
+  {
+    return -1;
+  }
+
+  /* check that the regions fit in data */
+  for(i = 0 ; i < count ; i++)
+  {
+    const jint* r = regions + i * 6;
+
+    if(r[2] <= 0 || r[3] <= 0 || r[4] < 0 || r[5] < 0 || r[4] + r[2] > dw
+        || ((size_t) (r[5] + r[3] - 1) * dw + r[4] + r[2]) * 4 > length)
+    {
+      return -1;
+    }
+  }
+
+  /* hand the regions but the first to the workers, the regions of workers
+   * which cannot be started are grabbed by the calling thread
+   */
+  pthread_mutex_lock(&session->workers_mutex);
+  for(i = 1 ; i < count ; i++)
+  {
+    const jint* r = regions + i * 6;
+    struct x11_worker* worker = &session->workers[i - 1];
+
+    if(!worker->session && x11_worker_start(session, worker) == -1)
+    {
+      serial[serial_count++] = i;
+      continue;
+    }
+    worker->data = data + ((size_t) r[5] * dw + r[4]) * 4;
+    worker->stride = dw * 4;
+    worker->x = r[0];
+    worker->y = r[1];
+    worker->w = r[2];
+    worker->h = r[3];
+    worker->job = 1;
+    session->workers_pending++;
+  }
+  if(session->workers_pending)
+  {
+    session->workers_round++;
+    pthread_cond_broadcast(&session->workers_cond);
+  }
+  pthread_mutex_unlock(&session->workers_mutex);
+
+  serial[serial_count++] = 0;
+  while(serial_count)
+  {
+    const jint* r = NULL;
+    int64_t time = 0;
+
+    i = serial[--serial_count];
+    r = regions + i * 6;
+    if(x11_session_grab_timed(session, data + ((size_t) r[5] * dw + r[4]) * 4, dw * 4, r[0], r[1], r[2], r[3], &time) == -1)
+    {
+      ret = -1;
+    }
+    times[i] = time;
+  }
+
+  pthread_mutex_lock(&session->workers_mutex);
+  while(session->workers_pending)
+  {
+    pthread_cond_wait(&session->workers_done_cond, &session->workers_mutex);
+  }
+  pthread_mutex_unlock(&session->workers_mutex);
+
+  for(i = 1 ; i < count ; i++)
+  {
+    struct x11_worker* worker = &session->workers[i - 1];
+
+    if(worker->session)
+    {
+      if(worker->ret == -1)
+      {
+        ret = -1;
+      }
+      times[i] = worker->time;
+    }
+  }
+
+  /* the cursor is got once for all regions */
+  if(ret == 0 && session->draw_cursor && x11_session_get_cursor(session) == 0)
+  {
+    for(i = 0 ; i < count ; i++)
+    {
+      const jint* r = regions + i * 6;
+
+      x11_composite_cursor(&session->cursor, (uint8_t*) data + ((size_t) r[5] * dw + r[4]) * 4, dw * 4, r[0], r[1], r[2], r[3], 1, NULL);
+    }
+  }
+
+  return ret;
+}
+
+/**
+ * \brief Grab X11 screen.
+ * \param data array that will contain screen capture
+ * \param displayIndex display index
+ * \param x x position to start capture
+ * \param y y position to start capture
+ * \param w capture width
+ * \param h capture height 
+ * \return 0 if success, -1 otherwise
+ */
+static int x11_grab_screen(jbyte* data, unsigned int displayIndex, int x, int y, int w, int h)
+{
+  struct x11_session* session = x11_session_open(displayIndex);
+  int ret = -1;
+
+  if(!session)
+  {
+    return -1;
+  }
+
+  ret = x11_session_grab(session, data, w * 4, x, y, w, h);
+  x11_session_close(session);
+  return ret;
+}
+
+#endif
+
+/**
+ * \brief JNI native method to grab desktop screen and retrieve ARGB pixels.
+ * \param env JVM environment
+ * \param clazz NativeScreenCapture Java class
+ * \param display display index
+ * \param x x position to start capture
+ * \param y y position to start capture
+ * \param width capture width
+ * \param height capture height
+ * \param output output buffer, screen bytes will be stored in
+ * \return true if success, false otherwise
+ */
+JNIEXPORT jboolean JNICALL
+Java_org_jitsi_impl_neomedia_imgstreaming_ScreenCapture_grabScreen__IIIII_3B
+    (JNIEnv* env, jclass clazz, jint display, jint x, jint y, jint width, jint height, jbyteArray output)
+{
+  jint size = width * height * 4;
+  jbyte* data = NULL;
+
+  clazz = clazz; /* not used */
+
+  if(!output || (*env)->GetArrayLength(env, output) < size)
+  {
+    return JNI_FALSE;
+  }
+
+  data = (*env)->GetPrimitiveArrayCritical(env, output, 0);
+
+  if(!data)
+  {
+    return JNI_FALSE;
+  }
+
+#if defined (_WIN32) || defined(_WIN64)
+  if(windows_grab_screen(data, display, x, y, width, height) == -1)
+#elif defined(__APPLE__)
+    if(quartz_grab_screen(data, display, x, y, width, height) == -1)
+#else /* Unix */
+  if(x11_grab_screen(data, display, x, y, width, height) == -1)
+#endif
+  {
+    (*env)->ReleasePrimitiveArrayCritical(env, output, data, 0);
+    return JNI_FALSE;
+  }
+
+  (*env)->ReleasePrimitiveArrayCritical(env, output, data, 0);
+  return JNI_TRUE;
+}
+
+/**
+ * \brief JNI native method to grab desktop screen and retrieve ARGB pixels.
+ * \param env JVM environment
+ * \param clazz NativeScreenCapture Java class
+ * \param display display index
+ * \param x x position to start capture
+ * \param y y position to start capture
+ * \param width capture width
+ * \param height capture height
+ * \param output native output buffer
+ * \return true if success, false otherwise
+ */
+JNIEXPORT jboolean JNICALL
+Java_org_jitsi_impl_neomedia_imgstreaming_ScreenCapture_grabScreen__IIIIIJI
+    (JNIEnv* env, jclass clazz, jint display, jint x, jint y, jint width, jint height, jlong output, jint outputLength)
+{
+  jint size = width * height * 4;
+  jbyte* data = (jbyte*) (intptr_t) output;
+
+  /* not used */
+  clazz = clazz;
+  env = env;
+
+  if(!data || outputLength < size)
+  {
+    return JNI_FALSE;
+  }
+
+#if defined (_WIN32) || defined(_WIN64)
+  if(windows_grab_screen(data, display, x, y, width, height) == -1)
+#elif defined(__APPLE__)
+    if(quartz_grab_screen(data, display, x, y, width, height) == -1)
+#else /* Unix */
+  if(x11_grab_screen(data, display, x, y, width, height) == -1)
+#endif
+  {
+    return JNI_FALSE;
+  }
+
+  return JNI_TRUE;
+}
+
+/**
+ * \brief JNI native method to open a screen capture session which keeps the
+ * resources needed to grab a display alive between grabs.
+ * \param env JVM environment
+ * \param clazz ScreenCapture Java class
+ * \param display display index
+ * \return session pointer or 0 if failure or not supported on this platform
+ */
+JNIEXPORT jlong JNICALL
+Java_org_jitsi_impl_neomedia_imgstreaming_ScreenCapture_openSession
+    (JNIEnv* env, jclass clazz, jint display)
+{
+  /* not used */
+  env = env;
+  clazz = clazz;
+
+#if defined (_WIN32) || defined(_WIN64) || defined(__APPLE__)
+  display = display;
+  return 0;
+#else /* Unix */
+  return (jlong) (intptr_t) x11_session_open(display);
+#endif
+}
+
+/**
+ * \brief JNI native method to grab desktop screen in a screen capture session
+ * and retrieve ARGB pixels.
+ * \param env JVM environment
+ * \param clazz ScreenCapture Java class
+ * \param session session pointer
+ * \param x x position to start capture
+ * \param y y position to start capture
+ * \param width capture width
+ * \param height capture height
+ * \param output native output buffer
+ * \param outputLength native output length
+ * \return true if success, false otherwise
+ */
+JNIEXPORT jboolean JNICALL
+Java_org_jitsi_impl_neomedia_imgstreaming_ScreenCapture_grabSession
+    (JNIEnv* env, jclass clazz, jlong session, jint x, jint y, jint width, jint height, jlong output, jint outputLength)
+{
+  jint size = width * height * 4;
+  jbyte* data = (jbyte*) (intptr_t) output;
+
+  /* not used */
+  clazz = clazz;
+  env = env;
+
+  if(!session || !data || outputLength < size)
+  {
+    return JNI_FALSE;
+  }
+
+#if defined (_WIN32) || defined(_WIN64) || defined(__APPLE__)
+  x = x;
+  y = y;
+  return JNI_FALSE;
+#else /* Unix */
+  {
+    struct x11_session* s = (struct x11_session*) (intptr_t) session;
+
+    if(x11_session_grab(s, data, width * 4, x, y, width, height) == -1)
+    {
+      return JNI_FALSE;
+    }
+    x11_session_draw_cursor(s, (uint8_t*) data, width * 4, x, y, width, height, 1, NULL);
+  }
+
+  return JNI_TRUE;
+#endif
+}
+
+/**
+ * \brief JNI native method to grab desktop screen in a screen capture session
+ * tracking the damaged areas of the screen and retrieve ARGB pixels. Only the
+ * areas damaged since the previous grab are actually grabbed.
+ * \param env JVM environment
+ * \param clazz ScreenCapture Java class
+ * \param session session pointer
+ * \param x x position to start capture
+ * \param y y position to start capture
+ * \param width capture width
+ * \param height capture height
+ * \param output native output buffer
+ * \param outputLength native output length
+ * \param rects array that will contain the x, y, width and height of the
+ * damaged rectangles relative to the capture area
+ * \return number of damaged rectangles stored in rects (i.e. 0 if the capture
+ * area has not changed), -1 if failure
+ */
+JNIEXPORT jint JNICALL
+Java_org_jitsi_impl_neomedia_imgstreaming_ScreenCapture_grabSessionDamage
+    (JNIEnv* env, jclass clazz, jlong session, jint x, jint y, jint width, jint height, jlong output, jint outputLength, jintArray rects)
+{
+  jint size = width * height * 4;
+  jbyte* data = (jbyte*) (intptr_t) output;
+  jint rectsLength = 0;
+  jint rectsBuf[DAMAGE_MAX_RECTS * 4];
+  jint ret = -1;
+
+  /* not used */
+  clazz = clazz;
+
+  if(!session || !data || outputLength < size || !rects)
+  {
+    return -1;
+  }
+
+  rectsLength = (*env)->GetArrayLength(env, rects);
+  if(rectsLength > DAMAGE_MAX_RECTS * 4)
+  {
+    rectsLength = DAMAGE_MAX_RECTS * 4;
+  }
+
+#if defined (_WIN32) || defined(_WIN64) || defined(__APPLE__)
+  x = x;
+  y = y;
+  rectsBuf[0] = 0;
+#else /* Unix */
+  ret = x11_session_grab_damage((struct x11_session*) (intptr_t) session, data, x, y, width, height, rectsBuf, rectsLength);
+  if(ret > 0)
+  {
+    (*env)->SetIntArrayRegion(env, rects, 0, ret * 4, rectsBuf);
+  }
+#endif
+
+  return ret;
+}
+
+/**
+ * \brief JNI native method to grab desktop screen in a screen capture session
+ * tracking the damaged areas of the screen and retrieve it as an I420 picture
+ * of a specific size. The picture is only converted again when the capture
+ * area has changed since the previous grab.
+ * \param env JVM environment
+ * \param clazz ScreenCapture Java class
+ * \param session session pointer
+ * \param x x position to start capture
+ * \param y y position to start capture
+ * \param width capture width
+ * \param height capture height
+ * \param output native output buffer which will contain the Y, U and V planes
+ * one after the other
+ * \param outputLength native output length
+ * \param outputWidth width of the I420 picture (even)
+ * \param outputHeight height of the I420 picture (even)
+ * \param rects array that will contain the x, y, width and height of the
+ * damaged rectangles relative to the I420 picture
+ * \return number of damaged rectangles stored in rects (i.e. 0 if the capture
+ * area has not changed), -1 if failure
+ */
+JNIEXPORT jint JNICALL
+Java_org_jitsi_impl_neomedia_imgstreaming_ScreenCapture_grabSessionI420
+    (JNIEnv* env, jclass clazz, jlong session, jint x, jint y, jint width, jint height, jlong output, jint outputLength, jint outputWidth, jint outputHeight, jintArray rects)
+{
+  jint size = outputWidth * outputHeight * 3 / 2;
+  jbyte* data = (jbyte*) (intptr_t) output;
+  jint rectsLength = 0;
+  jint rectsBuf[DAMAGE_MAX_RECTS * 4];
+  jint ret = -1;
+
+  /* not used */
+  clazz = clazz;
+
+  if(!session || !data || outputLength < size || !rects
+      || outputWidth < 2 || outputHeight < 2
+      || (outputWidth & 1) || (outputHeight & 1))
+  {
+    return -1;
+  }
+
+  rectsLength = (*env)->GetArrayLength(env, rects);
+  if(rectsLength > DAMAGE_MAX_RECTS * 4)
+  {
+    rectsLength = DAMAGE_MAX_RECTS * 4;
+  }
+
+#if defined (_WIN32) || defined(_WIN64) || defined(__APPLE__)
+  x = x;
+  y = y;
+  width = width;
+  height = height;
+  rectsBuf[0] = 0;
+#else /* Unix */
+  ret = x11_session_grab_i420_damage((struct x11_session*) (intptr_t) session, (uint8_t*) data, x, y, width, height, outputWidth, outputHeight, rectsBuf, rectsLength);
+  if(ret > 0)
+  {
+    (*env)->SetIntArrayRegion(env, rects, 0, ret * 4, rectsBuf);
+  }
+#endif
+
+  return ret;
+}
+
+/**
+ * \brief JNI native method to grab several regions of desktop screen (e.g.
+ * the monitors of a multi-monitor setup) in parallel in a screen capture
+ * session and stitch their ARGB pixels into one buffer.
+ * \param env JVM environment
+ * \param clazz ScreenCapture Java class
+ * \param session session pointer
+ * \param regions x, y, width and height of each region on the screen followed
+ * by its x and y position in output
+ * \param output native output buffer
+ * \param outputLength native output length
+ * \param outputWidth width in pixels of output
+ * \param times array that will contain the duration in nanoseconds of the
+ * grab of each region or NULL
+ * \return true if success, false otherwise
+ */
+JNIEXPORT jboolean JNICALL
+Java_org_jitsi_impl_neomedia_imgstreaming_ScreenCapture_grabSessionRegions
+    (JNIEnv* env, jclass clazz, jlong session, jintArray regions, jlong output, jint outputLength, jint outputWidth, jlongArray times)
+{
+  jbyte* data = (jbyte*) (intptr_t) output;
+  jint regionsBuf[REGIONS_MAX * 6];
+  jlong timesBuf[REGIONS_MAX];
+  jint count = 0;
+
+  /* not used */
+  clazz = clazz;
+
+  if(!session || !data || outputLength <= 0 || !regions)
+  {
+    return JNI_FALSE;
+  }
+
+  count = (*env)->GetArrayLength(env, regions) / 6;
+  if(count < 1 || count > REGIONS_MAX
+      || (times && (*env)->GetArrayLength(env, times) < count))
+  {
+    return JNI_FALSE;
+  }
+  (*env)->GetIntArrayRegion(env, regions, 0, count * 6, regionsBuf);
+
+#if defined (_WIN32) || defined(_WIN64) || defined(__APPLE__)
+  outputWidth = outputWidth;
+  timesBuf[0] = 0;
+  return JNI_FALSE;
+#else /* Unix */
+  if(x11_session_grab_regions((struct x11_session*) (intptr_t) session, regionsBuf, count, data, (size_t) outputLength, outputWidth, timesBuf) == -1)
+  {
+    return JNI_FALSE;
+  }
+  if(times)
+  {
+    (*env)->SetLongArrayRegion(env, times, 0, count, timesBuf);
+  }
 
   return JNI_TRUE;
+#endif
+}
+
+/**
+ * \brief JNI native method to set whether the cursor is drawn into the grabs
+ * of a screen capture session.
+ * \param env JVM environment
+ * \param clazz ScreenCapture Java class
+ * \param session session pointer
+ * \param drawCursor whether the cursor is to be drawn
+ */
+JNIEXPORT void JNICALL
+Java_org_jitsi_impl_neomedia_imgstreaming_ScreenCapture_setSessionCursor
+    (JNIEnv* env, jclass clazz, jlong session, jboolean drawCursor)
+{
+  /* not used */
+  env = env;
+  clazz = clazz;
+
+#if defined (_WIN32) || defined(_WIN64) || defined(__APPLE__)
+  session = session;
+  drawCursor = drawCursor;
+#else /* Unix */
+  if(session)
+  {
+    ((struct x11_session*) (intptr_t) session)->draw_cursor = (drawCursor == JNI_TRUE);
+  }
+#endif
+}
+
+/**
+ * \brief JNI native method to close a screen capture session.
+ * \param env JVM environment
+ * \param clazz ScreenCapture Java class
+ * \param session session pointer
+ */
+JNIEXPORT void JNICALL
+Java_org_jitsi_impl_neomedia_imgstreaming_ScreenCapture_closeSession
+    (JNIEnv* env, jclass clazz, jlong session)
+{
+  /* not used */
+  env = env;
+  clazz = clazz;
+
+#if defined (_WIN32) || defined(_WIN64) || defined(__APPLE__)
+  session = session;
+#else /* Unix */
+  if(session)
+  {
+    x11_session_close((struct x11_session*) (intptr_t) session);
+  }
+#endif
 }
@@ -7,6 +7,14 @@
 #ifdef __cplusplus
 extern "C" {
 #endif
+/*
+ * Class:     org_jitsi_impl_neomedia_imgstreaming_ScreenCapture
+ * Method:    closeSession
+ * Signature: (J)V
+ */
+JNIEXPORT void JNICALL Java_org_jitsi_impl_neomedia_imgstreaming_ScreenCapture_closeSession
+  (JNIEnv *, jclass, jlong);
+
 /*
  * Class:     org_jitsi_impl_neomedia_imgstreaming_ScreenCapture
  * Method:    grabScreen
@@ -18,10 +26,58 @@ JNIEXPORT jboolean JNICALL Java_org_jitsi_impl_neomedia_imgstreaming_ScreenCaptu
 /*
  * Class:     org_jitsi_impl_neomedia_imgstreaming_ScreenCapture
  * Method:    grabScreen
- * Signature: (IIIIJI)Z
+ * Signature: (IIIIIJI)Z
+ */
+JNIEXPORT jboolean JNICALL Java_org_jitsi_impl_neomedia_imgstreaming_ScreenCapture_grabScreen__IIIIIJI
+  (JNIEnv *, jclass, jint, jint, jint, jint, jint, jlong, jint);
+
+/*
+ * Class:     org_jitsi_impl_neomedia_imgstreaming_ScreenCapture
+ * Method:    grabSession
+ * Signature: (JIIIIJI)Z
+ */
+JNIEXPORT jboolean JNICALL Java_org_jitsi_impl_neomedia_imgstreaming_ScreenCapture_grabSession
+  (JNIEnv *, jclass, jlong, jint, jint, jint, jint, jlong, jint);
+
+/*
+ * Class:     org_jitsi_impl_neomedia_imgstreaming_ScreenCapture
+ * Method:    grabSessionDamage
+ * Signature: (JIIIIJI[I)I
+ */
+JNIEXPORT jint JNICALL Java_org_jitsi_impl_neomedia_imgstreaming_ScreenCapture_grabSessionDamage
+  (JNIEnv *, jclass, jlong, jint, jint, jint, jint, jlong, jint, jintArray);
+
+/*
+ * Class:     org_jitsi_impl_neomedia_imgstreaming_ScreenCapture
+ * Method:    grabSessionI420
+ * Signature: (JIIIIJIII[I)I
+ */
+JNIEXPORT jint JNICALL Java_org_jitsi_impl_neomedia_imgstreaming_ScreenCapture_grabSessionI420
+  (JNIEnv *, jclass, jlong, jint, jint, jint, jint, jlong, jint, jint, jint, jintArray);
+
+/*
+ * Class:     org_jitsi_impl_neomedia_imgstreaming_ScreenCapture
+ * Method:    grabSessionRegions
+ * Signature: (J[IJII[J)Z
+ */
+JNIEXPORT jboolean JNICALL Java_org_jitsi_impl_neomedia_imgstreaming_ScreenCapture_grabSessionRegions
+  (JNIEnv *, jclass, jlong, jintArray, jlong, jint, jint, jlongArray);
+
+/*
+ * Class:     org_jitsi_impl_neomedia_imgstreaming_ScreenCapture
+ * Method:    openSession
+ * Signature: (I)J
+ */
+JNIEXPORT jlong JNICALL Java_org_jitsi_impl_neomedia_imgstreaming_ScreenCapture_openSession
+  (JNIEnv *, jclass, jint);
+
+/*
+ * Class:     org_jitsi_impl_neomedia_imgstreaming_ScreenCapture
+ * Method:    setSessionCursor
+ * Signature: (JZ)V
  */
-JNIEXPORT jboolean JNICALL Java_org_jitsi_impl_neomedia_imgstreaming_ScreenCapture_grabScreen__IIIIJI
-  (JNIEnv *, jclass, jint, jint, jint, jint, jlong, jint);
+JNIEXPORT void JNICALL Java_org_jitsi_impl_neomedia_imgstreaming_ScreenCapture_setSessionCursor
+  (JNIEnv *, jclass, jlong, jboolean);
 
 #ifdef __cplusplus
 }
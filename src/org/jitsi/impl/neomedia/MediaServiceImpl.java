@@ -92,6 +92,16 @@ public class MediaServiceImpl
     private static final String DYNAMIC_PAYLOAD_TYPE_PREFERENCES_PNAME_PREFIX
         = "net.java.sip.communicator.impl.neomedia.dynamicPayloadTypePreferences";
 
+    /**
+     * The name of the <tt>boolean</tt> <tt>ConfigurationService</tt> property
+     * which indicates whether the remote videos of all streams are to be
+     * rendered together into a single gallery <tt>Component</tt> (with a
+     * single Xv port) rather than each into its own <tt>Component</tt>. The
+     * default value is <tt>false</tt>. Supported on Linux only.
+     */
+    public static final String ENABLE_VIDEO_GALLERY_PNAME
+        = "net.java.sip.communicator.impl.neomedia.video.GALLERY";
+
     /**
      * The value of the <tt>devices</tt> property of <tt>MediaServiceImpl</tt>
      * when no <tt>MediaDevice</tt>s are available. Explicitly defined in order
@@ -1618,6 +1628,28 @@ public class MediaServiceImpl
                 && !Boolean.getBoolean(propertyName);
     }
 
+    /**
+     * Determines whether the remote videos of all streams are to be rendered
+     * together into a single gallery <tt>Component</tt>. The
+     * <tt>ConfigurationService</tt> and <tt>System</tt> property
+     * {@link #ENABLE_VIDEO_GALLERY_PNAME} enables the gallery.
+     *
+     * @return <tt>true</tt> if the remote videos are to be rendered into a
+     * single gallery <tt>Component</tt>; otherwise, <tt>false</tt>
+     */
+    public static boolean isVideoGalleryEnabled()
+    {
+        if (!OSUtils.IS_LINUX)
+            return false;
+
+        ConfigurationService cfg = LibJitsi.getConfigurationService();
+
+        return
+            ((cfg != null)
+                    && cfg.getBoolean(ENABLE_VIDEO_GALLERY_PNAME, false))
+                || Boolean.getBoolean(ENABLE_VIDEO_GALLERY_PNAME);
+    }
+
     /**
      * The listener which will be notified for changes in the video container.
      * Whether the container is displayable or not we will stop the player
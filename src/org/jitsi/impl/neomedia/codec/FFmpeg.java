@@ -51,6 +51,12 @@ public class FFmpeg
      */
     public static final int CODEC_FLAG2_CHUNKS = 0x00008000;
 
+    /**
+     * The flag which allows speedups of a decoder which are not compliant
+     * with the specification.
+     */
+    public static final int CODEC_FLAG2_FAST = 0x00000001;
+
     /**
      * Intra refresh flag2.
      */
@@ -121,6 +127,18 @@ public class FFmpeg
      */
     public static final int FF_PROFILE_H264_HIGH = 100;
 
+    /**
+     * The <tt>thread_type</tt> which decodes more than one frame at once and
+     * adds a frame of delay per thread.
+     */
+    public static final int FF_THREAD_FRAME = 1;
+
+    /**
+     * The <tt>thread_type</tt> which decodes more than one part of a single
+     * frame at once and adds no delay.
+     */
+    public static final int FF_THREAD_SLICE = 2;
+
     /**
      * ARGB format.
      */
@@ -331,6 +349,18 @@ public class FFmpeg
     public static native int avcodec_encode_video(long ctx, byte[] buff,
         int buf_size, long frame);
 
+    /**
+     * Encode a video frame into native memory.
+     *
+     * @param ctx codec context
+     * @param buf a pointer to the output buffer
+     * @param buf_size output buffer size
+     * @param frame frame to encode
+     * @return number of bytes written to buf if success
+     */
+    public static native int avcodec_encode_video(long ctx, long buf,
+        int buf_size, long frame);
+
     /**
      * Find a registered decoder with a matching ID.
      *
@@ -610,6 +640,17 @@ public class FFmpeg
     public static native void avcodeccontext_set_thread_count(long ctx,
         int thread_count);
 
+    /**
+     * Sets the multithreading methods which a codec may use e.g.
+     * {@link #FF_THREAD_SLICE}.
+     *
+     * @param ctx the <tt>AVCodecContext</tt> to set the multithreading methods
+     * of
+     * @param thread_type a combination of the <tt>FF_THREAD_</tt> flags
+     */
+    public static native void avcodeccontext_set_thread_type(long ctx,
+        int thread_type);
+
     public static native void avcodeccontext_set_ticks_per_frame(long ctx,
         int ticks_per_frame);
 
@@ -694,8 +735,48 @@ public class FFmpeg
      */
     public static native void avfilter_unref_buffer(long ref);
 
+    /**
+     * Gets a pointer to a specific plane of the picture of an
+     * <tt>AVFrame</tt>.
+     *
+     * @param frame a pointer to the <tt>AVFrame</tt>
+     * @param plane the index of the plane (e.g. <tt>0</tt> for the Y plane of
+     * a <tt>PIX_FMT_YUV420P</tt> picture)
+     * @return a pointer to the specified plane of the picture of
+     * <tt>frame</tt>
+     */
+    public static native long avframe_get_data(long frame, int plane);
+
+    /**
+     * Gets the size in bytes of a line of a specific plane of the picture of
+     * an <tt>AVFrame</tt>.
+     *
+     * @param frame a pointer to the <tt>AVFrame</tt>
+     * @param plane the index of the plane
+     * @return the size in bytes of a line of the specified plane of the
+     * picture of <tt>frame</tt>
+     */
+    public static native int avframe_get_linesize(long frame, int plane);
+
     public static native long avframe_get_pts(long frame);
 
+    /**
+     * Makes an <tt>AVFrame</tt> reference the picture of another
+     * <tt>AVFrame</tt> which has been decoded into (or references) a frame
+     * pool installed with {@link #framepool_install(long, long)}. The picture
+     * stays valid and unchanged until the reference is dropped with
+     * {@link #avframe_unref(long)} regardless of the decoding of subsequent
+     * pictures. Whatever <tt>dst</tt> referenced before is dropped.
+     *
+     * @param dst a pointer to the <tt>AVFrame</tt> to reference the picture of
+     * <tt>src</tt>
+     * @param src a pointer to the <tt>AVFrame</tt> the picture of which is to
+     * be referenced
+     * @return <tt>true</tt> if <tt>dst</tt> references the picture of
+     * <tt>src</tt>; <tt>false</tt> if the picture of <tt>src</tt> is not pooled
+     */
+    public static native boolean avframe_ref(long dst, long src);
+
     public static native void avframe_set_data(
             long frame,
             long data0, long offset1, long offset2);
@@ -708,21 +789,138 @@ public class FFmpeg
             long frame,
             int linesize0, int linesize1, int linesize2);
 
+    /**
+     * Drops the reference to a pooled picture made by
+     * {@link #avframe_ref(long, long)} (if any) and resets an <tt>AVFrame</tt>
+     * to its defaults. The picture returns to its pool once its last reference
+     * is dropped. May be invoked on any thread.
+     *
+     * @param frame a pointer to the <tt>AVFrame</tt> to drop the reference of
+     */
+    public static native void avframe_unref(long frame);
+
     public static native int avpicture_fill(long picture, long ptr,
         int pix_fmt, int width, int height);
 
+    /**
+     * Allocates a new pool of aligned, reference-counted picture buffers for
+     * a video decoder.
+     *
+     * @return a pointer to the new frame pool or <tt>0</tt> on failure
+     */
+    public static native long framepool_alloc();
+
+    /**
+     * Frees a frame pool allocated by {@link #framepool_alloc()}. The pictures
+     * which are still referenced are freed when their references are dropped.
+     * The codec the pool is installed into is to be closed first.
+     *
+     * @param pool a pointer to the frame pool to free
+     */
+    public static native void framepool_free(long pool);
+
+    /**
+     * Installs a frame pool as the allocator of the pictures of a video
+     * decoder so that the decoded pictures may be referenced with
+     * {@link #avframe_ref(long, long)} instead of being copied. It is to be
+     * invoked before {@link #avcodec_open2(long, long, String[])}. Decoders
+     * which do not support direct rendering keep the default allocator.
+     *
+     * @param pool a pointer to the frame pool to install
+     * @param ctx a pointer to the <tt>AVCodecContext</tt> of the decoder
+     */
+    public static native void framepool_install(long pool, long ctx);
+
     public static native long get_filtered_video_frame(
             long input, int width, int height, int pixFmt,
             long buffer,
             long ffsink,
             long output);
 
+    /**
+     * Packetizes the NAL units of a H.264 byte stream into RTP payloads in
+     * accord with RFC 6184 "RTP Payload Format for H.264 Video". A NAL unit
+     * which does not fit into a payload is fragmented into FU-A payloads of
+     * <tt>maxPayloadSize</tt> bytes each (the last one padded with zeros). If
+     * <tt>aggregate</tt>, consecutive NAL units which fit into a payload
+     * together are aggregated into a STAP-A payload.
+     *
+     * @param src the H.264 byte stream to packetize
+     * @param srcOffset the offset in <tt>src</tt> of the byte stream
+     * @param srcLength the length in bytes of the byte stream
+     * @param maxPayloadSize the maximum size in bytes of a payload
+     * @param aggregate <tt>true</tt> to aggregate NAL units into STAP-A
+     * payloads (which is only allowed in packetization-mode 1)
+     * @param packets the array to write the payloads into one after the other
+     * @param payloadLengths the array to write the lengths of the payloads into
+     * @return the number of payloads written into <tt>packets</tt> or
+     * <tt>-1</tt> if <tt>packets</tt> or <tt>payloadLengths</tt> is too small
+     */
+    public static native int h264_packetize(
+            byte[] src, int srcOffset, int srcLength,
+            int maxPayloadSize, boolean aggregate,
+            byte[] packets, int[] payloadLengths);
+
+    /**
+     * Converts an image in one of the pixel formats <tt>PIX_FMT_NV12</tt>,
+     * <tt>PIX_FMT_RGB32</tt>, <tt>PIX_FMT_UYVY422</tt> or
+     * <tt>PIX_FMT_YUYV422</tt> into <tt>PIX_FMT_YUV420P</tt> either at the same
+     * size or downscaled by 2:1 in both dimensions, using SIMD where available.
+     *
+     * @param src source image (native <tt>AVPicture</tt> pointer)
+     * @param srcFormat source format
+     * @param srcW width of source image
+     * @param srcH height of source image
+     * @param dst destination image (java type)
+     * @param dstW width of destination image
+     * @param dstH height of destination image
+     * @return 0 if success, -1 if the conversion is not supported and is to
+     * be carried out by {@link #sws_scale(long, long, int, int, Object, int,
+     * int, int)}
+     */
+    public static native int i420_convert(
+        long src, int srcFormat, int srcW, int srcH,
+        Object dst, int dstW, int dstH);
+
+    /**
+     * Converts an image in one of the pixel formats <tt>PIX_FMT_NV12</tt>,
+     * <tt>PIX_FMT_RGB32</tt>, <tt>PIX_FMT_UYVY422</tt> or
+     * <tt>PIX_FMT_YUYV422</tt> into <tt>PIX_FMT_YUV420P</tt> either at the same
+     * size or downscaled by 2:1 in both dimensions, using SIMD where available.
+     *
+     * @param src source image (java type)
+     * @param srcFormat source format
+     * @param srcW width of source image
+     * @param srcH height of source image
+     * @param dst destination image (java type)
+     * @param dstW width of destination image
+     * @param dstH height of destination image
+     * @return 0 if success, -1 if the conversion is not supported and is to
+     * be carried out by {@link #sws_scale(long, Object, int, int, int, int,
+     * int, Object, int, int, int)}
+     */
+    public static native int i420_convert(
+        Object src, int srcFormat, int srcW, int srcH,
+        Object dst, int dstW, int dstH);
+
+    public static native void memcpy(byte[] dst, int dst_offset,
+        int dst_length, long src);
+
     public static native void memcpy(int[] dst, int dst_offset, int dst_length,
         long src);
 
     public static native void memcpy(long dst, byte[] src, int src_offset,
         int src_length);
 
+    /**
+     * Gets the native <tt>MJPEGDecoder</tt> through which native code outside
+     * of this library (e.g. the Video for Linux Two API Specification capture
+     * engine) decodes Motion JPEG into I420 with FFmpeg.
+     *
+     * @return a pointer to the native <tt>MJPEGDecoder</tt>
+     */
+    public static native long mjpeg_decoder();
+
     /**
      * Get BGR32 pixel format.
      *
@@ -140,6 +140,7 @@ public class AVFrame
     {
         if (free && (ptr != 0))
         {
+            FFmpeg.avframe_unref(ptr);
             FFmpeg.avcodec_free_frame(ptr);
             free = false;
             ptr = 0;
@@ -175,4 +176,45 @@ public class AVFrame
     {
         return ptr;
     }
+
+    /**
+     * Makes this <tt>AVFrame</tt> reference the pooled picture of another
+     * <tt>AVFrame</tt> (e.g. the one a decoder has just decoded into) so that
+     * the picture may be kept past the decoding of the next one without
+     * copying it. Whatever this <tt>AVFrame</tt> referenced or had set on it
+     * before is dropped.
+     *
+     * @param src the <tt>AVFrame</tt> the picture of which is to be referenced
+     * @return <tt>true</tt> if this <tt>AVFrame</tt> references the picture of
+     * <tt>src</tt>; <tt>false</tt> if the picture of <tt>src</tt> is not pooled
+     * (and, consequently, has to be copied in order to be kept)
+     * @see FFmpeg#avframe_ref(long, long)
+     */
+    public synchronized boolean ref(AVFrame src)
+    {
+        if ((ptr == 0) || !free)
+            return false;
+
+        long srcPtr = src.getPtr();
+
+        if ((srcPtr == 0) || !FFmpeg.avframe_ref(ptr, srcPtr))
+            return false;
+
+        if (data != null)
+        {
+            data.free();
+            data = null;
+        }
+        return true;
+    }
+
+    /**
+     * Drops the reference to a pooled picture made by {@link #ref(AVFrame)}
+     * (if any) so that the picture may return to its pool.
+     */
+    public synchronized void unref()
+    {
+        if (free && (ptr != 0))
+            FFmpeg.avframe_unref(ptr);
+    }
 }
@@ -184,6 +184,14 @@ public class SwScale
     private final FrameProcessingControlImpl frameProcessingControl
         = new FrameProcessingControlImpl();
 
+    /**
+     * The indicator which determines whether conversions to YUV420P are to be
+     * attempted with {@link FFmpeg#i420_convert(long, int, int, int, Object,
+     * int, int)} before swscale. Cleared if the FFmpeg JNI library is
+     * out-of-date.
+     */
+    private boolean i420Convert = true;
+
     /**
      * The indicator which determines whether this instance is to preserve the
      * aspect ratio of the video frames provided to this instance as input to be
@@ -596,26 +604,56 @@ public class SwScale
             srcPicture = 0;
         }
 
-        swsContext
-            = FFmpeg.sws_getCachedContext(
-                    swsContext,
-                    inWidth, inHeight, srcFmt,
-                    outWidth, outHeight, dstFmt,
-                    FFmpeg.SWS_BICUBIC);
+        /*
+         * Capture devices commonly deliver YUYV, UYVY, NV12 or RGB32 which the
+         * encoders want in YUV420P at the same size or at half of it. The SIMD
+         * converter handles these much faster than swscale which remains the
+         * fallback for everything else.
+         */
+        int converted = -1;
 
-        if (srcPicture == 0)
+        if (i420Convert && (dstFmt == FFmpeg.PIX_FMT_YUV420P))
         {
-            FFmpeg.sws_scale(
-                    swsContext,
-                    src, srcFmt, inWidth, inHeight, 0, inHeight,
-                    dst, dstFmt, outWidth, outHeight);
+            try
+            {
+                converted
+                    = (srcPicture == 0)
+                        ? FFmpeg.i420_convert(
+                                src, srcFmt, inWidth, inHeight,
+                                dst, outWidth, outHeight)
+                        : FFmpeg.i420_convert(
+                                srcPicture, srcFmt, inWidth, inHeight,
+                                dst, outWidth, outHeight);
+            }
+            catch (UnsatisfiedLinkError ule)
+            {
+                logger.warn("The FFmpeg JNI library is out-of-date.");
+                i420Convert = false;
+            }
         }
-        else
+        if (converted != 0)
         {
-            FFmpeg.sws_scale(
-                    swsContext,
-                    srcPicture, 0, inHeight,
-                    dst, dstFmt, outWidth, outHeight);
+            swsContext
+                = FFmpeg.sws_getCachedContext(
+                        swsContext,
+                        inWidth, inHeight, srcFmt,
+                        outWidth, outHeight, dstFmt,
+                        FFmpeg.SWS_BICUBIC);
+
+            if (srcPicture == 0)
+            {
+                FFmpeg.sws_scale(
+                        swsContext,
+                        src, srcFmt, inWidth, inHeight, 0, inHeight,
+                        dst, dstFmt, outWidth, outHeight);
+            }
+            else
+            {
+                FFmpeg.sws_scale(
+                        swsContext,
+                        srcPicture, 0, inHeight,
+                        dst, dstFmt, outWidth, outHeight);
+            }
         }
 
         out.setData(dst);
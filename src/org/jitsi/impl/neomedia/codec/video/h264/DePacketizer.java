@@ -319,6 +319,107 @@ public class DePacketizer
         return BUFFER_PROCESSED_OK;
     }
 
+    /**
+     * Extracts the NAL units aggregated in a specific STAP-A RTP packet
+     * payload.
+     *
+     * @param in the payload of the RTP packet from which the aggregated NAL
+     * units are to be extracted
+     * @param inOffset the offset in <tt>in</tt> at which the payload begins
+     * @param inLength the length of the payload in <tt>in</tt> beginning at
+     * <tt>inOffset</tt>
+     * @param outBuffer the <tt>Buffer</tt> which is to receive the extracted
+     * NAL units
+     * @return the flags such as <tt>BUFFER_PROCESSED_OK</tt> and
+     * <tt>OUTPUT_BUFFER_NOT_FILLED</tt> to be returned by
+     * {@link #process(Buffer, Buffer)}
+     */
+    private int dePacketizeSTAPA(
+            byte[] in, int inOffset, int inLength,
+            Buffer outBuffer)
+    {
+        // Skip the STAP-A NAL HDR.
+        int begin = inOffset + 1;
+        int end = inOffset + inLength;
+        int newOutLength = 0;
+
+        /*
+         * Validate the NALU Sizes and compute the length of the output (in
+         * which each aggregated NAL unit is preceded by NAL_PREFIX instead of
+         * its NALU Size).
+         */
+        int i = begin;
+
+        while (i + 2 <= end)
+        {
+            int naluSize = ((in[i] & 0xFF) << 8) | (in[i + 1] & 0xFF);
+
+            i += 2;
+            if ((naluSize < 1) || (naluSize > end - i))
+            {
+                newOutLength = 0;
+                break;
+            }
+            newOutLength += NAL_PREFIX.length + naluSize;
+            i += naluSize;
+        }
+        if ((i != end) || (newOutLength == 0))
+        {
+            outBuffer.setDiscard(true);
+            return BUFFER_PROCESSED_OK;
+        }
+
+        int outOffset = outBuffer.getOffset();
+        byte[] out
+            = validateByteArraySize(
+                outBuffer,
+                outOffset + newOutLength + outputPaddingSize,
+                true);
+        int nal_unit_type = UNSPECIFIED_NAL_UNIT_TYPE;
+
+        for (i = begin; i < end;)
+        {
+            int naluSize = ((in[i] & 0xFF) << 8) | (in[i + 1] & 0xFF);
+
+            i += 2;
+
+            /*
+             * Report the aggregated nal_unit_type which matters the most to
+             * the key frame-related logic i.e. an IDR picture over a parameter
+             * set over anything else.
+             */
+            int naluType = in[i] & 0x1F;
+
+            switch (nal_unit_type)
+            {
+            case 5 /* Coded slice of an IDR picture */:
+                break;
+            case 7 /* Sequence parameter set */:
+            case 8 /* Picture parameter set */:
+                if (naluType == 5)
+                    nal_unit_type = naluType;
+                break;
+            default:
+                nal_unit_type = naluType;
+                break;
+            }
+
+            System.arraycopy(NAL_PREFIX, 0, out, outOffset, NAL_PREFIX.length);
+            outOffset += NAL_PREFIX.length;
+
+            System.arraycopy(in, i, out, outOffset, naluSize);
+            outOffset += naluSize;
+            i += naluSize;
+        }
+        this.nal_unit_type = nal_unit_type;
+
+        padOutput(out, outOffset);
+
+        outBuffer.setLength(newOutLength);
+
+        return BUFFER_PROCESSED_OK;
+    }
+
     /**
      * Close the <tt>Codec</tt>.
      */
@@ -463,6 +564,14 @@ public class DePacketizer
             if (outBuffer.isDiscard())
                 fuaStartedAndNotEnded = false;
         }
+        else if (nal_unit_type == 24) // STAP-A Single-time aggregation packet
+        {
+            fuaStartedAndNotEnded = false;
+            ret
+                = dePacketizeSTAPA(
+                    in, inOffset, inBuffer.getLength(),
+                    outBuffer);
+        }
         else
         {
             logger.warn(
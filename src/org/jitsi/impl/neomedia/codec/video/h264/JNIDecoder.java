@@ -15,8 +15,11 @@ import net.sf.fmj.media.*;
 
 import org.jitsi.impl.neomedia.codec.*;
 import org.jitsi.impl.neomedia.codec.video.*;
+import org.jitsi.service.configuration.*;
+import org.jitsi.service.libjitsi.*;
 import org.jitsi.service.neomedia.codec.*;
 import org.jitsi.service.neomedia.control.*;
+import org.jitsi.util.*;
 
 /**
  * Decodes H.264 NAL units and returns the resulting frames as FFmpeg
@@ -35,11 +38,51 @@ public class JNIDecoder
     private static final VideoFormat[] DEFAULT_OUTPUT_FORMATS
         = new VideoFormat[] { new AVFrameFormat(FFmpeg.PIX_FMT_YUV420P) };
 
+    /**
+     * The default value of the {@link #THREAD_COUNT_PNAME}
+     * <tt>ConfigurationService</tt> property i.e. have FFmpeg choose the
+     * number of threads by the number of processors and the size of the
+     * video.
+     */
+    public static final int DEFAULT_THREAD_COUNT = 0;
+
+    /**
+     * The name of the boolean <tt>ConfigurationService</tt> property which
+     * specifies whether the decoder is to apply speedups which are not
+     * compliant with the specification (i.e. <tt>flags2 +fast</tt>). The
+     * default value is <tt>false</tt>.
+     */
+    public static final String FAST_PNAME
+        = "org.jitsi.impl.neomedia.codec.video.h264.decoder.fast";
+
+    /**
+     * The zeros written after the encoded media data in {@link #inputBuffer}
+     * in order to prevent the (optimized) bitstream readers of FFmpeg from
+     * reading past the end of the input or from mistaking stale data for it.
+     */
+    private static final byte[] INPUT_BUFFER_PADDING
+        = new byte[FFmpeg.FF_INPUT_BUFFER_PADDING_SIZE];
+
+    /**
+     * The logger used by the <tt>JNIDecoder</tt> class and its instances for
+     * logging output.
+     */
+    private static final Logger logger = Logger.getLogger(JNIDecoder.class);
+
     /**
      * Plugin name.
      */
     private static final String PLUGIN_NAME = "H.264 Decoder";
 
+    /**
+     * The name of the integer <tt>ConfigurationService</tt> property which
+     * specifies the number of threads which decode the slices of a frame in
+     * parallel. <tt>1</tt> disables multithreading and <tt>0</tt> has FFmpeg
+     * choose the number of threads.
+     */
+    public static final String THREAD_COUNT_PNAME
+        = "org.jitsi.impl.neomedia.codec.video.h264.decoder.threadCount";
+
     /**
      *  The codec context native pointer we will use.
      */
@@ -52,9 +95,13 @@ public class JNIDecoder
     private AVFrame avframe;
 
     /**
-     * If decoder has got a picture.
+     * The pointer to the native pool of reference-counted picture buffers into
+     * which {@link #avctx} decodes. It allows the decoded pictures to be output
+     * by reference in <tt>AVFrame</tt>s which keep them valid until they are
+     * reused or freed rather than in {@link #avframe} which the next decode
+     * overwrites.
      */
-    private final boolean[] got_picture = new boolean[1];
+    private long framePool;
 
     private boolean gotPictureAtLeastOnce;
 
@@ -64,6 +111,25 @@ public class JNIDecoder
      */
     private int height;
 
+    /**
+     * The native memory into which the encoded media data is copied (followed
+     * by {@link #INPUT_BUFFER_PADDING}) to be decoded. Reused across the
+     * processed <tt>Buffer</tt>s.
+     */
+    private ByteBuffer inputBuffer;
+
+    /**
+     * The number of bytes of the NAL units of the access unit being gathered
+     * in {@link #inputBuffer}.
+     */
+    private int inputLength;
+
+    /**
+     * The time stamp of the NAL units of the access unit being gathered in
+     * {@link #inputBuffer}.
+     */
+    private long inputTimeStamp = Buffer.TIME_UNKNOWN;
+
     /**
      * The <tt>KeyFrameControl</tt> used by this <tt>JNIDecoder</tt> to
      * control its key frame-related logic.
@@ -117,11 +183,23 @@ public class JNIDecoder
             FFmpeg.av_free(avctx);
             avctx = 0;
 
+            if (framePool != 0)
+            {
+                FFmpeg.framepool_free(framePool);
+                framePool = 0;
+            }
+
             if (avframe != null)
             {
                 avframe.free();
                 avframe = null;
             }
+            if (inputBuffer != null)
+            {
+                inputBuffer.free();
+                inputBuffer = null;
+            }
+            inputLength = 0;
 
             gotPictureAtLeastOnce = false;
         }
@@ -219,6 +297,18 @@ public class JNIDecoder
         }
         avframe = new AVFrame();
 
+        ConfigurationService cfg = LibJitsi.getConfigurationService();
+        boolean fast = false;
+        int threadCount = DEFAULT_THREAD_COUNT;
+
+        if (cfg != null)
+        {
+            fast = cfg.getBoolean(FAST_PNAME, fast);
+            threadCount = cfg.getInt(THREAD_COUNT_PNAME, threadCount);
+            if (threadCount < 0)
+                threadCount = DEFAULT_THREAD_COUNT;
+        }
+
         long avcodec = FFmpeg.avcodec_find_decoder(FFmpeg.CODEC_ID_H264);
 
         avctx = FFmpeg.avcodec_alloc_context3(avcodec);
@@ -228,11 +318,42 @@ public class JNIDecoder
         /* allow to pass incomplete frame to decoder */
         FFmpeg.avcodeccontext_add_flags2(avctx,
                 FFmpeg.CODEC_FLAG2_CHUNKS);
+        if (fast)
+            FFmpeg.avcodeccontext_add_flags2(avctx, FFmpeg.CODEC_FLAG2_FAST);
+
+        /*
+         * Decode the slices of a frame in parallel. Unlike frame threading,
+         * slice threading does not delay the output by a frame per thread.
+         */
+        try
+        {
+            FFmpeg.avcodeccontext_set_thread_type(avctx,
+                    FFmpeg.FF_THREAD_SLICE);
+            FFmpeg.avcodeccontext_set_thread_count(avctx, threadCount);
+        }
+        catch (UnsatisfiedLinkError ule)
+        {
+            logger.warn("The FFmpeg JNI library is out-of-date.");
+        }
+
+        /* decode into reference-counted buffers which may outlive a decode */
+        try
+        {
+            framePool = FFmpeg.framepool_alloc();
+            if (framePool != 0)
+                FFmpeg.framepool_install(framePool, avctx);
+        }
+        catch (UnsatisfiedLinkError ule)
+        {
+            logger.warn("The FFmpeg JNI library is out-of-date.");
+            framePool = 0;
+        }
 
         if (FFmpeg.avcodec_open2(avctx, avcodec) < 0)
             throw new RuntimeException("Could not open codec CODEC_ID_H264");
 
         gotPictureAtLeastOnce = false;
+        inputLength = 0;
 
         opened = true;
         super.open();
@@ -257,31 +378,115 @@ public class JNIDecoder
             propagateEOM(out);
             return BUFFER_PROCESSED_OK;
         }
+
+        /*
+         * The DePacketizer outputs a NAL unit at a time. Gather the NAL units
+         * of an access unit (i.e. up to the one with the RTP marker) and decode
+         * them at once so that the slices of a picture may be decoded in
+         * parallel. If the time stamp changes before the RTP marker is seen
+         * (e.g. because the packet which carried it has been lost), decode the
+         * NAL units gathered so far and have in processed again.
+         */
+        boolean marker = ((in.getFlags() & Buffer.FLAG_RTP_MARKER) != 0);
+        long timeStamp = in.getTimeStamp();
+        boolean flush
+            = (inputLength > 0)
+                && (timeStamp != Buffer.TIME_UNKNOWN)
+                && (inputTimeStamp != Buffer.TIME_UNKNOWN)
+                && (timeStamp != inputTimeStamp);
+
         if (in.isDiscard())
         {
-            out.setDiscard(true);
-            return BUFFER_PROCESSED_OK;
+            if (!flush && !(marker && (inputLength > 0)))
+            {
+                out.setDiscard(true);
+                return BUFFER_PROCESSED_OK;
+            }
+        }
+        else if (!flush)
+        {
+            /*
+             * Copy the encoded media data into native memory once, padded as
+             * required by FFmpeg, rather than have the whole byte array copied
+             * into and back out of native memory around the decoding.
+             */
+            int inLength = in.getLength();
+            int inputCapacity
+                = inputLength + inLength + INPUT_BUFFER_PADDING.length;
+
+            if ((inputBuffer == null)
+                    || (inputBuffer.getCapacity() < inputCapacity))
+            {
+                ByteBuffer newInputBuffer;
+
+                if (inputBuffer == null)
+                    newInputBuffer = new ByteBuffer(inputCapacity);
+                else
+                {
+                    newInputBuffer
+                        = new ByteBuffer(
+                                Math.max(
+                                        inputCapacity,
+                                        2 * inputBuffer.getCapacity()));
+                    if (inputLength > 0)
+                    {
+                        byte[] gathered = new byte[inputLength];
+
+                        FFmpeg.memcpy(
+                                gathered, 0, inputLength,
+                                inputBuffer.getPtr());
+                        FFmpeg.memcpy(
+                                newInputBuffer.getPtr(),
+                                gathered, 0, inputLength);
+                    }
+                    inputBuffer.free();
+                }
+                inputBuffer = newInputBuffer;
+            }
+
+            FFmpeg.memcpy(
+                    inputBuffer.getPtr() + inputLength,
+                    (byte[]) in.getData(), in.getOffset(), inLength);
+            inputLength += inLength;
+            inputTimeStamp = timeStamp;
+
+            if (!marker)
+            {
+                out.setDiscard(true);
+                return BUFFER_PROCESSED_OK;
+            }
         }
 
+        long input = inputBuffer.getPtr();
+        int length = inputLength;
+        int processed
+            = flush
+                ? (BUFFER_PROCESSED_OK | INPUT_BUFFER_NOT_CONSUMED)
+                : BUFFER_PROCESSED_OK;
+
+        inputLength = 0;
+        FFmpeg.memcpy(
+                input + length,
+                INPUT_BUFFER_PADDING, 0, INPUT_BUFFER_PADDING.length);
+
         // Ask FFmpeg to decode.
-        got_picture[0] = false;
-        // TODO Take into account the offset of inputBuffer.
-        FFmpeg.avcodec_decode_video(
-                avctx,
-                avframe.getPtr(),
-                got_picture,
-                (byte[]) in.getData(), in.getLength());
-
-        if (!got_picture[0])
+        boolean got_picture
+            = (FFmpeg.avcodec_decode_video(
+                        avctx,
+                        avframe.getPtr(),
+                        input, length)
+                    >= 0);
+
+        if (!got_picture)
         {
-            if ((in.getFlags() & Buffer.FLAG_RTP_MARKER) != 0)
+            if (marker && !flush)
             {
                 if (keyFrameControl != null)
                     keyFrameControl.requestKeyFrame(!gotPictureAtLeastOnce);
             }
 
             out.setDiscard(true);
-            return BUFFER_PROCESSED_OK;
+            return processed;
         }
         gotPictureAtLeastOnce = true;
 
@@ -310,8 +515,30 @@ public class JNIDecoder
         out.setFormat(outputFormat);
 
         // data
-        if (out.getData() != avframe)
-            out.setData(avframe);
+        /*
+         * Output a reference to the decoded picture rather than avframe itself
+         * so that the picture stays intact while the Renderer holds it. The
+         * AVFrame of out is reused i.e. it drops the picture it referenced
+         * before. If the picture is not pooled, it is output in avframe as
+         * before.
+         */
+        Object outData = out.getData();
+        AVFrame outFrame
+            = ((outData instanceof AVFrame) && (outData != avframe))
+                ? (AVFrame) outData
+                : null;
+
+        if (framePool != 0)
+        {
+            if (outFrame == null)
+                outFrame = new AVFrame();
+            if (!outFrame.ref(avframe))
+                outFrame = avframe;
+        }
+        else
+            outFrame = avframe;
+        if (outData != outFrame)
+            out.setData(outFrame);
 
         // timeStamp
         long pts = FFmpeg.AV_NOPTS_VALUE; // TODO avframe_get_pts(avframe);
@@ -329,7 +556,19 @@ public class JNIDecoder
             out.setFlags(outFlags);
         }
 
-        return BUFFER_PROCESSED_OK;
+        return processed;
+    }
+
+    /**
+     * Resets the state of this <tt>Codec</tt> i.e. drops the NAL units of the
+     * access unit gathered so far (if any).
+     */
+    @Override
+    public synchronized void reset()
+    {
+        super.reset();
+
+        inputLength = 0;
     }
 
     /**
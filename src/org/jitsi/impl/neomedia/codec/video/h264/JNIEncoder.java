@@ -112,6 +112,21 @@ public class JNIEncoder
         = "net.java.sip.communicator.impl.neomedia.codec.video.h264."
             + "defaultProfile";
 
+    /**
+     * The default value of the {@link #SLICE_MAX_SIZE_PNAME}
+     * <tt>ConfigurationService</tt> property i.e. the size of the RTP payloads
+     * output by the <tt>Packetizer</tt> so that a slice fits into a single RTP
+     * packet rather than being fragmented into FU-As.
+     */
+    public static final int DEFAULT_SLICE_MAX_SIZE
+        = Packetizer.MAX_PAYLOAD_SIZE;
+
+    /**
+     * The default value of the {@link #VBV_BUFFER_FRAMES_PNAME}
+     * <tt>ConfigurationService</tt> property.
+     */
+    public static final int DEFAULT_VBV_BUFFER_FRAMES = 1;
+
     /**
      * The name of the high H.264 (encoding) profile.
      */
@@ -158,6 +173,15 @@ public class JNIEncoder
     public static final String PRESET_PNAME
         = "org.jitsi.impl.neomedia.codec.video.h264.preset";
 
+    /**
+     * The name of the integer <tt>ConfigurationService</tt> property which
+     * specifies the maximum size in bytes of a slice (i.e. the x264
+     * <tt>slice-max-size</tt> option). A value of zero lets x264 make slices
+     * of any size.
+     */
+    public static final String SLICE_MAX_SIZE_PNAME
+        = "org.jitsi.impl.neomedia.codec.video.h264.sliceMaxSize";
+
     /**
      * The list of <tt>Formats</tt> supported by <tt>JNIEncoder</tt> instances
      * as output.
@@ -172,6 +196,17 @@ public class JNIEncoder
                     PACKETIZATION_MODE_FMTP, "1")
         };
 
+    /**
+     * The name of the integer <tt>ConfigurationService</tt> property which
+     * specifies the size in frames (at the average bit rate) of the VBV
+     * (video buffering verifier) buffer of x264. A buffer of a single frame
+     * keeps the size of every frame (e.g. a keyframe) close to the average
+     * and, consequently, spares the network bursts. A value of zero disables
+     * the VBV.
+     */
+    public static final String VBV_BUFFER_FRAMES_PNAME
+        = "org.jitsi.impl.neomedia.codec.video.h264.vbvBufferFrames";
+
     public static final int X264_KEYINT_MAX_INFINITE = 1 << 30;
 
     public static final int X264_KEYINT_MIN_AUTO = 0;
@@ -206,6 +241,14 @@ public class JNIEncoder
      */
     private long avFrame;
 
+    /**
+     * The native buffer into which {@link #avFrame} is encoded. Encoding into
+     * native memory and copying just the encoded bytes into the output
+     * <tt>byte[]</tt> spares the copying of the whole (raw frame-sized) array
+     * into and out of native memory around every encode.
+     */
+    private long encodedFrameBuffer;
+
     /**
      * The indicator which determines whether the generation of a keyframe is to
      * be forced during a subsequent execution of
@@ -326,6 +369,11 @@ public class JNIEncoder
                 FFmpeg.av_free(rawFrameBuffer);
                 rawFrameBuffer = 0;
             }
+            if (encodedFrameBuffer != 0)
+            {
+                FFmpeg.av_free(encodedFrameBuffer);
+                encodedFrameBuffer = 0;
+            }
 
             if (keyFrameRequestee != null)
             {
@@ -512,6 +560,8 @@ public class JNIEncoder
         int keyint = DEFAULT_KEYINT;
         String preset = DEFAULT_PRESET;
         String profile = DEFAULT_DEFAULT_PROFILE;
+        int sliceMaxSize = DEFAULT_SLICE_MAX_SIZE;
+        int vbvBufferFrames = DEFAULT_VBV_BUFFER_FRAMES;
 
         if (cfg != null)
         {
@@ -520,7 +570,14 @@ public class JNIEncoder
             keyint = cfg.getInt(KEYINT_PNAME, keyint);
             preset = cfg.getString(PRESET_PNAME, preset);
             profile = cfg.getString(DEFAULT_PROFILE_PNAME, profile);
+            sliceMaxSize = cfg.getInt(SLICE_MAX_SIZE_PNAME, sliceMaxSize);
+            vbvBufferFrames
+                = cfg.getInt(VBV_BUFFER_FRAMES_PNAME, vbvBufferFrames);
         }
+        if (sliceMaxSize < 0)
+            sliceMaxSize = 0;
+        if (vbvBufferFrames < 0)
+            vbvBufferFrames = 0;
 
         if (additionalCodecSettings != null)
         {
@@ -609,7 +666,14 @@ public class JNIEncoder
         FFmpeg.avcodeccontext_set_me_range(avctx, 16);
         FFmpeg.avcodeccontext_set_me_cmp(avctx, FFmpeg.FF_CMP_CHROMA);
         FFmpeg.avcodeccontext_set_scenechange_threshold(avctx, 40);
-        FFmpeg.avcodeccontext_set_rc_buffer_size(avctx, 10);
+        /*
+         * FFmpeg passes rc_max_rate and rc_buffer_size on to x264 as
+         * vbv-maxrate and vbv-bufsize. Periodic Intra Refresh spreads the
+         * intra-coded macroblocks over a number of frames so the small VBV
+         * buffer does not have to choke keyframes.
+         */
+        FFmpeg.avcodeccontext_set_rc_buffer_size(avctx,
+                (bitRate / frameRate) * vbvBufferFrames);
         FFmpeg.avcodeccontext_set_gop_size(avctx, keyint);
         FFmpeg.avcodeccontext_set_i_quant_factor(avctx, 1f / 1.4f);
 
@@ -650,6 +714,7 @@ public class JNIEncoder
                     "keyint", Integer.toString(keyint),
                     "partitions", "b8x8,i4x4,p8x8",
                     "preset", preset,
+                    "slice-max-size", Integer.toString(sliceMaxSize),
                     "thread_type", "slice",
                     "tune", "zerolatency")
                 < 0)
@@ -661,6 +726,7 @@ public class JNIEncoder
 
         rawFrameLen = (width * height * 3) / 2;
         rawFrameBuffer = FFmpeg.av_malloc(rawFrameLen);
+        encodedFrameBuffer = FFmpeg.av_malloc(rawFrameLen);
         avFrame = FFmpeg.avcodec_alloc_frame();
 
         int sizeInBytes = width * height;
@@ -761,17 +827,49 @@ public class JNIEncoder
             lastKeyFrame++;
 
         // Encode avFrame into the data of outBuffer.
+        int outLength = 0;
+        boolean encoded = false;
+
+        if (encodedFrameBuffer != 0)
+        {
+            try
+            {
+                outLength
+                    = FFmpeg.avcodec_encode_video(
+                            avctx,
+                            encodedFrameBuffer, rawFrameLen,
+                            avFrame);
+                encoded = true;
+            }
+            catch (UnsatisfiedLinkError ule)
+            {
+                logger.warn("The FFmpeg JNI library is out-of-date.");
+                FFmpeg.av_free(encodedFrameBuffer);
+                encodedFrameBuffer = 0;
+            }
+        }
+
         byte[] out
             = AbstractCodec2.validateByteArraySize(
                     outBuffer,
-                    rawFrameLen,
+                    encoded ? Math.max(outLength, 0) : rawFrameLen,
                     false);
-        int outLength
-            = FFmpeg.avcodec_encode_video(avctx, out, out.length, avFrame);
+
+        if (encoded)
+        {
+            if (outLength > 0)
+                FFmpeg.memcpy(out, 0, outLength, encodedFrameBuffer);
+        }
+        else
+        {
+            outLength
+                = FFmpeg.avcodec_encode_video(avctx, out, out.length, avFrame);
+        }
 
         outBuffer.setLength(outLength);
         outBuffer.setOffset(0);
         outBuffer.setTimeStamp(inBuffer.getTimeStamp());
+        outBuffer.setSequenceNumber(inBuffer.getSequenceNumber());
         return BUFFER_PROCESSED_OK;
     }
 
@@ -8,7 +8,6 @@ package org.jitsi.impl.neomedia.codec.video.h264;
 
 import java.awt.*;
 import java.util.*;
-import java.util.List;
 
 import javax.media.*;
 import javax.media.format.*;
@@ -17,7 +16,10 @@ import net.sf.fmj.media.*;
 
 import org.jitsi.impl.neomedia.codec.*;
 import org.jitsi.impl.neomedia.format.*;
+import org.jitsi.service.configuration.*;
+import org.jitsi.service.libjitsi.*;
 import org.jitsi.service.neomedia.codec.*;
+import org.jitsi.util.*;
 
 /**
  * Packetizes H.264 encoded data/NAL units into RTP packets in accord with RFC
@@ -29,6 +31,12 @@ import org.jitsi.service.neomedia.codec.*;
 public class Packetizer
     extends AbstractPacketizer
 {
+    /**
+     * The <tt>Logger</tt> used by the <tt>Packetizer</tt> class and its
+     * instances for logging output.
+     */
+    private static final Logger logger = Logger.getLogger(Packetizer.class);
+
     /**
      * Maximum payload size without the headers.
      */
@@ -53,6 +61,16 @@ public class Packetizer
                     JNIEncoder.PACKETIZATION_MODE_FMTP, "1")
         };
 
+    /**
+     * The name of the <tt>ConfigurationService</tt> property which specifies
+     * whether consecutive NAL units which fit into a single RTP packet together
+     * are to be aggregated into a STAP-A (in packetization-mode 1). Disabled by
+     * default because older versions of the <tt>DePacketizer</tt> drop STAP-A
+     * packets.
+     */
+    public static final String STAP_A_PNAME
+        = "org.jitsi.impl.neomedia.codec.video.h264.stapA";
+
     /**
      * Finds the index in <tt>byteStream</tt> at which the
      * start_code_prefix_one_3bytes of a NAL unit begins.
@@ -86,15 +104,59 @@ public class Packetizer
     }
 
     /**
-     * The list of NAL units to be sent as payload in RTP packets.
+     * The indicator which determines whether consecutive NAL units are to be
+     * aggregated into STAP-A packets.
+     *
+     * @see #STAP_A_PNAME
      */
-    private final List<byte[]> nals = new LinkedList<byte[]>();
+    private boolean aggregate;
 
     /**
-     * The timeStamp of the RTP packets in which <tt>nals</tt> are to be sent.
+     * The timeStamp of the RTP packets in which the payloads in
+     * {@link #packets} are to be sent.
      */
     private long nalsTimeStamp;
 
+    /**
+     * The indicator which determines whether {@link #packets} is to be filled
+     * by {@link FFmpeg#h264_packetize(byte[], int, int, int, boolean, byte[],
+     * int[])}. Cleared if the FFmpeg JNI library is out-of-date.
+     */
+    private boolean nativePacketize = true;
+
+    /**
+     * The RTP payloads (i.e. the NAL units, FU-As and STAP-As) to be sent, one
+     * after the other. Reused across the processed frames. The output
+     * <tt>Buffer</tt>s refer to it rather than to copies of the payloads so
+     * each one is to be consumed before the next one is processed.
+     */
+    private byte[] packets = new byte[0];
+
+    /**
+     * The number of bytes in {@link #packets} occupied by RTP payloads.
+     */
+    private int packetsLength;
+
+    /**
+     * The number of RTP payloads in {@link #packets}.
+     */
+    private int payloadCount;
+
+    /**
+     * The index in {@link #payloadLengths} of the next RTP payload to be sent.
+     */
+    private int payloadIndex;
+
+    /**
+     * The lengths of the RTP payloads in {@link #packets}.
+     */
+    private int[] payloadLengths = new int[16];
+
+    /**
+     * The offset in {@link #packets} of the next RTP payload to be sent.
+     */
+    private int payloadOffset;
+
     /**
      * The sequence number of the next RTP packet to be output by this
      * <tt>Packetizer</tt>.
@@ -114,6 +176,40 @@ public class Packetizer
         outputFormat = null;
     }
 
+    /**
+     * Appends a RTP payload of a specific length to {@link #packets}.
+     *
+     * @param length the length of the RTP payload to append
+     * @return the offset in <tt>packets</tt> at which the RTP payload is to be
+     * written
+     */
+    private int addPayload(int length)
+    {
+        int offset = packetsLength;
+
+        if (offset + length > packets.length)
+        {
+            byte[] newPackets
+                = new byte[Math.max(2 * packets.length, offset + length)];
+
+            System.arraycopy(packets, 0, newPackets, 0, offset);
+            packets = newPackets;
+        }
+        if (payloadCount == payloadLengths.length)
+        {
+            int[] newPayloadLengths = new int[2 * payloadLengths.length];
+
+            System.arraycopy(
+                    payloadLengths, 0,
+                    newPayloadLengths, 0,
+                    payloadCount);
+            payloadLengths = newPayloadLengths;
+        }
+        payloadLengths[payloadCount++] = length;
+        packetsLength += length;
+        return offset;
+    }
+
     /**
      * Close this <tt>Packetizer</tt>.
      */
@@ -222,9 +318,22 @@ public class Packetizer
     {
         if (!opened)
         {
-            nals.clear();
+            payloadCount = 0;
+            payloadIndex = 0;
+            payloadOffset = 0;
             sequenceNumber = 0;
 
+            ConfigurationService cfg = LibJitsi.getConfigurationService();
+
+            aggregate
+                = (cfg != null)
+                    && cfg.getBoolean(STAP_A_PNAME, false)
+                    && "1".equals(
+                            getPacketizationMode(
+                                    (outputFormat == null)
+                                        ? inputFormat
+                                        : outputFormat));
+
             super.open();
             opened = true;
         }
@@ -242,10 +351,8 @@ public class Packetizer
      * H.264 encoded data to be packetized begins
      * @param nalLength the length in <tt>nal</tt> beginning at
      * <tt>nalOffset</tt> of the NAL unit of H.264 encoded data to be packetized
-     * @return <tt>true</tt> if at least one RTP packet payload has been
-     * packetized i.e. prepared for sending; otherwise, <tt>false</tt>
      */
-    private boolean packetizeNAL(byte[] nal, int nalOffset, int nalLength)
+    private void packetizeNAL(byte[] nal, int nalOffset, int nalLength)
     {
         /*
          * If the NAL fits into a "Single NAL Unit Packet", it's already
@@ -253,10 +360,11 @@ public class Packetizer
          */
         if (nalLength <= MAX_PAYLOAD_SIZE)
         {
-            byte[] singleNALUnitPacket = new byte[nalLength];
-
-            System.arraycopy(nal, nalOffset, singleNALUnitPacket, 0, nalLength);
-            return nals.add(singleNALUnitPacket);
+            System.arraycopy(
+                    nal, nalOffset,
+                    packets, addPayload(nalLength),
+                    nalLength);
+            return;
         }
 
         // Otherwise, split it into "Fragmentation Units (FUs)".
@@ -284,7 +392,6 @@ public class Packetizer
 
         int maxFUPayloadLength
             = MAX_PAYLOAD_SIZE - 2 /* FU indicator & FU header */;
-        boolean nalsAdded = false;
 
         while (nalLength > 0)
         {
@@ -304,21 +411,77 @@ public class Packetizer
              * similar question on the x264-devel mailing list but,
              * unfortunately, it is unanswered.
              */
-            byte[] fua
-                = new byte[
-                        2 /* FU indicator & FU header */ + maxFUPayloadLength];
-
-            fua[0] = fuIndicator;
-            fua[1] = fuHeader;
-            System.arraycopy(nal, nalOffset, fua, 2, fuPayloadLength);
+            int fua
+                = addPayload(
+                        2 /* FU indicator & FU header */ + maxFUPayloadLength);
+
+            packets[fua] = fuIndicator;
+            packets[fua + 1] = fuHeader;
+            System.arraycopy(nal, nalOffset, packets, fua + 2, fuPayloadLength);
+            Arrays.fill(
+                    packets,
+                    fua + 2 + fuPayloadLength,
+                    fua + 2 + maxFUPayloadLength,
+                    (byte) 0);
             nalOffset += fuPayloadLength;
             nalLength -= fuPayloadLength;
 
-            nalsAdded = nals.add(fua) || nalsAdded;
-
             fuHeader &= ~0x80; // Turn off the Start bit.
         }
-        return nalsAdded;
+    }
+
+    /**
+     * Packetizes H.264 encoded data into {@link #packets} in native code which
+     * scans for the start codes of the NAL units with SIMD and writes the RTP
+     * payloads (i.e. Single NAL Unit Packets, FU-As and, if
+     * {@link #aggregate}, STAP-As) straight into <tt>packets</tt>.
+     *
+     * @param data the H.264 encoded data to packetize
+     * @param offset the offset in <tt>data</tt> of the H.264 encoded data
+     * @param length the length of the H.264 encoded data
+     * @return <tt>true</tt> if <tt>data</tt> has been packetized;
+     * <tt>false</tt> if it is to be packetized in Java because the FFmpeg JNI
+     * library is out-of-date
+     */
+    private boolean packetizeNative(byte[] data, int offset, int length)
+    {
+        /*
+         * The FU-As are padded to MAX_PAYLOAD_SIZE so the payloads may be
+         * somewhat larger than the encoded data.
+         */
+        int minCapacity = length + length / 16 + 2 * MAX_PAYLOAD_SIZE;
+
+        if (packets.length < minCapacity)
+            packets = new byte[minCapacity];
+
+        int count;
+
+        do
+        {
+            try
+            {
+                count
+                    = FFmpeg.h264_packetize(
+                            data, offset, length,
+                            MAX_PAYLOAD_SIZE, aggregate,
+                            packets, payloadLengths);
+            }
+            catch (UnsatisfiedLinkError ule)
+            {
+                logger.warn("The FFmpeg JNI library is out-of-date.");
+                nativePacketize = false;
+                return false;
+            }
+            if (count < 0)
+            {
+                packets = new byte[2 * packets.length];
+                payloadLengths = new int[2 * payloadLengths.length];
+            }
+        }
+        while (count < 0);
+
+        payloadCount = count;
+        return true;
     }
 
     /**
@@ -333,19 +496,23 @@ public class Packetizer
     public int process(Buffer inBuffer, Buffer outBuffer)
     {
         // if there are some nals we check and send them
-        if (nals.size() > 0)
+        if (payloadIndex < payloadCount)
         {
-            byte[] nal = nals.remove(0);
+            int nalOffset = payloadOffset;
+            int nalLength = payloadLengths[payloadIndex];
 
-            // Send the NAL.
-            outBuffer.setData(nal);
-            outBuffer.setLength(nal.length);
-            outBuffer.setOffset(0);
+            payloadIndex++;
+            payloadOffset += nalLength;
+
+            // Send the NAL straight out of packets.
+            outBuffer.setData(packets);
+            outBuffer.setLength(nalLength);
+            outBuffer.setOffset(nalOffset);
             outBuffer.setTimeStamp(nalsTimeStamp);
             outBuffer.setSequenceNumber(sequenceNumber++);
 
             // If there are other NALs, send them as well.
-            if(nals.size() > 0)
+            if (payloadIndex < payloadCount)
                 return (BUFFER_PROCESSED_OK | INPUT_BUFFER_NOT_CONSUMED);
             else
             {
@@ -359,13 +526,13 @@ public class Packetizer
                  * the last NALs in an access unit should probably NOT be
                  * marked anyway.
                  */
-                if (nal.length > 0)
+                if (nalLength > 0)
                 {
-                    int nal_unit_type = nal[0] & 0x1F;
+                    int nal_unit_type = packets[nalOffset] & 0x1F;
 
-                    if ((nal_unit_type == 28 /* FU-A */) && (nal.length > 1))
+                    if ((nal_unit_type == 28 /* FU-A */) && (nalLength > 1))
                     {
-                        byte fuHeader = nal[1];
+                        byte fuHeader = packets[nalOffset + 1];
 
                         if ((fuHeader & 0x40 /* End bit */) == 0)
                         {
@@ -428,7 +595,20 @@ public class Packetizer
 
         byte[] inData = (byte[]) inBuffer.getData();
         int inOffset = inBuffer.getOffset();
-        boolean nalsAdded = false;
+
+        packetsLength = 0;
+        payloadCount = 0;
+        payloadIndex = 0;
+        payloadOffset = 0;
+        nalsTimeStamp = inBuffer.getTimeStamp();
+
+        if (nativePacketize && packetizeNative(inData, inOffset, inLength))
+        {
+            return
+                (payloadCount > 0)
+                    ? process(inBuffer, outBuffer)
+                    : OUTPUT_BUFFER_NOT_FILLED;
+        }
 
         /*
          * Split the H.264 encoded data into NAL units. Each NAL unit begins
@@ -460,16 +640,14 @@ public class Packetizer
                     nalLength--;
 
                 if (nalLength > 0)
-                    nalsAdded
-                        = packetizeNAL(inData, beginIndex, nalLength)
-                            || nalsAdded;
+                    packetizeNAL(inData, beginIndex, nalLength);
             }
         }
 
-        nalsTimeStamp = inBuffer.getTimeStamp();
-
         return
-            nalsAdded ? process(inBuffer, outBuffer) : OUTPUT_BUFFER_NOT_FILLED;
+            (payloadCount > 0)
+                ? process(inBuffer, outBuffer)
+                : OUTPUT_BUFFER_NOT_FILLED;
     }
 
     /**
@@ -96,6 +96,12 @@ public abstract class AudioSystem
      */
     public static final String LOCATOR_PROTOCOL_WASAPI = "wasapi";
 
+    /**
+     * The default real-time priority to be requested for the native audio
+     * threads if a real-time scheduling policy is configured.
+     */
+    public static final int DEFAULT_SCHED_PRIORITY = 10;
+
     /**
      * The <tt>Logger</tt> used by this instance for logging output.
      */
@@ -115,6 +121,22 @@ public abstract class AudioSystem
      */
     protected static final String PNAME_ECHOCANCEL = "echocancel";
 
+    /**
+     * The (base) name of the <tt>ConfigurationService</tt> property which
+     * specifies the scheduling policy to be requested for the native audio
+     * threads i.e. <tt>FIFO</tt>, <tt>RR</tt> or <tt>NICE</tt>. If the
+     * property is not set, the scheduling policy of the threads is left
+     * intact.
+     */
+    protected static final String PNAME_SCHED_POLICY = "schedPolicy";
+
+    /**
+     * The (base) name of the <tt>ConfigurationService</tt> property which
+     * specifies the real-time priority to be requested along with the
+     * scheduling policy of the native audio threads.
+     */
+    protected static final String PNAME_SCHED_PRIORITY = "schedPriority";
+
     public static AudioSystem getAudioSystem(String locatorProtocol)
     {
         AudioSystem[] audioSystems = getAudioSystems();
@@ -462,6 +484,62 @@ public abstract class AudioSystem
                 + "." + basePropertyName;
     }
 
+    /**
+     * Gets the name of the scheduling policy to be requested for the native
+     * audio threads of this <tt>AudioSystem</tt>.
+     *
+     * @return <tt>FIFO</tt>, <tt>RR</tt>, <tt>NICE</tt> or <tt>null</tt> if the
+     * scheduling policy of the native audio threads is to be left intact
+     */
+    public String getSchedPolicy()
+    {
+        ConfigurationService cfg = LibJitsi.getConfigurationService();
+        String value
+            = (cfg == null)
+                ? null
+                : cfg.getString(getPropertyName(PNAME_SCHED_POLICY));
+
+        if (value != null)
+        {
+            value = value.trim().toUpperCase(Locale.ENGLISH);
+            if (!"FIFO".equals(value)
+                    && !"RR".equals(value)
+                    && !"NICE".equals(value))
+            {
+                if (value.length() != 0)
+                {
+                    logger.warn(
+                            "Ignoring unsupported value of "
+                                + getPropertyName(PNAME_SCHED_POLICY)
+                                + ": "
+                                + value);
+                }
+                value = null;
+            }
+        }
+        return value;
+    }
+
+    /**
+     * Gets the real-time priority to be requested along with the scheduling
+     * policy of the native audio threads of this <tt>AudioSystem</tt>.
+     *
+     * @return the real-time priority to be requested along with the
+     * scheduling policy of the native audio threads of this
+     * <tt>AudioSystem</tt>
+     */
+    public int getSchedPriority()
+    {
+        ConfigurationService cfg = LibJitsi.getConfigurationService();
+
+        return
+            (cfg == null)
+                ? DEFAULT_SCHED_PRIORITY
+                : cfg.getInt(
+                        getPropertyName(PNAME_SCHED_PRIORITY),
+                        DEFAULT_SCHED_PRIORITY);
+    }
+
     /**
      * Gets the selected device for a specific data flow: capture, notify or
      * playback.
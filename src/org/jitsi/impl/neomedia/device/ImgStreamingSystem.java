@@ -14,6 +14,7 @@ import javax.media.format.*;
 import org.jitsi.impl.neomedia.*;
 import org.jitsi.impl.neomedia.codec.*;
 import org.jitsi.impl.neomedia.codec.video.*;
+import org.jitsi.impl.neomedia.imgstreaming.*;
 import org.jitsi.service.neomedia.*;
 import org.jitsi.service.neomedia.device.*;
 import org.jitsi.util.*;
@@ -33,6 +34,34 @@ public class ImgStreamingSystem
     private static final String LOCATOR_PROTOCOL
         = LOCATOR_PROTOCOL_IMGSTREAMING;
 
+    /**
+     * Determines whether a native screen capture session can be opened on a
+     * specific display. The I420 format is captured in such a session only.
+     *
+     * @param display the index of the display to open a session on
+     * @return <tt>true</tt> if a native screen capture session can be opened
+     * on <tt>display</tt>; otherwise, <tt>false</tt>
+     */
+    private static boolean canOpenScreenCaptureSession(int display)
+    {
+        try
+        {
+            long session = ScreenCapture.openSession(display);
+
+            if (session != 0)
+            {
+                ScreenCapture.closeSession(session);
+                return true;
+            }
+        }
+        catch (Throwable t)
+        {
+            if (t instanceof ThreadDeath)
+                throw (ThreadDeath) t;
+        }
+        return false;
+    }
+
     /**
      * Add capture devices.
      *
@@ -109,6 +138,36 @@ public class ImgStreamingSystem
                             32, // bitsPerPixel
                             2 /* red */, 3 /* green */,  4 /* blue */)
                 };
+
+            /*
+             * On Linux the screen is captured straight into the I420 of the
+             * video encoders. It takes a native screen capture session so the
+             * format is offered only if one can be opened. When the screen
+             * combines several monitors, ARGB is preferred because ImageStream
+             * grabs it monitor by monitor in parallel.
+             */
+            if (OSUtils.IS_LINUX && canOpenScreenCaptureSession(i))
+            {
+                Format[] i420Formats = new Format[formats.length + 1];
+                int i420Index
+                    = (multipleMonitorsOneScreen && (screens.length > 1))
+                        ? formats.length
+                        : 0;
+
+                System.arraycopy(formats, 0, i420Formats, 0, i420Index);
+                i420Formats[i420Index]
+                    = new AVFrameFormat(
+                            size,
+                            Format.NOT_SPECIFIED,
+                            FFmpeg.PIX_FMT_YUV420P,
+                            Format.NOT_SPECIFIED);
+                System.arraycopy(
+                        formats, i420Index,
+                        i420Formats, i420Index + 1,
+                        formats.length - i420Index);
+                formats = i420Formats;
+            }
+
             CaptureDeviceInfo cdi
                 = new CaptureDeviceInfo(
                         name + " " + i,
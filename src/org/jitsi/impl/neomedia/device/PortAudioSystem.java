@@ -370,6 +370,92 @@ public class PortAudioSystem
         }
     }
 
+    /**
+     * Requests the scheduling policy configured for the
+     * <tt>PortAudioSystem</tt> for the native thread transferring the audio of
+     * a specific PortAudio stream and locks the memory accessed by that thread
+     * on behalf of the stream into RAM. Does nothing if no scheduling policy is
+     * configured.
+     *
+     * @param stream the pointer to the PortAudio stream
+     */
+    public static void setSchedPolicy(long stream)
+    {
+        AudioSystem audioSystem = AudioSystem.getAudioSystem(LOCATOR_PROTOCOL);
+
+        if (audioSystem == null)
+            return;
+
+        String schedPolicy = audioSystem.getSchedPolicy();
+        int policy;
+
+        if ("FIFO".equals(schedPolicy))
+            policy = Pa.SCHED_POLICY_FIFO;
+        else if ("RR".equals(schedPolicy))
+            policy = Pa.SCHED_POLICY_RR;
+        else if ("NICE".equals(schedPolicy))
+            policy = Pa.SCHED_POLICY_NICE;
+        else
+            return;
+
+        if (!Pa.SetStreamSchedPolicy(
+                stream,
+                policy,
+                audioSystem.getSchedPriority()))
+        {
+            logger.warn("Failed to lock the memory of a PortAudio stream.");
+        }
+    }
+
+    /**
+     * Gets a human-readable representation of the values of the health
+     * counters of a specific PortAudio stream as returned by
+     * {@link Pa#GetStreamStats(long, long[])}.
+     *
+     * @param stream the pointer to the PortAudio stream to get the health
+     * counters of
+     * @return a human-readable representation of the values of the health
+     * counters of the specified <tt>stream</tt>
+     */
+    public static String streamStatsToString(long stream)
+    {
+        long[] values = new long[Pa.STREAM_STATS_LENGTH];
+
+        Pa.GetStreamStats(stream, values);
+
+        StringBuilder s = new StringBuilder();
+
+        s.append("inputUnderflows=").append(
+                values[Pa.STREAM_STATS_INPUT_UNDERFLOWS]);
+        s.append(", inputOverflows=").append(
+                values[Pa.STREAM_STATS_INPUT_OVERFLOWS]);
+        s.append(", outputUnderflows=").append(
+                values[Pa.STREAM_STATS_OUTPUT_UNDERFLOWS]);
+        s.append(", outputOverflows=").append(
+                values[Pa.STREAM_STATS_OUTPUT_OVERFLOWS]);
+        s.append(", callbacks=").append(values[Pa.STREAM_STATS_CALLBACKS]);
+        s.append(", maxCallbackIntervalNanos=").append(
+                values[Pa.STREAM_STATS_CALLBACK_INTERVAL_MAX]);
+        s.append(", maxInputFill=").append(
+                values[Pa.STREAM_STATS_INPUT_FILL_MAX]);
+        s.append(", maxOutputFill=").append(
+                values[Pa.STREAM_STATS_OUTPUT_FILL_MAX]);
+        s.append(", aqiTimeNanos=").append(values[Pa.STREAM_STATS_AQI_TIME]);
+        s.append(", mutexBlockedTimeNanos=").append(
+                values[Pa.STREAM_STATS_MUTEX_BLOCKED_TIME]);
+        s.append(", callbackIntervalHistogram=[");
+        for (int i = 0;
+                i < Pa.STREAM_STATS_CALLBACK_INTERVAL_HISTOGRAM_LENGTH;
+                i++)
+        {
+            if (i != 0)
+                s.append(", ");
+            s.append(values[Pa.STREAM_STATS_CALLBACK_INTERVAL_HISTOGRAM + i]);
+        }
+        s.append(']');
+        return s.toString();
+    }
+
     /**
      * Waits for all PortAudio clients to finish executing
      * <tt>Pa_OpenStream</tt>.
@@ -16,6 +16,7 @@ import org.jitsi.impl.neomedia.*;
 import org.jitsi.impl.neomedia.jmfext.media.renderer.audio.*;
 import org.jitsi.impl.neomedia.pulseaudio.*;
 import org.jitsi.service.version.*;
+import org.jitsi.util.*;
 
 /**
  * Implements an <tt>AudioSystem</tt> using the native PulseAudio API/library.
@@ -27,6 +28,13 @@ public class PulseAudioSystem
 {
     private static final String LOCATOR_PROTOCOL = LOCATOR_PROTOCOL_PULSEAUDIO;
 
+    /**
+     * The <tt>Logger</tt> used by the <tt>PulseAudioSystem</tt> class and its
+     * instances for logging output.
+     */
+    private static final Logger logger
+        = Logger.getLogger(PulseAudioSystem.class);
+
     public static final String MEDIA_ROLE_EVENT = "event";
 
     public static final String MEDIA_ROLE_PHONE = "phone";
@@ -58,10 +66,91 @@ public class PulseAudioSystem
                 : null;
     }
 
+    /**
+     * Reads a string serialized by
+     * {@link PA#device_registry_get_snapshot(long)}.
+     *
+     * @param in the <tt>DataInput</tt> to read the serialized string from
+     * @return the read string
+     * @throws IOException if reading from <tt>in</tt> fails
+     */
+    private static String readDeviceRegistryString(DataInput in)
+        throws IOException
+    {
+        int length = in.readInt();
+
+        if (length < 0)
+            return null;
+
+        byte[] bytes = new byte[length];
+
+        in.readFully(bytes);
+        return new String(bytes, "UTF-8");
+    }
+
+    /**
+     * Gets a human-readable representation of the values of the health
+     * counters of a <tt>pa_stream</tt> initialized by
+     * {@link PA#stream_stats_new(long, boolean)}.
+     *
+     * @param stats the health counters to get the values of
+     * @return a human-readable representation of the values of the health
+     * counters specified by <tt>stats</tt>
+     */
+    public static String streamStatsToString(long stats)
+    {
+        long[] values = new long[PA.STREAM_STATS_LENGTH];
+
+        PA.stream_stats_get(stats, values);
+
+        StringBuilder s = new StringBuilder();
+
+        s.append("underflows=").append(values[PA.STREAM_STATS_UNDERFLOWS]);
+        s.append(", overflows=").append(values[PA.STREAM_STATS_OVERFLOWS]);
+        s.append(", holes=").append(values[PA.STREAM_STATS_HOLES]);
+        s.append(", pumpUnderflows=").append(
+                values[PA.STREAM_STATS_PUMP_UNDERFLOWS]);
+        s.append(", pumpOverflows=").append(
+                values[PA.STREAM_STATS_PUMP_OVERFLOWS]);
+        s.append(", callbacks=").append(values[PA.STREAM_STATS_CALLBACKS]);
+        s.append(", latencyMicros=").append(values[PA.STREAM_STATS_LATENCY]);
+        s.append(", bufferLength=").append(
+                values[PA.STREAM_STATS_BUFFER_LENGTH]);
+        s.append(", maxCallbackIntervalNanos=").append(
+                values[PA.STREAM_STATS_CALLBACK_INTERVAL_MAX]);
+        s.append(", maxRequestBytes=").append(
+                values[PA.STREAM_STATS_REQUEST_BYTES_MAX]);
+        s.append(", callbackIntervalHistogram=[");
+        for (int i = 0;
+                i < PA.STREAM_STATS_CALLBACK_INTERVAL_HISTOGRAM_LENGTH;
+                i++)
+        {
+            if (i != 0)
+                s.append(", ");
+            s.append(values[PA.STREAM_STATS_CALLBACK_INTERVAL_HISTOGRAM + i]);
+        }
+        s.append(']');
+        return s.toString();
+    }
+
     private boolean createContext;
 
     private long context;
 
+    /**
+     * The native cache of the sinks and sources of {@link #context} which is
+     * kept current by the subscription events of <tt>context</tt>.
+     */
+    private long deviceRegistry;
+
+    /**
+     * The indicator which determines whether the native I/O pumps created by
+     * this instance are to be locked into RAM because the thread of
+     * {@link #mainloop} which services them runs with an elevated scheduling
+     * policy.
+     */
+    private boolean lockPumpMemory;
+
     private long mainloop;
 
     /**
@@ -76,6 +165,99 @@ public class PulseAudioSystem
         super(LOCATOR_PROTOCOL, FEATURE_NOTIFY_AND_PLAYBACK_DEVICES);
     }
 
+    /**
+     * Adds a sink cached by {@link #deviceRegistry} to a specific list of
+     * playback devices.
+     */
+    private void addSink(
+            String name,
+            String description,
+            int sampleSpecFormat,
+            List<CaptureDeviceInfo2> deviceList)
+    {
+        if (sampleSpecFormat != PA.SAMPLE_S16LE)
+            return;
+
+        if (description == null)
+            description = name;
+        deviceList.add(
+                new CaptureDeviceInfo2(
+                        description,
+                        new MediaLocator(
+                                LOCATOR_PROTOCOL
+                                    + ":"
+                                    + name),
+                        null,
+                        null,
+                        null,
+                        null));
+    }
+
+    /**
+     * Adds a source cached by {@link #deviceRegistry} to a specific list of
+     * capture devices unless it is the monitor of a sink.
+     */
+    private void addSource(
+            String name,
+            String description,
+            int monitorOfSink,
+            int sampleSpecFormat,
+            int channels,
+            int rate,
+            List<CaptureDeviceInfo2> deviceList,
+            List<Format> formatList)
+    {
+        if (monitorOfSink != PA.INVALID_INDEX)
+            return;
+        if (sampleSpecFormat != PA.SAMPLE_S16LE)
+            return;
+
+        List<Format> sourceInfoFormatList = new LinkedList<Format>();
+
+        if ((MediaUtils.MAX_AUDIO_CHANNELS != Format.NOT_SPECIFIED)
+                && (MediaUtils.MAX_AUDIO_CHANNELS < channels))
+            channels = MediaUtils.MAX_AUDIO_CHANNELS;
+        if ((MediaUtils.MAX_AUDIO_SAMPLE_RATE != Format.NOT_SPECIFIED)
+                && (MediaUtils.MAX_AUDIO_SAMPLE_RATE < rate))
+            rate = (int) MediaUtils.MAX_AUDIO_SAMPLE_RATE;
+
+        AudioFormat audioFormat
+            = new AudioFormat(
+                AudioFormat.LINEAR,
+                rate,
+                16,
+                channels,
+                AudioFormat.LITTLE_ENDIAN,
+                AudioFormat.SIGNED,
+                Format.NOT_SPECIFIED /* frameSizeInBits */,
+                Format.NOT_SPECIFIED /* frameRate */,
+                Format.byteArray);
+
+        if (!sourceInfoFormatList.contains(audioFormat))
+        {
+            sourceInfoFormatList.add(audioFormat);
+            if (!formatList.contains(audioFormat))
+                formatList.add(audioFormat);
+        }
+        if (!formatList.isEmpty())
+        {
+            if (description == null)
+                description = name;
+            deviceList.add(
+                    new CaptureDeviceInfo2(
+                            description,
+                            new MediaLocator(
+                                    LOCATOR_PROTOCOL
+                                        + ":"
+                                        + name),
+                            sourceInfoFormatList.toArray(
+                                    new Format[sourceInfoFormatList.size()]),
+                            null,
+                            null,
+                            null));
+        }
+    }
+
     private void createContext()
     {
         if (this.context != 0)
@@ -172,6 +354,35 @@ public class PulseAudioSystem
         }
     }
 
+    /**
+     * Initializes a new native I/O pump of a specific <tt>pa_stream</tt> which
+     * is serviced by the threaded mainloop of this instance. The mainloop lock
+     * must be held.
+     *
+     * @param stream the <tt>pa_stream</tt> to pump
+     * @param capacity the capacity in bytes of the ring buffer of the new pump
+     * @param playback <tt>true</tt> if <tt>stream</tt> is a playback stream;
+     * <tt>false</tt> if <tt>stream</tt> is a record stream
+     * @param stats the health counters of <tt>stream</tt> or <tt>0</tt>
+     * @return the new pump
+     * @throws IllegalStateException if the initialization of the new pump
+     * failed
+     */
+    public long createPump(
+            long stream,
+            int capacity,
+            boolean playback,
+            long stats)
+    {
+        long pump = PA.pump_new(mainloop, stream, capacity, playback, stats);
+
+        if (pump == 0)
+            throw new IllegalStateException("pa_pump_new");
+        if (lockPumpMemory && !PA.pump_lock_memory(pump))
+            logger.warn("Failed to lock the PulseAudio pump into RAM.");
+        return pump;
+    }
+
     /**
      * {@inheritDoc}
      *
@@ -287,101 +498,88 @@ public class PulseAudioSystem
         throws Exception
     {
         long context = getContext();
+        byte[] snapshot;
 
-        final List<CaptureDeviceInfo2> captureDevices
-            = new LinkedList<CaptureDeviceInfo2>();
-        final List<Format> captureDeviceFormats = new LinkedList<Format>();
-        PA.source_info_cb_t sourceInfoListCallback
-            = new PA.source_info_cb_t()
-            {
-                public void callback(long c, long i, int eol)
-                {
-                    try
-                    {
-                        if ((eol == 0) && (i != 0))
-                        {
-                            sourceInfoListCallback(
-                                    c,
-                                    i,
-                                    captureDevices,
-                                    captureDeviceFormats);
-                        }
-                    }
-                    finally
-                    {
-                        signalMainloop(false);
-                    }
-                }
-            };
-
-        final List<CaptureDeviceInfo2> playbackDevices
-            = new LinkedList<CaptureDeviceInfo2>();
-        final List<Format> playbackDeviceFormats = new LinkedList<Format>();
-        PA.sink_info_cb_t sinkInfoListCallback
-            = new PA.sink_info_cb_t()
-            {
-                public void callback(long c, long i, int eol)
-                {
-                    try
-                    {
-                        if ((eol == 0) && (i != 0))
-                        {
-                            sinkInfoListCallback(
-                                    c,
-                                    i,
-                                    playbackDevices,
-                                    playbackDeviceFormats);
-                        }
-                    }
-                    finally
-                    {
-                        signalMainloop(false);
-                    }
-                }
-            };
-
+        /*
+         * The devices are read out of the native device registry in a single
+         * call instead of through a JNI call per attribute per device.
+         */
         lockMainloop();
         try
         {
-            long o
-                = PA.context_get_source_info_list(
-                        context,
-                        sourceInfoListCallback);
-
-            if (o == 0)
-                throw new RuntimeException("pa_context_get_source_info_list");
-
-            try
+            if (deviceRegistry == 0)
             {
-                while (PA.operation_get_state(o) == PA.OPERATION_RUNNING)
-                    waitMainloop();
+                deviceRegistry = PA.device_registry_new(mainloop, context);
+                if (deviceRegistry == 0)
+                    throw new RuntimeException("pa_context_subscribe");
             }
-            finally
+            while ((PA.device_registry_get_version(deviceRegistry) == 0)
+                    && (PA.context_get_state(context) == PA.CONTEXT_READY))
+                waitMainloop();
+            snapshot = PA.device_registry_get_snapshot(deviceRegistry);
+
+            /*
+             * The registry is no longer kept current once its context has
+             * failed or terminated so release it along with its subscription.
+             */
+            if (PA.context_get_state(context) != PA.CONTEXT_READY)
             {
-                PA.operation_unref(o);
+                PA.device_registry_free(deviceRegistry);
+                deviceRegistry = 0;
             }
+        }
+        finally
+        {
+            unlockMainloop();
+        }
+        if (snapshot == null)
+            throw new RuntimeException("pa_device_registry_get_snapshot");
+
+        List<CaptureDeviceInfo2> captureDevices
+            = new LinkedList<CaptureDeviceInfo2>();
+        List<Format> captureDeviceFormats = new LinkedList<Format>();
+        List<CaptureDeviceInfo2> playbackDevices
+            = new LinkedList<CaptureDeviceInfo2>();
+        DataInputStream in
+            = new DataInputStream(new ByteArrayInputStream(snapshot));
+        long version = in.readLong();
+        int count = in.readInt();
 
-            o
-                = PA.context_get_sink_info_list(
-                        context,
-                        sinkInfoListCallback);
+        for (int i = 0; i < count; i++)
+        {
+            int type = in.readInt();
 
-            if (o == 0)
-                throw new RuntimeException("pa_context_get_sink_info_list");
+            in.readInt(); /* index */
 
-            try
+            int monitor = in.readInt();
+            int sampleSpecFormat = in.readInt();
+            int channels = in.readInt();
+            int rate = in.readInt();
+            String name = readDeviceRegistryString(in);
+            String description = readDeviceRegistryString(in);
+
+            if (type == PA.DEVICE_REGISTRY_SINK)
             {
-                while (PA.operation_get_state(o) == PA.OPERATION_RUNNING)
-                    waitMainloop();
+                addSink(
+                        name, description,
+                        sampleSpecFormat,
+                        playbackDevices);
             }
-            finally
+            else
             {
-                PA.operation_unref(o);
+                addSource(
+                        name, description,
+                        monitor,
+                        sampleSpecFormat, channels, rate,
+                        captureDevices,
+                        captureDeviceFormats);
             }
         }
-        finally
+        if (logger.isDebugEnabled())
         {
-            unlockMainloop();
+            logger.debug(
+                    "Read " + count + " PulseAudio devices of device registry"
+                        + " version " + version + ".");
         }
 
         if (!captureDeviceFormats.isEmpty())
@@ -474,100 +672,39 @@ public class PulseAudioSystem
         PA.threaded_mainloop_signal(mainloop, waitForAccept);
     }
 
-    private void sinkInfoListCallback(
-            long context,
-            long sinkInfo,
-            List<CaptureDeviceInfo2> deviceList,
-            List<Format> formatList)
-    {
-        int sampleSpecFormat = PA.sink_info_get_sample_spec_format(sinkInfo);
-
-        if (sampleSpecFormat != PA.SAMPLE_S16LE)
-            return;
-
-        String description = PA.sink_info_get_description(sinkInfo);
-        String name = PA.sink_info_get_name(sinkInfo);
-
-        if (description == null)
-            description = name;
-        deviceList.add(
-                new CaptureDeviceInfo2(
-                        description,
-                        new MediaLocator(
-                                LOCATOR_PROTOCOL
-                                    + ":"
-                                    + name),
-                        null,
-                        null,
-                        null,
-                        null));
-    }
-
-    private void sourceInfoListCallback(
-            long context,
-            long sourceInfo,
-            List<CaptureDeviceInfo2> deviceList,
-            List<Format> formatList)
+    /**
+     * Requests the scheduling policy configured for this
+     * <tt>PulseAudioSystem</tt> for the thread of {@link #mainloop} which
+     * serves the read and write requests of the PulseAudio streams. Does
+     * nothing if no scheduling policy is configured.
+     */
+    private void setMainloopSchedPolicy()
     {
-        int monitorOfSink = PA.source_info_get_monitor_of_sink(sourceInfo);
-
-        if (monitorOfSink != PA.INVALID_INDEX)
-            return;
-
-        int sampleSpecFormat
-            = PA.source_info_get_sample_spec_format(sourceInfo);
-
-        if (sampleSpecFormat != PA.SAMPLE_S16LE)
+        String schedPolicy = getSchedPolicy();
+        int policy;
+
+        if ("FIFO".equals(schedPolicy))
+            policy = PA.SCHED_POLICY_FIFO;
+        else if ("RR".equals(schedPolicy))
+            policy = PA.SCHED_POLICY_RR;
+        else if ("NICE".equals(schedPolicy))
+            policy = PA.SCHED_POLICY_NICE;
+        else
             return;
 
-        int channels = PA.source_info_get_sample_spec_channels(sourceInfo);
-        int rate = PA.source_info_get_sample_spec_rate(sourceInfo);
-        List<Format> sourceInfoFormatList = new LinkedList<Format>();
+        int effectivePolicy
+            = PA.threaded_mainloop_set_sched_policy(
+                    mainloop,
+                    policy,
+                    getSchedPriority());
 
-        if ((MediaUtils.MAX_AUDIO_CHANNELS != Format.NOT_SPECIFIED)
-                && (MediaUtils.MAX_AUDIO_CHANNELS < channels))
-            channels = MediaUtils.MAX_AUDIO_CHANNELS;
-        if ((MediaUtils.MAX_AUDIO_SAMPLE_RATE != Format.NOT_SPECIFIED)
-                && (MediaUtils.MAX_AUDIO_SAMPLE_RATE < rate))
-            rate = (int) MediaUtils.MAX_AUDIO_SAMPLE_RATE;
-
-        AudioFormat audioFormat
-            = new AudioFormat(
-                AudioFormat.LINEAR,
-                rate,
-                16,
-                channels,
-                AudioFormat.LITTLE_ENDIAN,
-                AudioFormat.SIGNED,
-                Format.NOT_SPECIFIED /* frameSizeInBits */,
-                Format.NOT_SPECIFIED /* frameRate */,
-                Format.byteArray);
-
-        if (!sourceInfoFormatList.contains(audioFormat))
+        lockPumpMemory = (effectivePolicy != PA.SCHED_POLICY_DEFAULT);
+        if (effectivePolicy != policy)
         {
-            sourceInfoFormatList.add(audioFormat);
-            if (!formatList.contains(audioFormat))
-                formatList.add(audioFormat);
-        }
-        if (!formatList.isEmpty())
-        {
-            String description = PA.source_info_get_description(sourceInfo);
-            String name = PA.source_info_get_name(sourceInfo);
-
-            if (description == null)
-                description = name;
-            deviceList.add(
-                    new CaptureDeviceInfo2(
-                            description,
-                            new MediaLocator(
-                                    LOCATOR_PROTOCOL
-                                        + ":"
-                                        + name),
-                            sourceInfoFormatList.toArray(
-                                    new Format[sourceInfoFormatList.size()]),
-                            null,
-                            null,
-                            null));
+            logger.warn(
+                    "Requested scheduling policy " + schedPolicy
+                        + " of the PulseAudio mainloop thread, got "
+                        + effectivePolicy);
         }
     }
 
@@ -587,6 +724,7 @@ public class PulseAudioSystem
                 throw new RuntimeException("pa_threaded_mainloop_start");
 
             this.mainloop = mainloop;
+            setMainloopSchedPolicy();
         }
         finally
         {
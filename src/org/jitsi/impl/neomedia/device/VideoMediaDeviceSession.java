@@ -23,6 +23,7 @@ import org.jitsi.impl.neomedia.codec.video.*;
 import org.jitsi.impl.neomedia.codec.video.h264.*;
 import org.jitsi.impl.neomedia.control.*;
 import org.jitsi.impl.neomedia.format.*;
+import org.jitsi.impl.neomedia.jmfext.media.renderer.video.*;
 import org.jitsi.impl.neomedia.transform.*;
 import org.jitsi.service.libjitsi.*;
 import org.jitsi.service.neomedia.*;
@@ -696,6 +697,40 @@ public class VideoMediaDeviceSession
         return canvas;
     }
 
+    /**
+     * Initializes a <tt>Renderer</tt> instance which is to be utilized by a
+     * specific <tt>Player</tt> in order to play back the media represented by
+     * a specific <tt>TrackControl</tt>. If the video gallery is enabled, the
+     * remote video is rendered into its cell of the gallery and the visual
+     * <tt>Component</tt> of the <tt>Player</tt> is the gallery.
+     *
+     * @param player the <tt>Player</tt> which is to utilize the
+     * initialized/returned <tt>Renderer</tt>
+     * @param trackControl the <tt>TrackControl</tt> which represents the media
+     * to be played back
+     * @return the <tt>Renderer</tt> which is to be set on the specified
+     * <tt>trackControl</tt>
+     * @see MediaDeviceSession#createRenderer(Player, TrackControl)
+     */
+    @Override
+    protected Renderer createRenderer(Player player, TrackControl trackControl)
+    {
+        if (MediaServiceImpl.isVideoGalleryEnabled())
+        {
+            try
+            {
+                return JAWTCompositor.getGallery().createRenderer();
+            }
+            catch (Throwable t)
+            {
+                if (t instanceof ThreadDeath)
+                    throw (ThreadDeath) t;
+                logger.error("Failed to render into the video gallery", t);
+            }
+        }
+        return super.createRenderer(player, trackControl);
+    }
+
     /**
      * Releases the resources allocated by a specific local <tt>Player</tt> in
      * the course of its execution and prepares it to be garbage collected. If
@@ -1070,9 +1105,12 @@ public class VideoMediaDeviceSession
                     /*
                      * Since SwScale will scale any input size into the
                      * configured output size, we may never get SizeChangeEvent
-                     * from the player. We'll generate it ourselves then.
+                     * from the player. We'll generate it ourselves then. The
+                     * video gallery scales into the cells of its surface
+                     * itself.
                      */
-                    playerScaler = new PlayerScaler(player);
+                    if (!MediaServiceImpl.isVideoGalleryEnabled())
+                        playerScaler = new PlayerScaler(player);
 
                     /*
                      * For H.264, we will use RTCP feedback. For example, to
@@ -1101,14 +1139,16 @@ public class VideoMediaDeviceSession
                         }
 
                         trackControl.setCodecChain(
-                                new Codec[]
-                                {
-                                    depacketizer,
-                                    decoder,
-                                    playerScaler
-                                });
+                                (playerScaler == null)
+                                    ? new Codec[] { depacketizer, decoder }
+                                    : new Codec[]
+                                        {
+                                            depacketizer,
+                                            decoder,
+                                            playerScaler
+                                        });
                     }
-                    else
+                    else if (playerScaler != null)
                     {
                         trackControl.setCodecChain(
                                 new Codec[] { playerScaler });
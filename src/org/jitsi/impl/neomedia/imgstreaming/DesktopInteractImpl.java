@@ -9,8 +9,6 @@ package org.jitsi.impl.neomedia.imgstreaming;
 import java.awt.*;
 import java.awt.image.*;
 
-import net.java.sip.communicator.impl.neomedia.imgstreaming.*;
-
 import org.jitsi.util.*;
 
 /**
@@ -117,7 +115,7 @@ public class DesktopInteractImpl
         if (OSUtils.IS_LINUX || OSUtils.IS_MAC || OSUtils.IS_WINDOWS)
         {
             return
-                NativeScreenCapture.grabScreen(
+                ScreenCapture.grabScreen(
                         display,
                         x, y, width, height,
                         output);
@@ -151,7 +149,7 @@ public class DesktopInteractImpl
         if (OSUtils.IS_LINUX || OSUtils.IS_MAC || OSUtils.IS_WINDOWS)
         {
             return
-                NativeScreenCapture.grabScreen(
+                ScreenCapture.grabScreen(
                         display,
                         x, y, width, height,
                         buffer, bufferLength);
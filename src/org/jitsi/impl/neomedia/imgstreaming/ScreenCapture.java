@@ -0,0 +1,181 @@
+/*
+ * Jitsi, the OpenSource Java VoIP and Instant Messaging client.
+ *
+ * Distributable under LGPL license.
+ * See terms of license at gnu.org.
+ */
+package org.jitsi.impl.neomedia.imgstreaming;
+
+/**
+ * This class uses native code to capture desktop screen.
+ *
+ * It should work for Windows, Mac OS X and X11-based Unix such as Linux
+ * and FreeBSD.
+ *
+ * @author Sebastien Vincent
+ */
+public class ScreenCapture
+{
+    static
+    {
+        System.loadLibrary("jnscreencapture");
+    }
+
+    /**
+     * Closes a screen capture session opened by {@link #openSession(int)}.
+     *
+     * @param session the screen capture session to close
+     */
+    public static native void closeSession(long session);
+
+    /**
+     * Grab desktop screen and get raw bytes.
+     *
+     * @param display index of display
+     * @param x x position to start capture
+     * @param y y position to start capture
+     * @param width capture width
+     * @param height capture height
+     * @param output output buffer to store screen bytes
+     * @return true if grab success, false otherwise
+     */
+    public static native boolean grabScreen(int display, int x, int y,
+            int width, int height, byte output[]);
+
+    /**
+     * Grab desktop screen and get raw bytes.
+     *
+     * @param display index of display
+     * @param x x position to start capture
+     * @param y y position to start capture
+     * @param width capture width
+     * @param height capture height
+     * @param output native output buffer to store screen bytes
+     * @param outputLength native output length
+     * @return true if grab success, false otherwise
+     */
+    public static native boolean grabScreen(int display, int x, int y,
+            int width, int height, long output, int outputLength);
+
+    /**
+     * Grab desktop screen in a screen capture session and get raw bytes.
+     * Contrary to {@link #grabScreen(int, int, int, int, int, long, int)}, the
+     * resources needed to grab (e.g. the connection to the display and the
+     * shared memory image on X11) are reused between grabs and are only
+     * recreated when the capture size changes.
+     *
+     * @param session the screen capture session to grab in
+     * @param x x position to start capture
+     * @param y y position to start capture
+     * @param width capture width
+     * @param height capture height
+     * @param output native output buffer to store screen bytes
+     * @param outputLength native output length
+     * @return true if grab success, false otherwise
+     */
+    public static native boolean grabSession(long session, int x, int y,
+            int width, int height, long output, int outputLength);
+
+    /**
+     * Grab desktop screen in a screen capture session tracking the damaged
+     * areas of the screen and get raw bytes. Only the areas which have been
+     * damaged since the previous grab in the session are actually grabbed and
+     * patched into a frame kept by the session which is then copied into
+     * <tt>output</tt>. Where damage tracking is not available, every grab is a
+     * full grab reported as a single damaged rectangle.
+     *
+     * @param session the screen capture session to grab in
+     * @param x x position to start capture
+     * @param y y position to start capture
+     * @param width capture width
+     * @param height capture height
+     * @param output native output buffer to store screen bytes
+     * @param outputLength native output length
+     * @param rects array to store the x, y, width and height of the damaged
+     * rectangles relative to the capture area in. If there are more damaged
+     * rectangles than fit, their bounding box is stored instead.
+     * @return the number of damaged rectangles stored in <tt>rects</tt> (i.e.
+     * <tt>0</tt> if the captured area has not changed since the previous grab)
+     * or <tt>-1</tt> if grab failed
+     */
+    public static native int grabSessionDamage(long session, int x, int y,
+            int width, int height, long output, int outputLength,
+            int[] rects);
+
+    /**
+     * Grab desktop screen in a screen capture session tracking the damaged
+     * areas of the screen and get it as an I420 (i.e. planar YUV 4:2:0)
+     * picture of a specific size. The captured area is converted (and scaled
+     * if its size differs from the size of the picture) straight from the
+     * image of the screen without an intermediate ARGB picture. The picture is
+     * kept by the session and only grabbed and converted again when the
+     * captured area has been damaged (or the cursor has changed) since the
+     * previous grab in the session. Where damage tracking is not available,
+     * every grab is a full grab reported as a single damaged rectangle.
+     *
+     * @param session the screen capture session to grab in
+     * @param x x position to start capture
+     * @param y y position to start capture
+     * @param width capture width
+     * @param height capture height
+     * @param output native output buffer to store the Y, U and V planes of the
+     * picture one after the other in
+     * @param outputLength native output length
+     * @param outputWidth the width of the picture (even)
+     * @param outputHeight the height of the picture (even)
+     * @param rects array to store the x, y, width and height of the damaged
+     * rectangles relative to the picture in. If there are more damaged
+     * rectangles than fit, their bounding box is stored instead.
+     * @return the number of damaged rectangles stored in <tt>rects</tt> (i.e.
+     * <tt>0</tt> if the captured area has not changed since the previous grab)
+     * or <tt>-1</tt> if grab failed
+     */
+    public static native int grabSessionI420(long session, int x, int y,
+            int width, int height, long output, int outputLength,
+            int outputWidth, int outputHeight, int[] rects);
+
+    /**
+     * Grab several regions of desktop screen (e.g. the monitors of a
+     * multi-monitor setup) in parallel in a screen capture session and stitch
+     * them into one buffer of raw bytes. The first region is grabbed by the
+     * calling thread and the others by worker threads of the session, each
+     * with its own connection to the display. Separate buffers for the
+     * regions may be had by laying them out next to each other in
+     * <tt>output</tt>.
+     *
+     * @param session the screen capture session to grab in
+     * @param regions the x, y, width and height of each region on the screen
+     * followed by the x and y position of the region in <tt>output</tt> (i.e.
+     * six ints per region, at most 16 regions)
+     * @param output native output buffer to store screen bytes
+     * @param outputLength native output length
+     * @param outputWidth the width in pixels of <tt>output</tt>
+     * @param times array to store the duration in nanoseconds of the grab of
+     * each region in or <tt>null</tt>
+     * @return true if grab success, false otherwise
+     */
+    public static native boolean grabSessionRegions(long session,
+            int[] regions, long output, int outputLength, int outputWidth,
+            long[] times);
+
+    /**
+     * Opens a screen capture session on a specific display. A session is to
+     * be used by a single thread at a time.
+     *
+     * @param display index of display
+     * @return the screen capture session or <tt>0</tt> if it could not be
+     * opened or sessions are not supported on the current platform
+     */
+    public static native long openSession(int display);
+
+    /**
+     * Sets whether the cursor is drawn into the grabs of a screen capture
+     * session. The cursor is not drawn by default.
+     *
+     * @param session the screen capture session
+     * @param drawCursor <tt>true</tt> to draw the cursor into the grabs of
+     * <tt>session</tt>; otherwise, <tt>false</tt>
+     */
+    public static native void setSessionCursor(long session,
+            boolean drawCursor);
+}
@@ -16,8 +16,10 @@ import javax.media.format.*;
 
 import org.jitsi.impl.neomedia.codec.*;
 import org.jitsi.impl.neomedia.codec.video.*;
+import org.jitsi.impl.neomedia.device.*;
 import org.jitsi.impl.neomedia.imgstreaming.*;
 import org.jitsi.impl.neomedia.jmfext.media.protocol.*;
+import org.jitsi.service.neomedia.device.*;
 import org.jitsi.util.*;
 
 /**
@@ -36,6 +38,28 @@ public class ImageStream
      */
     private static final Logger logger = Logger.getLogger(ImageStream.class);
 
+    /**
+     * The maximum interval in milliseconds between consecutive frames read
+     * out of this <tt>ImageStream</tt> while the screen does not change. Frames
+     * in which nothing has changed are not read out more often so that the
+     * encoders do not process them but the receivers still get a frame to
+     * start decoding with every now and then.
+     */
+    private static final long MAX_UNCHANGED_FRAME_INTERVAL = 1000;
+
+    /**
+     * The maximum number of monitors grabbed in parallel by
+     * {@link ScreenCapture#grabSessionRegions(long, int[], long, int, int,
+     * long[])}.
+     */
+    private static final int MAX_REGIONS = 16;
+
+    /**
+     * The interval in milliseconds at which the screen is polled for changes
+     * while it does not change if the frame rate is not specified.
+     */
+    private static final long UNCHANGED_POLL_INTERVAL = 100;
+
     /**
      * The pool of <tt>ByteBuffer</tt>s this instances is using to optimize the
      * allocations and deallocations of <tt>ByteBuffer</tt>s.
@@ -47,11 +71,60 @@ public class ImageStream
      */
     private DesktopInteract desktopInteract = null;
 
+    /**
+     * The number of areas of the screen stored in {@link #damagedRects} or
+     * <tt>-1</tt> if the last grab did not track the changed areas.
+     */
+    private int damagedRectCount = -1;
+
+    /**
+     * The x, y, width and height of the areas of the screen which have changed
+     * in the last grab in {@link #screenCaptureSession} relative to the
+     * picture read out of this <tt>ImageStream</tt>.
+     */
+    private final int[] damagedRects = new int[4 * 16];
+
     /**
      * Index of display that we will capture from.
      */
     private int displayIndex = -1;
 
+    /**
+     * The time in milliseconds at which the last frame was read out of this
+     * <tt>ImageStream</tt>.
+     */
+    private long lastFrameTime;
+
+    /**
+     * The durations in nanoseconds of the last grabs of {@link #regions}.
+     */
+    private long[] regionGrabTimes;
+
+    /**
+     * The x, y, width and height of each monitor in the captured area followed
+     * by its x and y position in the captured picture or <tt>null</tt> if the
+     * captured area does not span several monitors.
+     */
+    private int[] regions;
+
+    /**
+     * The captured area of the screen {@link #regions} have been computed for.
+     */
+    private Rectangle regionsArea;
+
+    /**
+     * The native screen capture session which keeps the resources needed to
+     * grab {@link #displayIndex} alive between grabs or <tt>0</tt> if there
+     * is no such session.
+     */
+    private long screenCaptureSession = 0;
+
+    /**
+     * The <tt>Object</tt> which synchronizes the access to
+     * {@link #screenCaptureSession}.
+     */
+    private final Object screenCaptureSessionSyncRoot = new Object();
+
     /**
      * Sequence number.
      */
@@ -83,7 +156,11 @@ public class ImageStream
 
     /**
      * Blocks and reads into a <tt>Buffer</tt> from this
-     * <tt>PullBufferStream</tt>.
+     * <tt>PullBufferStream</tt>. When the changed areas of the screen are
+     * tracked, blocks until the screen changes (or for at most
+     * {@link #MAX_UNCHANGED_FRAME_INTERVAL}) and sets the header of
+     * <tt>buffer</tt> to the <tt>Rectangle[]</tt> of the areas which have
+     * changed since the previous frame.
      *
      * @param buffer the <tt>Buffer</tt> this <tt>PullBufferStream</tt> is to
      * read into
@@ -110,6 +187,8 @@ public class ImageStream
                 buffer.setFormat(format);
         }
 
+        Object header = null;
+
         if(format instanceof AVFrameFormat)
         {
             Object o = buffer.getData();
@@ -125,7 +204,23 @@ public class ImageStream
 
             AVFrameFormat avFrameFormat = (AVFrameFormat) format;
             Dimension size = avFrameFormat.getSize();
-            ByteBuffer data = readScreenNative(size);
+            ByteBuffer data = readScreenNativeChanged(size, avFrameFormat);
+
+            if ((data != null) && (damagedRectCount > 0))
+            {
+                Rectangle[] rects = new Rectangle[damagedRectCount];
+
+                for (int i = 0, j = 0; i < rects.length; i++, j += 4)
+                {
+                    rects[i]
+                        = new Rectangle(
+                                damagedRects[j],
+                                damagedRects[j + 1],
+                                damagedRects[j + 2],
+                                damagedRects[j + 3]);
+                }
+                header = rects;
+            }
 
             if(data != null)
             {
@@ -156,13 +251,89 @@ public class ImageStream
             buffer.setLength(bytes.length);
         }
 
-        buffer.setHeader(null);
+        buffer.setHeader(header);
         buffer.setTimeStamp(System.nanoTime());
+        lastFrameTime = System.currentTimeMillis();
         buffer.setSequenceNumber(seqNo);
         buffer.setFlags(Buffer.FLAG_SYSTEM_TIME | Buffer.FLAG_LIVE_DATA);
         seqNo++;
     }
 
+    /**
+     * Gets the regions of the screen, one per monitor, to be grabbed in
+     * parallel when the area captured by this <tt>ImageStream</tt> spans
+     * several monitors combined into a single screen. The monitors are to be
+     * disjoint and to cover the captured area.
+     *
+     * @param dim dimension of the captured area
+     * @return the x, y, width and height of each region on the screen followed
+     * by its x and y position in the captured picture or <tt>null</tt> if the
+     * captured area is not to be grabbed by region
+     */
+    private int[] getRegions(Dimension dim)
+    {
+        Rectangle area = new Rectangle(x, y, dim.width, dim.height);
+
+        if (area.equals(regionsArea))
+            return regions;
+
+        ScreenDevice[] screens = ScreenDeviceImpl.getAvailableScreenDevices();
+        Rectangle[] bounds = new Rectangle[screens.length];
+        int count = 0;
+        long covered = 0;
+
+        for (ScreenDevice screen : screens)
+        {
+            if (!(screen instanceof ScreenDeviceImpl))
+                continue;
+
+            Rectangle r
+                = ((ScreenDeviceImpl) screen).getBounds().intersection(area);
+
+            if (r.isEmpty())
+                continue;
+            for (int i = 0; i < count; i++)
+            {
+                if (bounds[i].intersects(r))
+                {
+                    /* Separate X screens share their coordinates. */
+                    count = -1;
+                    break;
+                }
+            }
+            if (count < 0)
+                break;
+            bounds[count++] = r;
+            covered += (long) r.width * r.height;
+        }
+
+        if ((count < 2)
+                || (count > MAX_REGIONS)
+                || (covered != (long) area.width * area.height))
+        {
+            regions = null;
+            regionGrabTimes = null;
+        }
+        else
+        {
+            regions = new int[6 * count];
+            regionGrabTimes = new long[count];
+            for (int i = 0, j = 0; i < count; i++)
+            {
+                Rectangle r = bounds[i];
+
+                regions[j++] = r.x;
+                regions[j++] = r.y;
+                regions[j++] = r.width;
+                regions[j++] = r.height;
+                regions[j++] = r.x - area.x;
+                regions[j++] = r.y - area.y;
+            }
+        }
+        regionsArea = area;
+        return regions;
+    }
+
     /**
      * Read screen.
      *
@@ -246,11 +417,186 @@ public class ImageStream
         data.setLength(size);
 
         /* get desktop screen via native grabber */
-        if (desktopInteract.captureScreen(
-                    displayIndex,
-                    x, y, dim.width, dim.height,
-                    data.getPtr(),
-                    data.getLength()))
+        boolean grabbed;
+
+        synchronized (screenCaptureSessionSyncRoot)
+        {
+            int[] regions
+                = (screenCaptureSession != 0) ? getRegions(dim) : null;
+
+            if (regions != null)
+            {
+                /*
+                 * The monitors are grabbed in full, in parallel, so the areas
+                 * which have changed are not tracked.
+                 */
+                damagedRectCount = -1;
+                grabbed
+                    = ScreenCapture.grabSessionRegions(
+                            screenCaptureSession,
+                            regions,
+                            data.getPtr(),
+                            data.getLength(),
+                            dim.width,
+                            regionGrabTimes);
+                if (grabbed && logger.isTraceEnabled())
+                {
+                    StringBuilder s
+                        = new StringBuilder("Grabbed the monitors in");
+
+                    for (long time : regionGrabTimes)
+                        s.append(' ').append(time).append(" ns");
+                    logger.trace(s);
+                }
+            }
+            else if (screenCaptureSession != 0)
+            {
+                /*
+                 * Only the areas of the screen which have changed since the
+                 * previous grab are actually grabbed.
+                 */
+                damagedRectCount
+                    = ScreenCapture.grabSessionDamage(
+                            screenCaptureSession,
+                            x, y, dim.width, dim.height,
+                            data.getPtr(),
+                            data.getLength(),
+                            damagedRects);
+                grabbed = (damagedRectCount >= 0);
+            }
+            else
+            {
+                damagedRectCount = -1;
+                grabbed
+                    = desktopInteract.captureScreen(
+                            displayIndex,
+                            x, y, dim.width, dim.height,
+                            data.getPtr(),
+                            data.getLength());
+            }
+        }
+        if (grabbed)
+        {
+            return data;
+        }
+        else
+        {
+            data.free();
+            return null;
+        }
+    }
+
+    /**
+     * Reads the screen into a native buffer as soon as it has changed since
+     * the previous frame. While the changed areas of the screen are tracked
+     * and none has changed, polls the screen at the frame rate of a specific
+     * format for at most {@link #MAX_UNCHANGED_FRAME_INTERVAL} since the
+     * previous frame.
+     *
+     * @param dim dimension of the video
+     * @param format the format of the video, ARGB or I420
+     * @return the native buffer if success, <tt>null</tt> otherwise
+     */
+    private ByteBuffer readScreenNativeChanged(
+            Dimension dim,
+            AVFrameFormat format)
+    {
+        boolean i420 = (format.getPixFmt() == FFmpeg.PIX_FMT_YUV420P);
+        float frameRate = format.getFrameRate();
+        long pollInterval
+            = (frameRate > 0)
+                ? Math.max(1, (long) (1000 / frameRate))
+                : UNCHANGED_POLL_INTERVAL;
+
+        while (true)
+        {
+            ByteBuffer data
+                = i420 ? readScreenNativeI420(dim) : readScreenNative(dim);
+
+            if ((data == null)
+                    || (damagedRectCount != 0)
+                    || (System.currentTimeMillis() - lastFrameTime
+                            >= MAX_UNCHANGED_FRAME_INTERVAL)
+                    || Thread.currentThread().isInterrupted())
+                return data;
+
+            data.free();
+            try
+            {
+                Thread.sleep(pollInterval);
+            }
+            catch (InterruptedException ie)
+            {
+                Thread.currentThread().interrupt();
+            }
+        }
+    }
+
+    /**
+     * Read screen straight into an I420 picture stored in a native buffer.
+     * The captured area has the size of the screen (as reported by the
+     * <tt>CaptureDeviceInfo</tt> of the <tt>DataSource</tt>) and is scaled to
+     * the size of the picture if necessary. The picture is only converted
+     * again when the screen has changed since the previous grab.
+     *
+     * @param dim dimension of the video
+     * @return the native buffer if success, <tt>null</tt> otherwise
+     */
+    private ByteBuffer readScreenNativeI420(Dimension dim)
+    {
+        int size = dim.width * dim.height * 3 / 2;
+        Dimension captureSize = null;
+
+        CaptureDeviceInfo captureDeviceInfo
+            = dataSource.getCaptureDeviceInfo();
+
+        if (captureDeviceInfo != null)
+        {
+            for (Format format : captureDeviceInfo.getFormats())
+            {
+                if (format instanceof VideoFormat)
+                {
+                    captureSize = ((VideoFormat) format).getSize();
+                    if (captureSize != null)
+                        break;
+                }
+            }
+        }
+        if (captureSize == null)
+            captureSize = dim;
+
+        /* pad the buffer */
+        size += FFmpeg.FF_INPUT_BUFFER_PADDING_SIZE;
+
+        /* allocate native array */
+        ByteBuffer data = byteBufferPool.getBuffer(size);
+
+        data.setLength(size);
+
+        /* get desktop screen via native grabber */
+        boolean grabbed;
+
+        synchronized (screenCaptureSessionSyncRoot)
+        {
+            if (screenCaptureSession != 0)
+            {
+                damagedRectCount
+                    = ScreenCapture.grabSessionI420(
+                            screenCaptureSession,
+                            x, y, captureSize.width, captureSize.height,
+                            data.getPtr(),
+                            data.getLength(),
+                            dim.width, dim.height,
+                            damagedRects);
+                grabbed = (damagedRectCount >= 0);
+            }
+            else
+            {
+                damagedRectCount = -1;
+                grabbed = false;
+            }
+        }
+        if (grabbed)
         {
             return data;
         }
@@ -306,6 +652,35 @@ public class ImageStream
                 logger.warn("Cannot create DesktopInteract object!");
             }
         }
+
+        synchronized (screenCaptureSessionSyncRoot)
+        {
+            if ((screenCaptureSession == 0) && (desktopInteract != null))
+            {
+                try
+                {
+                    screenCaptureSession
+                        = ScreenCapture.openSession(displayIndex);
+                    if (screenCaptureSession != 0)
+                    {
+                        ScreenCapture.setSessionCursor(
+                                screenCaptureSession,
+                                true);
+                    }
+                }
+                catch (Throwable t)
+                {
+                    if (t instanceof ThreadDeath)
+                        throw (ThreadDeath) t;
+                    else
+                    {
+                        logger.warn(
+                                "Cannot open native screen capture session!",
+                                t);
+                    }
+                }
+            }
+        }
     }
 
     /**
@@ -326,6 +701,15 @@ public class ImageStream
         {
             super.stop();
 
+            synchronized (screenCaptureSessionSyncRoot)
+            {
+                if (screenCaptureSession != 0)
+                {
+                    ScreenCapture.closeSession(screenCaptureSession);
+                    screenCaptureSession = 0;
+                }
+            }
+
             byteBufferPool.drain();
         }
     }
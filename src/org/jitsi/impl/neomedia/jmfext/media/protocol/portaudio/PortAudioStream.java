@@ -369,6 +369,7 @@ public class PortAudioStream
         this.framesPerBuffer = framesPerBuffer;
         bytesPerBuffer
             = Pa.GetSampleSize(sampleFormat) * channels * framesPerBuffer;
+        PortAudioSystem.setSchedPolicy(stream);
 
         /*
          * Know the Format in which this PortAudioStream will output audio
@@ -643,6 +644,18 @@ public class PortAudioStream
 
                 boolean closed = false;
 
+                if (logger.isDebugEnabled())
+                {
+                    logger.debug(
+                            "Scheduling policy of "
+                                + getClass().getSimpleName()
+                                + ": "
+                                + Pa.GetStreamSchedPolicy(stream));
+                    logger.debug(
+                            "PortAudio capture stream stats: "
+                                + PortAudioSystem.streamStatsToString(stream));
+                }
+
                 try
                 {
                     Pa.CloseStream(stream);
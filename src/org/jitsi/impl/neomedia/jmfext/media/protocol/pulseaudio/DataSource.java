@@ -38,8 +38,6 @@ public class DataSource
 
     private static final int BUFFER_IN_TENS_OF_MILLIS = 10;
 
-    private static final boolean DEBUG = logger.isDebugEnabled();
-
     private static final int FRAGSIZE_IN_TENS_OF_MILLIS = 2;
 
     private static final boolean SOFTWARE_GAIN;
@@ -84,8 +82,6 @@ public class DataSource
     private class PulseAudioStream
         extends AbstractPullBufferStream<DataSource>
     {
-        private byte[] buffer;
-
         private int channels;
 
         private boolean corked = true;
@@ -98,23 +94,28 @@ public class DataSource
 
         private float gainControlLevel;
 
-        private int length;
-
-        private int offset;
-
         private final PulseAudioSystem pulseAudioSystem;
 
-        private final PA.stream_request_cb_t readCallback
-            = new PA.stream_request_cb_t()
-            {
-                public void callback(long s, int nbytes)
-                {
-                    readCallback(s, nbytes);
-                }
-            };
+        /**
+         * The native I/O pump which reads the audio of {@link #stream} on the
+         * thread of the threaded mainloop so that {@link #read(Buffer)} does
+         * not have to acquire the mainloop lock in order to read it.
+         */
+        private volatile long pump;
+
+        /**
+         * The <tt>Object</tt> which synchronizes {@link #read(Buffer)} with the
+         * freeing of {@link #pump}.
+         */
+        private final Object readSyncRoot = new Object();
 
         private long stream;
 
+        /**
+         * The health counters of {@link #stream}.
+         */
+        private long streamStats;
+
         /**
          * Initializes a new <tt>PulseAudioStream</tt> which is to have its
          * <tt>Format</tt>-related information abstracted by a specific
@@ -146,163 +147,65 @@ public class DataSource
         public void read(Buffer buffer)
             throws IOException
         {
-            pulseAudioSystem.lockMainloop();
-            try
+            byte[] data;
+            int length;
+
+            synchronized (readSyncRoot)
             {
-                if (stream == 0)
+                long pump = this.pump;
+
+                if (pump == 0)
                     throw new IOException("stream");
 
-                byte[] data
+                data
                     = AbstractCodec2.validateByteArraySize(
                             buffer,
                             fragsize,
                             false);
-                int toRead = fragsize;
-                int offset = 0;
-                int length = 0;
-
-                while (toRead > 0)
-                {
-                    if (corked)
-                        break;
-
-                    if (this.length <= 0)
-                    {
-                        pulseAudioSystem.waitMainloop();
-                        continue;
-                    }
-
-                    int toCopy = (toRead < this.length) ? toRead : this.length;
-
-                    System.arraycopy(
-                            this.buffer, this.offset,
-                            data, offset,
-                            toCopy);
-
-                    this.offset += toCopy;
-                    this.length -= toCopy;
-                    if (this.length <= 0)
-                    {
-                        this.offset = 0;
-                        this.length = 0;
-                    }
-
-                    toRead -= toCopy;
-                    offset += toCopy;
-                    length += toCopy;
-                }
+                /*
+                 * The pump is interrupted while the stream is corked so the
+                 * reading does not block then.
+                 */
+                length = PA.pump_read(pump, data, 0, fragsize);
+            }
 
-                buffer.setFlags(Buffer.FLAG_SYSTEM_TIME);
-                buffer.setLength(length);
-                buffer.setOffset(0);
-                buffer.setTimeStamp(System.nanoTime());
+            buffer.setFlags(Buffer.FLAG_SYSTEM_TIME);
+            buffer.setLength(length);
+            buffer.setOffset(0);
+            buffer.setTimeStamp(System.nanoTime());
 
-                if (gainControl != null)
+            if (gainControl != null)
+            {
+                if (SOFTWARE_GAIN || (cvolume == 0))
                 {
-                    if (SOFTWARE_GAIN || (cvolume == 0))
-                    {
-                        if (length > 0)
-                        {
-                            BasicVolumeControl.applyGain(
-                                    gainControl,
-                                    data, 0, length);
-                        }
-                    }
-                    else
+                    if (length > 0)
                     {
-                        float gainControlLevel = gainControl.getLevel();
-
-                        if (this.gainControlLevel != gainControlLevel)
-                        {
-                            this.gainControlLevel = gainControlLevel;
-                            setStreamVolume(stream, gainControlLevel);
-                        }
+                        BasicVolumeControl.applyGain(
+                                gainControl,
+                                data, 0, length);
                     }
                 }
-            }
-            finally
-            {
-                pulseAudioSystem.unlockMainloop();
-            }
-        }
-
-        private void readCallback(long stream, int length)
-        {
-            try
-            {
-                int peeked;
-
-                if (corked)
-                    peeked = 0;
                 else
                 {
-                    int offset;
+                    float gainControlLevel = gainControl.getLevel();
 
-                    if ((buffer == null) || (buffer.length < length))
+                    if (this.gainControlLevel != gainControlLevel)
                     {
-                        buffer = new byte[length];
-                        this.offset = 0;
-                        this.length = 0;
-                        offset = 0;
-                    }
-                    else
-                    {
-                        offset = this.offset + this.length;
-                        if (offset + length > buffer.length)
+                        pulseAudioSystem.lockMainloop();
+                        try
                         {
-                            int overflow = this.length + length - buffer.length;
-
-                            if (overflow > 0)
+                            if (stream != 0)
                             {
-                                if (overflow >= this.length)
-                                {
-                                    if (DEBUG && logger.isDebugEnabled())
-                                    {
-                                        logger.debug(
-                                                "Dropping "
-                                                    + this.length
-                                                    + " bytes!");
-                                    }
-                                    this.offset = 0;
-                                    this.length = 0;
-                                    offset = 0;
-                                }
-                                else
-                                {
-                                    if (DEBUG && logger.isDebugEnabled())
-                                    {
-                                        logger.debug(
-                                                "Dropping "
-                                                    + overflow
-                                                    + " bytes!");
-                                    }
-                                    this.offset += overflow;
-                                    this.length -= overflow;
-                                }
-                            }
-                            if (this.length > 0)
-                            {
-                                for (int i = 0;
-                                        i < this.length;
-                                        i++, this.offset++)
-                                {
-                                    buffer[i] = buffer[this.offset];
-                                }
-                                this.offset = 0;
-                                offset = this.length;
+                                this.gainControlLevel = gainControlLevel;
+                                setStreamVolume(stream, gainControlLevel);
                             }
                         }
+                        finally
+                        {
+                            pulseAudioSystem.unlockMainloop();
+                        }
                     }
-
-                    peeked = PA.stream_peek(stream, buffer, offset);
                 }
-
-                PA.stream_drop(stream);
-                this.length += peeked;
-            }
-            finally
-            {
-                pulseAudioSystem.signalMainloop(false);
             }
         }
 
@@ -378,7 +281,6 @@ public class DataSource
                     = (sampleRate / 100) * channels * (sampleSizeInBits / 8);
 
                 fragsize = FRAGSIZE_IN_TENS_OF_MILLIS * bytesPerTenMillis;
-                buffer = new byte[BUFFER_IN_TENS_OF_MILLIS * bytesPerTenMillis];
 
                 long attr
                     = PA.buffer_attr_new(
@@ -428,9 +330,16 @@ public class DataSource
                         if (state != PA.STREAM_READY)
                             throw new IOException("stream.state");
 
-                        PA.stream_set_read_callback(
-                                stream,
-                                readCallback);
+                        streamStats = PA.stream_stats_new(stream, false);
+                        pump
+                            = pulseAudioSystem.createPump(
+                                    stream,
+                                    BUFFER_IN_TENS_OF_MILLIS
+                                        * bytesPerTenMillis,
+                                    false,
+                                    streamStats);
+                        /* The stream starts corked. */
+                        PA.pump_set_interrupted(pump, true);
 
                         if (!SOFTWARE_GAIN && (gainControl != null))
                         {
@@ -461,7 +370,19 @@ public class DataSource
                     finally
                     {
                         if (this.stream == 0)
+                        {
+                            if (pump != 0)
+                            {
+                                PA.pump_free(pump);
+                                pump = 0;
+                            }
+                            if (streamStats != 0)
+                            {
+                                PA.stream_stats_free(streamStats);
+                                streamStats = 0;
+                            }
                             PA.stream_disconnect(stream);
+                        }
                     }
                 }
                 finally
@@ -487,6 +408,12 @@ public class DataSource
             }
             finally
             {
+                /*
+                 * Do not let read(Buffer) block while no audio is to be read
+                 * from the stream.
+                 */
+                if (pump != 0)
+                    PA.pump_set_interrupted(pump, corked);
                 pulseAudioSystem.signalMainloop(false);
             }
         }
@@ -494,43 +421,73 @@ public class DataSource
         public void disconnect()
             throws IOException
         {
+            /*
+             * Stop first in order to interrupt the pump and, consequently, to
+             * have read(Buffer) release readSyncRoot.
+             */
             pulseAudioSystem.lockMainloop();
             try
             {
-                long stream = this.stream;
-
                 if (stream != 0)
+                    stopWithMainloopLock();
+            }
+            finally
+            {
+                pulseAudioSystem.unlockMainloop();
+
+                synchronized (readSyncRoot)
                 {
+                    pulseAudioSystem.lockMainloop();
                     try
                     {
-                        stopWithMainloopLock();
+                        disconnectWithMainloopLock();
                     }
                     finally
                     {
-                        long cvolume = this.cvolume;
+                        pulseAudioSystem.unlockMainloop();
+                    }
+                }
+            }
+        }
 
-                        this.cvolume = 0;
-                        this.stream = 0;
+        private void disconnectWithMainloopLock()
+        {
+            long stream = this.stream;
 
-                        buffer = null;
-                        corked = true;
-                        fragsize = 0;
-                        length = 0;
-                        offset = 0;
+            if (stream == 0)
+                return;
 
-                        pulseAudioSystem.signalMainloop(false);
+            long cvolume = this.cvolume;
+            long pump = this.pump;
+            long streamStats = this.streamStats;
 
-                        if (cvolume != 0)
-                            PA.cvolume_free(cvolume);
-                        PA.stream_disconnect(stream);
-                        PA.stream_unref(stream);
-                    }
-                }
-            }
-            finally
+            this.cvolume = 0;
+            this.pump = 0;
+            this.stream = 0;
+            this.streamStats = 0;
+
+            corked = true;
+            fragsize = 0;
+
+            pulseAudioSystem.signalMainloop(false);
+
+            if (cvolume != 0)
+                PA.cvolume_free(cvolume);
+            if (pump != 0)
+                PA.pump_free(pump);
+            if (streamStats != 0)
             {
-                pulseAudioSystem.unlockMainloop();
+                if (logger.isDebugEnabled())
+                {
+                    logger.debug(
+                            "PulseAudio record stream stats: "
+                                + PulseAudioSystem.streamStatsToString(
+                                        streamStats));
+                }
+                PA.stream_stats_free(streamStats);
             }
+            PA.stream_disconnect(stream);
+            PA.stream_unref(stream);
         }
 
         private void setStreamVolume(long stream, float level)
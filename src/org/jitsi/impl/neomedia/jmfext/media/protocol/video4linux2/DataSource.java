@@ -37,10 +37,11 @@ public class DataSource
                     FFmpeg.PIX_FMT_YUV420P,
                     Video4Linux2.V4L2_PIX_FMT_YUYV,
                     FFmpeg.PIX_FMT_YUYV422,
+                    /* The capture engine decodes (M)JPEG into YUV420P. */
                     Video4Linux2.V4L2_PIX_FMT_MJPEG,
-                    FFmpeg.PIX_FMT_YUVJ422P,
+                    FFmpeg.PIX_FMT_YUV420P,
                     Video4Linux2.V4L2_PIX_FMT_JPEG,
-                    FFmpeg.PIX_FMT_YUVJ422P,
+                    FFmpeg.PIX_FMT_YUV420P,
                     Video4Linux2.V4L2_PIX_FMT_RGB24,
                     FFmpeg.PIX_FMT_RGB24_1,
                     Video4Linux2.V4L2_PIX_FMT_BGR24,
@@ -98,8 +98,114 @@ public class Video4Linux2
         VIDIOC_STREAMON = VIDIOC_STREAMON();
     }
 
+    /**
+     * Stops and releases a native capture engine. If the Java side still
+     * holds frames of the engine, the release of its native memory is deferred
+     * until the last of them is released.
+     *
+     * @param capture the native capture engine to free
+     */
+    public static native void capture_free(long capture);
+
+    /**
+     * Gets the histogram of the times which the decode threads of a native
+     * capture engine have taken to decode frames. Element <tt>0</tt> counts
+     * the decodes which took less than a millisecond, element <tt>i</tt> those
+     * which took less than <tt>2^i</tt> milliseconds and the last element all
+     * the rest.
+     *
+     * @param capture the native capture engine to get the histogram of
+     * @param decodeTimes the array to copy the histogram into
+     * @return the number of elements of the histogram
+     */
+    public static native int capture_getDecodeTimes(
+            long capture,
+            long[] decodeTimes);
+
+    /**
+     * Initializes a new native capture engine which requests <tt>count</tt>
+     * buffers from a Video for Linux Two API Specification device and owns
+     * them as a pool of frames into which the device captures media data. With
+     * <tt>V4L2_MEMORY_USERPTR</tt> the engine allocates page-aligned buffers
+     * which the device writes into directly.
+     *
+     * @param fd the file descriptor of the device with its format already set
+     * @param count the number of buffers to request from the device
+     * @param memory <tt>V4L2_MEMORY_MMAP</tt> or <tt>V4L2_MEMORY_USERPTR</tt>
+     * @return the new native capture engine or <tt>0</tt> upon failure
+     */
+    public static native long capture_new(int fd, int count, int memory);
+
+    /**
+     * Blocks until the native capture thread of a specific engine publishes a
+     * frame which has not been read yet and returns the latest one. The
+     * returned frame is to be released with {@link #frame_release(long)}.
+     *
+     * @param capture the native capture engine to read from
+     * @return the latest frame captured by <tt>capture</tt> or <tt>0</tt> if
+     * <tt>capture</tt> has been stopped or its device has failed
+     */
+    public static native long capture_read(long capture);
+
+    /**
+     * Makes a stopped native capture engine decode the captured (Motion) JPEG
+     * frames with a specific native <tt>MJPEGDecoder</tt> on a number of
+     * threads in parallel. The frames read from the engine afterwards are I420
+     * pictures of the size of the device format from a pool of the engine and
+     * are published in the order of their capture.
+     *
+     * @param capture the native capture engine to set the decoder of
+     * @param decoder the native <tt>MJPEGDecoder</tt> e.g.
+     * <tt>FFmpeg.mjpeg_decoder()</tt>
+     * @param threadCount the number of decode threads
+     * @return <tt>0</tt> upon success; otherwise, <tt>-1</tt>
+     */
+    public static native int capture_setDecoder(
+            long capture,
+            long decoder,
+            int threadCount);
+
+    /**
+     * Enqueues the buffers of a native capture engine, starts the streaming
+     * of its device and starts its capture thread.
+     *
+     * @param capture the native capture engine to start
+     * @return <tt>0</tt> upon success; otherwise, <tt>-1</tt>
+     */
+    public static native int capture_start(long capture);
+
+    public static native int capture_stop(long capture);
+
     public static native int close(int fd);
 
+    public static native long frame_getData(long frame);
+
+    public static native int frame_getLength(long frame);
+
+    /**
+     * Gets the sequence number which the Video for Linux Two API Specification
+     * driver has assigned to a specific frame. A gap between the sequence
+     * numbers of consecutive frames tells the number of dropped frames.
+     *
+     * @param frame the frame to get the sequence number of
+     * @return the sequence number (as an unsigned 32-bit value) of
+     * <tt>frame</tt>
+     */
+    public static native int frame_getSequence(long frame);
+
+    /**
+     * Gets the time at which a specific frame has been captured as reported by
+     * the Video for Linux Two API Specification driver.
+     *
+     * @param frame the frame to get the capture time of
+     * @return the capture time in nanoseconds on the <tt>CLOCK_MONOTONIC</tt>
+     * clock (i.e. the clock of <tt>System.nanoTime()</tt>) of <tt>frame</tt>
+     * or <tt>0</tt> if the driver does not timestamp on that clock
+     */
+    public static native long frame_getTimestamp(long frame);
+
+    public static native void frame_release(long frame);
+
     public static native void free(long ptr);
 
     public static native int ioctl(int fd, int request, long argp);
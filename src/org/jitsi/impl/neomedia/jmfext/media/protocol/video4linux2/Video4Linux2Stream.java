@@ -17,6 +17,7 @@ import org.jitsi.impl.neomedia.*;
 import org.jitsi.impl.neomedia.codec.*;
 import org.jitsi.impl.neomedia.codec.video.*;
 import org.jitsi.impl.neomedia.jmfext.media.protocol.*;
+import org.jitsi.util.*;
 
 /**
  * Implements a <tt>PullBufferStream</tt> using the Video for Linux Two API
@@ -28,23 +29,35 @@ public class Video4Linux2Stream
     extends AbstractVideoPullBufferStream<DataSource>
 {
     /**
-     * The <tt>AVCodecContext</tt> of the MJPEG decoder.
+     * The number of buffers which the native capture engine requests from the
+     * Video for Linux Two API Specification device. A buffer is only enqueued
+     * back to the device after the <tt>Buffer</tt> it has been read into has
+     * been given another frame so there should be some to spare.
      */
-    private long avctx = 0;
+    private static final int CAPTURE_BUFFER_COUNT = 6;
 
     /**
-     * The <tt>AVFrame</tt> which represents the media data decoded by the MJPEG
-     * decoder/{@link #avctx}.
+     * The <tt>Logger</tt> used by the <tt>Video4Linux2Stream</tt> class and its
+     * instances for logging output.
      */
-    private long avframe = 0;
+    private static final Logger logger
+        = Logger.getLogger(Video4Linux2Stream.class);
 
     /**
-     * The pool of <tt>ByteBuffer</tt>s this instances is using to transfer the
-     * media data captured by the Video for Linux Two API Specification device
-     * out of this instance through the <tt>Buffer</tt>s specified in its
-     * {@link #read(Buffer)}.
+     * The number of threads on which the native capture engine decodes (M)JPEG
+     * in parallel. A processor is left to the encoder if there are enough.
      */
-    private final ByteBufferPool byteBufferPool = new ByteBufferPool();
+    private static final int MJPEG_DECODE_THREAD_COUNT
+        = Math.max(
+                1,
+                Math.min(4, Runtime.getRuntime().availableProcessors() - 1));
+
+    /**
+     * The native capture engine which owns the buffers of the Video for Linux
+     * Two API Specification device represented by {@link #fd} and dequeues and
+     * enqueues them on its own thread.
+     */
+    private long capture = 0;
 
     /**
      * The capabilities of the Video for Linux Two API Specification device
@@ -52,6 +65,13 @@ public class Video4Linux2Stream
      */
     private int capabilities = 0;
 
+    /**
+     * The number of frames which the Video for Linux Two API Specification
+     * driver has dropped since the start of the capture as told by the gaps in
+     * the sequence numbers of the captured frames.
+     */
+    private long droppedFrameCount = 0;
+
     /**
      * The file descriptor of the Video for Linux Two API Specification device
      * read through this <tt>PullBufferStream</tt>.
@@ -65,33 +85,18 @@ public class Video4Linux2Stream
     private Format format;
 
     /**
-     * The lengths in bytes of the buffers in the application's address space
-     * through which the Video for Linux Two API Specification device provides
-     * the captured media data to this instance when
-     * {@link #requestbuffersMemory} is equal to <tt>V4L2_MEMORY_MAP</tt>.
+     * The sequence number assigned by the Video for Linux Two API
+     * Specification driver to the last frame read through this
+     * <tt>PullBufferStream</tt> or <tt>-1</tt> if no frame has been read since
+     * the start of the capture.
      */
-    private int[] mmapLengths;
-
-    /**
-     * The buffers through which the Video for Linux Two API Specification
-     * device provides the captured media data to this instance when
-     * {@link #requestbuffersMemory} is equal to <tt>V4L2_MEMORY_MAP</tt>. These
-     * are mapped in the application's address space.
-     */
-    private long[] mmaps;
+    private long lastSequence = -1;
 
     /**
      * Native Video for Linux Two pixel format.
      */
     private int nativePixelFormat = 0;
 
-    /**
-     * The number of buffers through which the Video for Linux Two API
-     * Specification device provides the captured media data to this instance
-     * when {@link #requestbuffersMemory} is equal to <tt>V4L2_MEMORY_MMAP</tt>.
-     */
-    private int requestbuffersCount = 0;
-
     /**
      * The input method negotiated by this instance with the Video for Linux Two
      * API Specification device.
@@ -103,13 +108,6 @@ public class Video4Linux2Stream
      */
     private boolean startInRead = false;
 
-    /**
-     * The <tt>v4l2_buffer</tt> instance via which captured media data is
-     * fetched from the Video for Linux Two API Specification device to this
-     * instance in {@link #read(Buffer)}.
-     */
-    private long v4l2_buffer;
-
     /**
      * Initializes a new <tt>Video4Linux2Stream</tt> instance which is to have
      * its <tt>Format</tt>-related information abstracted by a specific
@@ -125,15 +123,6 @@ public class Video4Linux2Stream
             FormatControl formatControl)
     {
         super(dataSource, formatControl);
-
-        v4l2_buffer
-            = Video4Linux2.v4l2_buffer_alloc(
-                    Video4Linux2.V4L2_BUF_TYPE_VIDEO_CAPTURE);
-        if (0 == v4l2_buffer)
-            throw new OutOfMemoryError("v4l2_buffer_alloc");
-        Video4Linux2.v4l2_buffer_setMemory(
-                v4l2_buffer,
-                Video4Linux2.V4L2_MEMORY_MMAP);
     }
 
     /**
@@ -147,13 +136,6 @@ public class Video4Linux2Stream
     public void close()
     {
         super.close();
-
-        if (v4l2_buffer != 0)
-        {
-            Video4Linux2.free(v4l2_buffer);
-            v4l2_buffer = 0;
-        }
-        byteBufferPool.drain();
     }
 
     /**
@@ -215,100 +197,71 @@ public class Video4Linux2Stream
                 buffer.setFormat(format);
         }
 
+        if (capture == 0)
+            throw new IOException("No V4L2 capture engine");
+
         if(startInRead)
         {
             startInRead = false;
 
-            long v4l2_buf_type
-                = Video4Linux2.v4l2_buf_type_alloc(
-                        Video4Linux2.V4L2_BUF_TYPE_VIDEO_CAPTURE);
-
-            if (0 == v4l2_buf_type)
-                throw new OutOfMemoryError("v4l2_buf_type_alloc");
-            try
-            {
-                if (Video4Linux2.ioctl(fd, Video4Linux2.VIDIOC_STREAMON,
-                        v4l2_buf_type) == -1)
-                {
-                    throw new IOException("ioctl: request= VIDIOC_STREAMON");
-                }
-            }
-            finally
-            {
-                Video4Linux2.free(v4l2_buf_type);
-            }
+            if (Video4Linux2.capture_start(capture) == -1)
+                throw new IOException("capture_start");
         }
 
-        if (Video4Linux2.ioctl(fd, Video4Linux2.VIDIOC_DQBUF, v4l2_buffer)
-                == -1)
-            throw new IOException("ioctl: request= VIDIOC_DQBUF");
+        long frame = Video4Linux2.capture_read(capture);
 
-        long timeStamp = System.nanoTime();
+        if (frame == 0)
+            throw new IOException("capture_read");
 
-        try
-        {
-            int index = Video4Linux2.v4l2_buffer_getIndex(v4l2_buffer);
-            long mmap = mmaps[index];
-            int bytesused = Video4Linux2.v4l2_buffer_getBytesused(v4l2_buffer);
-
-            if((nativePixelFormat == Video4Linux2.V4L2_PIX_FMT_JPEG)
-                    || (nativePixelFormat == Video4Linux2.V4L2_PIX_FMT_MJPEG))
-            {
-                /* Initialize the FFmpeg MJPEG decoder if necessary. */
-                if(avctx == 0)
-                {
-                    long avcodec
-                        = FFmpeg.avcodec_find_decoder(FFmpeg.CODEC_ID_MJPEG);
+        /*
+         * The driver timestamps the frames on CLOCK_MONOTONIC which is the
+         * clock of System.nanoTime() on Linux so the time of the capture rather
+         * than the time of the read is given downstream. The engine reports 0
+         * if the driver uses another clock.
+         */
+        long timeStamp = Video4Linux2.frame_getTimestamp(frame);
+        long sequence = Video4Linux2.frame_getSequence(frame) & 0xFFFFFFFFL;
 
-                    avctx = FFmpeg.avcodec_alloc_context3(avcodec);
-                    FFmpeg.avcodeccontext_set_workaround_bugs(avctx,
-                            FFmpeg.FF_BUG_AUTODETECT);
+        if (timeStamp == 0)
+            timeStamp = System.nanoTime();
+        if (lastSequence != -1)
+        {
+            long gap = (sequence - lastSequence) & 0xFFFFFFFFL;
 
-                    if (FFmpeg.avcodec_open2(avctx, avcodec) < 0)
-                    {
-                        throw new RuntimeException("" +
-                                "Could not open codec CODEC_ID_MJPEG");
-                    }
+            if ((gap > 1) && (gap < 0x80000000L))
+                droppedFrameCount += gap - 1;
+        }
+        lastSequence = sequence;
 
-                    avframe = FFmpeg.avcodec_alloc_frame();
-                }
+        /*
+         * Hand the frame itself downstream. It is released to the native
+         * capture engine when the AVFrame is given the next frame. (M)JPEG has
+         * already been decoded into I420 by the engine.
+         */
+        ByteBuffer byteBuffer
+            = new FrameByteBuffer(frame, Video4Linux2.frame_getData(frame));
 
-                if(FFmpeg.avcodec_decode_video(avctx, avframe, mmap, bytesused)
-                        != -1)
-                {
-                    Object out = buffer.getData();
+        byteBuffer.setLength(Video4Linux2.frame_getLength(frame));
+        if (AVFrame.read(buffer, format, byteBuffer) < 0)
+            byteBuffer.free();
 
-                    if (!(out instanceof AVFrame)
-                            || (((AVFrame) out).getPtr() != avframe))
-                    {
-                        buffer.setData(new AVFrame(avframe));
-                    }
-                }
-            }
-            else
-            {
-                ByteBuffer data = byteBufferPool.getBuffer(bytesused);
+        buffer.setFlags(Buffer.FLAG_LIVE_DATA | Buffer.FLAG_SYSTEM_TIME);
+        buffer.setTimeStamp(timeStamp);
+        buffer.setSequenceNumber(sequence);
+    }
 
-                if (data != null)
-                {
-                    Video4Linux2.memcpy(data.getPtr(), mmap, bytesused);
-                    data.setLength(bytesused);
-                    if (AVFrame.read(buffer, format, data) < 0)
-                        data.free();
-                }
-            }
-        }
-        finally
+    /**
+     * Frees {@link #capture} i.e. the native capture engine which owns the
+     * buffers through which the Video for Linux Two API Specification device
+     * provides the captured media data to this instance.
+     */
+    private void freeCapture()
+    {
+        if (capture != 0)
         {
-            if (Video4Linux2.ioctl(fd, Video4Linux2.VIDIOC_QBUF, v4l2_buffer)
-                    == -1)
-            {
-                throw new IOException("ioctl: request= VIDIOC_QBUF");
-            }
+            Video4Linux2.capture_free(capture);
+            capture = 0;
         }
-
-        buffer.setFlags(Buffer.FLAG_LIVE_DATA | Buffer.FLAG_SYSTEM_TIME);
-        buffer.setTimeStamp(timeStamp);
     }
 
     /**
@@ -376,39 +329,6 @@ public class Video4Linux2Stream
         return format;
     }
 
-    /**
-     * Unmaps the buffers through which the Video for Linux Two API
-     * Specification device provides the captured media data to this instance
-     * when {@link #requestbuffersMemory} is equal to <tt>V4L2_MEMORY_MMAP</tt>
-     * i.e. breaks the buffers' mappings between the driver's and the
-     * application's address spaces.
-     */
-    private void munmap()
-    {
-        try
-        {
-            if (mmaps != null)
-            {
-                for (int i = 0; i < mmaps.length; i++)
-                {
-                    long mmap = mmaps[i];
-
-                    if (mmap != 0)
-                    {
-                        Video4Linux2.munmap(mmap, mmapLengths[i]);
-                        mmaps[i] = 0;
-                        mmapLengths[i] = 0;
-                    }
-                }
-            }
-        }
-        finally
-        {
-            mmaps = null;
-            mmapLengths = null;
-        }
-    }
-
     /**
      * Negotiates the input method with the Video for Linux Two API
      * Specification device represented by the <tt>fd</tt> of this instance.
@@ -443,105 +363,46 @@ public class Video4Linux2Stream
                 != Video4Linux2.V4L2_CAP_STREAMING)
             throw new IOException("Non-streaming V4L2 device not supported.");
 
-        long v4l2_requestbuffers
-            = Video4Linux2.v4l2_requestbuffers_alloc(
-                    Video4Linux2.V4L2_BUF_TYPE_VIDEO_CAPTURE);
-
-        if (0 == v4l2_requestbuffers)
-            throw new OutOfMemoryError("v4l2_requestbuffers_alloc");
-        try
+        /*
+         * Prefer that the device writes into memory allocated by the native
+         * capture engine and fall back to memory mapped from the device.
+         */
+        requestbuffersMemory = Video4Linux2.V4L2_MEMORY_USERPTR;
+        capture
+            = Video4Linux2.capture_new(
+                    fd,
+                    CAPTURE_BUFFER_COUNT,
+                    requestbuffersMemory);
+        if (capture == 0)
         {
             requestbuffersMemory = Video4Linux2.V4L2_MEMORY_MMAP;
-            Video4Linux2.v4l2_requestbuffers_setMemory(
-                    v4l2_requestbuffers,
-                    requestbuffersMemory);
-            Video4Linux2.v4l2_requestbuffers_setCount(v4l2_requestbuffers, 2);
-            if (Video4Linux2.ioctl(
+            capture
+                = Video4Linux2.capture_new(
                         fd,
-                        Video4Linux2.VIDIOC_REQBUFS,
-                        v4l2_requestbuffers)
-                    == -1)
-            {
-                throw new IOException(
-                        "ioctl: request= VIDIOC_REQBUFS, memory= "
-                            + requestbuffersMemory);
-            }
-            requestbuffersCount
-                = Video4Linux2.v4l2_requestbuffers_getCount(
-                        v4l2_requestbuffers);
+                        CAPTURE_BUFFER_COUNT,
+                        requestbuffersMemory);
         }
-        finally
+        if (capture == 0)
         {
-            Video4Linux2.free(v4l2_requestbuffers);
+            throw new IOException(
+                    "capture_new: memory= " + requestbuffersMemory);
         }
-        if (requestbuffersCount < 1)
-            throw new IOException("Insufficient V4L2 device memory.");
 
-
-        long v4l2_buffer
-            = Video4Linux2.v4l2_buffer_alloc(
-                    Video4Linux2.V4L2_BUF_TYPE_VIDEO_CAPTURE);
-
-        if (0 == v4l2_buffer)
-            throw new OutOfMemoryError("v4l2_buffer_alloc");
-
-        try
+        if ((nativePixelFormat == Video4Linux2.V4L2_PIX_FMT_JPEG)
+                || (nativePixelFormat == Video4Linux2.V4L2_PIX_FMT_MJPEG))
         {
-            Video4Linux2.v4l2_buffer_setMemory(
-                    v4l2_buffer,
-                    Video4Linux2.V4L2_MEMORY_MMAP);
-
-            mmaps = new long[requestbuffersCount];
-            mmapLengths = new int[requestbuffersCount];
-
-            boolean munmap = true;
-
-            try
-            {
-                for (int i = 0; i < requestbuffersCount; i++)
-                {
-                    Video4Linux2.v4l2_buffer_setIndex(v4l2_buffer, i);
-                    if (Video4Linux2.ioctl(
-                                fd,
-                                Video4Linux2.VIDIOC_QUERYBUF,
-                                v4l2_buffer)
-                            == -1)
-                    {
-                        throw
-                            new IOException("ioctl: request= VIDIOC_QUERYBUF");
-                    }
-
-                    int length
-                        = Video4Linux2.v4l2_buffer_getLength(v4l2_buffer);
-                    long offset
-                        = Video4Linux2.v4l2_buffer_getMOffset(v4l2_buffer);
-                    long mmap
-                        = Video4Linux2.mmap(
-                                0,
-                                length,
-                                Video4Linux2.PROT_READ
-                                    | Video4Linux2.PROT_WRITE,
-                                Video4Linux2.MAP_SHARED,
-                                fd,
-                                offset);
-
-                    if (-1 == mmap)
-                        throw new IOException("mmap");
-                    mmaps[i] = mmap;
-                    mmapLengths[i] = length;
-                }
-                munmap = false;
-            }
-            finally
+            if (Video4Linux2.capture_setDecoder(
+                        capture,
+                        FFmpeg.mjpeg_decoder(),
+                        MJPEG_DECODE_THREAD_COUNT)
+                    == -1)
             {
-                if (munmap)
-                    munmap();
+                freeCapture();
+                throw new IOException(
+                        "capture_setDecoder: threadCount= "
+                            + MJPEG_DECODE_THREAD_COUNT);
             }
         }
-        finally
-        {
-            Video4Linux2.free(v4l2_buffer);
-        }
     }
 
     /**
@@ -569,7 +430,7 @@ public class Video4Linux2Stream
                 catch (IOException ioex)
                 {
                 }
-                munmap();
+                freeCapture();
             }
 
             /*
@@ -584,7 +445,6 @@ public class Video4Linux2Stream
             this.fd = -1;
             this.capabilities = 0;
             this.requestbuffersMemory = 0;
-            this.requestbuffersCount = 0;
 
             if (fd != -1)
             {
@@ -754,36 +614,6 @@ public class Video4Linux2Stream
     {
         super.start();
 
-        long v4l2_buffer
-            = Video4Linux2.v4l2_buffer_alloc(
-                    Video4Linux2.V4L2_BUF_TYPE_VIDEO_CAPTURE);
-
-        if (0 == v4l2_buffer)
-            throw new OutOfMemoryError("v4l2_buffer_alloc");
-        try
-        {
-            Video4Linux2.v4l2_buffer_setMemory(
-                    v4l2_buffer,
-                    Video4Linux2.V4L2_MEMORY_MMAP);
-            for (int i = 0; i < requestbuffersCount; i++)
-            {
-                Video4Linux2.v4l2_buffer_setIndex(v4l2_buffer, i);
-                if (Video4Linux2.ioctl(
-                            fd,
-                            Video4Linux2.VIDIOC_QBUF,
-                            v4l2_buffer)
-                        == -1)
-                {
-                    throw new IOException(
-                            "ioctl: request= VIDIOC_QBUF, index= " + i);
-                }
-            }
-        }
-        finally
-        {
-            Video4Linux2.free(v4l2_buffer);
-        }
-
         /* we will start capture in read() method (i.e do the VIDIOC_STREAMON
          * ioctl) because for some couple of fps/resolution the captured image
          * will be weird (shift, not a JPEG for JPEG/MJPEG format, ...)
@@ -806,46 +636,91 @@ public class Video4Linux2Stream
     {
         try
         {
-            long v4l2_buf_type
-                = Video4Linux2.v4l2_buf_type_alloc(
-                        Video4Linux2.V4L2_BUF_TYPE_VIDEO_CAPTURE);
+            if ((capture != 0) && (Video4Linux2.capture_stop(capture) == -1))
+                throw new IOException("capture_stop");
+        }
+        finally
+        {
+            super.stop();
 
-            if (0 == v4l2_buf_type)
-                throw new OutOfMemoryError("v4l2_buf_type_alloc");
-            try
+            if ((capture != 0) && logger.isDebugEnabled())
             {
-                if (Video4Linux2.ioctl(
-                            fd,
-                            Video4Linux2.VIDIOC_STREAMOFF,
-                            v4l2_buf_type)
-                        == -1)
+                long[] decodeTimes = new long[8];
+                int decodeTimeCount
+                    = Video4Linux2.capture_getDecodeTimes(capture, decodeTimes);
+                StringBuilder s = new StringBuilder("MJPEG decode times:");
+                boolean decoded = false;
+
+                for (int i = 0;
+                        i < Math.min(decodeTimeCount, decodeTimes.length);
+                        i++)
                 {
-                    throw new IOException("ioctl: request= VIDIOC_STREAMOFF");
+                    s.append(' ');
+                    if (i == decodeTimeCount - 1)
+                        s.append(">=").append(1 << (i - 1));
+                    else
+                        s.append('<').append(1 << i);
+                    s.append("ms=").append(decodeTimes[i]);
+                    if (decodeTimes[i] != 0)
+                        decoded = true;
                 }
+                if (decoded)
+                    logger.debug(s);
             }
-            finally
+            if ((droppedFrameCount != 0) && logger.isDebugEnabled())
             {
-                Video4Linux2.free(v4l2_buf_type);
+                logger.debug(
+                        "Video4Linux2 driver dropped " + droppedFrameCount
+                            + " frames.");
             }
+            droppedFrameCount = 0;
+            lastSequence = -1;
         }
-        finally
+    }
+
+    /**
+     * Implements a <tt>ByteBuffer</tt> which represents a frame of the native
+     * capture engine of a <tt>Video4Linux2Stream</tt> and releases the frame to
+     * the engine upon {@link #free()} instead of freeing its native memory.
+     */
+    private static class FrameByteBuffer
+        extends ByteBuffer
+    {
+        /**
+         * The frame of the native capture engine represented by this instance
+         * or <tt>0</tt> if it has been released already.
+         */
+        private long frame;
+
+        /**
+         * Initializes a new <tt>FrameByteBuffer</tt> which is to represent a
+         * specific frame of a native capture engine.
+         *
+         * @param frame the frame of the native capture engine to be
+         * represented by the new instance
+         * @param ptr the pointer to the native memory of <tt>frame</tt>
+         */
+        public FrameByteBuffer(long frame, long ptr)
         {
-            super.stop();
+            super(ptr);
 
-            if(avctx != 0)
-            {
-                FFmpeg.avcodec_close(avctx);
-                FFmpeg.av_free(avctx);
-                avctx = 0;
-            }
+            this.frame = frame;
+        }
 
-            if(avframe != 0)
+        /**
+         * {@inheritDoc}
+         *
+         * Releases the frame represented by this instance to the native
+         * capture engine so that it is enqueued back to the device.
+         */
+        @Override
+        public synchronized void free()
+        {
+            if (frame != 0)
             {
-                FFmpeg.avcodec_free_frame(avframe);
-                avframe = 0;
+                Video4Linux2.frame_release(frame);
+                frame = 0;
             }
-
-            byteBufferPool.drain();
         }
     }
 }
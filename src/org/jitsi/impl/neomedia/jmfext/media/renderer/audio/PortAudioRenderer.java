@@ -353,6 +353,15 @@ public class PortAudioRenderer
         {
             if (stream != 0)
             {
+                if (logger.isDebugEnabled())
+                {
+                    logger.debug(
+                            "Scheduling policy of PortAudio stream: "
+                                + Pa.GetStreamSchedPolicy(stream));
+                    logger.debug(
+                            "PortAudio playback stream stats: "
+                                + PortAudioSystem.streamStatsToString(stream));
+                }
                 try
                 {
                     Pa.CloseStream(stream);
@@ -660,6 +669,7 @@ public class PortAudioRenderer
                 = Pa.GetSampleSize(sampleFormat)
                     * channels
                     * framesPerBuffer;
+            PortAudioSystem.setSchedPolicy(stream);
 
             // Pa_WriteStream has not been invoked yet.
             if (writeIsMalfunctioningSince != DiagnosticsControl.NEVER)
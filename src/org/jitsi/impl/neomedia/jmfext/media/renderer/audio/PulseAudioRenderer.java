@@ -27,12 +27,37 @@ import org.jitsi.util.*;
 public class PulseAudioRenderer
     extends AbstractAudioRenderer<PulseAudioSystem>
 {
+    /**
+     * The <tt>Logger</tt> used by the <tt>PulseAudioRenderer</tt> class and its
+     * instances for logging output.
+     */
+    private static final Logger logger
+        = Logger.getLogger(PulseAudioRenderer.class);
+
+    /**
+     * The number of underflows per ten seconds which the adaptive buffer
+     * attributes of {@link #stream} tolerate.
+     */
+    private static final int ADAPTIVE_GLITCHES = 1;
+
+    /**
+     * The maximum target length in tens of milliseconds to which the adaptive
+     * buffer attributes of {@link #stream} may grow.
+     */
+    private static final int ADAPTIVE_MAX_TLENGTH_IN_TENS_OF_MILLIS = 20;
+
     /**
      * The human-readable <tt>PlugIn</tt> name of the
      * <tt>PulseAudioRenderer</tt> instances.
      */
     private static final String PLUGIN_NAME = "PulseAudio Renderer";
 
+    /**
+     * The capacity in tens of milliseconds of the ring buffer of the native
+     * I/O pump which writes the audio of {@link #stream}.
+     */
+    private static final int PUMP_IN_TENS_OF_MILLIS = 4;
+
     private static final boolean SOFTWARE_GAIN = false;
 
     private static final Format[] SUPPORTED_INPUT_FORMATS
@@ -50,6 +75,12 @@ public class PulseAudioRenderer
                     Format.byteArray)
         };
 
+    /**
+     * The initial and minimum target length in tens of milliseconds of the
+     * buffer of {@link #stream}.
+     */
+    private static final int TLENGTH_IN_TENS_OF_MILLIS = 2;
+
     private int channels;
 
     private boolean corked = true;
@@ -65,16 +96,25 @@ public class PulseAudioRenderer
 
     private final String mediaRole;
 
+    /**
+     * The native I/O pump which writes the audio of {@link #stream} on the
+     * thread of the threaded mainloop so that {@link #process(Buffer)} does not
+     * have to acquire the mainloop lock in order to write it.
+     */
+    private volatile long pump;
+
     private long stream;
 
-    private final PA.stream_request_cb_t writeCallback
-        = new PA.stream_request_cb_t()
-        {
-            public void callback(long s, int nbytes)
-            {
-                audioSystem.signalMainloop(false);
-            }
-        };
+    /**
+     * The health counters of {@link #stream}.
+     */
+    private long streamStats;
+
+    /**
+     * The <tt>Object</tt> which synchronizes {@link #process(Buffer)} with the
+     * freeing of {@link #pump}.
+     */
+    private final Object writeSyncRoot = new Object();
 
     /**
      * Initializes a new <tt>PulseAudioRenderer</tt> instance with a default
@@ -113,42 +153,74 @@ public class PulseAudioRenderer
     @Override
     public void close()
     {
+        /*
+         * Stop first in order to interrupt the pump and, consequently, to have
+         * process(Buffer) release writeSyncRoot.
+         */
         audioSystem.lockMainloop();
         try
         {
-            long stream = this.stream;
+            stopWithMainloopLock();
+        }
+        finally
+        {
+            audioSystem.unlockMainloop();
+        }
 
-            if (stream != 0)
+        synchronized (writeSyncRoot)
+        {
+            audioSystem.lockMainloop();
+            try
             {
-                try
-                {
-                    stopWithMainloopLock();
-                }
-                finally
-                {
-                    long cvolume = this.cvolume;
+                closeWithMainloopLock();
 
-                    this.cvolume = 0;
-                    this.stream = 0;
+                super.close();
+            }
+            finally
+            {
+                audioSystem.unlockMainloop();
+            }
+        }
+    }
 
-                    corked = true;
-                    dev = null;
+    private void closeWithMainloopLock()
+    {
+        long stream = this.stream;
 
-                    audioSystem.signalMainloop(false);
+        if (stream == 0)
+            return;
 
-                    if (cvolume != 0)
-                        PA.cvolume_free(cvolume);
-                    PA.stream_disconnect(stream);
-                    PA.stream_unref(stream);
-                }
-            }
+        long cvolume = this.cvolume;
+        long pump = this.pump;
+        long streamStats = this.streamStats;
 
-            super.close();
-        }
-        finally
+        this.cvolume = 0;
+        this.pump = 0;
+        this.stream = 0;
+        this.streamStats = 0;
+
+        corked = true;
+        dev = null;
+
+        audioSystem.signalMainloop(false);
+
+        if (cvolume != 0)
+            PA.cvolume_free(cvolume);
+        if (pump != 0)
+            PA.pump_free(pump);
+        if (streamStats != 0)
         {
-            audioSystem.unlockMainloop();
+            if (logger.isDebugEnabled())
+            {
+                logger.debug(
+                        "PulseAudio playback stream stats: "
+                            + PulseAudioSystem.streamStatsToString(
+                                    streamStats));
+            }
+            PA.stream_stats_free(streamStats);
         }
+        PA.stream_disconnect(stream);
+        PA.stream_unref(stream);
     }
 
     private void cork(boolean b)
@@ -164,10 +236,35 @@ public class PulseAudioRenderer
         }
         finally
         {
+            /*
+             * Do not let process(Buffer) block while no audio is to be written
+             * into the stream.
+             */
+            if (pump != 0)
+                PA.pump_set_interrupted(pump, corked);
             audioSystem.signalMainloop(false);
         }
     }
 
+    /**
+     * Gets the current latency of the playback of this <tt>Renderer</tt>.
+     *
+     * @return the current latency in microseconds of the playback of this
+     * <tt>Renderer</tt> or <tt>-1</tt> if it is not known
+     */
+    public long getLatency()
+    {
+        audioSystem.lockMainloop();
+        try
+        {
+            return (stream == 0) ? -1 : PA.stream_get_latency(stream);
+        }
+        finally
+        {
+            audioSystem.unlockMainloop();
+        }
+    }
+
     private String getLocatorDev()
     {
         MediaLocator locator = getLocator();
@@ -272,13 +369,12 @@ public class PulseAudioRenderer
 
         try
         {
+            int bytesPerTenMillis
+                = (sampleRate / 100) * channels * (sampleSizeInBits / 8);
             long attr
                 = PA.buffer_attr_new(
                         -1,
-                        2 /* millis / 10 */
-                            * (sampleRate / 100)
-                            * channels
-                            * (sampleSizeInBits / 8),
+                        TLENGTH_IN_TENS_OF_MILLIS * bytesPerTenMillis,
                         -1,
                         -1,
                         -1);
@@ -308,6 +404,8 @@ public class PulseAudioRenderer
                         dev,
                         attr,
                         PA.STREAM_ADJUST_LATENCY
+                            | PA.STREAM_AUTO_TIMING_UPDATE
+                            | PA.STREAM_INTERPOLATE_TIMING
                             | PA.STREAM_START_CORKED,
                         0,
                         0);
@@ -328,9 +426,25 @@ public class PulseAudioRenderer
                     if (state != PA.STREAM_READY)
                         throw new ResourceUnavailableException("stream.state");
 
-                    PA.stream_set_write_callback(
-                            stream,
-                            writeCallback);
+                    streamStats = PA.stream_stats_new(stream, true);
+                    /*
+                     * Start with a small buffer and let it grow only as much
+                     * as the underflows on this host require.
+                     */
+                    PA.stream_stats_set_adaptive(
+                            streamStats,
+                            TLENGTH_IN_TENS_OF_MILLIS * bytesPerTenMillis,
+                            ADAPTIVE_MAX_TLENGTH_IN_TENS_OF_MILLIS
+                                * bytesPerTenMillis,
+                            ADAPTIVE_GLITCHES);
+                    pump
+                        = audioSystem.createPump(
+                                stream,
+                                PUMP_IN_TENS_OF_MILLIS * bytesPerTenMillis,
+                                true,
+                                streamStats);
+                    /* The stream starts corked. */
+                    PA.pump_set_interrupted(pump, true);
 
                     GainControl gainControl;
 
@@ -365,7 +479,19 @@ public class PulseAudioRenderer
                 finally
                 {
                     if (this.stream == 0)
+                    {
+                        if (pump != 0)
+                        {
+                            PA.pump_free(pump);
+                            pump = 0;
+                        }
+                        if (streamStats != 0)
+                        {
+                            PA.stream_stats_free(streamStats);
+                            streamStats = 0;
+                        }
                         PA.stream_disconnect(stream);
+                    }
                 }
             }
             finally
@@ -466,89 +592,69 @@ public class PulseAudioRenderer
         if (buffer.getLength() <= 0)
             return BUFFER_PROCESSED_OK;
 
-        int ret;
-
-        audioSystem.lockMainloop();
-        try
-        {
-            ret = processWithMainloopLock(buffer);
-        }
-        finally
-        {
-            audioSystem.unlockMainloop();
-        }
-        if ((ret != BUFFER_PROCESSED_FAILED) && (buffer.getLength() > 0))
-            ret |= INPUT_BUFFER_NOT_CONSUMED;
-
-        return ret;
-    }
-
-    private int processWithMainloopLock(Buffer buffer)
-    {
-        if ((stream == 0) || corked)
-            return BUFFER_PROCESSED_FAILED;
+        byte[] data = (byte[]) buffer.getData();
+        int offset = buffer.getOffset();
+        int length = buffer.getLength();
+        GainControl gainControl = getGainControl();
 
-        int writableSize = PA.stream_writable_size(stream);
-        int ret;
-
-        if (writableSize <= 0)
-        {
-            audioSystem.waitMainloop();
-            ret = BUFFER_PROCESSED_OK;
-        }
-        else
+        /*
+         * The mainloop lock must not be acquired while writeSyncRoot is held
+         * because playbackDevicePropertyChange(PropertyChangeEvent) invokes
+         * close() with the mainloop lock held.
+         */
+        if (gainControl != null)
         {
-            byte[] data = (byte[]) buffer.getData();
-            int offset = buffer.getOffset();
-            int length = buffer.getLength();
-
-            if (length < writableSize)
-                writableSize = length;
-
-            GainControl gainControl = getGainControl();
-
-            if (gainControl != null)
+            if (SOFTWARE_GAIN || (cvolume == 0))
+            {
+                BasicVolumeControl.applyGain(
+                        gainControl,
+                        data, offset, length);
+            }
+            else
             {
-                if (SOFTWARE_GAIN || (cvolume == 0))
+                float gainControlLevel = gainControl.getLevel();
+
+                if (this.gainControlLevel != gainControlLevel)
                 {
-                    if (length > 0)
+                    audioSystem.lockMainloop();
+                    try
                     {
-                        BasicVolumeControl.applyGain(
-                                gainControl,
-                                data, offset, writableSize);
+                        if (stream != 0)
+                        {
+                            this.gainControlLevel = gainControlLevel;
+                            setStreamVolume(stream, gainControlLevel);
+                        }
                     }
-                }
-                else
-                {
-                    float gainControlLevel = gainControl.getLevel();
-
-                    if (this.gainControlLevel != gainControlLevel)
+                    finally
                     {
-                        this.gainControlLevel = gainControlLevel;
-                        setStreamVolume(stream, gainControlLevel);
+                        audioSystem.unlockMainloop();
                     }
                 }
             }
+        }
 
-            int writtenSize
-                = PA.stream_write(
-                        stream,
-                        data, offset, writableSize,
-                        null,
-                        0,
-                        PA.SEEK_RELATIVE);
+        /*
+         * The pump writes into the stream on the thread of the threaded
+         * mainloop so the mainloop lock is not acquired here. The writing
+         * blocks until all of data has been handed over to the pump unless the
+         * stream gets corked.
+         */
+        synchronized (writeSyncRoot)
+        {
+            long pump = this.pump;
 
-            if (writtenSize < 0)
-                ret = BUFFER_PROCESSED_FAILED;
-            else
-            {
-                ret = BUFFER_PROCESSED_OK;
-                buffer.setLength(length - writtenSize);
-                buffer.setOffset(offset + writtenSize);
-            }
-        }
+            if (pump == 0)
+                return BUFFER_PROCESSED_FAILED;
 
-        return ret;
+            int writtenSize = PA.pump_write(pump, data, offset, length);
+
+            buffer.setLength(length - writtenSize);
+            buffer.setOffset(offset + writtenSize);
+            return
+                (writtenSize < length)
+                    ? BUFFER_PROCESSED_FAILED
+                    : BUFFER_PROCESSED_OK;
+        }
     }
 
     private void setStreamVolume(long stream, float level)
@@ -0,0 +1,520 @@
+/*
+ * Jitsi, the OpenSource Java VoIP and Instant Messaging client.
+ *
+ * Distributable under LGPL license.
+ * See terms of license at gnu.org.
+ */
+package org.jitsi.impl.neomedia.jmfext.media.renderer.video;
+
+import java.awt.*;
+import java.util.*;
+import java.util.List;
+
+import javax.media.*;
+import javax.media.format.*;
+import javax.media.renderer.*;
+
+import org.jitsi.impl.neomedia.codec.*;
+import org.jitsi.impl.neomedia.codec.video.*;
+import org.jitsi.impl.neomedia.jmfext.media.renderer.*;
+
+/**
+ * Renders the videos of multiple participants (e.g. a gallery) into a single
+ * AWT <tt>Component</tt> by compositing them into the I420 surface of a single
+ * <tt>JAWTRenderer</tt>. Consequently, the whole gallery is put with a single
+ * Xv port and a single blit per paint instead of one of each per participant.
+ * Each participant is rendered by a <tt>VideoRenderer</tt> created by
+ * {@link #createRenderer()} which scales the decoded frames into its bounds
+ * within the surface. The participants which have not been given bounds are
+ * laid out in a grid. The surface is acquired when the first participant is
+ * opened and released when the last one is closed. Supported on Linux only.
+ */
+public class JAWTCompositor
+{
+    /**
+     * The height of the surface of the gallery by default.
+     */
+    private static final int DEFAULT_GALLERY_HEIGHT = 720;
+
+    /**
+     * The width of the surface of the gallery by default.
+     */
+    private static final int DEFAULT_GALLERY_WIDTH = 1280;
+
+    /**
+     * The <tt>JAWTCompositor</tt> which renders the remote videos of all
+     * streams when the video gallery is enabled or <tt>null</tt> if it has not
+     * been created yet.
+     */
+    private static JAWTCompositor gallery;
+
+    /**
+     * The human-readable <tt>PlugIn</tt> name of the <tt>VideoRenderer</tt>s
+     * created by <tt>JAWTCompositor</tt>s.
+     */
+    private static final String PLUGIN_NAME = "JAWT Compositor Renderer";
+
+    /**
+     * The array of input formats supported by the <tt>VideoRenderer</tt>s
+     * created by <tt>JAWTCompositor</tt>s.
+     */
+    private static final Format[] SUPPORTED_INPUT_FORMATS
+        = new Format[] { new AVFrameFormat(FFmpeg.PIX_FMT_YUV420P) };
+
+    /**
+     * The <tt>VideoRenderer</tt>s created by this <tt>JAWTCompositor</tt>
+     * which are open, in the order in which they are laid out.
+     */
+    private final List<ParticipantRenderer> participants
+        = new ArrayList<ParticipantRenderer>();
+
+    /**
+     * The height of the surface into which the videos are composited.
+     */
+    private int surfaceHeight;
+
+    /**
+     * The <tt>JAWTRenderer</tt> which keeps the surface into which the videos
+     * are composited and renders it into its <tt>Component</tt>.
+     */
+    private final JAWTRenderer surfaceRenderer = new JAWTRenderer();
+
+    /**
+     * The width of the surface into which the videos are composited.
+     */
+    private int surfaceWidth;
+
+    /**
+     * Initializes a new <tt>JAWTCompositor</tt> instance which is to composite
+     * videos into a surface of a specific size.
+     *
+     * @param surfaceWidth the width of the surface into which the videos are to
+     * be composited
+     * @param surfaceHeight the height of the surface into which the videos are
+     * to be composited
+     */
+    public JAWTCompositor(int surfaceWidth, int surfaceHeight)
+    {
+        setSurfaceSize(surfaceWidth, surfaceHeight);
+    }
+
+    /**
+     * Gets the <tt>JAWTCompositor</tt> which renders the remote videos of all
+     * streams when the video gallery is enabled.
+     *
+     * @return the <tt>JAWTCompositor</tt> of the video gallery
+     */
+    public static synchronized JAWTCompositor getGallery()
+    {
+        if (gallery == null)
+        {
+            gallery
+                = new JAWTCompositor(
+                        DEFAULT_GALLERY_WIDTH,
+                        DEFAULT_GALLERY_HEIGHT);
+        }
+        return gallery;
+    }
+
+    /**
+     * Adds a specific participant to the participants which are open and
+     * acquires the surface if it is the first one.
+     *
+     * @param participant the participant which is being opened
+     * @throws ResourceUnavailableException if the surface cannot be acquired
+     */
+    private void addParticipant(ParticipantRenderer participant)
+        throws ResourceUnavailableException
+    {
+        synchronized (participants)
+        {
+            if (participants.contains(participant))
+                return;
+            if (participants.isEmpty())
+                surfaceRenderer.open();
+            participants.add(participant);
+        }
+        layOut();
+    }
+
+    /**
+     * Scales a specific video frame into a specific rectangle of the surface
+     * of this <tt>JAWTCompositor</tt> and queues the surface to be presented.
+     *
+     * @param frame the pointer to the <tt>AVFrame</tt> to be composited or
+     * <tt>0</tt> to clear <tt>bounds</tt>
+     * @param size the size of <tt>frame</tt>
+     * @param bounds the rectangle of the surface into which <tt>frame</tt> is
+     * to be scaled or <tt>null</tt> for the whole surface
+     * @return <tt>true</tt> if <tt>frame</tt> has been composited
+     */
+    boolean composite(long frame, Dimension size, Rectangle bounds)
+    {
+        long[] planes = new long[3];
+        int[] strides = new int[3];
+        int width, height;
+
+        if (frame != 0)
+        {
+            for (int plane = 0; plane < planes.length; plane++)
+            {
+                planes[plane] = FFmpeg.avframe_get_data(frame, plane);
+                strides[plane] = FFmpeg.avframe_get_linesize(frame, plane);
+            }
+            width = size.width;
+            height = size.height;
+        }
+        else
+            width = height = 0;
+
+        Component component = getComponent();
+        boolean composited;
+
+        synchronized (surfaceRenderer.getHandleLock())
+        {
+            long handle = surfaceRenderer.getHandle();
+
+            if (handle == 0)
+                return false;
+
+            synchronized (this)
+            {
+                if (bounds == null)
+                    bounds = new Rectangle(0, 0, surfaceWidth, surfaceHeight);
+                composited
+                    = JAWTRenderer.composite(
+                            handle,
+                            component,
+                            planes[0], strides[0],
+                            planes[1], strides[1],
+                            planes[2], strides[2],
+                            width, height,
+                            bounds.x, bounds.y, bounds.width, bounds.height,
+                            surfaceWidth, surfaceHeight);
+            }
+            if (composited)
+                surfaceRenderer.queueFrame(component);
+        }
+        return composited;
+    }
+
+    /**
+     * Initializes a new <tt>VideoRenderer</tt> which renders the video of a
+     * participant into (a rectangle of) the surface of this
+     * <tt>JAWTCompositor</tt>. Its bounds are set with
+     * {@link VideoRenderer#setBounds(Rectangle)} in the coordinates of the
+     * surface and its <tt>Component</tt> is the one of this
+     * <tt>JAWTCompositor</tt>.
+     *
+     * @return a new <tt>VideoRenderer</tt> which renders into the surface of
+     * this <tt>JAWTCompositor</tt>
+     */
+    public VideoRenderer createRenderer()
+    {
+        return new ParticipantRenderer();
+    }
+
+    /**
+     * Gets the AWT <tt>Component</tt> into which this <tt>JAWTCompositor</tt>
+     * renders the videos of all participants.
+     *
+     * @return the AWT <tt>Component</tt> into which this
+     * <tt>JAWTCompositor</tt> renders
+     */
+    public Component getComponent()
+    {
+        return surfaceRenderer.getComponent();
+    }
+
+    /**
+     * Lays out the participants which have not been given bounds in a grid
+     * over the surface and clears the surface so that no participant leaves
+     * its previous frame behind.
+     */
+    private void layOut()
+    {
+        List<ParticipantRenderer> cells = new ArrayList<ParticipantRenderer>();
+        int surfaceWidth, surfaceHeight;
+
+        synchronized (participants)
+        {
+            for (ParticipantRenderer participant : participants)
+            {
+                if (participant.getBounds() == null)
+                    cells.add(participant);
+            }
+        }
+        synchronized (this)
+        {
+            surfaceWidth = this.surfaceWidth;
+            surfaceHeight = this.surfaceHeight;
+        }
+
+        int count = cells.size();
+
+        if (count != 0)
+        {
+            int columns = (int) Math.ceil(Math.sqrt(count));
+            int rows = (count + columns - 1) / columns;
+            int cellWidth = (surfaceWidth / columns) & ~1;
+            int cellHeight = (surfaceHeight / rows) & ~1;
+
+            for (int i = 0; i < count; i++)
+            {
+                cells.get(i).setCell(
+                        new Rectangle(
+                                (i % columns) * cellWidth,
+                                (i / columns) * cellHeight,
+                                cellWidth,
+                                cellHeight));
+            }
+        }
+        composite(0, null, null);
+    }
+
+    /**
+     * Removes a specific participant from the participants which are open and
+     * releases the surface and the Xv port if it is the last one.
+     *
+     * @param participant the participant which is being closed
+     */
+    private void removeParticipant(ParticipantRenderer participant)
+    {
+        synchronized (participants)
+        {
+            if (!participants.remove(participant))
+                return;
+            if (participants.isEmpty())
+            {
+                surfaceRenderer.close();
+                return;
+            }
+        }
+        layOut();
+    }
+
+    /**
+     * Sets the size of the surface into which the videos are composited. The
+     * surface is cleared and the participants are laid out again.
+     *
+     * @param surfaceWidth the width of the surface
+     * @param surfaceHeight the height of the surface
+     */
+    public void setSurfaceSize(int surfaceWidth, int surfaceHeight)
+    {
+        synchronized (this)
+        {
+            this.surfaceWidth = surfaceWidth;
+            this.surfaceHeight = surfaceHeight;
+        }
+        /* Let the Component prefer the size of the surface. */
+        surfaceRenderer.setInputFormat(
+                new AVFrameFormat(
+                        new Dimension(surfaceWidth, surfaceHeight),
+                        Format.NOT_SPECIFIED,
+                        FFmpeg.PIX_FMT_YUV420P));
+        layOut();
+    }
+
+    /**
+     * Implements a <tt>VideoRenderer</tt> which renders the video of a
+     * participant into its bounds within the surface of the
+     * <tt>JAWTCompositor</tt> which created it.
+     */
+    private class ParticipantRenderer
+        extends AbstractRenderer<VideoFormat>
+        implements VideoRenderer
+    {
+        /**
+         * The region of the surface into which this <tt>VideoRenderer</tt>
+         * has been set to render or <tt>null</tt> if it is laid out in the
+         * grid.
+         */
+        private Rectangle bounds;
+
+        /**
+         * The cell of the grid into which this <tt>VideoRenderer</tt> renders
+         * if it has not been given bounds or <tt>null</tt> for the whole
+         * surface.
+         */
+        private Rectangle cell;
+
+        /**
+         * Closes this <tt>PlugIn</tt> and gives its region of the surface to
+         * the other participants.
+         */
+        public void close()
+        {
+            removeParticipant(this);
+        }
+
+        /**
+         * Gets the region of the surface into which this
+         * <tt>VideoRenderer</tt> has been set to render.
+         *
+         * @return the region of the surface into which this
+         * <tt>VideoRenderer</tt> has been set to render; <tt>null</tt> if it
+         * is laid out in the grid
+         */
+        public synchronized Rectangle getBounds()
+        {
+            return (bounds == null) ? null : new Rectangle(bounds);
+        }
+
+        /**
+         * Gets the AWT <tt>Component</tt> of the <tt>JAWTCompositor</tt>
+         * which created this <tt>VideoRenderer</tt>.
+         *
+         * @return the AWT <tt>Component</tt> into which this
+         * <tt>VideoRenderer</tt> draws
+         */
+        public Component getComponent()
+        {
+            return JAWTCompositor.this.getComponent();
+        }
+
+        /**
+         * Gets the human-readable name of this <tt>PlugIn</tt>.
+         *
+         * @return the human-readable name of this <tt>PlugIn</tt>
+         */
+        public String getName()
+        {
+            return PLUGIN_NAME;
+        }
+
+        /**
+         * Gets the list of input <tt>Format</tt>s supported by this
+         * <tt>Renderer</tt>.
+         *
+         * @return an array of <tt>Format</tt> elements which represent the
+         * input <tt>Format</tt>s supported by this <tt>Renderer</tt>
+         */
+        public Format[] getSupportedInputFormats()
+        {
+            return SUPPORTED_INPUT_FORMATS.clone();
+        }
+
+        /**
+         * Gets the region of the surface into which this
+         * <tt>VideoRenderer</tt> renders i.e. its bounds or its cell of the
+         * grid.
+         *
+         * @return the region of the surface into which this
+         * <tt>VideoRenderer</tt> renders; <tt>null</tt> for the whole surface
+         */
+        private synchronized Rectangle getRenderBounds()
+        {
+            Rectangle r = (bounds == null) ? cell : bounds;
+
+            return (r == null) ? null : new Rectangle(r);
+        }
+
+        /**
+         * Opens this <tt>PlugIn</tt> and acquires the surface if this is the
+         * first participant to be opened.
+         *
+         * @throws ResourceUnavailableException if the surface cannot be
+         * acquired
+         */
+        public void open()
+            throws ResourceUnavailableException
+        {
+            addParticipant(this);
+        }
+
+        /**
+         * Scales the <tt>AVFrame</tt> in a specific <tt>Buffer</tt> into the
+         * bounds of this <tt>VideoRenderer</tt> within the surface.
+         *
+         * @param buffer a <tt>Buffer</tt> containing the data to be processed
+         * and rendered
+         * @return <tt>BUFFER_PROCESSED_OK</tt> if the processing is
+         * successful; otherwise, the other possible return codes defined in
+         * the <tt>PlugIn</tt> interface
+         */
+        public int process(Buffer buffer)
+        {
+            if (buffer.isDiscard())
+                return BUFFER_PROCESSED_OK;
+
+            Object data = buffer.getData();
+
+            if (!(data instanceof AVFrame))
+                return BUFFER_PROCESSED_OK;
+
+            Format format = buffer.getFormat();
+            Dimension size = null;
+
+            if (format instanceof VideoFormat)
+                size = ((VideoFormat) format).getSize();
+            if ((size == null) && (inputFormat != null))
+                size = inputFormat.getSize();
+            if (size == null)
+                return BUFFER_PROCESSED_FAILED;
+
+            return
+                composite(((AVFrame) data).getPtr(), size, getRenderBounds())
+                    ? BUFFER_PROCESSED_OK
+                    : BUFFER_PROCESSED_FAILED;
+        }
+
+        /**
+         * Sets the region of the surface into which this
+         * <tt>VideoRenderer</tt> is to render. The participants are laid out
+         * again and the surface is cleared.
+         *
+         * @param bounds the region of the surface into which this
+         * <tt>VideoRenderer</tt> is to render; <tt>null</tt> if it is to be
+         * laid out in the grid
+         */
+        public void setBounds(Rectangle bounds)
+        {
+            synchronized (this)
+            {
+                if ((bounds == null)
+                        ? (this.bounds == null)
+                        : bounds.equals(this.bounds))
+                    return;
+                this.bounds = (bounds == null) ? null : new Rectangle(bounds);
+            }
+            layOut();
+        }
+
+        /**
+         * Sets the cell of the grid into which this <tt>VideoRenderer</tt>
+         * renders if it has not been given bounds.
+         *
+         * @param cell the cell of the grid
+         */
+        synchronized void setCell(Rectangle cell)
+        {
+            this.cell = cell;
+        }
+
+        /**
+         * Sets the AWT <tt>Component</tt> into which this
+         * <tt>VideoRenderer</tt> is to draw. It cannot draw into any other AWT
+         * <tt>Component</tt> but the one of its <tt>JAWTCompositor</tt> so it
+         * always returns <tt>false</tt>.
+         *
+         * @param component the AWT <tt>Component</tt> into which this
+         * <tt>VideoRenderer</tt> is to draw
+         * @return <tt>false</tt>
+         */
+        public boolean setComponent(Component component)
+        {
+            return false;
+        }
+
+        /**
+         * Starts the rendering process.
+         */
+        public void start() {}
+
+        /**
+         * Stops the rendering process.
+         */
+        public void stop() {}
+    }
+}
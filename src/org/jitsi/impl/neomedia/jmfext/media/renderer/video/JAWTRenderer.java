@@ -14,6 +14,7 @@ import javax.media.format.*;
 import javax.media.renderer.*;
 import javax.swing.*;
 
+import org.jitsi.impl.neomedia.codec.*;
 import org.jitsi.impl.neomedia.codec.video.*;
 import org.jitsi.impl.neomedia.jmfext.media.renderer.*;
 import org.jitsi.util.*;
@@ -44,6 +45,14 @@ public class JAWTRenderer
      */
     private static final Logger logger = Logger.getLogger(JAWTRenderer.class);
 
+    /**
+     * The indicator which determines whether the frames are presented by
+     * <tt>JAWTRendererPresenter</tt> at the refresh rate of the display rather
+     * than whenever AWT repaints the <tt>Component</tt>. The native
+     * counterpart keeps only the newest frame on Linux.
+     */
+    private static final boolean PACED = OSUtils.IS_LINUX;
+
     /**
      * The human-readable <tt>PlugIn</tt> name of the <tt>JAWTRenderer</tt>
      * instances.
@@ -51,13 +60,16 @@ public class JAWTRenderer
     private static final String PLUGIN_NAME = "JAWT Renderer";
 
     /**
-     * The array of supported input formats.
+     * The array of supported input formats. On Linux, the decoded
+     * <tt>AVFrame</tt>s are accepted as they are in order to spare their
+     * conversion into <tt>int</tt> arrays.
      */
     private static final Format[] SUPPORTED_INPUT_FORMATS
-        = new Format[]
-                {
-                    OSUtils.IS_LINUX
-                        ? new YUVFormat(
+        = OSUtils.IS_LINUX
+            ? new Format[]
+                    {
+                        new AVFrameFormat(FFmpeg.PIX_FMT_YUV420P),
+                        new YUVFormat(
                                 null /* size */,
                                 Format.NOT_SPECIFIED /* maxDataLength */,
                                 Format.intArray,
@@ -68,7 +80,10 @@ public class JAWTRenderer
                                 Format.NOT_SPECIFIED /* offsetY */,
                                 Format.NOT_SPECIFIED /* offsetU */,
                                 Format.NOT_SPECIFIED /* offsetV */)
-                        : OSUtils.IS_ANDROID
+                    }
+            : new Format[]
+                    {
+                        OSUtils.IS_ANDROID
                             ? new RGBFormat(
                                     null,
                                     Format.NOT_SPECIFIED,
@@ -83,7 +98,7 @@ public class JAWTRenderer
                                     Format.NOT_SPECIFIED,
                                     32,
                                     0x00ff0000, 0x0000ff00, 0x000000ff)
-                };
+                    };
 
     static
     {
@@ -107,6 +122,42 @@ public class JAWTRenderer
      */
     private static native void close(long handle, Component component);
 
+    /**
+     * Scales an I420 video frame given as pointers to its Y, U and V planes
+     * and their strides into a specific rectangle of the I420 surface which
+     * the native counterpart of a <tt>JAWTRenderer</tt> keeps and renders as a
+     * whole. The surface starts black and is reallocated when its size
+     * changes. Supported on Linux only.
+     *
+     * @param handle the handle to the native counterpart of a
+     * <tt>JAWTRenderer</tt> which keeps the surface
+     * @param component the <tt>AWT</tt> component into which the specified
+     * <tt>JAWTRenderer</tt> and its native counterpart draw
+     * @param y a pointer to the Y plane of the video frame or <tt>0</tt> to
+     * clear the rectangle
+     * @param yStride the size in bytes of a line of the Y plane
+     * @param u a pointer to the U plane of the video frame
+     * @param uStride the size in bytes of a line of the U plane
+     * @param v a pointer to the V plane of the video frame
+     * @param vStride the size in bytes of a line of the V plane
+     * @param width the width of the video frame
+     * @param height the height of the video frame
+     * @param boundsX the x coordinate of the rectangle in the surface
+     * @param boundsY the y coordinate of the rectangle in the surface
+     * @param boundsWidth the width of the rectangle in the surface
+     * @param boundsHeight the height of the rectangle in the surface
+     * @param surfaceWidth the width of the surface
+     * @param surfaceHeight the height of the surface
+     * @return <tt>true</tt> if the frame has been successfully composited
+     */
+    static native boolean composite(
+            long handle,
+            Component component,
+            long y, int yStride, long u, int uStride, long v, int vStride,
+            int width, int height,
+            int boundsX, int boundsY, int boundsWidth, int boundsHeight,
+            int surfaceWidth, int surfaceHeight);
+
     /**
      * Opens a handle to a native counterpart of a <tt>JAWTRenderer</tt> which
      * is to draw into a specific AWT <tt>Component</tt>.
@@ -179,6 +230,41 @@ public class JAWTRenderer
             int[] data, int offset, int length,
             int width, int height);
 
+    /**
+     * Processes an I420 video frame given as pointers to its Y, U and V planes
+     * and their strides (e.g. the picture of an FFmpeg <tt>AVFrame</tt>) and
+     * renders it to the output device represented by a <tt>JAWTRenderer</tt>
+     * specified by the handle to it native counterpart. Unlike
+     * {@link #process(long, Component, int[], int, int, int, int)}, the frame
+     * does not go through the Java heap. Unless <tt>hold</tt> is
+     * <tt>true</tt>, the planes are only read during the call. Supported on
+     * Linux only.
+     *
+     * @param handle the handle to the native counterpart of a
+     * <tt>JAWTRenderer</tt> to process the specified frame and render it
+     * @param component the <tt>AWT</tt> component into which the specified
+     * <tt>JAWTRenderer</tt> and its native counterpart draw
+     * @param y a pointer to the Y plane of the video frame
+     * @param yStride the size in bytes of a line of the Y plane
+     * @param u a pointer to the U plane of the video frame
+     * @param uStride the size in bytes of a line of the U plane
+     * @param v a pointer to the V plane of the video frame
+     * @param vStride the size in bytes of a line of the V plane
+     * @param width the width of the video frame
+     * @param height the height of the video frame
+     * @param hold <tt>true</tt> if the planes stay valid until the next
+     * invocation of a native method with the specified handle and the native
+     * counterpart may, consequently, read them at paint time instead of
+     * copying them right away
+     * @return <tt>true</tt> if the frame has been successfully processed
+     */
+    static native boolean processPlanes(
+            long handle,
+            Component component,
+            long y, int yStride, long u, int uStride, long v, int vStride,
+            int width, int height,
+            boolean hold);
+
     private static native String sysctlbyname(String name);
 
     /**
@@ -186,17 +272,107 @@ public class JAWTRenderer
      */
     private Component component;
 
+    /**
+     * The number of frames which have been superseded by newer frames before
+     * they could be presented.
+     */
+    private long droppedFrameCount = 0;
+
     /**
      * The handle to the native counterpart of this <tt>JAWTRenderer</tt>.
      */
     private long handle = 0;
 
+    /**
+     * The index in {@link #heldFrames} of the <tt>AVFrame</tt> the picture of
+     * which the native counterpart of this <tt>JAWTRenderer</tt> holds or
+     * <tt>-1</tt> if it does not hold any.
+     */
+    private int heldFrameIndex = -1;
+
+    /**
+     * The <tt>AVFrame</tt>s which reference the pooled pictures (e.g. of a
+     * decoder) processed by this <tt>JAWTRenderer</tt> so that its native
+     * counterpart may hold the latest one until it is painted instead of
+     * copying it. One of them references the picture held by the native
+     * counterpart and the other one the picture being processed which
+     * supersedes it.
+     */
+    private final AVFrame[] heldFrames = new AVFrame[2];
+
     /**
      * The last known height of the input processed by this
      * <tt>JAWTRenderer</tt>.
      */
     private int height = 0;
 
+    /**
+     * The number of frames which have been presented more than a refresh of
+     * the display after they were queued.
+     */
+    private long lateFrameCount = 0;
+
+    /**
+     * The <tt>int</tt> array of the frame which has been taken over from the
+     * <tt>Buffer</tt> it was processed in and which is to be converted only
+     * when it is presented (i.e. not at all if it is superseded before then)
+     * or <tt>null</tt> if there is no such frame.
+     */
+    private int[] pendingFrame;
+
+    /**
+     * The number of elements of {@link #pendingFrame} which represent the
+     * frame.
+     */
+    private int pendingFrameLength;
+
+    /**
+     * The index in {@link #pendingFrame} at which the frame starts.
+     */
+    private int pendingFrameOffset;
+
+    /**
+     * The size of the frame in {@link #pendingFrame}.
+     */
+    private Dimension pendingFrameSize;
+
+    /**
+     * The number of frames which have been presented.
+     */
+    private long presentedFrameCount = 0;
+
+    /**
+     * The <tt>Runnable</tt> which is executed to bring the invocations of
+     * {@link #present(long)} into the AWT event dispatching thread.
+     */
+    private final Runnable presentInEventDispatchThread
+        = new Runnable()
+        {
+            public void run()
+            {
+                presentInEventDispatchThread();
+            }
+        };
+
+    /**
+     * The indicator which determines whether
+     * {@link #presentInEventDispatchThread} has been scheduled for execution
+     * and has not started executing yet.
+     */
+    private boolean presentPending = false;
+
+    /**
+     * The time in nanoseconds between two refreshes of the display as
+     * specified by the last invocation of {@link #present(long)}.
+     */
+    private long presentPeriod;
+
+    /**
+     * The time in nanoseconds at which the frame which is to be presented next
+     * was queued or <tt>-1</tt> if there is no such frame.
+     */
+    private long queuedFrameTime = -1;
+
     /**
      * The <tt>Runnable</tt> which is executed to bring the invocations of
      * {@link #reflectInputFormatOnComponent()} into the AWT event dispatching
@@ -211,6 +387,14 @@ public class JAWTRenderer
             }
         };
 
+    /**
+     * The <tt>int</tt> array which used to be {@link #pendingFrame} and which
+     * is to be handed back to the next <tt>Buffer</tt> which has its
+     * <tt>int</tt> array taken over or <tt>null</tt> if there is no such
+     * array.
+     */
+    private int[] spareFrame;
+
     /**
      * The last known width of the input processed by this
      * <tt>JAWTRenderer</tt>.
@@ -232,9 +416,15 @@ public class JAWTRenderer
     {
         if (handle != 0)
         {
+            if (PACED)
+                JAWTRendererPresenter.remove(this);
             close(handle, component);
             handle = 0;
+            queuedFrameTime = -1;
         }
+        releaseHeldFrames(-1);
+        pendingFrame = null;
+        spareFrame = null;
     }
 
     /**
@@ -250,6 +440,19 @@ public class JAWTRenderer
         return null;
     }
 
+    /**
+     * Gets the number of frames which this <tt>JAWTRenderer</tt> has dropped
+     * because they were superseded by newer frames before they could be
+     * presented.
+     *
+     * @return the number of frames which this <tt>JAWTRenderer</tt> has
+     * dropped
+     */
+    public synchronized long getDroppedFrameCount()
+    {
+        return droppedFrameCount;
+    }
+
     /**
      * Gets the AWT <tt>Component</tt> into which this <tt>VideoRenderer</tt>
      * draws.
@@ -344,6 +547,18 @@ public class JAWTRenderer
         return this;
     }
 
+    /**
+     * Gets the number of frames which this <tt>JAWTRenderer</tt> has presented
+     * more than a refresh of the display after they were processed.
+     *
+     * @return the number of frames which this <tt>JAWTRenderer</tt> has
+     * presented late
+     */
+    public synchronized long getLateFrameCount()
+    {
+        return lateFrameCount;
+    }
+
     /**
      * Gets the human-readable name of this <tt>PlugIn</tt>.
      *
@@ -354,6 +569,18 @@ public class JAWTRenderer
         return PLUGIN_NAME;
     }
 
+    /**
+     * Gets the number of frames which this <tt>JAWTRenderer</tt> has
+     * presented.
+     *
+     * @return the number of frames which this <tt>JAWTRenderer</tt> has
+     * presented
+     */
+    public synchronized long getPresentedFrameCount()
+    {
+        return presentedFrameCount;
+    }
+
     /**
      * Gets the list of input <tt>Format</tt>s supported by this
      * <tt>Renderer</tt>.
@@ -401,6 +628,8 @@ public class JAWTRenderer
                     throw new ResourceUnavailableException(
                             "Failed to open the native JAWTRenderer.");
                 }
+                if (PACED)
+                    JAWTRendererPresenter.add(this);
             }
             else
             {
@@ -425,6 +654,103 @@ public class JAWTRenderer
         }
     }
 
+    /**
+     * Presents the frame which has been queued by this <tt>JAWTRenderer</tt>
+     * (if any) i.e. schedules its painting into the <tt>Component</tt> of this
+     * <tt>JAWTRenderer</tt> in the AWT event dispatching thread. Invoked by
+     * <tt>JAWTRendererPresenter</tt> once per refresh of the display.
+     *
+     * @param period the time in nanoseconds between two refreshes of the
+     * display
+     */
+    void present(long period)
+    {
+        synchronized (getHandleLock())
+        {
+            if ((handle == 0) || (queuedFrameTime == -1) || presentPending)
+                return;
+            presentPending = true;
+            presentPeriod = period;
+        }
+        EventQueue.invokeLater(presentInEventDispatchThread);
+    }
+
+    /**
+     * Paints the frame which has been queued by this <tt>JAWTRenderer</tt>
+     * (if any) into its <tt>Component</tt> the way AWT does i.e. through
+     * {@link Component#paint(Graphics)} in the AWT event dispatching thread.
+     * The frame remains queued until the <tt>Component</tt> may be painted
+     * into.
+     */
+    private void presentInEventDispatchThread()
+    {
+        Component component;
+
+        synchronized (getHandleLock())
+        {
+            presentPending = false;
+            if ((handle == 0) || (queuedFrameTime == -1))
+                return;
+            component = this.component;
+        }
+        if ((component == null)
+                || !component.isShowing()
+                || (component.getWidth()
+                        < SwScale.MIN_SWS_SCALE_HEIGHT_OR_WIDTH)
+                || (component.getHeight()
+                        < SwScale.MIN_SWS_SCALE_HEIGHT_OR_WIDTH))
+            return;
+
+        Graphics g = component.getGraphics();
+
+        if (g == null)
+            return;
+        try
+        {
+            synchronized (getHandleLock())
+            {
+                if ((handle == 0) || (queuedFrameTime == -1))
+                    return;
+
+                /*
+                 * The frame which has been taken over as an int array is
+                 * converted only now that it has not been superseded.
+                 */
+                if (pendingFrame != null)
+                {
+                    boolean processed
+                        = process(
+                                handle,
+                                component,
+                                pendingFrame,
+                                pendingFrameOffset,
+                                pendingFrameLength,
+                                pendingFrameSize.width,
+                                pendingFrameSize.height);
+
+                    releaseHeldFrames(-1);
+                    spareFrame = pendingFrame;
+                    pendingFrame = null;
+                    if (!processed)
+                    {
+                        queuedFrameTime = -1;
+                        return;
+                    }
+                }
+
+                component.paint(g);
+                presentedFrameCount++;
+                if (System.nanoTime() - queuedFrameTime > presentPeriod)
+                    lateFrameCount++;
+                queuedFrameTime = -1;
+            }
+        }
+        finally
+        {
+            g.dispose();
+        }
+    }
+
     /**
      * Processes the data provided in a specific <tt>Buffer</tt> and renders it
      * to the output device represented by this <tt>Renderer</tt>.
@@ -440,9 +766,11 @@ public class JAWTRenderer
         if (buffer.isDiscard())
             return BUFFER_PROCESSED_OK;
 
+        Object data = buffer.getData();
         int bufferLength = buffer.getLength();
 
-        if (bufferLength == 0)
+        /* The length of a Buffer carrying an AVFrame is not significant. */
+        if ((bufferLength == 0) && !(data instanceof AVFrame))
             return BUFFER_PROCESSED_OK;
 
         Format format = buffer.getFormat();
@@ -479,24 +807,141 @@ public class JAWTRenderer
                     && (size.height >= SwScale.MIN_SWS_SCALE_HEIGHT_OR_WIDTH))
             {
                 Component component = getComponent();
-                boolean repaint
-                    = process(
-                            handle,
-                            component,
-                            (int[]) buffer.getData(),
-                            buffer.getOffset(),
-                            bufferLength,
-                            size.width,
-                            size.height);
+                boolean repaint;
+
+                if (data instanceof AVFrame)
+                {
+                    /*
+                     * If the picture is pooled, hold a reference to it so that
+                     * the native counterpart may put off copying it until it
+                     * is painted (and skip copying it if it is superseded
+                     * before then).
+                     */
+                    int heldFrameIndex = (this.heldFrameIndex == 0) ? 1 : 0;
+                    AVFrame heldFrame = heldFrames[heldFrameIndex];
+
+                    if (heldFrame == null)
+                    {
+                        heldFrame = new AVFrame();
+                        heldFrames[heldFrameIndex] = heldFrame;
+                    }
+
+                    boolean hold = heldFrame.ref((AVFrame) data);
+                    long frame
+                        = (hold ? heldFrame : (AVFrame) data).getPtr();
+
+                    repaint
+                        = processPlanes(
+                                handle,
+                                component,
+                                FFmpeg.avframe_get_data(frame, 0),
+                                FFmpeg.avframe_get_linesize(frame, 0),
+                                FFmpeg.avframe_get_data(frame, 1),
+                                FFmpeg.avframe_get_linesize(frame, 1),
+                                FFmpeg.avframe_get_data(frame, 2),
+                                FFmpeg.avframe_get_linesize(frame, 2),
+                                size.width,
+                                size.height,
+                                hold);
+                    /*
+                     * The native counterpart has let go of the picture it held
+                     * before.
+                     */
+                    releaseHeldFrames(hold ? heldFrameIndex : -1);
+                    if (pendingFrame != null)
+                    {
+                        spareFrame = pendingFrame;
+                        pendingFrame = null;
+                    }
+                }
+                else if (PACED)
+                {
+                    /*
+                     * Take the int array over instead of having the native
+                     * counterpart copy it so that it is converted only if it
+                     * is still the newest frame when it is presented. The
+                     * array of the frame which it supersedes (if any) is
+                     * handed back for the next frame to be written into.
+                     */
+                    int[] supersededFrame = pendingFrame;
+
+                    if (supersededFrame == null)
+                    {
+                        supersededFrame = spareFrame;
+                        spareFrame = null;
+                    }
+                    pendingFrame = (int[]) data;
+                    pendingFrameOffset = buffer.getOffset();
+                    pendingFrameLength = bufferLength;
+                    pendingFrameSize = size;
+                    buffer.setData(supersededFrame);
+                    repaint = true;
+                }
+                else
+                {
+                    repaint
+                        = process(
+                                handle,
+                                component,
+                                (int[]) data,
+                                buffer.getOffset(),
+                                bufferLength,
+                                size.width,
+                                size.height);
+                    releaseHeldFrames(-1);
+                }
 
                 if (repaint)
-                    component.repaint();
+                    queueFrame(component);
             }
 
             return BUFFER_PROCESSED_OK;
         }
     }
 
+    /**
+     * Queues the frame which the native counterpart of this
+     * <tt>JAWTRenderer</tt> has just been given to be presented. If the frames
+     * are paced, it supersedes the frame which has been queued before (if
+     * any) and is presented on the next refresh of the display. Otherwise, the
+     * <tt>Component</tt> of this <tt>JAWTRenderer</tt> is repainted. Invoked
+     * with the handle lock held.
+     *
+     * @param component the <tt>Component</tt> of this <tt>JAWTRenderer</tt>
+     */
+    void queueFrame(Component component)
+    {
+        if (PACED)
+        {
+            if (queuedFrameTime != -1)
+                droppedFrameCount++;
+            queuedFrameTime = System.nanoTime();
+        }
+        else
+            component.repaint();
+    }
+
+    /**
+     * Drops the references to the pooled pictures held in {@link #heldFrames}
+     * except the one at a specific index which the native counterpart of this
+     * <tt>JAWTRenderer</tt> holds now. Invoked with the handle lock held and
+     * after a native method has superseded the picture held before.
+     *
+     * @param heldFrameIndex the index in <tt>heldFrames</tt> of the
+     * <tt>AVFrame</tt> to keep or <tt>-1</tt> to drop all
+     */
+    private void releaseHeldFrames(int heldFrameIndex)
+    {
+        for (int i = 0; i < heldFrames.length; i++)
+        {
+            AVFrame heldFrame = heldFrames[i];
+
+            if ((i != heldFrameIndex) && (heldFrame != null))
+                heldFrame.unref();
+        }
+        this.heldFrameIndex = heldFrameIndex;
+    }
+
     /**
      * Sets properties of the AWT <tt>Component</tt> of this <tt>Renderer</tt>
      * which depend on the properties of the <tt>inputFormat</tt> of this
@@ -0,0 +1,221 @@
+/*
+ * Jitsi, the OpenSource Java VoIP and Instant Messaging client.
+ *
+ * Distributable under LGPL license.
+ * See terms of license at gnu.org.
+ */
+package org.jitsi.impl.neomedia.jmfext.media.renderer.video;
+
+import java.awt.*;
+import java.util.*;
+import java.util.List;
+import java.util.concurrent.locks.*;
+
+import org.jitsi.util.*;
+
+/**
+ * Presents the frames queued by <tt>JAWTRenderer</tt>s on a timer which ticks
+ * at the refresh rate of the display rather than whenever AWT happens to
+ * repaint. Since a <tt>JAWTRenderer</tt> keeps only its newest frame, at most
+ * one frame per renderer is put per refresh and the superseded ones never get
+ * turned into images. The painting itself is carried out in the AWT event
+ * dispatching thread. A single thread serves all <tt>JAWTRenderer</tt>s and
+ * runs only while there are any.
+ */
+class JAWTRendererPresenter
+    implements Runnable
+{
+    /**
+     * The refresh rate in Hz to assume when the one of the display cannot be
+     * determined.
+     */
+    private static final int DEFAULT_REFRESH_RATE = 60;
+
+    /**
+     * The <tt>Logger</tt> used by the <tt>JAWTRendererPresenter</tt> class
+     * and its instances for logging output.
+     */
+    private static final Logger logger
+        = Logger.getLogger(JAWTRendererPresenter.class);
+
+    /**
+     * The interval in nanoseconds at which the refresh rate of the display is
+     * determined again so that changes of the display mode are followed.
+     */
+    private static final long REFRESH_PERIOD_CHECK_INTERVAL = 5000000000L;
+
+    /**
+     * The <tt>JAWTRendererPresenter</tt> which presents the frames of all
+     * <tt>JAWTRenderer</tt>s.
+     */
+    private static final JAWTRendererPresenter presenter
+        = new JAWTRendererPresenter();
+
+    /**
+     * Starts presenting the frames queued by a specific
+     * <tt>JAWTRenderer</tt>.
+     *
+     * @param renderer the <tt>JAWTRenderer</tt> to present the frames of
+     */
+    static void add(JAWTRenderer renderer)
+    {
+        presenter.addRenderer(renderer);
+    }
+
+    /**
+     * Gets the time in nanoseconds between two refreshes of the screen device
+     * with the highest refresh rate. The renderers on the other screen
+     * devices have their excess refreshes coalesced.
+     *
+     * @return the time in nanoseconds between two refreshes of the screen
+     * device with the highest refresh rate
+     */
+    private static long getRefreshPeriod()
+    {
+        int refreshRate = DisplayMode.REFRESH_RATE_UNKNOWN;
+
+        try
+        {
+            if (!GraphicsEnvironment.isHeadless())
+            {
+                for (GraphicsDevice screen
+                        : GraphicsEnvironment
+                            .getLocalGraphicsEnvironment()
+                                .getScreenDevices())
+                {
+                    int screenRefreshRate
+                        = screen.getDisplayMode().getRefreshRate();
+
+                    if (screenRefreshRate > refreshRate)
+                        refreshRate = screenRefreshRate;
+                }
+            }
+        }
+        catch (Throwable t)
+        {
+            if (t instanceof ThreadDeath)
+                throw (ThreadDeath) t;
+            logger.warn("Failed to determine the refresh rate.", t);
+        }
+        if (refreshRate <= 0)
+            refreshRate = DEFAULT_REFRESH_RATE;
+        return 1000000000L / refreshRate;
+    }
+
+    /**
+     * Stops presenting the frames queued by a specific
+     * <tt>JAWTRenderer</tt>.
+     *
+     * @param renderer the <tt>JAWTRenderer</tt> to stop presenting the frames
+     * of
+     */
+    static void remove(JAWTRenderer renderer)
+    {
+        presenter.removeRenderer(renderer);
+    }
+
+    /**
+     * The <tt>JAWTRenderer</tt>s the frames of which are presented by this
+     * instance.
+     */
+    private final List<JAWTRenderer> renderers = new ArrayList<JAWTRenderer>();
+
+    /**
+     * The <tt>Thread</tt> which presents the frames of {@link #renderers}.
+     */
+    private Thread thread;
+
+    /**
+     * Starts presenting the frames queued by a specific
+     * <tt>JAWTRenderer</tt> and starts {@link #thread} if necessary.
+     *
+     * @param renderer the <tt>JAWTRenderer</tt> to present the frames of
+     */
+    private synchronized void addRenderer(JAWTRenderer renderer)
+    {
+        if (!renderers.contains(renderer))
+            renderers.add(renderer);
+        if (thread == null)
+        {
+            thread = new Thread(this, getClass().getName());
+            thread.setDaemon(true);
+            thread.setPriority(Thread.MAX_PRIORITY - 1);
+            thread.start();
+        }
+    }
+
+    /**
+     * Stops presenting the frames queued by a specific
+     * <tt>JAWTRenderer</tt>. {@link #thread} exits once there are no more
+     * <tt>JAWTRenderer</tt>s.
+     *
+     * @param renderer the <tt>JAWTRenderer</tt> to stop presenting the frames
+     * of
+     */
+    private synchronized void removeRenderer(JAWTRenderer renderer)
+    {
+        renderers.remove(renderer);
+    }
+
+    /**
+     * Presents the frames queued by {@link #renderers} once per refresh of
+     * the display until there are no more <tt>JAWTRenderer</tt>s.
+     */
+    public void run()
+    {
+        long period = getRefreshPeriod();
+        long periodTime = System.nanoTime();
+        long tick = periodTime + period;
+
+        try
+        {
+            while (true)
+            {
+                long now;
+
+                while ((now = System.nanoTime()) < tick)
+                    LockSupport.parkNanos(tick - now);
+
+                JAWTRenderer[] renderers;
+
+                synchronized (this)
+                {
+                    if (this.renderers.isEmpty())
+                    {
+                        thread = null;
+                        break;
+                    }
+                    renderers
+                        = this.renderers.toArray(
+                                new JAWTRenderer[this.renderers.size()]);
+                }
+                for (JAWTRenderer renderer : renderers)
+                    renderer.present(period);
+
+                now = System.nanoTime();
+                if (now - periodTime >= REFRESH_PERIOD_CHECK_INTERVAL)
+                {
+                    period = getRefreshPeriod();
+                    periodTime = now;
+                }
+
+                /*
+                 * Keep to the refresh grid but do not try to catch up with the
+                 * ticks which have been missed altogether.
+                 */
+                tick += period;
+                now = System.nanoTime();
+                if (now >= tick)
+                    tick += ((now - tick) / period + 1) * period;
+            }
+        }
+        finally
+        {
+            synchronized (this)
+            {
+                if (Thread.currentThread().equals(thread))
+                    thread = null;
+            }
+        }
+    }
+}
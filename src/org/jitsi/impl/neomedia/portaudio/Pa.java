@@ -189,6 +189,25 @@ public final class Pa
      */
     public static final long SAMPLE_FORMAT_UINT8 = 0x00000020;
 
+    /**
+     * The scheduling policy which leaves the priority of a thread intact.
+     */
+    public static final int SCHED_POLICY_DEFAULT = 0;
+
+    /** The first-in, first-out real-time scheduling policy. */
+    public static final int SCHED_POLICY_FIFO = 1;
+
+    /**
+     * The scheduling policy which elevates the priority of a thread within the
+     * time-sharing scheduler e.g. by means of a negative nice level. It is
+     * what the real-time scheduling policies fall back to when they are
+     * denied.
+     */
+    public static final int SCHED_POLICY_NICE = 3;
+
+    /** The round-robin real-time scheduling policy. */
+    public static final int SCHED_POLICY_RR = 2;
+
     /** Disables default clipping of out of range samples. */
     public static final long STREAM_FLAGS_CLIP_OFF = 0x00000001;
 
@@ -224,6 +243,113 @@ public final class Pa
         STREAM_FLAGS_PRIME_OUTPUT_BUFFERS_USING_STREAM_CALLBACK
             = 0x00000008;
 
+    /**
+     * The index in the array of values of the health counters of a PortAudio
+     * stream (as returned by {@link #GetStreamStats(long, long[])}) of the
+     * total time in nanoseconds spent performing audio quality improvement
+     * (e.g. acoustic echo cancellation, denoise).
+     */
+    public static final int STREAM_STATS_AQI_TIME = 10;
+
+    /**
+     * The index in the array of values of the health counters of a PortAudio
+     * stream of the number of transfers i.e. invocations of the stream
+     * callback or, for blocking streams, of <tt>Pa_ReadStream</tt> or
+     * <tt>Pa_WriteStream</tt>.
+     */
+    public static final int STREAM_STATS_CALLBACKS = 0;
+
+    /**
+     * The index in the array of values of the health counters of a PortAudio
+     * stream of the first bin of the histogram of the intervals between
+     * consecutive transfers. The first bin counts the intervals shorter than
+     * a millisecond, bin <tt>i</tt> counts the intervals in the range
+     * <tt>[2<sup>i-1</sup>, 2<sup>i</sup>)</tt> milliseconds and the last bin
+     * counts the longer intervals.
+     */
+    public static final int STREAM_STATS_CALLBACK_INTERVAL_HISTOGRAM = 12;
+
+    /**
+     * The number of bins of the histogram of the intervals between
+     * consecutive transfers.
+     */
+    public static final int STREAM_STATS_CALLBACK_INTERVAL_HISTOGRAM_LENGTH
+        = 10;
+
+    /**
+     * The index in the array of values of the health counters of a PortAudio
+     * stream of the longest interval in nanoseconds between consecutive
+     * transfers.
+     */
+    public static final int STREAM_STATS_CALLBACK_INTERVAL_MAX = 1;
+
+    /**
+     * The index in the array of values of the health counters of a PortAudio
+     * stream of the number of bytes in the input buffer of the pseudo-blocking
+     * stream interface implementation.
+     */
+    public static final int STREAM_STATS_INPUT_FILL = 6;
+
+    /**
+     * The index in the array of values of the health counters of a PortAudio
+     * stream of the maximum number of bytes ever in the input buffer of the
+     * pseudo-blocking stream interface implementation.
+     */
+    public static final int STREAM_STATS_INPUT_FILL_MAX = 7;
+
+    /**
+     * The index in the array of values of the health counters of a PortAudio
+     * stream of the number of input overflows i.e. input data discarded
+     * because it was not read in time.
+     */
+    public static final int STREAM_STATS_INPUT_OVERFLOWS = 2;
+
+    /**
+     * The index in the array of values of the health counters of a PortAudio
+     * stream of the number of input underflows reported by PortAudio.
+     */
+    public static final int STREAM_STATS_INPUT_UNDERFLOWS = 3;
+
+    /**
+     * The number of values of the health counters of a PortAudio stream.
+     */
+    public static final int STREAM_STATS_LENGTH = 22;
+
+    /**
+     * The index in the array of values of the health counters of a PortAudio
+     * stream of the total time in nanoseconds <tt>ReadStream</tt> and
+     * <tt>WriteStream</tt> spent blocked on the mutexes and condition
+     * variables of the pseudo-blocking stream interface implementation.
+     */
+    public static final int STREAM_STATS_MUTEX_BLOCKED_TIME = 11;
+
+    /**
+     * The index in the array of values of the health counters of a PortAudio
+     * stream of the number of bytes in the output buffer of the
+     * pseudo-blocking stream interface implementation.
+     */
+    public static final int STREAM_STATS_OUTPUT_FILL = 8;
+
+    /**
+     * The index in the array of values of the health counters of a PortAudio
+     * stream of the maximum number of bytes ever in the output buffer of the
+     * pseudo-blocking stream interface implementation.
+     */
+    public static final int STREAM_STATS_OUTPUT_FILL_MAX = 9;
+
+    /**
+     * The index in the array of values of the health counters of a PortAudio
+     * stream of the number of output overflows reported by PortAudio.
+     */
+    public static final int STREAM_STATS_OUTPUT_OVERFLOWS = 4;
+
+    /**
+     * The index in the array of values of the health counters of a PortAudio
+     * stream of the number of output underflows i.e. silence played because
+     * output data was not written in time.
+     */
+    public static final int STREAM_STATS_OUTPUT_UNDERFLOWS = 5;
+
     static
     {
         System.loadLibrary("jnportaudio");
@@ -570,6 +696,35 @@ public final class Pa
      */
     public static native long GetStreamReadAvailable(long stream);
 
+    /**
+     * Gets the scheduling policy which took effect on the thread transferring
+     * the audio of a specific PortAudio stream as requested by
+     * {@link #SetStreamSchedPolicy(long, int, int)}. The policy is applied by
+     * the thread itself when it first transfers audio so it may not have
+     * taken effect yet.
+     *
+     * @param stream the pointer to the PortAudio stream
+     * @return one of the <tt>SCHED_POLICY_XXX</tt> constants which specifies
+     * the scheduling policy which took effect
+     */
+    public static native int GetStreamSchedPolicy(long stream);
+
+    /**
+     * Gets the health counters of a specific PortAudio stream i.e. the numbers
+     * of underflows and overflows, the histogram of the intervals between
+     * consecutive transfers, the fill levels of the pseudo-blocking buffers and
+     * the time spent in audio quality improvement and blocked on mutexes. The
+     * values are indexed by the <tt>STREAM_STATS_XXX</tt> constants and are
+     * read without synchronization with the audio threads.
+     *
+     * @param stream the pointer to the PortAudio stream to get the health
+     * counters of
+     * @param stats the array to write the values of the health counters into.
+     * If it has less than {@link #STREAM_STATS_LENGTH} elements, only as many
+     * values as fit are written.
+     */
+    public static native void GetStreamStats(long stream, long[] stats);
+
     /**
      * Retrieve the number of frames that can be written to the stream
      * without waiting.
@@ -771,6 +926,28 @@ public final class Pa
             long stream,
             long echoFilterLengthInMillis);
 
+    /**
+     * Requests a scheduling policy for the native thread transferring the
+     * audio of a specific PortAudio stream i.e. the stream callback thread
+     * which also feeds a pseudo-blocking stream. The Java threads reading from
+     * or writing to a stream keep their scheduling policy. A real-time
+     * policy which is denied falls back to {@link #SCHED_POLICY_NICE} where
+     * supported. Unless the requested policy is
+     * {@link #SCHED_POLICY_DEFAULT}, the memory accessed by the thread on
+     * behalf of the stream is also locked into RAM.
+     *
+     * @param stream the pointer to the PortAudio stream
+     * @param policy one of the <tt>SCHED_POLICY_XXX</tt> constants which
+     * specifies the scheduling policy to be requested
+     * @param priority the real-time priority to be requested
+     * @return <tt>true</tt> if the memory accessed on behalf of
+     * <tt>stream</tt> is locked into RAM; otherwise, <tt>false</tt>
+     */
+    public static native boolean SetStreamSchedPolicy(
+            long stream,
+            int policy,
+            int priority);
+
     /**
      * Commences audio processing.
      *
@@ -830,8 +1007,10 @@ public final class Pa
      * <p>
      * Provides better efficiency than achieved through multiple consecutive
      * calls to {@link #WriteStream(long, byte[], long)} with one and the
-     * same buffer because the JNI access to the bytes of the buffer which is
-     * likely to copy the whole buffer is only performed once.
+     * same buffer because the transition into native code is only performed
+     * once. The samples are copied straight out of <tt>buffer</tt> into the
+     * output buffer of a stream which implements the blocking stream interface
+     * on top of the non-blocking one.
      * </p>
      *
      * @param stream the pointer to the PortAudio stream to write the samples to
@@ -58,6 +58,10 @@ public final class PA
 
     public static final int CONTEXT_UNCONNECTED = 0;
 
+    public static final int DEVICE_REGISTRY_SINK = 0;
+
+    public static final int DEVICE_REGISTRY_SOURCE = 1;
+
     public static final int ENCODING_ANY = 0;
 
     public static final int ENCODING_INVALID = -1;
@@ -86,18 +90,59 @@ public final class PA
 
     public static final int SAMPLE_S16LE = 3;
 
+    public static final int SCHED_POLICY_DEFAULT = 0;
+
+    public static final int SCHED_POLICY_FIFO = 1;
+
+    public static final int SCHED_POLICY_NICE = 3;
+
+    public static final int SCHED_POLICY_RR = 2;
+
     public static final int SEEK_RELATIVE = 0;
 
     public static final int STREAM_ADJUST_LATENCY = 0x2000;
 
+    public static final int STREAM_AUTO_TIMING_UPDATE = 0x0008;
+
     public static final int STREAM_FAILED = 3;
 
+    public static final int STREAM_INTERPOLATE_TIMING = 0x0002;
+
     public static final int STREAM_NOFLAGS = 0x0000;
 
     public static final int STREAM_READY = 2;
 
     public static final int STREAM_START_CORKED = 0x0001;
 
+    public static final int STREAM_STATS_BUFFER_LENGTH = 19;
+
+    public static final int STREAM_STATS_CALLBACKS = 0;
+
+    public static final int STREAM_STATS_CALLBACK_INTERVAL_HISTOGRAM = 6;
+
+    public static final int STREAM_STATS_CALLBACK_INTERVAL_HISTOGRAM_LENGTH
+        = 10;
+
+    public static final int STREAM_STATS_CALLBACK_INTERVAL_MAX = 1;
+
+    public static final int STREAM_STATS_HOLES = 16;
+
+    public static final int STREAM_STATS_LATENCY = 20;
+
+    public static final int STREAM_STATS_LENGTH = 21;
+
+    public static final int STREAM_STATS_OVERFLOWS = 2;
+
+    public static final int STREAM_STATS_PUMP_OVERFLOWS = 17;
+
+    public static final int STREAM_STATS_PUMP_UNDERFLOWS = 18;
+
+    public static final int STREAM_STATS_REQUEST_BYTES = 4;
+
+    public static final int STREAM_STATS_REQUEST_BYTES_MAX = 5;
+
+    public static final int STREAM_STATS_UNDERFLOWS = 3;
+
     public static final int STREAM_TERMINATED = 4;
 
     static
@@ -159,6 +204,48 @@ public final class PA
 
     public static native long cvolume_set(long cv, int channels, int v);
 
+    public static native void device_registry_free(long r);
+
+    /**
+     * Gets a snapshot of the sinks and sources cached by a device registry
+     * initialized by {@link #device_registry_new(long, long)}. The snapshot is
+     * serialized in big-endian byte order as the <tt>long</tt> version of the
+     * registry, the <tt>int</tt> number of devices and, for each device, the
+     * <tt>int</tt> <tt>DEVICE_REGISTRY_XXX</tt> type, index, index of the
+     * monitor source (of a sink) or of the monitored sink (of a source), sample
+     * format, number of channels and sample rate followed by the name and the
+     * description. Each string is serialized as its <tt>int</tt> length in
+     * bytes followed by its UTF-8 bytes; a <tt>null</tt> string has the length
+     * <tt>-1</tt>. The mainloop lock must be held.
+     *
+     * @param r the device registry to get a snapshot of
+     * @return the serialized snapshot of the devices cached by <tt>r</tt>
+     */
+    public static native byte[] device_registry_get_snapshot(long r);
+
+    /**
+     * Gets the number of times the devices cached by a device registry have
+     * changed. Zero until the initial lists of sinks and sources have been
+     * retrieved. The threaded mainloop is signaled whenever the version
+     * changes. The mainloop lock must be held.
+     *
+     * @param r the device registry to get the version of
+     * @return the version of <tt>r</tt>
+     */
+    public static native long device_registry_get_version(long r);
+
+    /**
+     * Initializes a new native cache of the sinks and sources of a
+     * <tt>pa_context</tt> which is kept current by the subscription events of
+     * the context. The mainloop lock must be held.
+     *
+     * @param m the threaded mainloop which services <tt>c</tt>
+     * @param c the <tt>pa_context</tt> to cache the sinks and sources of
+     * @return the new device registry or <tt>0</tt> if the subscription to
+     * the events of <tt>c</tt> failed
+     */
+    public static native long device_registry_new(long m, long c);
+
     public static native int format_info_get_encoding(long f);
 
     public static native long format_info_get_plist(long f);
@@ -177,6 +264,78 @@ public final class PA
 
     public static native int proplist_sets(long p, String key, String value);
 
+    public static native void pump_free(long pump);
+
+    /**
+     * Locks a specific native I/O pump and its ring buffer into RAM so that
+     * the thread of the threaded mainloop does not incur page faults while
+     * servicing the pump. The memory is unlocked by {@link #pump_free(long)}.
+     *
+     * @param pump the pump to lock into RAM
+     * @return <tt>true</tt> if <tt>pump</tt> is locked into RAM; otherwise,
+     * <tt>false</tt>
+     */
+    public static native boolean pump_lock_memory(long pump);
+
+    /**
+     * Initializes a new native I/O pump of a <tt>pa_stream</tt>. The pump
+     * services the read (record) or write (playback) requests of the stream on
+     * the thread of the threaded mainloop and hands the audio over to/from
+     * Java through a lock-free ring buffer so that {@link #pump_read(long,
+     * byte[], int, int)} and {@link #pump_write(long, byte[], int, int)} do not
+     * have to acquire the mainloop lock. The mainloop lock must be held while
+     * invoking <tt>pump_new</tt> and {@link #pump_free(long)}.
+     *
+     * @param m the threaded mainloop which services <tt>s</tt>
+     * @param s the <tt>pa_stream</tt> to pump
+     * @param capacity the capacity in bytes of the ring buffer of the pump
+     * @param playback <tt>true</tt> if <tt>s</tt> is a playback stream;
+     * <tt>false</tt> if <tt>s</tt> is a record stream
+     * @param stats the health counters of <tt>s</tt> initialized by
+     * {@link #stream_stats_new(long, boolean)} or <tt>0</tt>
+     * @return the new pump or <tt>0</tt> if the initialization failed
+     */
+    public static native long pump_new(
+            long m,
+            long s,
+            int capacity,
+            boolean playback,
+            long stats);
+
+    /**
+     * Reads audio from a record pump. Blocks until <tt>length</tt> bytes have
+     * been read or the pump has been interrupted.
+     *
+     * @return the number of bytes read
+     */
+    public static native int pump_read(
+            long pump,
+            byte[] data,
+            int offset,
+            int length);
+
+    /**
+     * Sets whether {@link #pump_read(long, byte[], int, int)} and
+     * {@link #pump_write(long, byte[], int, int)} are to return without
+     * blocking when no audio or space is available. Unblocks a thread which is
+     * currently blocked in them.
+     */
+    public static native void pump_set_interrupted(
+            long pump,
+            boolean interrupted);
+
+    /**
+     * Writes audio into a playback pump. Blocks until <tt>length</tt> bytes
+     * have been written or the pump has been interrupted.
+     *
+     * @return the number of bytes written
+     */
+    public static native int pump_write(
+            long pump,
+            byte[] data,
+            int offset,
+            int length);
+
     public static native void sample_spec_free(long ss);
 
     public static native long sample_spec_new(
@@ -254,6 +413,20 @@ public final class PA
 
     public static native int stream_get_index(long s);
 
+    /**
+     * Gets the current latency of a <tt>pa_stream</tt> i.e. the time in
+     * microseconds which a sample written into a playback stream takes to be
+     * played back or a sample captured by the source takes to be read out of a
+     * record stream. The stream should be connected with
+     * {@link #STREAM_INTERPOLATE_TIMING} and {@link #STREAM_AUTO_TIMING_UPDATE}
+     * in order to have the latency known. The mainloop lock must be held.
+     *
+     * @param s the <tt>pa_stream</tt> to get the latency of
+     * @return the latency in microseconds of <tt>s</tt> or <tt>-1</tt> if it is
+     * not known yet
+     */
+    public static native long stream_get_latency(long s);
+
     public static native int stream_get_state(long s);
 
     public static native long stream_new_with_proplist(
@@ -269,13 +442,75 @@ public final class PA
 
     public static native void stream_set_read_callback(
             long s,
-            stream_request_cb_t cb);
+            stream_request_cb_t cb,
+            long stats);
 
     public static native void stream_set_state_callback(long s, Runnable cb);
 
     public static native void stream_set_write_callback(
             long s,
-            stream_request_cb_t cb);
+            stream_request_cb_t cb,
+            long stats);
+
+    /**
+     * Frees the health counters of a <tt>pa_stream</tt> initialized by
+     * {@link #stream_stats_new(long, boolean)} and removes the native callbacks
+     * which update them. The mainloop lock must be held.
+     *
+     * @param stats the health counters to free
+     */
+    public static native void stream_stats_free(long stats);
+
+    /**
+     * Gets the values of the health counters of a <tt>pa_stream</tt> indexed
+     * by the <tt>STREAM_STATS_XXX</tt> constants. The numbers of underflows and
+     * overflows are reported by the server, the request callback intervals are
+     * in nanoseconds and the request bytes are the numbers of bytes
+     * readable/writable upon the read/write requests.
+     *
+     * @param stats the health counters to get the values of
+     * @param values the array to write the values into. If it has less than
+     * {@link #STREAM_STATS_LENGTH} elements, only as many values as fit are
+     * written.
+     */
+    public static native void stream_stats_get(long stats, long[] values);
+
+    /**
+     * Initializes new health counters for a specific <tt>pa_stream</tt> and
+     * installs the native underflow and overflow callbacks which update them.
+     * The read/write requests are counted if the returned value is specified
+     * to <tt>stream_set_read_callback</tt>/<tt>stream_set_write_callback</tt>.
+     * The mainloop lock must be held.
+     *
+     * @param s the <tt>pa_stream</tt> to initialize the health counters of
+     * @param playback <tt>true</tt> if <tt>s</tt> is a playback stream or
+     * <tt>false</tt> if it is a record stream
+     * @return the new health counters or <tt>0</tt> on failure
+     */
+    public static native long stream_stats_new(long s, boolean playback);
+
+    /**
+     * Enables or disables the adaptive mode of the health counters of a
+     * playback <tt>pa_stream</tt>. In the adaptive mode, the target length of
+     * the buffer of the stream is grown as soon as the underflows exceed a
+     * specific number per ten seconds and is shrunk while the underflows stay
+     * well within it i.e. it converges on the smallest buffer which keeps the
+     * underflows within the specified rate. The current target length and
+     * latency are reported as {@link #STREAM_STATS_BUFFER_LENGTH} and
+     * {@link #STREAM_STATS_LATENCY}. The mainloop lock must be held.
+     *
+     * @param stats the health counters of a playback stream initialized by
+     * {@link #stream_stats_new(long, boolean)}
+     * @param minLength the minimum target length in bytes of the buffer
+     * @param maxLength the maximum target length in bytes of the buffer or
+     * <tt>0</tt> to disable the adaptive mode
+     * @param glitches the number of underflows per ten seconds to be tolerated
+     */
+    public static native void stream_stats_set_adaptive(
+            long stats,
+            int minLength,
+            int maxLength,
+            int glitches);
 
     public static native void stream_unref(long s);
 
@@ -300,6 +535,11 @@ public final class PA
 
     public static native long threaded_mainloop_new();
 
+    public static native int threaded_mainloop_set_sched_policy(
+            long m,
+            int policy,
+            int priority);
+
     public static native void threaded_mainloop_signal(
             long m,
             boolean waitForAccept);